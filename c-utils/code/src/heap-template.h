@@ -14,7 +14,7 @@
  * limitations under the License
  */
 /*
- *  Generic binary heap.
+ *  Generic d-ary heap, binary by default.
  *
  *  Implements a min-heap.
  *
@@ -24,6 +24,15 @@
  *  HEAP_VAL_T: a value type
  *  HEAP_PFX: the prefix to apply to function names, e.g. my_heap_
  *
+ *  Optional macros:
+ *  HEAP_ARITY: children per node, default 2.  A wider heap is
+ *    shallower, and with small entries all children of a node share
+ *    a cache line, e.g. 4 or 8 for 8-byte entries.
+ *  HEAP_SET_POS(val, i): called whenever an entry with value val is
+ *    placed at index i.  Lets the user keep a back-pointer from each
+ *    value to its position, so that it can be removed directly with
+ *    del_entry without searching the heap.
+ *
  *  This will define types ${HEAP_PFX}key_t ${HEAP_PFX}val_t, and
  *   ${HEAP_PFX}entry_t and a range of heap functions, e.g.
  *   ${HEAP_PFX}init, ${HEAP_PFX}add, etc.
@@ -45,6 +54,23 @@
 #define HEAP_RIGHT(i) (i * 2 + 2)
 #define HEAP_PARENT(i) ((i - 1) / 2)
 
+#ifndef HEAP_ARITY
+#define HEAP_ARITY 2
+#endif
+
+#ifndef HEAP_SET_POS
+#define HEAP_SET_POS(val, i) // noop
+#endif
+
+// Evaluated with HEAP_ARITY of each instantiation
+#define HEAP_FIRST_CHILD(i) ((i) * HEAP_ARITY + 1)
+#define HEAP_PARENT_D(i) (((i) - 1) / HEAP_ARITY)
+
+/* Put entry at index i of heap array */
+#define HEAP_PLACE(heap, i, entry) {                            \
+    (heap)->array[(i)] = (entry);                               \
+    HEAP_SET_POS((entry).val, (i)); }
+
 #define heap_min(X, Y) ( (X) < (Y) ? (X) : (Y))
 #define heap_max(X, Y) ( (X) > (Y) ? (X) : (Y))
 
@@ -154,18 +180,12 @@ HEAP_CHECK(HEAP_T *heap) {
   heap_idx_t i;
   for (i = 0; i < heap->size; i++) {
     HEAP_KEY_T k = heap->array[i].key;
-    if (HEAP_LEFT(i) < heap->size) {
-      HEAP_KEY_T kl = heap->array[HEAP_LEFT(i)].key;
-      if (kl < k) {
-        printf("bad heap: key(%li) == %li, key(%li) == %li\n",
-               (long) i, (long) k, (long) HEAP_LEFT(i), (long) kl);
-      }
-    }
-    if (HEAP_RIGHT(i) < heap->size) {
-      HEAP_KEY_T kr = heap->array[HEAP_RIGHT(i)].key;
-      if (kr < k) {
+    for (heap_idx_t c = HEAP_FIRST_CHILD(i);
+         c < HEAP_FIRST_CHILD(i) + HEAP_ARITY && c < heap->size; c++) {
+      HEAP_KEY_T kc = heap->array[c].key;
+      if (kc < k) {
         printf("bad heap: key(%li) == %li, key(%li) == %li\n",
-               (long) i, (long) k, (long) HEAP_RIGHT(i), (long) kr);
+               (long) i, (long) k, (long) c, (long) kc);
       }
     }
   }
@@ -205,28 +225,33 @@ static inline void HEAP_SIFT_DOWN(HEAP_T *heap, heap_idx_t i) {
   HEAP_ENTRY_T entry = heap->array[i];
   HEAP_KEY_T key = entry.key;
   while (1) {
-    if ( HEAP_LEFT(i) < heap->size ) {
-      /* Find the smaller child */
-      heap_idx_t min_idx = HEAP_LEFT(i);
-      HEAP_KEY_T min = heap->array[HEAP_LEFT(i)].key;
-      if ( HEAP_RIGHT(i) < heap->size &&
-         heap->array[HEAP_RIGHT(i)].key < min) {
-        min = heap->array[HEAP_RIGHT(i)].key;
-        min_idx = HEAP_RIGHT(i);
+    heap_idx_t first = HEAP_FIRST_CHILD(i);
+    if ( first < heap->size ) {
+      /* Find the smallest child */
+      heap_idx_t min_idx = first;
+      HEAP_KEY_T min = heap->array[first].key;
+      heap_idx_t end = first + HEAP_ARITY;
+      if (end > heap->size)
+        end = heap->size;
+      for (heap_idx_t c = first + 1; c < end; c++) {
+        if (heap->array[c].key < min) {
+          min = heap->array[c].key;
+          min_idx = c;
+        }
       }
 
       /* Check if minheap property is violated */
       if (min < key) {
-        heap->array[i] = heap->array[min_idx];
+        HEAP_PLACE(heap, i, heap->array[min_idx]);
         i = min_idx;
       } else {
         /* entry is less than children, we now have a min-heap again */
-        heap->array[i] = entry;
+        HEAP_PLACE(heap, i, entry);
         break;
       }
     } else {
       /* At bottom, put in entry and we're done */
-      heap->array[i] = entry;
+      HEAP_PLACE(heap, i, entry);
       break;
     }
   }
@@ -248,6 +273,9 @@ static inline void HEAP_DEL_ROOT(HEAP_T *heap)
   }
 }
 
+#define HEAP_SIFT_UP HEAP_NAME(sift_up)
+static inline void HEAP_SIFT_UP(HEAP_T *heap, heap_idx_t i);
+
 /*
  * Remove any entry of the heap
  */
@@ -258,9 +286,14 @@ static inline void HEAP_DEL_ENTRY(HEAP_T *heap, heap_idx_t i)
   heap->size--;
 
   if (i != heap->size) {
-    /* put last element up the top */
+    /* put last element in the gap: it may belong above or below */
     heap->array[i] = heap->array[heap->size];
-    HEAP_SIFT_DOWN(heap, i);
+    if (i > 0 &&
+        heap->array[i].key < heap->array[HEAP_PARENT_D(i)].key) {
+      HEAP_SIFT_UP(heap, i);
+    } else {
+      HEAP_SIFT_DOWN(heap, i);
+    }
   }
 }
 
@@ -297,23 +330,22 @@ static inline void HEAP_INCREASE_KEY(HEAP_T *heap, heap_idx_t i, HEAP_KEY_T newk
  * heap property, except A[i] might have key < its parent.
  * Sift up A[i] until it is a heap again
  */
-#define HEAP_SIFT_UP HEAP_NAME(sift_up)
 static inline void HEAP_SIFT_UP(HEAP_T *heap, heap_idx_t i) {
   assert(heap->size > i);
   HEAP_ENTRY_T entry, parent;
   entry = heap->array[i];
   while (i > 0) {
-    parent = heap->array[HEAP_PARENT(i)];
+    parent = heap->array[HEAP_PARENT_D(i)];
     if (parent.key <= entry.key) {
       /* Is heap */
       break;
     } else {
-      heap->array[i] = parent;
-      i = HEAP_PARENT(i);
+      HEAP_PLACE(heap, i, parent);
+      i = HEAP_PARENT_D(i);
     }
   }
   /* Last i should be the location where new prime belonds */
-  heap->array[i] = entry;
+  HEAP_PLACE(heap, i, entry);
 }
 
 /*
@@ -413,6 +445,9 @@ HEAP_DECREASE_KEY(HEAP_T *heap, heap_idx_t i, HEAP_KEY_T newkey)
 #undef HEAP_ADD_ENTRY
 #undef HEAP_ADD
 #undef HEAP_DECREASE_KEY
+#undef HEAP_PLACE
+#undef HEAP_FIRST_CHILD
+#undef HEAP_PARENT_D
 
 #undef HEAP_NAME__
 #undef HEAP_NAME_
@@ -421,4 +456,6 @@ HEAP_DECREASE_KEY(HEAP_T *heap, heap_idx_t i, HEAP_KEY_T newkey)
 #undef HEAP_KEY_T
 #undef HEAP_VAL_T
 #undef HEAP_PFX
+#undef HEAP_ARITY
+#undef HEAP_SET_POS
 #endif // HEAP_KEEP_DEFNS
@@ -114,23 +114,31 @@ RBTREE_INIT(struct RBTREE_TYPENAME* target)
   target->root = NULL;
 }
 
-static inline struct RBTREE_NODE*
-create_node(RBTREE_KEY_T key, RBTREE_VAL_T data)
+static inline bool
+init_node(struct RBTREE_NODE* node, RBTREE_KEY_T key, RBTREE_VAL_T data)
 {
-  struct RBTREE_NODE* node = malloc(sizeof(struct RBTREE_NODE));
-  if (node == NULL) return NULL;
   node->parent = NULL;
   node->right = NULL;
   node->left = NULL;
   bool ok = RBTREE_KEY_COPY(node->key, key);
   if (!ok)
+    return false;
+
+  node->data = data;
+  node->color = RED;
+  return true;
+}
+
+static inline struct RBTREE_NODE*
+create_node(RBTREE_KEY_T key, RBTREE_VAL_T data)
+{
+  struct RBTREE_NODE* node = malloc(sizeof(struct RBTREE_NODE));
+  if (node == NULL) return NULL;
+  if (!init_node(node, key, data))
   {
     free(node);
     return NULL;
   }
-
-  node->data = data;
-  node->color = RED;
   return node;
 }
 
@@ -305,6 +313,13 @@ RBTREE_NODE_CREATE(RBTREE_KEY_T key, RBTREE_VAL_T data)
   return create_node(key, data);
 }
 
+bool
+RBTREE_NODE_INIT(struct RBTREE_NODE* node, RBTREE_KEY_T key,
+                 RBTREE_VAL_T data)
+{
+  return init_node(node, key, data);
+}
+
 void
 RBTREE_ADD_NODE(struct RBTREE_TYPENAME* target,
                 struct RBTREE_NODE* node)
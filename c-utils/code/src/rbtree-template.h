@@ -78,6 +78,16 @@ bool RBTREE_ADD(struct RBTREE_TYPENAME* target, RBTREE_KEY_T key, RBTREE_VAL_T d
 #define RBTREE_NODE_CREATE RBTREE_NAME(node_create)
 struct RBTREE_NODE* RBTREE_NODE_CREATE(RBTREE_KEY_T key, RBTREE_VAL_T data);
 
+/**
+   Initialize a node allocated by the caller, e.g. from a pool,
+   for use with RBTREE_ADD_NODE().  The key is copied.
+   Caller must free the key before releasing the node memory.
+   @return false iff failed to allocate memory
+ */
+#define RBTREE_NODE_INIT RBTREE_NAME(node_init)
+bool RBTREE_NODE_INIT(struct RBTREE_NODE* node, RBTREE_KEY_T key,
+                      RBTREE_VAL_T data);
+
 /**
    Add a node.  Key and value must be initialized
  */
@@ -181,6 +191,7 @@ void RBTREE_FREE(struct RBTREE_TYPENAME* target);
 #undef RBTREE_INIT
 #undef RBTREE_ADD
 #undef RBTREE_NODE_CREATE
+#undef RBTREE_NODE_INIT
 #undef RBTREE_ADD_NODE
 #undef RBTREE_SEARCH_NODE
 #undef RBTREE_REMOVE
@@ -0,0 +1,619 @@
+/*
+ * Copyright 2013 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * rhtable_lp.c
+ *
+ * Robin Hood hashing: on insert, an entry that is further from its
+ * home slot than the resident entry takes the slot, and the resident
+ * is pushed on down the probe sequence.  This bounds the variance of
+ * probe lengths, so lookups can stop as soon as they see a slot whose
+ * entry is closer to home than the probe.  Removal uses backward
+ * shifting so no tombstones are needed.
+ */
+
+#define _GNU_SOURCE // for asprintf
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rhtable_lp.h"
+
+// Double in size for now
+static const int table_expand_factor = 2;
+
+/** Probe distances are stored in a byte; expand before overflow */
+#define RHTABLE_LP_MAX_DIST UINT8_MAX
+
+/**
+   64-bit finalizer from MurmurHash3: cheap, and mixes sequential
+   IDs well, which is the common case for ADLB
+ */
+static inline uint64_t
+hash_long(int64_t key)
+{
+  uint64_t x = (uint64_t)key;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+static inline int
+home_slot(const rhtable_lp *T, int64_t key)
+{
+  return (int)(hash_long(key) & (uint64_t)(T->capacity - 1));
+}
+
+static void
+rhtable_lp_dump2(const char* format, const rhtable_lp* target,
+                 bool include_vals);
+
+static bool
+alloc_arrays(rhtable_lp *T, int capacity);
+
+static bool
+insert_entry(rhtable_lp *T, rhtable_lp_entry *entry, bool check_dup,
+             bool *duplicate);
+
+static bool
+rhtable_lp_expand(rhtable_lp *T, rhtable_lp_entry *pending);
+
+static void
+undo_insert(rhtable_lp *T, int64_t key, rhtable_lp_entry *homeless);
+
+static int
+locate_slot(const rhtable_lp *T, int64_t key);
+
+static void
+remove_slot(rhtable_lp *T, int slot);
+
+static int
+calc_resize_threshold(rhtable_lp *T)
+{
+  int threshold = (int)((float)T->capacity * T->load_factor);
+  if (threshold >= T->capacity)
+  {
+    threshold = T->capacity - 1;
+  }
+  return threshold;
+}
+
+static int
+round_capacity(int capacity)
+{
+  int result = 1;
+  while (result < capacity)
+  {
+    result *= 2;
+  }
+  return result;
+}
+
+bool
+rhtable_lp_init(rhtable_lp* table, int capacity)
+{
+  return rhtable_lp_init_custom(table, capacity,
+                                RHTABLE_LP_DEFAULT_LOAD_FACTOR);
+}
+
+bool
+rhtable_lp_init_custom(rhtable_lp* target, int capacity,
+                       float load_factor)
+{
+  assert(capacity >= 1);
+  assert(load_factor > 0.0);
+  if (load_factor > RHTABLE_LP_MAX_LOAD_FACTOR)
+  {
+    load_factor = (float)RHTABLE_LP_MAX_LOAD_FACTOR;
+  }
+
+  target->size = 0;
+  target->load_factor = load_factor;
+  if (!alloc_arrays(target, round_capacity(capacity)))
+  {
+    return false;
+  }
+  return true;
+}
+
+/*
+  Allocate zeroed arrays for capacity and update capacity info
+ */
+static bool
+alloc_arrays(rhtable_lp *T, int capacity)
+{
+  rhtable_lp_entry *array = malloc(sizeof(array[0]) * (size_t)capacity);
+  uint8_t *dists = calloc((size_t)capacity, sizeof(dists[0]));
+  if (array == NULL || dists == NULL)
+  {
+    free(array);
+    free(dists);
+    return false;
+  }
+
+  T->array = array;
+  T->dists = dists;
+  T->capacity = capacity;
+  T->resize_threshold = calc_resize_threshold(T);
+  return true;
+}
+
+rhtable_lp*
+rhtable_lp_create(int capacity)
+{
+  return rhtable_lp_create_custom(capacity,
+                                  RHTABLE_LP_DEFAULT_LOAD_FACTOR);
+}
+
+rhtable_lp*
+rhtable_lp_create_custom(int capacity, float load_factor)
+{
+  rhtable_lp *new_table = malloc(sizeof(rhtable_lp));
+  if (! new_table)
+    return NULL;
+
+  bool result = rhtable_lp_init_custom(new_table, capacity, load_factor);
+  if (!result)
+  {
+    free(new_table);
+    return NULL;
+  }
+
+  return new_table;
+}
+
+void
+rhtable_lp_clear(rhtable_lp* target)
+{
+  memset(target->dists, 0, sizeof(target->dists[0]) *
+                           (size_t)target->capacity);
+  target->size = 0;
+}
+
+void
+rhtable_lp_delete(rhtable_lp* target)
+{
+  RHTABLE_LP_FOREACH(target, item)
+  {
+    free(item->data);
+  }
+  rhtable_lp_clear(target);
+}
+
+void
+rhtable_lp_destroy(rhtable_lp* target)
+{
+  rhtable_lp_free_callback(target, true, NULL);
+}
+
+void rhtable_lp_free_callback(rhtable_lp* target, bool free_root,
+                              void (*callback)(int64_t, void*))
+{
+  if (callback != NULL)
+  {
+    RHTABLE_LP_FOREACH(target, item)
+    {
+      callback(item->key, item->data);
+    }
+  }
+
+  free(target->array);
+  free(target->dists);
+  if (free_root)
+  {
+    free(target);
+  }
+  else
+  {
+    target->array = NULL;
+    target->dists = NULL;
+    target->size = target->capacity = 0;
+  }
+}
+
+void
+rhtable_lp_release(rhtable_lp* target)
+{
+  free(target->array);
+  free(target->dists);
+}
+
+int
+rhtable_lp_size(rhtable_lp* target)
+{
+  return target->size;
+}
+
+/*
+  Find slot in table matching key
+  returns: -1 if not found
+ */
+static int
+locate_slot(const rhtable_lp *T, int64_t key)
+{
+  int mask = T->capacity - 1;
+  int slot = home_slot(T, key);
+  int dist = 1;
+  while (true)
+  {
+    // Empty slots have dist 0 so will terminate the search
+    if (T->dists[slot] < dist)
+    {
+      return -1;
+    }
+    if (T->array[slot].key == key)
+    {
+      return slot;
+    }
+    slot = (slot + 1) & mask;
+    dist++;
+  }
+}
+
+/*
+  Insert entry into table, displacing entries as needed.
+  check_dup: whether to check for duplicate keys
+  duplicate: set to true if a duplicate key was found.
+  returns: true if inserted, false if probe distance overflowed.
+           In that case entry is overwritten with the entry that
+           still needs a slot, which may be a displaced entry.
+ */
+static bool
+insert_entry(rhtable_lp *T, rhtable_lp_entry *entry, bool check_dup,
+             bool *duplicate)
+{
+  int mask = T->capacity - 1;
+  int slot = home_slot(T, entry->key);
+  int dist = 1;
+  while (true)
+  {
+    int slot_dist = T->dists[slot];
+    if (slot_dist == 0)
+    {
+      T->array[slot] = *entry;
+      T->dists[slot] = (uint8_t)dist;
+      return true;
+    }
+
+    if (check_dup && slot_dist >= dist &&
+        T->array[slot].key == entry->key)
+    {
+      *duplicate = true;
+      return false;
+    }
+
+    if (slot_dist < dist)
+    {
+      // Rob from the rich: swap with resident and continue
+      rhtable_lp_entry tmp = T->array[slot];
+      T->array[slot] = *entry;
+      T->dists[slot] = (uint8_t)dist;
+      *entry = tmp;
+      dist = slot_dist;
+      // Displaced entries can't be duplicates
+      check_dup = false;
+    }
+
+    slot = (slot + 1) & mask;
+    dist++;
+    if (dist >= RHTABLE_LP_MAX_DIST)
+    {
+      return false;
+    }
+  }
+}
+
+bool
+rhtable_lp_add(rhtable_lp *target, int64_t key, void* data)
+{
+  rhtable_lp_entry entry = { .key = key, .data = data };
+
+  // Check to resize hash table
+  if (target->size >= target->resize_threshold)
+  {
+    if (rhtable_lp_contains(target, key))
+    {
+      return false;
+    }
+
+    bool ok = rhtable_lp_expand(target, &entry);
+    if (!ok)
+      return false;
+    target->size++;
+    return true;
+  }
+
+  bool duplicate = false;
+  bool ok = insert_entry(target, &entry, true, &duplicate);
+  if (duplicate)
+  {
+    return false;
+  }
+  if (!ok)
+  {
+    // Pathological probe length: grow and insert homeless entry
+    ok = rhtable_lp_expand(target, &entry);
+    if (!ok)
+    {
+      undo_insert(target, key, &entry);
+      return false;
+    }
+  }
+  target->size++;
+  return true;
+}
+
+/*
+  Back out an insert of key that overflowed the probe distance, where
+  homeless is the entry left without a slot.  If key displaced
+  residents, it is in the table and homeless is a former resident.
+  Removing key and reinserting the resident gives a valid table with
+  the original contents, in which the resident fits as before.
+ */
+static void
+undo_insert(rhtable_lp *T, int64_t key, rhtable_lp_entry *homeless)
+{
+  if (homeless->key == key)
+  {
+    // Nothing was displaced
+    return;
+  }
+
+  int slot = locate_slot(T, key);
+  assert(slot >= 0);
+  remove_slot(T, slot);
+
+  bool ok = insert_entry(T, homeless, false, NULL);
+  assert(ok);
+  (void)ok;
+}
+
+bool rhtable_lp_set(rhtable_lp* table, int64_t key,
+                    void* value, void** old_value)
+{
+  int slot = locate_slot(table, key);
+  if (slot >= 0)
+  {
+    *old_value = table->array[slot].data;
+    table->array[slot].data = value;
+    return true;
+  }
+  else
+  {
+    *old_value = NULL;
+    return false;
+  }
+}
+
+bool
+rhtable_lp_search(rhtable_lp* table, int64_t key, void **value)
+{
+  int slot = locate_slot(table, key);
+  if (slot >= 0)
+  {
+    *value = table->array[slot].data;
+    return true;
+  }
+  else
+  {
+    *value = NULL;
+    return false;
+  }
+}
+
+bool
+rhtable_lp_contains(rhtable_lp* table, int64_t key)
+{
+  return locate_slot(table, key) >= 0;
+}
+
+/*
+  Remove entry from slot, shifting back following entries to fill gap
+ */
+static void
+remove_slot(rhtable_lp *T, int slot)
+{
+  int mask = T->capacity - 1;
+  int next = (slot + 1) & mask;
+  while (T->dists[next] > 1)
+  {
+    T->array[slot] = T->array[next];
+    T->dists[slot] = (uint8_t)(T->dists[next] - 1);
+    slot = next;
+    next = (next + 1) & mask;
+  }
+  T->dists[slot] = 0;
+}
+
+bool
+rhtable_lp_move(rhtable_lp* table, int64_t key_old, int64_t key_new)
+{
+  void *val;
+
+  if (!rhtable_lp_search(table, key_old, &val))
+  {
+    return false;
+  }
+  if (key_old == key_new)
+  {
+    return true;
+  }
+  // Add first so that value stays in table if add fails
+  if (!rhtable_lp_add(table, key_new, val))
+  {
+    return false;
+  }
+  bool removed = rhtable_lp_remove(table, key_old, &val);
+  assert(removed);
+  (void)removed;
+  return true;
+}
+
+bool
+rhtable_lp_remove(rhtable_lp* table, int64_t key, void **value)
+{
+  int slot = locate_slot(table, key);
+  if (slot >= 0)
+  {
+    *value = table->array[slot].data; // Store data for caller
+    remove_slot(table, slot);
+    table->size--;
+    return true;
+  }
+  return false;
+}
+
+/**
+   Resize hash table to be larger
+   pending: if not NULL, an entry not yet in table to add after
+            rehashing.
+ */
+static bool
+rhtable_lp_expand(rhtable_lp *T, rhtable_lp_entry *pending)
+{
+  rhtable_lp old = *T;
+  int new_capacity = old.capacity * table_expand_factor;
+
+  while (true)
+  {
+    assert(new_capacity > old.capacity);
+    if (!alloc_arrays(T, new_capacity))
+    {
+      *T = old;
+      return false;
+    }
+
+    // Rehash and move all entries from old table
+    bool ok = true;
+    for (int i = 0; i < old.capacity && ok; i++)
+    {
+      if (rhtable_lp_slot_valid(&old, i))
+      {
+        rhtable_lp_entry e = old.array[i];
+        ok = insert_entry(T, &e, false, NULL);
+      }
+    }
+
+    if (ok && pending != NULL)
+    {
+      rhtable_lp_entry e = *pending;
+      ok = insert_entry(T, &e, false, NULL);
+    }
+
+    if (ok)
+    {
+      break;
+    }
+
+    // Overflowed even after expanding (extremely unlikely): try again
+    rhtable_lp_release(T);
+    new_capacity *= table_expand_factor;
+  }
+
+  rhtable_lp_release(&old);
+  return true;
+}
+
+/** format specifies the output format for the data items
+ */
+void
+rhtable_lp_dump(const char* format, const rhtable_lp* target)
+{
+  rhtable_lp_dump2(format, target, true);
+}
+
+void
+rhtable_lp_dumpkeys(const rhtable_lp* target)
+{
+  rhtable_lp_dump2(NULL, target, false);
+}
+
+static void
+rhtable_lp_dump2(const char *format, const rhtable_lp* target,
+                 bool include_vals)
+{
+  printf("{\n");
+  for (int i = 0; i < target->capacity; i++)
+  {
+    if (!rhtable_lp_slot_valid(target, i))
+    {
+      // Skip empty slots
+      continue;
+    }
+    const rhtable_lp_entry *e = &target->array[i];
+    printf("%i: (", i);
+    printf("%"PRId64, e->key);
+    if (include_vals)
+    {
+      printf(", ");
+      if (format == NULL)
+      {
+        // Print pointer by default
+        printf("%p", e->data);
+      }
+      else
+      {
+        printf(format, e->data);
+      }
+    }
+    printf(")\n");
+  }
+  printf("}\n");
+}
+
+/** Dump to string a la snprintf()
+        size must be greater than 2.
+        format specifies the output format for the data items
+        returns int greater than size if size limits are exceeded
+                indicating result is garbage
+ */
+size_t rhtable_lp_tostring(char* str, size_t size,
+                           char* format, rhtable_lp* target)
+{
+  size_t error = size+1;
+  char* ptr   = str;
+
+  if (size <= 4)
+    return error;
+
+  ptr += sprintf(str, "{\n");
+
+  RHTABLE_LP_FOREACH(target, item)
+  {
+    char* s;
+    int r = asprintf(&s, format, item->data);
+    if (r < 0)
+      return error;
+
+    if ((size_t)(ptr-str) + 32 + (size_t)r + 4 < size)
+    {
+      ptr += sprintf(ptr, "(%"PRId64",%s)\n", item->key, s);
+      free(s);
+    }
+    else
+    {
+      free(s);
+      return error;
+    }
+  }
+  sprintf(ptr, "}\n");
+
+  return (size_t)(ptr-str);
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2013 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * rhtable_lp.h
+ *
+ * Table mapping 64-bit int to void pointer
+ *
+ * Open-addressing (Robin Hood) alternative to table_lp with the
+ * same API.  Entries are stored inline in a flat array, so adds do
+ * not allocate (except on expand) and lookups do not chase pointers.
+ * A parallel byte array holds the probe distance of each slot,
+ * so most lookup misses only touch that array.
+ *
+ * Unlike table_lp, duplicate keys are not permitted: rhtable_lp_add
+ * returns false if the key is already present.
+ */
+
+#ifndef RHTABLE_LP_H
+#define RHTABLE_LP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "c-utils-types.h"
+
+typedef struct rhtable_lp_entry rhtable_lp_entry;
+
+struct rhtable_lp_entry
+{
+  int64_t key;
+  void* data; // NULL is valid data
+};
+
+typedef struct rhtable_lp
+{
+  rhtable_lp_entry* array;
+  /** Probe distance + 1 of entry in each slot, 0 if empty */
+  uint8_t* dists;
+  int capacity; // Always a power of two
+  int size;
+  float load_factor;
+  int resize_threshold; // Resize if > this size
+} rhtable_lp;
+
+#define RHTABLE_LP_DEFAULT_LOAD_FACTOR 0.85
+
+/** Higher load factors are clamped to this */
+#define RHTABLE_LP_MAX_LOAD_FACTOR 0.95
+
+/*
+  Macro for iterating over table entries.  This handles the simple case
+  of iterating over all valid table entries with no modifications.
+ */
+#define RHTABLE_LP_FOREACH(T, item) \
+  for (int __i = 0; __i < (T)->capacity; __i++) \
+    if (rhtable_lp_slot_valid((T), __i)) \
+      for (rhtable_lp_entry *item = &((T)->array[__i]); item != NULL; \
+           item = NULL)
+
+/**
+   @param capacity: Number of entries.  Must not be 0.
+                    Rounded up to a power of two.
+ */
+bool rhtable_lp_init(rhtable_lp *table, int capacity);
+
+bool rhtable_lp_init_custom(rhtable_lp *table, int capacity,
+                            float load_factor);
+
+rhtable_lp* rhtable_lp_create(int capacity);
+
+rhtable_lp* rhtable_lp_create_custom(int capacity, float load_factor);
+
+int rhtable_lp_size(rhtable_lp* table);
+
+/**
+   @return true on success, false on failure (memory or duplicate key)
+ */
+bool rhtable_lp_add(rhtable_lp* table, int64_t key, void* data);
+
+bool rhtable_lp_set(rhtable_lp* table, int64_t key,
+                    void* value, void** old_value);
+
+bool rhtable_lp_search(rhtable_lp* table, int64_t key, void **value);
+
+bool rhtable_lp_contains(rhtable_lp* table, int64_t key);
+
+/**
+   Move value from key_old to key_new
+   @return false if key_old is missing, key_new is already present, or
+           on memory failure.  The table is unchanged on failure.
+ */
+bool rhtable_lp_move(rhtable_lp* table,
+                     int64_t key_old, int64_t key_new);
+
+bool rhtable_lp_remove(rhtable_lp* table, int64_t key, void **value);
+
+void rhtable_lp_destroy(rhtable_lp* target);
+
+void rhtable_lp_free_callback(rhtable_lp* target, bool free_root,
+                              void (*callback)(int64_t, void*));
+
+void rhtable_lp_clear(rhtable_lp* target);
+
+void rhtable_lp_delete(rhtable_lp* target);
+
+void rhtable_lp_release(rhtable_lp* target);
+
+void rhtable_lp_dump(const char* format, const rhtable_lp* target);
+
+size_t rhtable_lp_tostring(char* str, size_t size,
+                           char* format, rhtable_lp* target);
+
+void rhtable_lp_dumpkeys(const rhtable_lp* target);
+
+/*
+  If the slot contains data
+ */
+static inline bool
+rhtable_lp_slot_valid(const rhtable_lp *T, int slot)
+{
+  return T->dists[slot] != 0;
+}
+
+#endif
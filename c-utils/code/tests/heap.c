@@ -21,6 +21,19 @@
 #include "heap.h"
 #include "c-utils-tests.h"
 
+// 4-ary heap with back-pointers from value to position
+#define DHEAP_VALS 1000
+static heap_idx_t dheap_pos[DHEAP_VALS];
+
+#define HEAP_KEY_T int
+#define HEAP_VAL_T int
+#define HEAP_PFX dheap_
+#define HEAP_ARITY 4
+#define HEAP_SET_POS(val, i) (dheap_pos[(val)] = (i))
+#include "heap-template.h"
+
+static void test_dheap(void);
+
 void heap_del_val(heap_t *h, void *val) {
   for (int i = 0; i < h->size; i++) {
     if (h->array[i].val == val) {
@@ -112,5 +125,48 @@ int main() {
 
   heap_clear(&h);
 
+  test_dheap();
+
   printf("DONE\n");
 }
+
+static void check_dheap_pos(dheap_t *h)
+{
+  for (heap_idx_t i = 0; i < h->size; i++) {
+    ASSERT_TRUE(dheap_pos[h->array[i].val] == i);
+  }
+}
+
+static void test_dheap(void)
+{
+  dheap_t h;
+  dheap_init_empty(&h);
+
+  for (int v = 0; v < DHEAP_VALS; v++) {
+    dheap_add(&h, (v * 7919) % 503, v);
+  }
+  dheap_check(&h);
+  check_dheap_pos(&h);
+
+  // Remove every third value directly through its back-pointer
+  for (int v = 0; v < DHEAP_VALS; v += 3) {
+    ASSERT_TRUE(h.array[dheap_pos[v]].val == v);
+    dheap_del_entry(&h, dheap_pos[v]);
+    check_dheap_pos(&h);
+  }
+  dheap_check(&h);
+  ASSERT_TRUE(h.size == DHEAP_VALS - (DHEAP_VALS + 2) / 3);
+
+  // Remaining keys come out in order
+  int prev = -1;
+  while (dheap_size(&h) > 0) {
+    dheap_entry_t root = dheap_root(&h);
+    ASSERT_TRUE(root.val % 3 != 0);
+    ASSERT_TRUE(root.key >= prev);
+    prev = root.key;
+    dheap_del_root(&h);
+    check_dheap_pos(&h);
+  }
+
+  dheap_clear(&h);
+}
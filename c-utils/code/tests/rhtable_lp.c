@@ -0,0 +1,249 @@
+/*
+ * Copyright 2013 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include "src/c-utils-tests.h"
+
+#include <rhtable_lp.h>
+
+static void null_cb(int64_t k, void *v);
+static void test_expand_oom(void);
+
+int main() {
+
+  rhtable_lp T;
+  bool ok;
+
+  ok = rhtable_lp_init(&T, 4);
+  ASSERT_TRUE(ok);
+
+  // force expand several times
+  int N = 64;
+  for (int i = 0; i < N; i++)
+  {
+    int64_t key = i;
+
+    void *val = (void*)(long)i;
+    ok = rhtable_lp_add(&T, key, val);
+    ASSERT_TRUE(ok);
+    
+    rhtable_lp_dump(NULL, &T);
+
+    // Check iteration works;
+    int count = 0;
+    RHTABLE_LP_FOREACH(&T, item)
+    {
+      count++;
+    }
+    printf("i=%i count=%i\n", i, count);
+    ASSERT_TRUE(count == i + 1);
+  }
+  ASSERT_TRUE(T.size == N);
+
+  for (int i = 0; i < N; i++)
+  {
+    // Lookup in different order
+    int64_t key = ((i*29) + 30) % N;
+    void *val;
+    bool found = rhtable_lp_search(&T, key, &val);
+    ASSERT_TRUE(found);
+    printf("Search: %"PRId64"=%li\n", key, (long)val);
+    ASSERT_TRUE(((long)val) == key);
+  }
+  ASSERT_TRUE(T.size == N);
+  
+  for (int i = 0; i < N; i++)
+  {
+    // Remove in different order
+    int64_t key = ((i*29) + 5) % N;
+    void *val;
+    bool found = rhtable_lp_remove(&T, key, &val);
+    ASSERT_TRUE(found);
+    printf("Remove: %"PRId64"=%li\n", key, (long)val);
+    ASSERT_TRUE(((long)val) == key);
+  }
+  ASSERT_TRUE(T.size == 0);
+
+  // Free
+  rhtable_lp_free_callback(&T, false, NULL);
+  
+  // Rebuild
+  N = 4096;
+  // Force high load and long probe sequences, with interleaved removes
+  rhtable_lp_init_custom(&T, 2, 32.0);
+  for (int i = 0; i < N; i++)
+  {
+    int64_t key = i * 1024;
+
+    void *val = (void*)((long)key);
+    ok = rhtable_lp_add(&T, key, val);
+    ASSERT_TRUE(ok);
+
+    // Duplicates are rejected
+    ok = rhtable_lp_add(&T, key, NULL);
+    ASSERT_TRUE(!ok);
+
+    void *search_val;
+    ok = rhtable_lp_search(&T, key, &search_val);
+    ASSERT_TRUE(ok);
+    ASSERT_TRUE(val == search_val);
+
+    if (i % 3 == 2)
+    {
+      // Remove an earlier key: backward shift must keep others findable
+      int64_t rm_key = (i - 1) * 1024;
+      ok = rhtable_lp_remove(&T, rm_key, &search_val);
+      ASSERT_TRUE(ok);
+      ASSERT_TRUE(((long)search_val) == rm_key);
+      ok = rhtable_lp_add(&T, rm_key, search_val);
+      ASSERT_TRUE(ok);
+    }
+  }
+  ASSERT_TRUE(T.size == N);
+
+  for (int i = 0; i < N; i++)
+  {
+    int64_t key = i * 1024;
+    void *val;
+    ok = rhtable_lp_search(&T, key, &val);
+    ASSERT_TRUE(ok);
+    ASSERT_TRUE(((long)val) == key);
+  }
+  ASSERT_TRUE(!rhtable_lp_contains(&T, 7));
+
+  // Move onto existing key fails and keeps value under old key
+  ok = rhtable_lp_move(&T, 0, 1024);
+  ASSERT_TRUE(!ok);
+  ASSERT_TRUE(rhtable_lp_contains(&T, 0));
+  ok = rhtable_lp_move(&T, 0, 7);
+  ASSERT_TRUE(ok);
+  ASSERT_TRUE(!rhtable_lp_contains(&T, 0));
+  ok = rhtable_lp_move(&T, 7, 0);
+  ASSERT_TRUE(ok);
+  ASSERT_TRUE(T.size == N);
+
+  // Try printing
+  printf("\n\nrhtable_lp_dump:\n");
+  rhtable_lp_dump("%p", &T);
+  printf("\n\nrhtable_lp_dump_keys:\n");
+  rhtable_lp_dumpkeys(&T);
+  
+  // This should free all memory
+  rhtable_lp_free_callback(&T, false, null_cb);
+
+  test_expand_oom();
+
+  printf("DONE\n");
+}
+
+/*
+  Invert the hash used by rhtable_lp to make a key with given hash
+ */
+static int64_t key_with_hash(uint64_t x)
+{
+  x ^= x >> 33;
+  x *= 0x9cb4b2f8129337dbULL;
+  x ^= x >> 33;
+  x *= 0x4f74430c22a54005ULL;
+  x ^= x >> 33;
+  return (int64_t)x;
+}
+
+/*
+  Overflow the probe distance after displacing a resident, with
+  expansion failing for lack of memory: the table must be unchanged.
+ */
+static void test_expand_oom(void)
+{
+  // Big enough that the expanded arrays must be newly mapped
+  const int capacity = 1 << 20;
+  const int run = 254;
+  rhtable_lp T;
+  bool ok = rhtable_lp_init(&T, capacity);
+  ASSERT_TRUE(ok);
+
+  // One entry at its home slot 0, then a run of entries homed at
+  // slot 1 with probe distances up to the maximum
+  int64_t first = key_with_hash(0);
+  ok = rhtable_lp_add(&T, first, NULL);
+  ASSERT_TRUE(ok);
+  int64_t keys[run];
+  for (int i = 0; i < run; i++)
+  {
+    keys[i] = key_with_hash(((uint64_t)(i + 1) << 20) | 1);
+    ok = rhtable_lp_add(&T, keys[i], (void*)(long)i);
+    ASSERT_TRUE(ok);
+  }
+  ASSERT_TRUE(T.capacity == capacity);
+  ASSERT_TRUE(T.dists[run] == run);
+
+  // Homed at slot 0: displaces keys[0], which then overflows
+  int64_t key = key_with_hash((uint64_t)(run + 1) << 20);
+
+  struct rlimit old_limit, limit;
+  int rc = getrlimit(RLIMIT_AS, &old_limit);
+  ASSERT_TRUE(rc == 0);
+  limit = old_limit;
+  limit.rlim_cur = 0;
+  rc = setrlimit(RLIMIT_AS, &limit);
+  ASSERT_TRUE(rc == 0);
+
+  // Check that the limit makes big allocations fail
+  void *probe = malloc(sizeof(T.array[0]) * (size_t)capacity * 2);
+  if (probe == NULL)
+  {
+    ok = rhtable_lp_add(&T, key, NULL);
+  }
+  rc = setrlimit(RLIMIT_AS, &old_limit);
+  ASSERT_TRUE(rc == 0);
+
+  if (probe != NULL)
+  {
+    printf("Could not limit memory: skipping OOM test\n");
+    free(probe);
+  }
+  else
+  {
+    ASSERT_TRUE(!ok);
+    ASSERT_TRUE(T.capacity == capacity);
+    ASSERT_TRUE(T.size == run + 1);
+    ASSERT_TRUE(!rhtable_lp_contains(&T, key));
+    ASSERT_TRUE(rhtable_lp_contains(&T, first));
+    for (int i = 0; i < run; i++)
+    {
+      void *val;
+      ok = rhtable_lp_search(&T, keys[i], &val);
+      ASSERT_TRUE(ok);
+      ASSERT_TRUE(((long)val) == i);
+    }
+  }
+
+  // With memory available the table expands
+  ok = rhtable_lp_add(&T, key, NULL);
+  ASSERT_TRUE(ok);
+  ASSERT_TRUE(T.capacity > capacity);
+  ASSERT_TRUE(T.size == run + 2);
+
+  rhtable_lp_free_callback(&T, false, NULL);
+}
+
+static void null_cb(int64_t k, void *v)
+{
+  // Do nothing
+}
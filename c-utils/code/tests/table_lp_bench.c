@@ -0,0 +1,125 @@
+/*
+ * Copyright 2013 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * table_lp_bench.c
+ *
+ * Microbenchmark comparing chained table_lp with open-addressing
+ * rhtable_lp on an ADLB-like workload: sequential datum IDs,
+ * lookups of present and absent keys, and interleaved removes.
+ *
+ * Usage: table_lp_bench.x [N] [lookups per key]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "src/c-utils-tests.h"
+
+#include <rhtable_lp.h>
+#include <table_lp.h>
+#include <tools.h>
+
+/** Defaults are small so this can run as a quick test */
+static int N = 64 * 1024;
+static int lookups = 4;
+
+typedef struct
+{
+  double add, search, miss, churn, remove;
+} bench_times;
+
+/*
+  Generate the same benchmark body for both tables
+ */
+#define BENCH_TABLE(PFX, T, times) { \
+  double t0, t1; \
+  bool ok; \
+  void* v; \
+  t0 = time_micros(); \
+  for (int i = 0; i < N; i++) { \
+    ok = PFX ## _add(T, i, (void*)(long)i); \
+    ASSERT_TRUE(ok); \
+  } \
+  t1 = time_micros(); (times)->add = t1 - t0; t0 = t1; \
+  for (int r = 0; r < lookups; r++) \
+    for (int i = 0; i < N; i++) { \
+      int64_t key = ((int64_t)i * 7919) % N; \
+      ok = PFX ## _search(T, key, &v); \
+      ASSERT_TRUE(ok && (long)v == key); \
+    } \
+  t1 = time_micros(); (times)->search = t1 - t0; t0 = t1; \
+  for (int r = 0; r < lookups; r++) \
+    for (int i = 0; i < N; i++) { \
+      ok = PFX ## _contains(T, N + i); \
+      ASSERT_TRUE(!ok); \
+    } \
+  t1 = time_micros(); (times)->miss = t1 - t0; t0 = t1; \
+  for (int i = 0; i < N; i++) { \
+    ok = PFX ## _remove(T, i, &v); \
+    ASSERT_TRUE(ok); \
+    ok = PFX ## _add(T, N + i, v); \
+    ASSERT_TRUE(ok); \
+  } \
+  t1 = time_micros(); (times)->churn = t1 - t0; t0 = t1; \
+  for (int i = 0; i < N; i++) { \
+    ok = PFX ## _remove(T, N + i, &v); \
+    ASSERT_TRUE(ok); \
+  } \
+  t1 = time_micros(); (times)->remove = t1 - t0; \
+  ASSERT_TRUE((T)->size == 0); \
+}
+
+static void
+report(const char *name, bench_times *t)
+{
+  double per_op = 1e9 / N; // seconds -> ns per op
+  printf("%-12s add: %7.1fns search: %7.1fns miss: %7.1fns "
+         "churn: %7.1fns remove: %7.1fns\n", name,
+         t->add * per_op, t->search * per_op / lookups,
+         t->miss * per_op / lookups, t->churn * per_op,
+         t->remove * per_op);
+}
+
+int main(int argc, char **argv)
+{
+  if (argc > 1)
+    N = atoi(argv[1]);
+  if (argc > 2)
+    lookups = atoi(argv[2]);
+  ASSERT_TRUE(N > 0 && lookups > 0);
+
+  printf("N=%i lookups=%i\n", N, lookups);
+
+  bench_times lp_times, rh_times;
+
+  // Small initial capacity so that expansion is included
+  table_lp lp;
+  ASSERT_TRUE(table_lp_init(&lp, 1024));
+  BENCH_TABLE(table_lp, &lp, &lp_times);
+  table_lp_free_callback(&lp, false, NULL);
+
+  rhtable_lp rh;
+  ASSERT_TRUE(rhtable_lp_init(&rh, 1024));
+  BENCH_TABLE(rhtable_lp, &rh, &rh_times);
+  rhtable_lp_free_callback(&rh, false, NULL);
+
+  report("table_lp", &lp_times);
+  report("rhtable_lp", &rh_times);
+
+  printf("DONE\n");
+  return 0;
+}
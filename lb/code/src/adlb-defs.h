@@ -191,6 +191,24 @@ typedef struct {
     adlb_subscript subscript;
   } adlb_datum_id_sub;
 
+  /*
+   * Description of a task for the batched put functions.
+   * Fields match the arguments of ADLB_Dput.
+   */
+  typedef struct {
+    const void *payload;
+    int length;
+    int target;
+    int answer;
+    int type;
+    adlb_put_opts opts;
+    const char *name; // Only used for debugging, may be NULL
+    const adlb_datum_id *wait_ids;
+    int wait_id_count;
+    const adlb_datum_id_sub *wait_id_subs;
+    int wait_id_sub_count;
+  } adlb_put_spec;
+
   typedef enum
   {
     ADLB_READ_REFCOUNT,
@@ -259,6 +277,10 @@ typedef struct {
     ADLB_PLACE_DEFAULT, /** Use default */
     ADLB_PLACE_LOCAL, /** Place on local server */
     ADLB_PLACE_RANDOM, /** Place on random server */
+    ADLB_PLACE_DATUM, /** Place on server of datum placement_arg */
+    ADLB_PLACE_RANK, /** Place on server of rank placement_arg */
+    ADLB_PLACE_HASH, /** Place on server chosen by key hash
+                         placement_arg, e.g. from ADLB_Placement_hash */
   } adlb_placement;
 
   // Prefer to tightly pack these structs
@@ -271,6 +293,8 @@ typedef struct {
     bool release_write_refs : 1;
     adlb_dsym symbol;
     adlb_placement placement;
+    /** Datum ID, rank or key hash for placement hint */
+    int64_t placement_arg;
   } adlb_create_props;
 
   // Default settings for new variables
@@ -281,6 +305,7 @@ typedef struct {
     false, /* release_write_refs */
     ADLB_DSYM_NULL, /* symbol */
     ADLB_PLACE_DEFAULT, /* placement */
+    0, /* placement_arg */
   };
 
   // Information for new variable creation
@@ -321,6 +346,44 @@ typedef struct {
         { 1, 0 }, /* incr_reference read and write refcounts */
   };
 
+  /*
+     Reduction operators for ADLB_Reduce
+   */
+  typedef enum
+  {
+    /** Sum of integer or float members */
+    ADLB_REDUCE_SUM,
+    /** Minimum of integer or float members */
+    ADLB_REDUCE_MIN,
+    /** Maximum of integer or float members */
+    ADLB_REDUCE_MAX,
+    /** Number of members with values */
+    ADLB_REDUCE_COUNT,
+    /** Concatenation of string members in enumeration order */
+    ADLB_REDUCE_CONCAT,
+  } adlb_reduce_op;
+
+  /*
+   * One datum to fetch with ADLB_Retrieve_multi.
+   * Fields match the arguments of ADLB_Retrieve.
+   */
+  typedef struct {
+    adlb_datum_id id;
+    adlb_subscript subscript;
+    adlb_retrieve_refc refcounts;
+  } adlb_retrieve_spec;
+
+  /*
+   * Result of one retrieve from ADLB_Retrieve_multi
+   */
+  typedef struct {
+    // ADLB_SUCCESS, ADLB_NOTHING if not found, or ADLB_ERROR
+    adlb_code code;
+    adlb_data_type type;
+    void *data; // Points into storage returned by ADLB_Retrieve_multi
+    size_t length;
+  } adlb_retrieve_result;
+
 
   /**
      Common return codes
@@ -46,8 +46,11 @@
 #include "mpe-tools.h"
 #include "mpi-tools.h"
 #include "notifications.h"
+#include "rma.h"
 #include "server.h"
+#include "slab.h"
 #include "sync.h"
+#include "write_buffer.h"
 
 static int next_server;
 
@@ -63,7 +66,8 @@ static MPI_Group adlb_group;
 
 static int mpi_version;
 
-static inline int choose_data_server(adlb_placement placement);
+static inline adlb_code choose_data_server(
+              const adlb_create_props *props, int *server);
 
 #define XLB_GET_RESP_HDR_IX 0
 #define XLB_GET_RESP_PAYLOAD_IX 1
@@ -188,6 +192,15 @@ ADLBP_Init(int nservers, int ntypes, int type_vect[],
   code = xlb_get_reqs_init();
   ADLB_CHECK(code);
 
+  code = xlb_write_buffer_init();
+  ADLB_CHECK(code);
+
+  code = xlb_notifications_init();
+  ADLB_CHECK(code);
+
+  code = xlb_rma_init(xlb_s.comm);
+  ADLB_CHECK(code);
+
   rc = MPI_Comm_group(xlb_s.comm, &adlb_group);
   assert(rc == MPI_SUCCESS);
 
@@ -338,6 +351,8 @@ ADLBP_Put(const void* payload, int length, int target, int answer,
   adlb_code rc;
   int response;
 
+  XLB_WRITE_BUFFER_SYNC();
+
   DEBUG("ADLB_Put: type=%i target=%i priority=%i strictness=%i "
         "accuracy=%i x%i length=%i \"%.*s\"", type, target, opts.priority,
         opts.strictness, opts.accuracy, opts.parallelism, length, length,
@@ -408,45 +423,56 @@ ADLBP_Put(const void* payload, int length, int target, int answer,
   return ADLB_SUCCESS;
 }
 
-adlb_code ADLBP_Dput(const void* payload, int length, int target,
-        int answer, int type, adlb_put_opts opts, const char *name,
-        const adlb_datum_id *wait_ids, int wait_id_count,
-        const adlb_datum_id_sub *wait_id_subs, int wait_id_sub_count)
+/*
+  Bytes needed to pack a dput request with pack_dput()
+ */
+static inline size_t
+packed_dput_size(int length, bool inline_payload, const char *name,
+        int wait_id_count, const adlb_datum_id_sub *wait_id_subs,
+        int wait_id_sub_count)
 {
-  MPI_Status status;
-  MPI_Request request;
-  int response;
-  adlb_code rc;
-
-  DEBUG("ADLB_Dput: target=%i x%i length=%i %.*s",
-        target, opts.parallelism, length, length, (char*) payload);
-
-  rc = adlb_put_check_params(target, type, opts);
-  ADLB_CHECK(rc);
+  size_t size = sizeof(struct packed_dput);
+  size += sizeof(adlb_datum_id) * (size_t)wait_id_count;
 
-  /** Server to contact */
-  int to_server;
-  rc = adlb_put_target_server(target, &to_server);
-  ADLB_CHECK(rc);
+  for (int i = 0; i < wait_id_sub_count; i++)
+  {
+    size += xlb_pack_id_sub_size(wait_id_subs[i].subscript);
+  }
 
-  int inline_data_len;
-  if (length <= PUT_INLINE_DATA_MAX)
+  #ifndef NDEBUG
+  if (name != NULL)
   {
-    inline_data_len = length;
+    size += strlen(name);
   }
-  else
+  #endif
+
+  if (inline_payload)
   {
-    inline_data_len = 0;
+    size += (size_t)length;
   }
+  return size;
+}
 
-  struct packed_dput *p = (struct packed_dput*)xlb_xfer;
+/*
+  Pack a dput request into buffer, which must have room for
+  packed_dput_size() bytes.
+  inline_payload: if true, pack payload after request
+  Returns number of bytes used
+ */
+static int
+pack_dput(struct packed_dput *p, const void *payload, int length,
+        bool inline_payload, int target, int answer, int type,
+        adlb_put_opts opts, const char *name,
+        const adlb_datum_id *wait_ids, int wait_id_count,
+        const adlb_datum_id_sub *wait_id_subs, int wait_id_sub_count)
+{
   p->type = type;
   p->putter = xlb_s.layout.rank;
   p->answer = answer;
   p->target = target;
   p->length = length;
   p->opts = opts;
-  p->has_inline_data = inline_data_len > 0;
+  p->has_inline_data = inline_payload;
   p->id_count = wait_id_count;
   p->id_sub_count = wait_id_sub_count;
 
@@ -456,7 +482,10 @@ adlb_code ADLBP_Dput(const void* payload, int length, int target,
   char *p_data = (char*)p->inline_data;
 
   size_t wait_id_len = sizeof(wait_ids[0]) * (size_t)wait_id_count;
-  memcpy(p_data, wait_ids, wait_id_len);
+  if (wait_id_len > 0)
+  {
+    memcpy(p_data, wait_ids, wait_id_len);
+  }
   p_data += wait_id_len;
   p_len += (int)wait_id_len;
 
@@ -470,19 +499,63 @@ adlb_code ADLBP_Dput(const void* payload, int length, int target,
 
   #ifndef NDEBUG
   // Don't pack name if NDEBUG on
-  p->name_strlen = (int)strlen(name);
-  memcpy(p_data, name, (size_t)p->name_strlen);
+  p->name_strlen = (name != NULL) ? (int)strlen(name) : 0;
+  if (p->name_strlen > 0)
+  {
+    memcpy(p_data, name, (size_t)p->name_strlen);
+  }
   p_data += p->name_strlen;
   p_len += p->name_strlen;
   #endif
 
-  if (p->has_inline_data)
+  if (inline_payload)
+  {
+    memcpy(p_data, payload, (size_t)length);
+    p_data += length;
+    p_len += length;
+  }
+
+  return p_len;
+}
+
+adlb_code ADLBP_Dput(const void* payload, int length, int target,
+        int answer, int type, adlb_put_opts opts, const char *name,
+        const adlb_datum_id *wait_ids, int wait_id_count,
+        const adlb_datum_id_sub *wait_id_subs, int wait_id_sub_count)
+{
+  MPI_Status status;
+  MPI_Request request;
+  int response;
+  adlb_code rc;
+
+  XLB_WRITE_BUFFER_SYNC();
+
+  DEBUG("ADLB_Dput: target=%i x%i length=%i %.*s",
+        target, opts.parallelism, length, length, (char*) payload);
+
+  rc = adlb_put_check_params(target, type, opts);
+  ADLB_CHECK(rc);
+
+  /** Server to contact */
+  int to_server;
+  rc = adlb_put_target_server(target, &to_server);
+  ADLB_CHECK(rc);
+
+  int inline_data_len;
+  if (length <= PUT_INLINE_DATA_MAX)
   {
-    memcpy(p_data, payload, (size_t)inline_data_len);
-    p_data += inline_data_len;
-    p_len += inline_data_len;
+    inline_data_len = length;
+  }
+  else
+  {
+    inline_data_len = 0;
   }
 
+  struct packed_dput *p = (struct packed_dput*)xlb_xfer;
+  int p_len = pack_dput(p, payload, length, inline_data_len > 0,
+        target, answer, type, opts, name, wait_ids, wait_id_count,
+        wait_id_subs, wait_id_sub_count);
+
   // xlb_xfer is much larger than we need for ids/subs plus inline data
   assert(p_len < ADLB_XFER_SIZE);
 
@@ -516,6 +589,304 @@ adlb_code ADLBP_Dput(const void* payload, int length, int target,
   return ADLB_SUCCESS;
 }
 
+/*
+  Callbacks for batch_dputs()
+ */
+typedef struct
+{
+  /**
+    Send message of count records packed into xlb_xfer
+    bytes: total bytes of header and records
+   */
+  adlb_code (*send)(int to_server, int count, size_t bytes, void *ctx);
+  /** Put task that does not fit in a message with others */
+  adlb_code (*put_one)(const adlb_put_spec *t, void *ctx);
+  void *ctx;
+} dput_batcher;
+
+/*
+  Pack tasks into messages in xlb_xfer, one message per run of tasks
+  for the same server, and send each one when full
+  batch_start: where records start in xlb_xfer, after the header,
+               or NULL if each task must be put by itself
+ */
+static adlb_code
+batch_dputs(const adlb_put_spec *tasks, int count, char *batch_start,
+            const dput_batcher *b)
+{
+  adlb_code rc;
+  const char *batch_end = xlb_xfer + ADLB_XFER_SIZE;
+  char *pos = batch_start;
+
+  // Server and task count for message under construction
+  int batch_server = ADLB_RANK_NULL;
+  int batch_count = 0;
+
+  for (int i = 0; i < count; i++)
+  {
+    const adlb_put_spec *t = &tasks[i];
+
+    rc = adlb_put_check_params(t->target, t->type, t->opts);
+    ADLB_CHECK(rc);
+
+    int to_server;
+    rc = adlb_put_target_server(t->target, &to_server);
+    ADLB_CHECK(rc);
+
+    size_t rec_size = PACKED_BATCH_PAD(packed_dput_size(t->length,
+          true, t->name, t->wait_id_count, t->wait_id_subs,
+          t->wait_id_sub_count));
+
+    bool batchable = batch_start != NULL &&
+                     rec_size <= (size_t)(batch_end - batch_start);
+
+    if (batch_count > 0 &&
+        (!batchable || to_server != batch_server ||
+         rec_size > (size_t)(batch_end - pos)))
+    {
+      // Send current message before starting another
+      rc = b->send(batch_server, batch_count, (size_t)(pos - xlb_xfer),
+                   b->ctx);
+      ADLB_CHECK(rc);
+      batch_count = 0;
+      pos = batch_start;
+    }
+
+    if (!batchable)
+    {
+      // Too large for a message with others: send by itself
+      rc = b->put_one(t, b->ctx);
+      ADLB_CHECK(rc);
+      continue;
+    }
+
+    batch_server = to_server;
+    int packed = pack_dput((struct packed_dput*)pos, t->payload,
+            t->length, true, t->target, t->answer, t->type, t->opts,
+            t->name, t->wait_ids, t->wait_id_count, t->wait_id_subs,
+            t->wait_id_sub_count);
+    assert(PACKED_BATCH_PAD((size_t)packed) == rec_size);
+    (void)packed;
+    pos += rec_size;
+    batch_count++;
+  }
+
+  if (batch_count > 0)
+  {
+    rc = b->send(batch_server, batch_count, (size_t)(pos - xlb_xfer),
+                 b->ctx);
+    ADLB_CHECK(rc);
+  }
+
+  return ADLB_SUCCESS;
+}
+
+/*
+  Send batch of dput requests packed into xlb_xfer
+ */
+static adlb_code
+send_dput_batch(int to_server, int count, size_t bytes, void *ctx)
+{
+  MPI_Status status;
+  MPI_Request request;
+  int response;
+
+  DEBUG("ADLB_Dput_batch: %i tasks (%zu bytes) to server %i",
+        count, bytes, to_server);
+
+  struct packed_batch_hdr *hdr =
+        (struct packed_batch_hdr*)xlb_xfer;
+  hdr->count = count;
+
+  assert(bytes <= ADLB_XFER_SIZE);
+  IRECV(&response, 1, MPI_INT, to_server, ADLB_TAG_RESPONSE_PUT);
+  SEND(xlb_xfer, (int)bytes, MPI_BYTE, to_server, ADLB_TAG_DPUT_BATCH);
+  WAIT(&request, &status);
+
+  ADLB_CHECK((adlb_code)response);
+  return ADLB_SUCCESS;
+}
+
+static adlb_code
+dput_batch_task(const adlb_put_spec *t, void *ctx)
+{
+  return ADLBP_Dput(t->payload, t->length, t->target, t->answer,
+          t->type, t->opts, t->name, t->wait_ids, t->wait_id_count,
+          t->wait_id_subs, t->wait_id_sub_count);
+}
+
+adlb_code
+ADLBP_Put_batch(const adlb_put_spec *tasks, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    ADLB_CHECK_MSG(tasks[i].wait_id_count == 0 &&
+                   tasks[i].wait_id_sub_count == 0,
+        "ADLB_Put_batch(): task %i has wait ids: use ADLB_Dput_batch", i);
+  }
+
+  return ADLBP_Dput_batch(tasks, count);
+}
+
+adlb_code
+ADLBP_Dput_batch(const adlb_put_spec *tasks, int count)
+{
+  XLB_WRITE_BUFFER_SYNC();
+
+  DEBUG("ADLB_Dput_batch: %i tasks", count);
+
+  // Records start after header
+  struct packed_batch_hdr *hdr =
+        (struct packed_batch_hdr*)xlb_xfer;
+  dput_batcher b = { .send = send_dput_batch,
+                     .put_one = dput_batch_task, .ctx = NULL };
+  adlb_code rc = batch_dputs(tasks, count, (char*)hdr->records, &b);
+  ADLB_CHECK(rc);
+
+  TRACE("ADLB_Dput_batch: DONE");
+  return ADLB_SUCCESS;
+}
+
+/** Shared inputs of ADLB_Dput_group() */
+typedef struct
+{
+  const adlb_datum_id *ids;
+  int id_count;
+  const adlb_datum_id_sub *id_subs;
+  int id_sub_count;
+  /** True if shared inputs are packed in header in xlb_xfer */
+  bool packed;
+} dput_group_shared;
+
+/*
+  Pack shared inputs of group into header in xlb_xfer
+  Returns start of records
+ */
+static char *
+pack_dput_group_hdr(const dput_group_shared *shared)
+{
+  struct packed_dput_group_hdr *hdr =
+        (struct packed_dput_group_hdr*)xlb_xfer;
+  hdr->shared_id_count = shared->id_count;
+  hdr->shared_id_sub_count = shared->id_sub_count;
+
+  char *pos = (char*)hdr->shared_ids;
+  size_t ids_len = sizeof(shared->ids[0]) * (size_t)shared->id_count;
+  if (ids_len > 0)
+  {
+    memcpy(pos, shared->ids, ids_len);
+  }
+  pos += ids_len;
+
+  for (int i = 0; i < shared->id_sub_count; i++)
+  {
+    pos += xlb_pack_id_sub(pos, shared->id_subs[i].id,
+                           shared->id_subs[i].subscript);
+  }
+
+  return (char*)hdr->shared_ids +
+          PACKED_BATCH_PAD((size_t)(pos - (char*)hdr->shared_ids));
+}
+
+/*
+  Send group of dput requests packed into xlb_xfer
+ */
+static adlb_code
+send_dput_group(int to_server, int count, size_t bytes, void *ctx)
+{
+  MPI_Status status;
+  MPI_Request request;
+  int response;
+
+  DEBUG("ADLB_Dput_group: %i tasks (%zu bytes) to server %i",
+        count, bytes, to_server);
+
+  struct packed_dput_group_hdr *hdr =
+        (struct packed_dput_group_hdr*)xlb_xfer;
+  hdr->count = count;
+
+  assert(bytes <= ADLB_XFER_SIZE);
+  IRECV(&response, 1, MPI_INT, to_server, ADLB_TAG_RESPONSE_PUT);
+  SEND(xlb_xfer, (int)bytes, MPI_BYTE, to_server, ADLB_TAG_DPUT_GROUP);
+  WAIT(&request, &status);
+
+  ADLB_CHECK((adlb_code)response);
+  return ADLB_SUCCESS;
+}
+
+/*
+  Put task of group by itself, waiting for the shared inputs as well
+  as its own
+ */
+static adlb_code
+dput_group_task(const adlb_put_spec *t, void *ctx)
+{
+  const dput_group_shared *shared = ctx;
+  int id_count = shared->id_count + t->wait_id_count;
+  int id_sub_count = shared->id_sub_count + t->wait_id_sub_count;
+  adlb_datum_id ids[id_count + 1];
+  adlb_datum_id_sub id_subs[id_sub_count + 1];
+
+  for (int i = 0; i < shared->id_count; i++)
+    ids[i] = shared->ids[i];
+  for (int i = 0; i < t->wait_id_count; i++)
+    ids[shared->id_count + i] = t->wait_ids[i];
+  for (int i = 0; i < shared->id_sub_count; i++)
+    id_subs[i] = shared->id_subs[i];
+  for (int i = 0; i < t->wait_id_sub_count; i++)
+    id_subs[shared->id_sub_count + i] = t->wait_id_subs[i];
+
+  adlb_code rc = ADLBP_Dput(t->payload, t->length, t->target,
+          t->answer, t->type, t->opts, t->name, ids, id_count,
+          id_subs, id_sub_count);
+  ADLB_CHECK(rc);
+
+  if (shared->packed)
+  {
+    // ADLB_Dput overwrote xlb_xfer
+    pack_dput_group_hdr(shared);
+  }
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+ADLBP_Dput_group(const adlb_datum_id *shared_ids,
+        int shared_id_count, const adlb_datum_id_sub *shared_id_subs,
+        int shared_id_sub_count, const adlb_put_spec *tasks, int count)
+{
+  XLB_WRITE_BUFFER_SYNC();
+
+  DEBUG("ADLB_Dput_group: %i tasks, %i shared inputs", count,
+        shared_id_count + shared_id_sub_count);
+
+  size_t shared_size = sizeof(struct packed_dput_group_hdr) +
+          sizeof(adlb_datum_id) * (size_t)shared_id_count;
+  for (int i = 0; i < shared_id_sub_count; i++)
+  {
+    shared_size += xlb_pack_id_sub_size(shared_id_subs[i].subscript);
+  }
+
+  dput_group_shared shared = { .ids = shared_ids,
+      .id_count = shared_id_count, .id_subs = shared_id_subs,
+      .id_sub_count = shared_id_sub_count,
+      // Leave at least half of buffer for records
+      .packed = shared_size <= ADLB_XFER_SIZE / 2 };
+
+  char *batch_start = NULL;
+  if (shared.packed)
+  {
+    batch_start = pack_dput_group_hdr(&shared);
+  }
+
+  dput_batcher b = { .send = send_dput_group,
+                     .put_one = dput_group_task, .ctx = &shared };
+  adlb_code rc = batch_dputs(tasks, count, batch_start, &b);
+  ADLB_CHECK(rc);
+
+  TRACE("ADLB_Dput_group: DONE");
+  return ADLB_SUCCESS;
+}
+
 adlb_code
 ADLBP_Get(int type_requested, void** payload,
           int* length, int max_length,
@@ -525,6 +896,8 @@ ADLBP_Get(int type_requested, void** payload,
   MPI_Status status;
   MPI_Request request;
 
+  XLB_WRITE_BUFFER_SYNC();
+
   TRACE_START;
 
   ADLB_CHECK_MSG(type_requested >= 0 && type_requested < xlb_s.types_size,
@@ -616,6 +989,8 @@ ADLBP_Iget(int type_requested, void* payload, int* length,
   MPI_Status status;
   MPI_Request request;
 
+  XLB_WRITE_BUFFER_SYNC();
+
   ADLB_CHECK_MSG(type_requested >= 0 && type_requested < xlb_s.types_size,
             "ADLB_Iget(): Bad work type: %i\n", type_requested);
 
@@ -798,6 +1173,9 @@ adlb_code ADLBP_Amget(int type_requested, int nreqs, bool wait,
                       adlb_get_req *reqs)
 {
   adlb_code ac;
+
+  XLB_WRITE_BUFFER_SYNC();
+
   assert(nreqs >= 0);
   if (nreqs <= 0)
   {
@@ -1107,7 +1485,8 @@ ADLBP_Create_impl(adlb_datum_id id, adlb_data_type type,
   if (id != ADLB_DATA_ID_NULL) {
     to_server_rank = ADLB_Locate(id);
   } else {
-    to_server_rank = choose_data_server(props.placement);
+    adlb_code rc = choose_data_server(&props, &to_server_rank);
+    ADLB_CHECK(rc);
   }
 
   if (to_server_rank == xlb_s.layout.rank)
@@ -1189,7 +1568,9 @@ adlb_code ADLBP_Multicreate(ADLB_create_spec *specs, int count)
   for (int i = 0; i < count; i++) {
     tmp_specs[i].idx = i;
     tmp_specs[i].spec = specs[i];
-    tmp_specs[i].server = choose_data_server(specs[i].props.placement);
+    adlb_code rc = choose_data_server(&specs[i].props,
+                                      &tmp_specs[i].server);
+    ADLB_CHECK(rc);
   }
 
   // Sort so that we can send them to servers in batches
@@ -1317,6 +1698,8 @@ ADLBP_Exists(adlb_datum_id id, adlb_subscript subscript, bool* result,
 {
   int to_server_rank = ADLB_Locate(id);
 
+  XLB_WRITE_BUFFER_SYNC();
+
   MPI_Status status;
   MPI_Request request;
 
@@ -1347,6 +1730,8 @@ ADLBP_Refcount_get(adlb_datum_id id, adlb_refc *result,
 {
   int to_server_rank = ADLB_Locate(id);
 
+  XLB_WRITE_BUFFER_SYNC();
+
   MPI_Status status;
   MPI_Request request;
 
@@ -1376,6 +1761,8 @@ ADLBP_Store(adlb_datum_id id, adlb_subscript subscript,
   adlb_notif_t notifs = ADLB_NO_NOTIFS;
   adlb_code rc, final_rc;
 
+  XLB_WRITE_BUFFER_SYNC();
+
   final_rc = xlb_store(id, subscript, type, data, length, refcount_decr,
                        store_refcounts, &notifs);
   ADLB_CHECK(final_rc); // Check for ADLB_ERROR, not other codes
@@ -1388,6 +1775,27 @@ ADLBP_Store(adlb_datum_id id, adlb_subscript subscript,
   return final_rc;
 }
 
+adlb_code
+ADLBP_Store_buffered(adlb_datum_id id, adlb_subscript subscript,
+          adlb_data_type type, const void *data, size_t length,
+          adlb_refc refcount_decr, adlb_refc store_refcounts)
+{
+  return xlb_write_buffer_store(id, subscript, type, data, length,
+                                refcount_decr, store_refcounts);
+}
+
+adlb_code
+ADLBP_Refcount_decr_buffered(adlb_datum_id id, adlb_refc decr)
+{
+  return xlb_write_buffer_refc_decr(id, decr);
+}
+
+adlb_code
+ADLBP_Flush_writes(void)
+{
+  return xlb_write_buffer_flush();
+}
+
 adlb_code
 xlb_store(adlb_datum_id id, adlb_subscript subscript,
           adlb_data_type type, const void *data, size_t length,
@@ -1446,6 +1854,14 @@ xlb_store(adlb_datum_id id, adlb_subscript subscript,
   };
   struct packed_store_resp resp;
 
+  // Server reads large payload directly from our buffer
+  bool rma = xlb_rma_use(length);
+  if (rma)
+  {
+    code = xlb_rma_expose(data, length, &hdr.rma_addr);
+    ADLB_CHECK(code);
+  }
+
   IRECV(&resp, sizeof(resp), MPI_BYTE, to_server_rank,
         ADLB_TAG_RESPONSE);
   SEND(&hdr, sizeof(struct packed_store_hdr), MPI_BYTE,
@@ -1455,10 +1871,19 @@ xlb_store(adlb_datum_id id, adlb_subscript subscript,
     SEND(subscript.key, (int)subscript.length, MPI_BYTE, to_server_rank,
          ADLB_TAG_STORE_SUBSCRIPT);
   }
-  mpi_send_big(data, length, to_server_rank, ADLB_TAG_STORE_PAYLOAD);
+  if (!rma)
+  {
+    mpi_send_big(data, length, to_server_rank, ADLB_TAG_STORE_PAYLOAD);
+  }
 
   WAIT(&request, &status);
 
+  if (rma)
+  {
+    code = xlb_rma_unexpose(data);
+    ADLB_CHECK(code);
+  }
+
   if (resp.dc == ADLB_DATA_ERROR_DOUBLE_WRITE)
     return ADLB_REJECTED;
   ADLB_DATA_CHECK(resp.dc);
@@ -1487,26 +1912,41 @@ get_next_server()
 /**
   Choose server to create data on
  */
-static inline int
-choose_data_server(adlb_placement placement)
+static inline adlb_code
+choose_data_server(const adlb_create_props *props, int *server)
 {
-  int server;
+  adlb_placement placement = props->placement;
   if (placement == ADLB_PLACE_DEFAULT)
     placement = xlb_s.placement;
 
+  int64_t arg = props->placement_arg;
   switch (placement)
   {
     case ADLB_PLACE_LOCAL:
-      server = xlb_s.layout.my_server;
+      *server = xlb_s.layout.my_server;
+      break;
+    case ADLB_PLACE_DATUM:
+      ADLB_CHECK_MSG(arg != ADLB_DATA_ID_NULL,
+                     "Placement near null datum ID");
+      *server = ADLB_Locate(arg);
+      break;
+    case ADLB_PLACE_RANK:
+      ADLB_CHECK_MSG(arg >= 0 && arg < xlb_s.layout.size,
+                     "Invalid rank for placement: %"PRId64, arg);
+      *server = xlb_map_to_server(&xlb_s.layout, (int)arg);
+      break;
+    case ADLB_PLACE_HASH:
+      *server = xlb_s.layout.master_server_rank +
+            (int)((uint64_t)arg % (uint64_t)xlb_s.layout.servers);
       break;
     case ADLB_PLACE_DEFAULT:
     case ADLB_PLACE_RANDOM:
     default:
-      server = xlb_random_server();
+      *server = xlb_random_server();
       break;
   }
 
-  return server;
+  return ADLB_SUCCESS;
 }
 
 adlb_code
@@ -1521,6 +1961,8 @@ ADLBP_Refcount_incr(adlb_datum_id id, adlb_refc change)
 {
   adlb_code rc;
 
+  XLB_WRITE_BUFFER_SYNC();
+
   adlb_notif_t notifs = ADLB_NO_NOTIFS;
   rc = xlb_refcount_incr(id, change, &notifs);
   ADLB_CHECK(rc);
@@ -1585,6 +2027,8 @@ ADLBP_Insert_atomic(adlb_datum_id id, adlb_subscript subscript,
   MPI_Request request;
   struct packed_insert_atomic_resp resp;
 
+  XLB_WRITE_BUFFER_SYNC();
+
   DEBUG("ADLB_Insert_atomic: "ADLB_PRIDSUB,
         ADLB_PRIDSUB_ARGS(id, ADLB_DSYM_NULL, subscript));
   char *xfer_pos = xlb_xfer;
@@ -1640,6 +2084,8 @@ ADLBP_Retrieve(adlb_datum_id id, adlb_subscript subscript,
   MPI_Status status;
   MPI_Request request;
 
+  XLB_WRITE_BUFFER_SYNC();
+
   int to_server_rank = ADLB_Locate(id);
 
   size_t subscript_len = adlb_has_sub(subscript) ?
@@ -1677,8 +2123,20 @@ ADLBP_Retrieve(adlb_datum_id id, adlb_subscript subscript,
   }
 
   assert(resp_hdr.length <= ADLB_PAYLOAD_MAX);
-  mpi_recv_big(data, resp_hdr.length, to_server_rank,
-               ADLB_TAG_RESPONSE);
+  if (resp_hdr.rma_addr != 0)
+  {
+    // Read large value directly, then let server release it
+    adlb_code ac = xlb_rma_read(data, resp_hdr.length, to_server_rank,
+                                resp_hdr.rma_addr);
+    ADLB_CHECK(ac);
+    SEND(&resp_hdr.rma_addr, sizeof(resp_hdr.rma_addr), MPI_BYTE,
+         to_server_rank, ADLB_TAG_RMA_DONE);
+  }
+  else
+  {
+    mpi_recv_big(data, resp_hdr.length, to_server_rank,
+                 ADLB_TAG_RESPONSE);
+  }
   // Set length and type output parameters
   *length = resp_hdr.length;
   *type = resp_hdr.type;
@@ -1690,6 +2148,235 @@ ADLBP_Retrieve(adlb_datum_id id, adlb_subscript subscript,
   return ADLB_SUCCESS;
 }
 
+/**
+   Pack retrieve requests for one server into xlb_xfer, starting at
+   order[*pos] and stopping at end or when the buffer is full.
+   Updates *pos to next unpacked spec.
+   return: bytes packed
+ */
+static size_t
+pack_retrieve_multi(const adlb_retrieve_spec *specs, const int *order,
+                    int *pos, int end)
+{
+  struct packed_batch_hdr *hdr = (struct packed_batch_hdr*)xlb_xfer;
+  char *p = (char*)hdr->records;
+  const char *buf_end = xlb_xfer + ADLB_XFER_SIZE;
+
+  hdr->count = 0;
+  while (*pos < end)
+  {
+    const adlb_retrieve_spec *spec = &specs[order[*pos]];
+    size_t sub_len = adlb_has_sub(spec->subscript) ?
+                     spec->subscript.length : 0;
+    size_t rec_len = PACKED_BATCH_PAD(
+                      sizeof(struct packed_retrieve_hdr) + sub_len);
+    if (p + rec_len > buf_end)
+    {
+      break;
+    }
+
+    struct packed_retrieve_hdr *rec = (struct packed_retrieve_hdr*)p;
+    rec->id = spec->id;
+    rec->refcounts = spec->refcounts;
+    rec->subscript_len = sub_len;
+    if (sub_len > 0)
+    {
+      memcpy(rec->subscript, spec->subscript.key, sub_len);
+    }
+
+    p += rec_len;
+    hdr->count++;
+    (*pos)++;
+  }
+
+  return (size_t)(p - xlb_xfer);
+}
+
+/**
+   Unpack response to ADLB_TAG_RETRIEVE_MULTI into results for specs
+   order[start..end-1].  Data pointers are set to offsets into
+   storage, fixed up by caller once all data is received.
+ */
+static void
+unpack_retrieve_multi(const char *resp, size_t resp_len,
+          size_t storage_offset, const int *order, int start, int end,
+          adlb_retrieve_result *results)
+{
+  size_t pos = 0;
+  for (int i = start; i < end; i++)
+  {
+    assert(pos < resp_len);
+
+    const struct retrieve_multi_resp_rec *rec =
+          (const struct retrieve_multi_resp_rec*)(resp + pos);
+    adlb_retrieve_result *r = &results[order[i]];
+    size_t data_pos = pos + PACKED_BATCH_PAD(sizeof(*rec));
+
+    r->type = rec->type;
+    r->length = rec->length;
+    r->data = (void*)(storage_offset + data_pos);
+    if (rec->code == ADLB_DATA_SUCCESS)
+    {
+      r->code = ADLB_SUCCESS;
+    }
+    else if (rec->code == ADLB_DATA_ERROR_NOT_FOUND ||
+             rec->code == ADLB_DATA_ERROR_SUBSCRIPT_NOT_FOUND)
+    {
+      r->code = ADLB_NOTHING;
+    }
+    else
+    {
+      r->code = ADLB_ERROR;
+    }
+
+    pos = data_pos + PACKED_BATCH_PAD(rec->length);
+  }
+}
+
+adlb_code
+ADLBP_Retrieve_multi(const adlb_retrieve_spec *specs, int count,
+                     adlb_retrieve_result *results, void **storage)
+{
+  adlb_code rc;
+  MPI_Status status;
+
+  XLB_WRITE_BUFFER_SYNC();
+
+  *storage = NULL;
+  if (count <= 0)
+  {
+    return ADLB_SUCCESS;
+  }
+
+  DEBUG("ADLB_Retrieve_multi: %i", count);
+
+  // Group specs by server with counting sort.  Specs for server s are
+  // order[server_start[s]..server_start[s+1]-1]
+  int nservers = xlb_s.layout.servers;
+  int *server_start = calloc((size_t)nservers + 1, sizeof(int));
+  int *server_pos = malloc(sizeof(int) * (size_t)nservers);
+  int *order = malloc(sizeof(int) * (size_t)count);
+  MPI_Request *reqs = malloc(sizeof(MPI_Request) * (size_t)nservers);
+  struct retrieve_multi_resp_hdr *resp_hdrs =
+      malloc(sizeof(resp_hdrs[0]) * (size_t)nservers);
+  int *req_servers = malloc(sizeof(int) * (size_t)nservers);
+  int *req_starts = malloc(sizeof(int) * (size_t)nservers);
+  ADLB_CHECK_MALLOC(server_start);
+  ADLB_CHECK_MALLOC(server_pos);
+  ADLB_CHECK_MALLOC(order);
+  ADLB_CHECK_MALLOC(reqs);
+  ADLB_CHECK_MALLOC(resp_hdrs);
+  ADLB_CHECK_MALLOC(req_servers);
+  ADLB_CHECK_MALLOC(req_starts);
+
+  for (int i = 0; i < count; i++)
+  {
+    int server = ADLB_Locate(specs[i].id) - xlb_s.layout.workers;
+    server_start[server + 1]++;
+  }
+  for (int s = 0; s < nservers; s++)
+  {
+    server_start[s + 1] += server_start[s];
+    server_pos[s] = server_start[s];
+  }
+  for (int i = 0; i < count; i++)
+  {
+    int server = ADLB_Locate(specs[i].id) - xlb_s.layout.workers;
+    order[server_pos[server]++] = i;
+  }
+  for (int s = 0; s < nservers; s++)
+  {
+    server_pos[s] = server_start[s];
+  }
+
+  // Data for all results, with pointers stored as offsets until done
+  adlb_buffer data = { .data = NULL, .length = 0 };
+  size_t data_len = 0;
+
+  adlb_notif_t notifs = ADLB_NO_NOTIFS;
+
+  // Each round sends at most one request to each server, so that a
+  // server is never blocked sending us a response while we block
+  // sending it another request.  Usually one round is enough.
+  bool done = false;
+  while (!done)
+  {
+    int nreqs = 0;
+    for (int s = 0; s < nservers; s++)
+    {
+      if (server_pos[s] == server_start[s + 1])
+        continue;
+
+      int to_server_rank = s + xlb_s.layout.workers;
+      req_servers[nreqs] = s;
+      req_starts[nreqs] = server_pos[s];
+      size_t req_len = pack_retrieve_multi(specs, order, &server_pos[s],
+                                           server_start[s + 1]);
+      ADLB_CHECK_MSG(server_pos[s] > req_starts[nreqs],
+                     "ADLB_Retrieve_multi: request too large");
+
+      IRECV2(&resp_hdrs[nreqs], sizeof(resp_hdrs[nreqs]), MPI_BYTE,
+             to_server_rank, ADLB_TAG_RESPONSE, &reqs[nreqs]);
+      SEND(xlb_xfer, (int)req_len, MPI_BYTE, to_server_rank,
+           ADLB_TAG_RETRIEVE_MULTI);
+      nreqs++;
+    }
+
+    // Receive responses in whatever order they arrive
+    for (int i = 0; i < nreqs; i++)
+    {
+      int k;
+      int mpi_rc = MPI_Waitany(nreqs, reqs, &k, &status);
+      MPI_CHECK(mpi_rc);
+
+      int s = req_servers[k];
+      int from_server_rank = s + xlb_s.layout.workers;
+      size_t resp_len = resp_hdrs[k].length;
+
+      adlb_data_code dc = ADLB_Resize_buf(&data, NULL,
+                                          data_len + resp_len);
+      ADLB_DATA_CHECK(dc);
+
+      rc = mpi_recv_big(data.data + data_len, resp_len,
+                        from_server_rank, ADLB_TAG_RESPONSE);
+      ADLB_CHECK(rc);
+
+      // Request covered specs up to where next request will start
+      unpack_retrieve_multi(data.data + data_len, resp_len,
+                  data_len, order, req_starts[k], server_pos[s], results);
+      data_len += resp_len;
+
+      rc = xlb_recv_notif_work(&resp_hdrs[k].notifs, from_server_rank,
+                               &notifs);
+      ADLB_CHECK(rc);
+    }
+
+    done = (nreqs == 0);
+  }
+
+  // Convert offsets to pointers now that data won't move
+  for (int i = 0; i < count; i++)
+  {
+    results[i].data = data.data + (size_t)results[i].data;
+  }
+  *storage = data.data;
+
+  free(server_start);
+  free(server_pos);
+  free(order);
+  free(reqs);
+  free(resp_hdrs);
+  free(req_servers);
+  free(req_starts);
+
+  // Process notifications only once all servers have responded
+  rc = xlb_notify_all(&notifs);
+  ADLB_CHECK(rc);
+  xlb_free_notif(&notifs);
+
+  return ADLB_SUCCESS;
+}
+
 /**
    Allocates fresh memory in subscripts and members
    Caller must free this when done
@@ -1704,6 +2391,8 @@ ADLBP_Enumerate(adlb_datum_id container_id,
   MPI_Status status;
   MPI_Request request;
 
+  XLB_WRITE_BUFFER_SYNC();
+
   int to_server_rank = ADLB_Locate(container_id);
 
   struct packed_enumerate opts;
@@ -1744,6 +2433,158 @@ ADLBP_Enumerate(adlb_datum_id container_id,
     return ADLB_ERROR;
 }
 
+adlb_code
+ADLBP_Retrieve_array(adlb_datum_id id, adlb_refc decr,
+                     adlb_data_type *type, void **data, int *count)
+{
+  MPI_Status status;
+  MPI_Request request;
+
+  XLB_WRITE_BUFFER_SYNC();
+
+  int to_server_rank = ADLB_Locate(id);
+
+  struct packed_retrieve_array req = { .id = id, .decr = decr };
+  struct packed_retrieve_array_result res;
+  IRECV(&res, sizeof(res), MPI_BYTE, to_server_rank, ADLB_TAG_RESPONSE);
+  SEND(&req, sizeof(req), MPI_BYTE, to_server_rank,
+       ADLB_TAG_RETRIEVE_ARRAY);
+  WAIT(&request, &status);
+
+  if (res.dc != ADLB_DATA_SUCCESS)
+    return ADLB_ERROR;
+
+  *type = res.type;
+  *count = res.count;
+  *data = NULL;
+  if (res.length > 0)
+  {
+    *data = malloc(res.length);
+    ADLB_CHECK_MALLOC(*data);
+    adlb_code ac = mpi_recv_big(*data, res.length, to_server_rank,
+                                ADLB_TAG_RESPONSE);
+    ADLB_CHECK(ac);
+  }
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+ADLBP_Enumerate_next(adlb_datum_id container_id, int64_t *cursor,
+                int count, adlb_refc decr,
+                bool include_keys, bool include_vals,
+                void** data, size_t* length, int* records,
+                adlb_type_extra *kv_type)
+{
+  MPI_Status status;
+  MPI_Request request;
+
+  XLB_WRITE_BUFFER_SYNC();
+
+  int to_server_rank = ADLB_Locate(container_id);
+
+  struct packed_enumerate_cursor opts;
+  opts.id = container_id;
+  opts.cursor = *cursor;
+  opts.count = count;
+  opts.request_subscripts = include_keys;
+  opts.request_members = include_vals;
+  opts.close = false;
+  opts.decr = decr;
+
+  struct packed_enumerate_cursor_result res;
+  IRECV(&res, sizeof(res), MPI_BYTE, to_server_rank, ADLB_TAG_RESPONSE);
+  SEND(&opts, sizeof(opts), MPI_BYTE, to_server_rank,
+       ADLB_TAG_ENUMERATE_CURSOR);
+  WAIT(&request,&status);
+
+  if (res.res.dc != ADLB_DATA_SUCCESS)
+    return ADLB_ERROR;
+
+  *cursor = res.cursor;
+  *records = res.res.records;
+  *length = res.res.length;
+  if (include_keys || include_vals)
+  {
+    *data = malloc(res.res.length);
+    ADLB_CHECK_MALLOC(*data);
+
+    adlb_code ac = mpi_recv_big(*data, res.res.length,
+                                to_server_rank, ADLB_TAG_RESPONSE);
+    ADLB_CHECK(ac);
+  }
+  kv_type->valid = true;
+  kv_type->CONTAINER.key_type = res.res.key_type;
+  kv_type->CONTAINER.val_type = res.res.val_type;
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+ADLBP_Enumerate_close(adlb_datum_id container_id, int64_t cursor,
+                      adlb_refc decr)
+{
+  MPI_Status status;
+  MPI_Request request;
+
+  XLB_WRITE_BUFFER_SYNC();
+
+  int to_server_rank = ADLB_Locate(container_id);
+
+  struct packed_enumerate_cursor opts;
+  memset(&opts, 0, sizeof(opts));
+  opts.id = container_id;
+  opts.cursor = cursor;
+  opts.close = true;
+  opts.decr = decr;
+
+  struct packed_enumerate_cursor_result res;
+  IRECV(&res, sizeof(res), MPI_BYTE, to_server_rank, ADLB_TAG_RESPONSE);
+  SEND(&opts, sizeof(opts), MPI_BYTE, to_server_rank,
+       ADLB_TAG_ENUMERATE_CURSOR);
+  WAIT(&request,&status);
+
+  if (res.res.dc != ADLB_DATA_SUCCESS)
+    return ADLB_ERROR;
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+ADLBP_Reduce(adlb_datum_id id, adlb_reduce_op op, adlb_refc decr,
+             adlb_data_type *type, void **result, size_t *length)
+{
+  MPI_Status status;
+  MPI_Request request;
+
+  XLB_WRITE_BUFFER_SYNC();
+
+  int to_server_rank = ADLB_Locate(id);
+
+  struct packed_reduce req = { .id = id, .op = op, .decr = decr };
+  struct packed_reduce_result res;
+  IRECV(&res, sizeof(res), MPI_BYTE, to_server_rank, ADLB_TAG_RESPONSE);
+  SEND(&req, sizeof(req), MPI_BYTE, to_server_rank, ADLB_TAG_REDUCE);
+  WAIT(&request, &status);
+
+  if (res.dc != ADLB_DATA_SUCCESS)
+    return ADLB_ERROR;
+
+  *type = res.type;
+  *length = res.length;
+  *result = NULL;
+  if (res.length > 0)
+  {
+    *result = malloc(res.length);
+    ADLB_CHECK_MALLOC(*result);
+
+    adlb_code ac = mpi_recv_big(*result, res.length,
+                                to_server_rank, ADLB_TAG_RESPONSE);
+    ADLB_CHECK(ac);
+  }
+
+  DEBUG("ADLB_Reduce: "ADLB_PRID" op %i => %zu bytes",
+        ADLB_PRID_ARGS(id, ADLB_DSYM_NULL), (int)op, res.length);
+  return ADLB_SUCCESS;
+}
+
 adlb_code
 ADLBP_Unique(adlb_datum_id* result)
 {
@@ -1872,6 +2713,8 @@ ADLBP_Subscribe(adlb_datum_id id, adlb_subscript subscript,
   MPI_Status status;
   MPI_Request request;
 
+  XLB_WRITE_BUFFER_SYNC();
+
   to_server_rank = ADLB_Locate(id);
 
   char *xfer_pos = xlb_xfer;
@@ -1938,6 +2781,8 @@ ADLBP_Container_reference(adlb_datum_id id, adlb_subscript subscript,
   MPI_Status status;
   MPI_Request request;
 
+  XLB_WRITE_BUFFER_SYNC();
+
   char *xfer_pos = xlb_xfer;
 
   MSG_PACK_BIN(xfer_pos, ref_type);
@@ -1982,6 +2827,8 @@ ADLBP_Container_size(adlb_datum_id container_id, int* size,
   MPI_Status status;
   MPI_Request request;
 
+  XLB_WRITE_BUFFER_SYNC();
+
   int to_server_rank = ADLB_Locate(container_id);
 
   struct packed_size_req req = { .id = container_id, .decr = decr };
@@ -2007,6 +2854,8 @@ ADLBP_Lock(adlb_datum_id id, bool* result)
   MPI_Status status;
   MPI_Request request;
 
+  XLB_WRITE_BUFFER_SYNC();
+
   int to_server_rank = ADLB_Locate(id);
 
   // c 0->try again, 1->locked, x->failed
@@ -2037,6 +2886,8 @@ ADLBP_Unlock(adlb_datum_id id)
   MPI_Status status;
   MPI_Request request;
 
+  XLB_WRITE_BUFFER_SYNC();
+
   int to_server_rank = ADLB_Locate(id);
 
   // c: 1->success, x->failed
@@ -2107,6 +2958,10 @@ ADLBP_Finalize()
   ADLB_CHECK_MSG(!flag,
             "ERROR: MPI_Finalize() called before ADLB_Finalize()\n");
 
+  // Send any buffered writes while servers are still running
+  rc = xlb_write_buffer_finalize();
+  ADLB_CHECK(rc);
+
 #ifdef XLB_ENABLE_XPT
   // Finalize checkpoints before shutting down data
   ADLB_Xpt_finalize();
@@ -2116,6 +2971,9 @@ ADLBP_Finalize()
   if (dc != ADLB_DATA_SUCCESS)
     xlb_server_fail(1);
 
+  // Data module is done with slab memory
+  xlb_slabs_finalize();
+
   if (xlb_s.layout.rank >= xlb_s.layout.master_server_rank)
   {
     // Server:
@@ -2124,6 +2982,7 @@ ADLBP_Finalize()
   else
   {
     // Worker:
+    xlb_print_notif_counters();
     if (!got_shutdown)
     {
       rc = ADLB_Shutdown();
@@ -2148,6 +3007,10 @@ ADLBP_Finalize()
   rc = xlb_get_reqs_finalize();
   ADLB_CHECK(rc);
 
+  // Collective: all ranks are done with data transfers
+  rc = xlb_rma_finalize();
+  ADLB_CHECK(rc);
+
   // Get messaging module to clean up state
   xlb_msg_finalize();
 
@@ -96,6 +96,47 @@ adlb_code ADLB_Dput(const void* payload, int length, int target,
         const adlb_datum_id *wait_ids, int wait_id_count, 
         const adlb_datum_id_sub *wait_id_subs, int wait_id_sub_count);
 
+/*
+  Put a batch of tasks into the global task queue.  Tasks going to the
+  same server are packed into as few messages as possible, rather than
+  one round trip per task.  Tasks must not have wait ids or subscripts:
+  use ADLB_Dput_batch for data-dependent tasks.
+  @param tasks: array of tasks
+  @param count: length of tasks array
+ */
+adlb_code ADLBP_Put_batch(const adlb_put_spec *tasks, int count);
+adlb_code ADLB_Put_batch(const adlb_put_spec *tasks, int count);
+
+/*
+  Put a batch of data-dependent tasks into the global task queue.
+  Equivalent to calling ADLB_Dput for each task in order, but tasks
+  going to the same server are sent together.
+  @param tasks: array of tasks
+  @param count: length of tasks array
+ */
+adlb_code ADLBP_Dput_batch(const adlb_put_spec *tasks, int count);
+adlb_code ADLB_Dput_batch(const adlb_put_spec *tasks, int count);
+
+/*
+  Put a group of data-dependent tasks that all wait for the same shared
+  inputs, e.g. the iterations of a foreach loop.  Equivalent to calling
+  ADLB_Dput for each task with the shared ids and id/subscript pairs
+  added to its own, but each server subscribes to the shared inputs
+  once for all of the tasks it receives.
+  @param shared_ids: array of ids all tasks wait for
+  @param shared_id_count: length of shared_ids array
+  @param shared_id_subs: array of id/subscript pairs all tasks wait for
+  @param shared_id_sub_count: length of shared_id_subs array
+  @param tasks: array of tasks, with their own wait ids/subscripts
+  @param count: length of tasks array
+ */
+adlb_code ADLBP_Dput_group(const adlb_datum_id *shared_ids,
+        int shared_id_count, const adlb_datum_id_sub *shared_id_subs,
+        int shared_id_sub_count, const adlb_put_spec *tasks, int count);
+adlb_code ADLB_Dput_group(const adlb_datum_id *shared_ids,
+        int shared_id_count, const adlb_datum_id_sub *shared_id_subs,
+        int shared_id_sub_count, const adlb_put_spec *tasks, int count);
+
 /*
   Get a task from the global task queue.
   @param type_requested: the type of work requested
@@ -296,6 +337,36 @@ adlb_code ADLB_Store(adlb_datum_id id, adlb_subscript subscript,
           adlb_data_type type, const void *data, size_t length,
           adlb_refc refcount_decr, adlb_refc store_refcounts);
 
+/*
+  Buffered variant of ADLB_Store for many small values.  The store
+  may be delayed until the write buffer for the destination server
+  fills, ADLB_WRITE_BUFFER_DELAY expires, this client requests a task,
+  or this client makes an unbuffered data call.
+  returns: ADLB_SUCCESS if stored or buffered
+           ADLB_REJECTED if this or an earlier buffered store was
+                         rejected
+           ADLB_ERROR for other errors
+ */
+adlb_code ADLBP_Store_buffered(adlb_datum_id id, adlb_subscript subscript,
+          adlb_data_type type, const void *data, size_t length,
+          adlb_refc refcount_decr, adlb_refc store_refcounts);
+adlb_code ADLB_Store_buffered(adlb_datum_id id, adlb_subscript subscript,
+          adlb_data_type type, const void *data, size_t length,
+          adlb_refc refcount_decr, adlb_refc store_refcounts);
+
+/*
+  Decrement refcounts by decr, buffered like ADLB_Store_buffered
+ */
+adlb_code ADLBP_Refcount_decr_buffered(adlb_datum_id id, adlb_refc decr);
+adlb_code ADLB_Refcount_decr_buffered(adlb_datum_id id, adlb_refc decr);
+
+/*
+  Send all buffered writes from this client
+  returns: ADLB_REJECTED if a buffered store was rejected
+ */
+adlb_code ADLBP_Flush_writes(void);
+adlb_code ADLB_Flush_writes(void);
+
 /*
    Retrieve contents of datum.
     
@@ -314,6 +385,24 @@ adlb_code ADLB_Retrieve(adlb_datum_id id, adlb_subscript subscript,
       adlb_retrieve_refc refcounts, adlb_data_type* type,
       void* data, size_t* length);
 
+/*
+   Retrieve contents of several datums.  Requests are grouped by
+   server and sent to all servers before waiting for any response,
+   so this takes about one round trip rather than one per datum.
+   specs: array of datums to retrieve, with refcount changes as for
+          ADLB_Retrieve
+   count: length of specs and results arrays
+   results: output array with code, type and data for each spec
+   storage: output arg for memory holding all result data, to be
+          freed by caller with free().  Set to NULL if no data.
+   returns: ADLB_SUCCESS if all requests were made, even if some
+            individual retrieves failed, or ADLB_ERROR
+ */
+adlb_code ADLBP_Retrieve_multi(const adlb_retrieve_spec *specs,
+      int count, adlb_retrieve_result *results, void **storage);
+adlb_code ADLB_Retrieve_multi(const adlb_retrieve_spec *specs,
+      int count, adlb_retrieve_result *results, void **storage);
+
 /*
    List contents of container
    
@@ -337,6 +426,54 @@ adlb_code ADLB_Enumerate(adlb_datum_id container_id,
                    void** data, size_t* length, int* records,
                    adlb_type_extra *kv_type);
 
+/*
+   Retrieve values of container with integer keys and integer or float
+   values as an array of int64_t or double, where element i holds the
+   value with subscript i.  Subscripts must be exactly 0..count-1, in
+   the decimal string form used by Turbine, all set.  The server copies
+   the values out in one pass, without packing each member.
+   decr: decrement refcounts of container after retrieval
+   type: output arg for value type
+   data: output arg for array, to be freed by caller, NULL if count is 0
+   count: output arg for number of elements
+ */
+adlb_code ADLBP_Retrieve_array(adlb_datum_id id, adlb_refc decr,
+                   adlb_data_type *type, void **data, int *count);
+adlb_code ADLB_Retrieve_array(adlb_datum_id id, adlb_refc decr,
+                   adlb_data_type *type, void **data, int *count);
+
+/*
+   List next chunk of contents of container or multiset.  The server
+   keeps the position reached, so listing a large container in chunks
+   takes time linear in its size.  Output is encoded as for
+   ADLB_Enumerate.
+   cursor: in: 0 to start, or value from previous call.
+           out: 0 once all members were returned.
+   count: maximum number of elements to return, negative for all
+   decr: decrement refcounts of container once cursor reaches the end.
+         Must be the same for each call with a cursor.
+ */
+adlb_code ADLBP_Enumerate_next(adlb_datum_id container_id,
+                   int64_t *cursor, int count, adlb_refc decr,
+                   bool include_keys, bool include_vals,
+                   void** data, size_t* length, int* records,
+                   adlb_type_extra *kv_type);
+adlb_code ADLB_Enumerate_next(adlb_datum_id container_id,
+                   int64_t *cursor, int count, adlb_refc decr,
+                   bool include_keys, bool include_vals,
+                   void** data, size_t* length, int* records,
+                   adlb_type_extra *kv_type);
+
+/*
+   Stop enumeration before the end, releasing the server-side cursor.
+   A cursor of 0 is allowed, so decr can be applied uniformly.
+   decr: decrement refcounts of container
+ */
+adlb_code ADLBP_Enumerate_close(adlb_datum_id container_id,
+                   int64_t cursor, adlb_refc decr);
+adlb_code ADLB_Enumerate_close(adlb_datum_id container_id,
+                   int64_t cursor, adlb_refc decr);
+
 // Switch on read refcounting and memory management, which is off by default
 adlb_code ADLBP_Read_refcount_enable(void);
 adlb_code ADLB_Read_refcount_enable(void);
@@ -387,6 +524,26 @@ adlb_code ADLB_Container_reference(adlb_datum_id id, adlb_subscript subscript,
 /*
  * Allocate a unique data ID
  */
+/*
+   Reduce the values of a container or multiset to a scalar on the
+   server that owns it, without transferring the members.
+   op: ADLB_REDUCE_SUM/MIN/MAX for integer or float values,
+       ADLB_REDUCE_COUNT for any values, ADLB_REDUCE_CONCAT for strings
+   decr: decrement refcounts of container after reduction
+   type: output arg for type of result: integer for count, string for
+         concat, otherwise the value type.  ADLB_DATA_TYPE_NULL if
+         min or max of no values.
+   result: output arg for packed result, to be freed by caller,
+           NULL if length is 0
+   length: output arg for result size in bytes
+ */
+adlb_code ADLBP_Reduce(adlb_datum_id id, adlb_reduce_op op,
+      adlb_refc decr, adlb_data_type *type, void **result,
+      size_t *length);
+adlb_code ADLB_Reduce(adlb_datum_id id, adlb_reduce_op op,
+      adlb_refc decr, adlb_data_type *type, void **result,
+      size_t *length);
+
 adlb_code ADLBP_Unique(adlb_datum_id *result);
 adlb_code ADLB_Unique(adlb_datum_id *result);
 
@@ -444,6 +601,13 @@ const char *ADLB_Data_type_tostring(adlb_data_type type);
 adlb_code ADLB_string_to_placement(const char *string,
                            adlb_placement *placement);
 
+/*
+  Hash key for ADLB_PLACE_HASH placement.  All ranks get the
+  same hash for the same key, so data created with it is placed on
+  the same server.
+ */
+int64_t ADLB_Placement_hash(const void *key, size_t length);
+
 adlb_code ADLB_Server_idle(int rank, int64_t check_attempt, bool* result,
                  int *request_counts, int *untargeted_work_counts);
 
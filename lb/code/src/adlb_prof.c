@@ -134,6 +134,42 @@ adlb_code ADLB_Dput(const void* payload, int length, int target,
   return rc;
 }
 
+adlb_code ADLB_Put_batch(const adlb_put_spec *tasks, int count)
+{
+  MPE_LOG(xlb_mpe_wkr_put_start);
+
+  adlb_code rc = ADLBP_Put_batch(tasks, count);
+
+  MPE_LOG(xlb_mpe_wkr_put_end);
+
+  return rc;
+}
+
+adlb_code ADLB_Dput_batch(const adlb_put_spec *tasks, int count)
+{
+  MPE_LOG(xlb_mpe_wkr_dput_start);
+
+  adlb_code rc = ADLBP_Dput_batch(tasks, count);
+
+  MPE_LOG(xlb_mpe_wkr_dput_end);
+
+  return rc;
+}
+
+adlb_code ADLB_Dput_group(const adlb_datum_id *shared_ids,
+        int shared_id_count, const adlb_datum_id_sub *shared_id_subs,
+        int shared_id_sub_count, const adlb_put_spec *tasks, int count)
+{
+  MPE_LOG(xlb_mpe_wkr_dput_start);
+
+  adlb_code rc = ADLBP_Dput_group(shared_ids, shared_id_count,
+          shared_id_subs, shared_id_sub_count, tasks, count);
+
+  MPE_LOG(xlb_mpe_wkr_dput_end);
+
+  return rc;
+}
+
 #ifdef ENABLE_MPE
 
 /**
@@ -299,6 +335,30 @@ ADLB_Store(adlb_datum_id id, adlb_subscript subscript,
   return rc;
 }
 
+adlb_code
+ADLB_Store_buffered(adlb_datum_id id, adlb_subscript subscript,
+          adlb_data_type type, const void *data, size_t length,
+          adlb_refc refcount_decr, adlb_refc store_refcounts)
+{
+  MPE_LOG(xlb_mpe_wkr_store_start);
+  adlb_code rc = ADLBP_Store_buffered(id, subscript, type, data, length,
+                             refcount_decr, store_refcounts);
+  MPE_LOG(xlb_mpe_wkr_store_end);
+  return rc;
+}
+
+adlb_code
+ADLB_Refcount_decr_buffered(adlb_datum_id id, adlb_refc decr)
+{
+  return ADLBP_Refcount_decr_buffered(id, decr);
+}
+
+adlb_code
+ADLB_Flush_writes(void)
+{
+  return ADLBP_Flush_writes();
+}
+
 adlb_code
 ADLB_Retrieve(adlb_datum_id id, adlb_subscript subscript,
       adlb_retrieve_refc refcounts, adlb_data_type* type,
@@ -310,6 +370,16 @@ ADLB_Retrieve(adlb_datum_id id, adlb_subscript subscript,
   return rc;
 }
 
+adlb_code
+ADLB_Retrieve_multi(const adlb_retrieve_spec *specs, int count,
+      adlb_retrieve_result *results, void **storage)
+{
+  MPE_LOG(xlb_mpe_wkr_retrieve_start);
+  adlb_code rc = ADLBP_Retrieve_multi(specs, count, results, storage);
+  MPE_LOG(xlb_mpe_wkr_retrieve_end);
+  return rc;
+}
+
 adlb_code
 ADLB_Enumerate(adlb_datum_id container_id,
                int count, int offset, adlb_refc decr,
@@ -322,6 +392,39 @@ ADLB_Enumerate(adlb_datum_id container_id,
                          data, length, records, kv_type);
 }
 
+adlb_code
+ADLB_Retrieve_array(adlb_datum_id id, adlb_refc decr,
+                    adlb_data_type *type, void **data, int *count)
+{
+  return ADLBP_Retrieve_array(id, decr, type, data, count);
+}
+
+adlb_code
+ADLB_Enumerate_next(adlb_datum_id container_id, int64_t *cursor,
+               int count, adlb_refc decr,
+               bool include_keys, bool include_vals,
+               void** data, size_t* length, int* records,
+               adlb_type_extra *kv_type)
+{
+  return ADLBP_Enumerate_next(container_id, cursor, count, decr,
+                         include_keys, include_vals,
+                         data, length, records, kv_type);
+}
+
+adlb_code
+ADLB_Enumerate_close(adlb_datum_id container_id, int64_t cursor,
+                     adlb_refc decr)
+{
+  return ADLBP_Enumerate_close(container_id, cursor, decr);
+}
+
+adlb_code
+ADLB_Reduce(adlb_datum_id id, adlb_reduce_op op, adlb_refc decr,
+            adlb_data_type *type, void **result, size_t *length)
+{
+  return ADLBP_Reduce(id, op, decr, type, result, length);
+}
+
 adlb_code
 ADLB_Read_refcount_enable(void)
 {
@@ -12,6 +12,7 @@
 
 #include "adlb.h"
 #include "checks.h"
+#include "container.h"
 #include "data_cleanup.h"
 #include "data_internal.h"
 #include "data_structs.h"
@@ -192,10 +193,10 @@ ADLB_Init_compound(adlb_datum_storage *d, adlb_data_type type,
   {
     case ADLB_DATA_TYPE_CONTAINER:
       assert(type_extra.valid);
-      d->CONTAINER.members = table_bp_create(CONTAINER_INIT_CAPACITY);
-      ADLB_DATA_CHECK_MALLOC(d->CONTAINER.members);
-      d->CONTAINER.key_type = type_extra.CONTAINER.key_type;
-      d->CONTAINER.val_type = type_extra.CONTAINER.val_type;
+      dc = xlb_container_init(&d->CONTAINER,
+                type_extra.CONTAINER.key_type,
+                type_extra.CONTAINER.val_type);
+      ADLB_DATA_CHECK_CODE(dc);
       break;
     case ADLB_DATA_TYPE_MULTISET:
       assert(type_extra.valid);
@@ -390,8 +391,8 @@ ADLB_Pack_container(const adlb_container *container,
 {
   adlb_data_code dc;
 
-  const table_bp *members = container->members;
-  dc = ADLB_Pack_container_hdr(members->size,
+  int size = xlb_container_size(container);
+  dc = ADLB_Pack_container_hdr(size,
       (adlb_data_type)container->key_type,
       (adlb_data_type)container->val_type,
       output, output_caller_buffer, output_pos);
@@ -399,9 +400,9 @@ ADLB_Pack_container(const adlb_container *container,
 
   int appended = 0;
 
-  TABLE_BP_FOREACH(members, item)
+  XLB_CONTAINER_FOREACH(container, item)
   {
-    size_t key_len = table_bp_key_len(item);
+    size_t key_len = item.key_len;
     assert(key_len <= INT_MAX);
     // append key; append val
     size_t required = *output_pos + VINT_MAX_BYTES + key_len;
@@ -409,11 +410,11 @@ ADLB_Pack_container(const adlb_container *container,
     ADLB_DATA_CHECK_CODE(dc);
 
     dc = ADLB_Append_buffer(ADLB_DATA_TYPE_NULL,
-          table_bp_get_key(item), key_len,
+          item.key, key_len,
           true, output, output_caller_buffer, output_pos);
     ADLB_DATA_CHECK_CODE(dc);
 
-    dc = ADLB_Pack_buffer(item->data, (adlb_data_type)container->val_type,
+    dc = ADLB_Pack_buffer(item.val, (adlb_data_type)container->val_type,
             true, tmp_buf, output, output_caller_buffer, output_pos);
     ADLB_DATA_CHECK_CODE(dc);
 
@@ -421,11 +422,11 @@ ADLB_Pack_container(const adlb_container *container,
   }
 
   DEBUG("Packed container:  entries: %i, key: %s, val: %s, bytes: %zu",
-        members->size, ADLB_Data_type_tostring(container->key_type),
+        size, ADLB_Data_type_tostring(container->key_type),
         ADLB_Data_type_tostring(container->val_type), *output_pos);
 
   // Check that the number we appended matches
-  assert(appended == members->size);
+  assert(appended == size);
   return ADLB_DATA_SUCCESS;
 }
 
@@ -631,13 +632,11 @@ ADLB_Unpack_container(adlb_container *container,
 
   if (init_cont)
   {
-    container->key_type = key_type;
-    container->val_type = val_type;
-    container->members = table_bp_create(CONTAINER_INIT_CAPACITY);
+    dc = xlb_container_init(container, key_type, val_type);
+    ADLB_DATA_CHECK_CODE(dc);
   }
   else
   {
-    assert(container->members != NULL);
     ADLB_CHECK_MSG_CODE(key_type == (adlb_data_type)container->key_type &&
          val_type == (adlb_data_type)container->val_type, ADLB_DATA_ERROR_TYPE,
         "Unpacked container type does not match: expected %s[%s] vs. %s[%s]",
@@ -662,8 +661,10 @@ ADLB_Unpack_container(adlb_container *container,
     ADLB_DATA_CHECK_CODE(dc);
 
     // TODO: handle case where key already exists
-    bool ok = table_bp_add(container->members, key, key_len, d);
-    ADLB_CHECK_MSG_CODE(ok, ADLB_DATA_ERROR_OOM, "Error adding to container");
+    adlb_subscript sub = { .key = key, .length = key_len };
+    dc = xlb_container_add(container, sub, d);
+    ADLB_CHECK_MSG_CODE(dc == ADLB_DATA_SUCCESS, dc,
+                        "Error adding to container");
   }
 
   return ADLB_DATA_SUCCESS;
@@ -920,7 +921,6 @@ char *ADLB_Data_repr(const adlb_datum_storage *d, adlb_data_type type)
 static char *data_repr_container(const adlb_container *c)
 {
   adlb_data_code dc;
-  table_bp* members = c->members;
   size_t cont_str_len = 1024;
   char *cont_str = malloc(cont_str_len);
   int cont_str_pos = 0;
@@ -932,26 +932,26 @@ static char *data_repr_container(const adlb_container *c)
   assert(dc == ADLB_DATA_SUCCESS);
   cont_str_pos += sprintf(&cont_str[cont_str_pos], "%s=>%s: ", kts, vts);
 
-  TABLE_BP_FOREACH(members, item)
+  XLB_CONTAINER_FOREACH(c, item)
   {
     const char *null_str = "(null)";
-    adlb_container_val v = item->data;
+    adlb_container_val v = item.val;
     char *value_s = (v == NULL) ? NULL :
           ADLB_Data_repr(v, (adlb_data_type)c->val_type);
     size_t value_strlen = (value_s == NULL) ? sizeof(null_str) :
                                               strlen(value_s);
     dc = xlb_resize_str(&cont_str, &cont_str_len, cont_str_pos,
-                   (table_bp_key_len(item) - 1) + value_strlen + 7);
+                   (item.key_len - 1) + value_strlen + 7);
     assert(dc == ADLB_DATA_SUCCESS);
     if (c->key_type == ADLB_DATA_TYPE_STRING)
     {
       cont_str_pos += sprintf(&cont_str[cont_str_pos], "\"%s\"=",
-                        (char*)table_bp_get_key(item));
+                        (const char*)item.key);
     }
     else
     {
       cont_str_pos += sprintf(&cont_str[cont_str_pos], "\"%s\"=",
-                              (char*)table_bp_get_key(item));
+                              (const char*)item.key);
     }
 
     if (value_s != NULL)
@@ -65,18 +65,33 @@ typedef struct {
   int write_refs;
 } adlb_ref;
 
+// Forward declaration of incomplete dense member array type
+typedef struct adlb_dense_members_s *adlb_dense_members_ptr;
+
 typedef struct {
-  /**
-    Map from subscript to member.  Use binary subscripts as keys.
-    Therefore binary representations of keys must be comparable.
-   */
-  struct table_bp* members;
+  union {
+    /**
+      Map from subscript to member.  Use binary subscripts as keys.
+      Therefore binary representations of keys must be comparable.
+      Used if not dense.
+     */
+    struct table_bp* members;
+
+    /**
+      Members of integer-keyed container indexed by integer value
+      of subscript.  Used if dense.
+     */
+    adlb_dense_members_ptr dense_members;
+  };
 
   /** Type of container keys */
   adlb_data_type key_type : ADLB_DATA_TYPE_BITS;
 
   /** type of container values */
   adlb_data_type val_type : ADLB_DATA_TYPE_BITS;
+
+  /** Whether members are stored in dense_members */
+  bool dense : 1;
 } adlb_container;
 
 // Forward declaration of incomplete struct type
@@ -0,0 +1,504 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * closed_summary.c
+ *
+ * Range-compressed summaries of closed data IDs, sent between servers
+ * to avoid remote subscribes to data that is already closed.
+ *
+ * IDs allocated by a server are numbered by index from 0 in
+ * allocation order.  The summary has a base index, divisible by 64.
+ * Indices below the base are closed, except those in the sorted open
+ * list.  Bit i of the bitmap is set if base + i is closed.
+ *
+ * Some IDs are never closed, e.g. those from ADLB_Unique().  So that
+ * they do not fill the open list and stop the window from moving, the
+ * oldest open indices are aged out when it is full.  Indices below
+ * the low index are then not reported at all.
+ */
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+
+#include <tools.h>
+
+#include "checks.h"
+#include "closed_summary.h"
+#include "common.h"
+#include "debug.h"
+#include "messaging.h"
+#include "sendqueue.h"
+#include "server.h"
+
+/** Most bitmap words kept above base */
+#define SUMMARY_MAX_WORDS 256
+/** Most open indices kept below base */
+#define SUMMARY_MAX_OPEN 64
+
+#define SUMMARY_MAX_BYTES (sizeof(struct packed_closed_summary) + \
+          SUMMARY_MAX_OPEN * sizeof(int64_t) +                  \
+          SUMMARY_MAX_WORDS * sizeof(uint64_t))
+
+#define SUMMARY_INTERVAL_DEFAULT 0.005
+
+/** Latest summary received from another server */
+typedef struct
+{
+  /** Received message, NULL if none yet */
+  struct packed_closed_summary *msg;
+  const int64_t *open;
+  const uint64_t *bits;
+} peer_summary;
+
+static bool enabled = false;
+
+static int servers;
+/** First ID allocated by this server */
+static int64_t first_id;
+
+/* Summary of this server's IDs */
+static int64_t base = 0;
+/** Indices below this are not reported */
+static int64_t low = 0;
+static int64_t open[SUMMARY_MAX_OPEN];
+static int open_count = 0;
+static uint64_t bits[SUMMARY_MAX_WORDS];
+/** Words of bits in use: later words are zero */
+static int words = 0;
+/** Incremented on every change */
+static int64_t summary_version = 0;
+
+static double interval = SUMMARY_INTERVAL_DEFAULT;
+static double last_gossip = 0.0;
+
+/** Indexed by server number */
+static peer_summary *peers = NULL;
+/** Servers that subscribed since the last gossip */
+static bool *subscribers = NULL;
+/** Version last sent to each server */
+static int64_t *sent_version = NULL;
+
+/* Statistics */
+static int64_t closed_tracked = 0;
+static int64_t closed_untracked = 0;
+static int64_t open_aged = 0;
+static int64_t summaries_sent = 0;
+static int64_t summary_bytes_sent = 0;
+static int64_t summaries_received = 0;
+static int open_hwm = 0;
+
+adlb_code
+xlb_closed_summary_init(int s, int server_num)
+{
+  getenv_boolean("ADLB_CLOSED_SUMMARY", true, &enabled);
+  bool ok = getenv_double("ADLB_CLOSED_SUMMARY_INTERVAL",
+                          SUMMARY_INTERVAL_DEFAULT, &interval);
+  ADLB_CHECK_MSG(ok && interval >= 0.0,
+                 "Invalid ADLB_CLOSED_SUMMARY_INTERVAL");
+
+  // Same sequence as xlb_data_unique()
+  servers = s;
+  first_id = (server_num == 0) ? s : server_num;
+
+  base = 0;
+  low = 0;
+  open_count = 0;
+  memset(bits, 0, sizeof(bits));
+  words = 0;
+  summary_version = 0;
+  last_gossip = 0.0;
+
+  if (!enabled || servers == 1)
+  {
+    enabled = false;
+    DEBUG("Closed summary: disabled");
+    return ADLB_SUCCESS;
+  }
+
+  peers = calloc((size_t)servers, sizeof(peers[0]));
+  subscribers = calloc((size_t)servers, sizeof(subscribers[0]));
+  sent_version = calloc((size_t)servers, sizeof(sent_version[0]));
+  ADLB_CHECK_MALLOC(peers);
+  ADLB_CHECK_MALLOC(subscribers);
+  ADLB_CHECK_MALLOC(sent_version);
+
+  DEBUG("Closed summary: interval: %f", interval);
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_closed_summary_finalize(void)
+{
+  if (peers != NULL)
+  {
+    int pending = true;
+    while (pending)
+    {
+      MPI_Status status;
+      IPROBE(MPI_ANY_SOURCE, ADLB_TAG_CLOSED_SUMMARY, &pending, &status);
+      if (pending)
+      {
+        adlb_code rc = xlb_closed_summary_recv(status.MPI_SOURCE);
+        ADLB_CHECK(rc);
+      }
+    }
+  }
+
+  if (peers != NULL)
+  {
+    for (int i = 0; i < servers; i++)
+    {
+      free(peers[i].msg);
+    }
+  }
+  free(peers);
+  free(subscribers);
+  free(sent_version);
+  peers = NULL;
+  subscribers = NULL;
+  sent_version = NULL;
+  enabled = false;
+  return ADLB_SUCCESS;
+}
+
+static inline int
+bit_count(uint64_t x)
+{
+  return __builtin_popcountll(x);
+}
+
+/**
+  Add index that is not closed to end of open list, aging out the
+  oldest if full
+ */
+static inline void
+open_append(int64_t index)
+{
+  if (open_count == SUMMARY_MAX_OPEN)
+  {
+    low = open[0] + 1;
+    memmove(open, open + 1, (size_t)(open_count - 1) * sizeof(open[0]));
+    open_count--;
+    open_aged++;
+  }
+  open[open_count++] = index;
+}
+
+/**
+  Remove first n words of bitmap, moving indices that are not closed
+  to the open list
+ */
+static void
+drop_words(int64_t n)
+{
+  // Indices are above all those already in open list
+  for (int w = 0; w < n && w < words; w++)
+  {
+    uint64_t word = bits[w];
+    for (int b = 0; word != UINT64_MAX && b < 64; b++)
+    {
+      if ((word & ((uint64_t)1 << b)) == 0)
+      {
+        open_append(base + 64 * w + b);
+      }
+    }
+  }
+  if (n > words)
+  {
+    // Words past the end have no closed indices: only the newest
+    // fit in open list
+    int64_t start = base + 64 * (int64_t)words;
+    int64_t end = base + 64 * n;
+    if (end - start > SUMMARY_MAX_OPEN)
+    {
+      open_aged += open_count + (end - start - SUMMARY_MAX_OPEN);
+      open_count = 0;
+      start = low = end - SUMMARY_MAX_OPEN;
+    }
+    for (int64_t i = start; i < end; i++)
+    {
+      open_append(i);
+    }
+  }
+  if (open_count > open_hwm)
+  {
+    open_hwm = open_count;
+  }
+
+  if (n < words)
+  {
+    memmove(bits, bits + n, (size_t)(words - n) * sizeof(bits[0]));
+    memset(bits + words - n, 0, (size_t)n * sizeof(bits[0]));
+    words -= (int)n;
+  }
+  else
+  {
+    memset(bits, 0, (size_t)words * sizeof(bits[0]));
+    words = 0;
+  }
+  base += 64 * n;
+}
+
+/**
+  Find index in open list
+  return position, or -1 if not present
+ */
+static int
+open_search(const int64_t *list, int count, int64_t index)
+{
+  int lo = 0, hi = count - 1;
+  while (lo <= hi)
+  {
+    int mid = (lo + hi) / 2;
+    if (list[mid] == index)
+      return mid;
+    else if (list[mid] < index)
+      lo = mid + 1;
+    else
+      hi = mid - 1;
+  }
+  return -1;
+}
+
+void
+xlb_closed_summary_add(adlb_datum_id id)
+{
+  if (!enabled || id < first_id || (id - first_id) % servers != 0)
+  {
+    return;
+  }
+
+  int64_t index = (id - first_id) / servers;
+  if (index < base)
+  {
+    int pos = open_search(open, open_count, index);
+    if (pos >= 0)
+    {
+      memmove(&open[pos], &open[pos + 1],
+              (size_t)(open_count - pos - 1) * sizeof(open[0]));
+      open_count--;
+      summary_version++;
+      closed_tracked++;
+    }
+    else
+    {
+      // Aged out
+      closed_untracked++;
+    }
+    return;
+  }
+
+  int64_t word = (index - base) / 64;
+  if (word >= SUMMARY_MAX_WORDS)
+  {
+    // Slide window up
+    int64_t drop = word - SUMMARY_MAX_WORDS + 1;
+    drop_words(drop);
+    word -= drop;
+  }
+
+  bits[word] |= (uint64_t)1 << ((index - base) % 64);
+  if (word >= words)
+  {
+    words = (int)word + 1;
+  }
+
+  // Advance past fully closed words
+  int full = 0;
+  while (full < words && bits[full] == UINT64_MAX)
+  {
+    full++;
+  }
+  if (full > 0)
+  {
+    drop_words(full);
+  }
+
+  summary_version++;
+  closed_tracked++;
+}
+
+void
+xlb_closed_summary_subscriber(int rank)
+{
+  if (!enabled)
+  {
+    return;
+  }
+  int server = rank - xlb_s.layout.workers;
+  assert(server >= 0 && server < servers);
+  subscribers[server] = true;
+}
+
+adlb_code
+xlb_closed_summary_gossip(void)
+{
+  if (!enabled || xlb_server_shutting_down)
+  {
+    return ADLB_SUCCESS;
+  }
+
+  double now = xlb_approx_time();
+  if (now - last_gossip < interval)
+  {
+    return ADLB_SUCCESS;
+  }
+  last_gossip = now;
+
+  size_t length = sizeof(struct packed_closed_summary) +
+                  (size_t)open_count * sizeof(int64_t) +
+                  (size_t)words * sizeof(uint64_t);
+  assert(length <= SUMMARY_MAX_BYTES);
+
+  for (int server = 0; server < servers; server++)
+  {
+    if (!subscribers[server] || sent_version[server] == summary_version)
+    {
+      continue;
+    }
+
+    struct packed_closed_summary *msg = malloc(length);
+    ADLB_CHECK_MALLOC(msg);
+    msg->low = low;
+    msg->base = base;
+    msg->open_count = open_count;
+    msg->words = words;
+    char *pos = (char*)(msg + 1);
+    memcpy(pos, open, (size_t)open_count * sizeof(int64_t));
+    pos += (size_t)open_count * sizeof(int64_t);
+    memcpy(pos, bits, (size_t)words * sizeof(uint64_t));
+
+    int rank = xlb_s.layout.workers + server;
+    DEBUG("Closed summary: to %i base: %"PRId64" open: %i words: %i",
+          rank, base, open_count, words);
+    adlb_code rc = xlb_sendq_owned(msg, length, rank,
+                                   ADLB_TAG_CLOSED_SUMMARY);
+    ADLB_CHECK(rc);
+
+    subscribers[server] = false;
+    sent_version[server] = summary_version;
+    summaries_sent++;
+    summary_bytes_sent += (int64_t)length;
+  }
+
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_closed_summary_recv(int rank)
+{
+  MPI_Status status;
+  int server = rank - xlb_s.layout.workers;
+  assert(server >= 0 && server < servers);
+
+  // Discard if disabled here but not on sender
+  if (peers == NULL)
+  {
+    char discard[SUMMARY_MAX_BYTES];
+    RECV(discard, (int)SUMMARY_MAX_BYTES, MPI_BYTE, rank,
+         ADLB_TAG_CLOSED_SUMMARY);
+    return ADLB_SUCCESS;
+  }
+
+  peer_summary *p = &peers[server];
+  if (p->msg == NULL)
+  {
+    p->msg = malloc(SUMMARY_MAX_BYTES);
+    ADLB_CHECK_MALLOC(p->msg);
+  }
+
+  RECV(p->msg, (int)SUMMARY_MAX_BYTES, MPI_BYTE, rank,
+       ADLB_TAG_CLOSED_SUMMARY);
+
+  int length;
+  int mc = MPI_Get_count(&status, MPI_BYTE, &length);
+  MPI_CHECK(mc);
+  ADLB_CHECK_MSG((size_t)length == sizeof(*p->msg) +
+        (size_t)p->msg->open_count * sizeof(int64_t) +
+        (size_t)p->msg->words * sizeof(uint64_t),
+        "Closed summary from %i has wrong length: %i", rank, length);
+
+  p->open = (const int64_t*)(p->msg + 1);
+  p->bits = (const uint64_t*)(p->open + p->msg->open_count);
+  summaries_received++;
+
+  DEBUG("Closed summary: from %i base: %"PRId64" open: %i words: %i",
+        rank, p->msg->base, p->msg->open_count, p->msg->words);
+  return ADLB_SUCCESS;
+}
+
+bool
+xlb_closed_summary_check(int rank, adlb_datum_id id)
+{
+  if (!enabled)
+  {
+    return false;
+  }
+
+  int server = rank - xlb_s.layout.workers;
+  const peer_summary *p = &peers[server];
+  if (p->msg == NULL)
+  {
+    return false;
+  }
+
+  int64_t peer_first = (server == 0) ? servers : server;
+  if (id < peer_first || (id - peer_first) % servers != 0)
+  {
+    return false;
+  }
+
+  int64_t index = (id - peer_first) / servers;
+  if (index < p->msg->low)
+  {
+    return false;
+  }
+  int64_t offset = index - p->msg->base;
+  if (offset < 0)
+  {
+    return open_search(p->open, p->msg->open_count, index) < 0;
+  }
+  if (offset >= 64 * (int64_t)p->msg->words)
+  {
+    return false;
+  }
+  return (p->bits[offset / 64] & ((uint64_t)1 << (offset % 64))) != 0;
+}
+
+void
+xlb_print_closed_summary_counters(void)
+{
+  if (!xlb_s.perfc_enabled)
+  {
+    return;
+  }
+
+  PRINT_COUNTER("closed_summary_enabled=%i", (int)enabled);
+  PRINT_COUNTER("closed_summary_tracked=%"PRId64, closed_tracked);
+  PRINT_COUNTER("closed_summary_untracked=%"PRId64, closed_untracked);
+  PRINT_COUNTER("closed_summary_base=%"PRId64, base);
+  PRINT_COUNTER("closed_summary_low=%"PRId64, low);
+  PRINT_COUNTER("closed_summary_open_aged=%"PRId64, open_aged);
+  PRINT_COUNTER("closed_summary_open_hwm=%i", open_hwm);
+  PRINT_COUNTER("closed_summary_sent=%"PRId64, summaries_sent);
+  PRINT_COUNTER("closed_summary_bytes_sent=%"PRId64, summary_bytes_sent);
+  PRINT_COUNTER("closed_summary_received=%"PRId64, summaries_received);
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * closed_summary.h
+ *
+ * Summaries of closed data IDs exchanged between servers.
+ *
+ * Each server tracks which of the IDs it allocated have been closed,
+ * as a range-compressed bitmap: all IDs below a base are closed except
+ * for a short list of IDs still open, and a bitmap covers IDs above
+ * the base.  Servers that sent us remote subscribes since the last
+ * round are sent the summary at most once every
+ * ADLB_CLOSED_SUMMARY_INTERVAL seconds, if it changed.  The engine
+ * checks the summary for the owning server before subscribing
+ * remotely to an ID.
+ *
+ * The summary is exact: an ID is only reported closed if it was
+ * closed, so no remote subscribe is needed to confirm it.  IDs that
+ * can't be represented within the size limits are not reported, nor
+ * are IDs older than those that stay open longest.
+ * Messages are small enough to be sent eagerly.
+ *
+ * ADLB_CLOSED_SUMMARY=0 disables the summaries.
+ */
+
+#ifndef XLB_CLOSED_SUMMARY_H
+#define XLB_CLOSED_SUMMARY_H
+
+#include <stdbool.h>
+
+#include "adlb-defs.h"
+
+adlb_code xlb_closed_summary_init(int servers, int server_num);
+
+/**
+  Release memory and discard summaries still arriving
+ */
+adlb_code xlb_closed_summary_finalize(void);
+
+/**
+  Record that an ID allocated by this server was closed
+ */
+void xlb_closed_summary_add(adlb_datum_id id);
+
+/**
+  Record that server rank subscribed to data on this server
+ */
+void xlb_closed_summary_subscriber(int rank);
+
+/**
+  Send summary to recent subscribers if it changed and the interval
+  has passed
+ */
+adlb_code xlb_closed_summary_gossip(void);
+
+/**
+  Receive summary from server rank
+ */
+adlb_code xlb_closed_summary_recv(int rank);
+
+/**
+  Check latest summary from server rank, which owns id
+  return true if id is known to be closed
+ */
+bool xlb_closed_summary_check(int rank, adlb_datum_id id);
+
+void xlb_print_closed_summary_counters(void);
+
+#endif // XLB_CLOSED_SUMMARY_H
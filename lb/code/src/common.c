@@ -29,6 +29,7 @@
 
 #include <mpi.h>
 
+#include <jenkins-hash.h>
 #include <tools.h>
 
 #include "common.h"
@@ -85,7 +86,17 @@ adlb_code xlb_env_placement(adlb_placement *placement)
   }
 
 
-  return ADLB_string_to_placement(s, placement);
+  adlb_code rc = ADLB_string_to_placement(s, placement);
+  ADLB_CHECK(rc);
+
+  // Hints need an argument, so can't be a default
+  if (*placement == ADLB_PLACE_DATUM || *placement == ADLB_PLACE_RANK ||
+      *placement == ADLB_PLACE_HASH)
+  {
+    ERR_PRINTF("Invalid ADLB_PLACEMENT value: %s\n", s);
+    return ADLB_ERROR;
+  }
+  return ADLB_SUCCESS;
 }
 
 adlb_code ADLB_string_to_placement(const char *string,
@@ -114,6 +125,18 @@ adlb_code ADLB_string_to_placement(const char *string,
   {
     *placement = ADLB_PLACE_DEFAULT;
   }
+  else if (strcmp(buf, "datum") == 0)
+  {
+    *placement = ADLB_PLACE_DATUM;
+  }
+  else if (strcmp(buf, "rank") == 0)
+  {
+    *placement = ADLB_PLACE_RANK;
+  }
+  else if (strcmp(buf, "hash") == 0)
+  {
+    *placement = ADLB_PLACE_HASH;
+  }
   else
   {
     ERR_PRINTF("Invalid ADLB_PLACEMENT value: %s\n", string);
@@ -121,3 +144,9 @@ adlb_code ADLB_string_to_placement(const char *string,
   }
   return ADLB_SUCCESS;
 }
+
+int64_t
+ADLB_Placement_hash(const void *key, size_t length)
+{
+  return (int64_t)bj_hashlittle(key, length, 0u);
+}
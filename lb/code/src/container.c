@@ -0,0 +1,394 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * container.c
+ *
+ * Storage of container members: see container.h
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <table_bp.h>
+
+#include "checks.h"
+#include "container.h"
+#include "data_internal.h"
+#include "debug.h"
+
+bool xlb_dense_containers = true;
+
+/** Initial number of slots for dense members */
+#define DENSE_MIN_CAPACITY 16
+
+/**
+  Number of gaps allowed in dense members beyond one per member,
+  so that members inserted somewhat out of order stay dense
+ */
+#define DENSE_SLACK 256
+
+/** Maximum digits of dense subscript: keeps index below INT_MAX */
+#define DENSE_MAX_DIGITS 9
+
+/** Marks slot of subscript reserved without a value */
+static adlb_datum_storage dense_reserved;
+
+static inline adlb_container_val
+dense_wrap(adlb_container_val val)
+{
+  return (val == NULL) ? &dense_reserved : val;
+}
+
+static inline adlb_container_val
+dense_unwrap(adlb_container_val val)
+{
+  return (val == &dense_reserved) ? NULL : val;
+}
+
+/*
+  Index of subscript in dense members, or -1 if not a decimal
+  integer in canonical form
+ */
+static int
+dense_index(adlb_subscript sub)
+{
+  const char *key = sub.key;
+  size_t digits = sub.length - 1;
+  if (sub.length < 2 || digits > DENSE_MAX_DIGITS ||
+      key[digits] != '\0' || (key[0] == '0' && digits > 1))
+  {
+    return -1;
+  }
+
+  int ix = 0;
+  for (size_t i = 0; i < digits; i++)
+  {
+    if (key[i] < '0' || key[i] > '9')
+      return -1;
+    ix = ix * 10 + (key[i] - '0');
+  }
+  return ix;
+}
+
+/*
+  Write canonical subscript for index into buffer of at least
+  XLB_DENSE_KEY_MAX bytes
+  returns length including null terminator
+ */
+static size_t
+dense_key(int ix, char *buf)
+{
+  char tmp[XLB_DENSE_KEY_MAX];
+  int n = 0;
+  do
+  {
+    tmp[n++] = (char)('0' + ix % 10);
+    ix /= 10;
+  } while (ix > 0);
+
+  for (int i = 0; i < n; i++)
+    buf[i] = tmp[n - 1 - i];
+  buf[n] = '\0';
+  return (size_t)n + 1;
+}
+
+adlb_data_code
+xlb_container_init(adlb_container *c, adlb_data_type key_type,
+                   adlb_data_type val_type)
+{
+  c->key_type = key_type;
+  c->val_type = val_type;
+  if (key_type == ADLB_DATA_TYPE_INTEGER && xlb_dense_containers)
+  {
+    // Allocate array on first insert
+    c->dense = true;
+    c->dense_members = NULL;
+  }
+  else
+  {
+    c->dense = false;
+    c->members = table_bp_create(CONTAINER_INIT_CAPACITY);
+    ADLB_DATA_CHECK_MALLOC(c->members);
+  }
+  return ADLB_DATA_SUCCESS;
+}
+
+void
+xlb_container_free(adlb_container *c)
+{
+  if (c->dense)
+  {
+    free(c->dense_members);
+    c->dense_members = NULL;
+  }
+  else
+  {
+    table_bp_free(c->members);
+    c->members = NULL;
+  }
+}
+
+int
+xlb_container_size(const adlb_container *c)
+{
+  if (c->dense)
+  {
+    return (c->dense_members == NULL) ? 0 : c->dense_members->size;
+  }
+  return c->members->size;
+}
+
+/*
+  Move dense members into hash table
+ */
+static adlb_data_code
+dense_to_table(adlb_container *c)
+{
+  adlb_dense_members_ptr D = c->dense_members;
+  int size = (D == NULL) ? 0 : D->size;
+  int capacity = CONTAINER_INIT_CAPACITY;
+  while (capacity < size * 2)
+    capacity *= 2;
+
+  struct table_bp *members = table_bp_create(capacity);
+  ADLB_DATA_CHECK_MALLOC(members);
+
+  for (int i = 0; D != NULL && i < D->capacity; i++)
+  {
+    if (D->vals[i] == NULL)
+      continue;
+
+    char key[XLB_DENSE_KEY_MAX];
+    size_t key_len = dense_key(i, key);
+    bool ok = table_bp_add(members, key, key_len,
+                           dense_unwrap(D->vals[i]));
+    if (!ok)
+    {
+      // Values are still owned by dense members
+      table_bp_free(members);
+      return ADLB_DATA_ERROR_OOM;
+    }
+  }
+
+  DEBUG("Container with %i members no longer dense", size);
+  free(D);
+  c->dense = false;
+  c->members = members;
+  return ADLB_DATA_SUCCESS;
+}
+
+/*
+  Make room in dense members for index
+  returns false if index would leave too many gaps
+ */
+static bool
+dense_reserve(adlb_container *c, int ix, bool *oom)
+{
+  adlb_dense_members_ptr D = c->dense_members;
+  int capacity = (D == NULL) ? 0 : D->capacity;
+  int size = (D == NULL) ? 0 : D->size;
+  *oom = false;
+  if (ix < capacity)
+    return true;
+
+  if (ix >= 2 * (size + 1) + DENSE_SLACK)
+    return false;
+
+  int new_capacity = (capacity == 0) ? DENSE_MIN_CAPACITY : capacity * 2;
+  if (new_capacity <= ix)
+    new_capacity = ix + 1;
+
+  adlb_dense_members_ptr tmp = realloc(D, sizeof(*D) +
+                    sizeof(D->vals[0]) * (size_t)new_capacity);
+  if (tmp == NULL)
+  {
+    *oom = true;
+    return false;
+  }
+  memset(&tmp->vals[capacity], 0,
+         sizeof(tmp->vals[0]) * (size_t)(new_capacity - capacity));
+  tmp->capacity = new_capacity;
+  tmp->size = size;
+  c->dense_members = tmp;
+  return true;
+}
+
+adlb_data_code
+xlb_container_add(adlb_container *c, adlb_subscript sub,
+                  adlb_container_val val)
+{
+  if (c->dense)
+  {
+    int ix = dense_index(sub);
+    bool oom = false;
+    if (ix >= 0 && dense_reserve(c, ix, &oom))
+    {
+      adlb_dense_members_ptr D = c->dense_members;
+      assert(D->vals[ix] == NULL);
+      D->vals[ix] = dense_wrap(val);
+      D->size++;
+      return ADLB_DATA_SUCCESS;
+    }
+    if (oom)
+      return ADLB_DATA_ERROR_OOM;
+
+    adlb_data_code dc = dense_to_table(c);
+    ADLB_DATA_CHECK_CODE(dc);
+  }
+
+  bool ok = table_bp_add(c->members, sub.key, sub.length, val);
+  return ok ? ADLB_DATA_SUCCESS : ADLB_DATA_ERROR_OOM;
+}
+
+/*
+  Find slot of member in dense members, or NULL if not present
+ */
+static adlb_container_val *
+dense_slot(const adlb_container *c, adlb_subscript sub)
+{
+  adlb_dense_members_ptr D = c->dense_members;
+  int ix = dense_index(sub);
+  if (D == NULL || ix < 0 || ix >= D->capacity || D->vals[ix] == NULL)
+    return NULL;
+  return &D->vals[ix];
+}
+
+bool
+xlb_container_set(adlb_container *c, adlb_subscript sub,
+                  adlb_container_val val, adlb_container_val *prev)
+{
+  if (c->dense)
+  {
+    adlb_container_val *slot = dense_slot(c, sub);
+    if (slot == NULL)
+      return false;
+    *prev = dense_unwrap(*slot);
+    *slot = dense_wrap(val);
+    return true;
+  }
+  return table_bp_set(c->members, sub.key, sub.length, val,
+                      (void**)prev);
+}
+
+bool
+xlb_container_lookup(const adlb_container *c, adlb_subscript sub,
+                     adlb_container_val *val)
+{
+  if (c->dense)
+  {
+    adlb_container_val *slot = dense_slot(c, sub);
+    if (slot == NULL)
+      return false;
+    *val = dense_unwrap(*slot);
+    return true;
+  }
+  return table_bp_search(c->members, sub.key, sub.length, (void**)val);
+}
+
+bool
+xlb_container_lookup_index(const adlb_container *c, int ix,
+                           adlb_container_val *val)
+{
+  if (c->dense)
+  {
+    adlb_dense_members_ptr D = c->dense_members;
+    if (D == NULL || ix < 0 || ix >= D->capacity || D->vals[ix] == NULL)
+      return false;
+    *val = dense_unwrap(D->vals[ix]);
+    return true;
+  }
+
+  if (ix < 0)
+    return false;
+  char key[XLB_DENSE_KEY_MAX];
+  size_t key_len = dense_key(ix, key);
+  return table_bp_search(c->members, key, key_len, (void**)val);
+}
+
+static bool
+dense_iter_next(adlb_dense_members_ptr D, xlb_container_iter *it)
+{
+  if (D == NULL)
+    return false;
+
+  while (it->pos < D->capacity && D->vals[it->pos] == NULL)
+    it->pos++;
+
+  if (it->pos >= D->capacity)
+    return false;
+
+  it->key_len = dense_key(it->pos, it->key_buf);
+  it->key = it->key_buf;
+  it->val = dense_unwrap(D->vals[it->pos]);
+  it->pos++;
+  return true;
+}
+
+static bool
+table_iter_next(const struct table_bp *members, xlb_container_iter *it)
+{
+  table_bp_entry *e = it->entry;
+  while (e == NULL && it->pos < members->capacity)
+  {
+    e = &members->array[it->pos];
+    if (table_bp_entry_valid(e))
+    {
+      for (int i = 0; i < it->chain_pos && e != NULL; i++)
+        e = e->next;
+    }
+    else
+    {
+      e = NULL;
+    }
+
+    if (e == NULL)
+    {
+      it->pos++;
+      it->chain_pos = 0;
+    }
+  }
+
+  if (e == NULL)
+    return false;
+
+  it->key = table_bp_get_key(e);
+  it->key_len = table_bp_key_len(e);
+  it->val = e->data;
+
+  // Move to following entry
+  it->entry = e->next;
+  if (e->next != NULL)
+  {
+    it->chain_pos++;
+  }
+  else
+  {
+    it->pos++;
+    it->chain_pos = 0;
+  }
+  return true;
+}
+
+bool
+xlb_container_iter_next(const adlb_container *c, xlb_container_iter *it)
+{
+  if (c->dense)
+    return dense_iter_next(c->dense_members, it);
+  return table_iter_next(c->members, it);
+}
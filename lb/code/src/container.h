@@ -0,0 +1,141 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * container.h
+ *
+ * Storage of container members.
+ *
+ * Members are stored in a hash table keyed by binary subscript, except
+ * that integer-keyed containers start out dense: members are stored in
+ * an array indexed by the integer value of the subscript.  This avoids
+ * a hash and a table entry per member, and enumerates members in
+ * subscript order.  Dense storage requires subscripts in the decimal
+ * string form used by Turbine ("0", "1", ... with null terminator).
+ * The first subscript that is not in that form, or that would leave
+ * too many gaps in the array, converts the container to a hash table
+ * for good.
+ *
+ * All access to members should go through these functions.
+ *
+ * ADLB_DENSE_CONTAINERS=0 disables dense storage.
+ */
+
+#ifndef XLB_CONTAINER_H
+#define XLB_CONTAINER_H
+
+#include <stdbool.h>
+
+#include "adlb_types.h"
+
+/** Whether new integer-keyed containers start out dense */
+extern bool xlb_dense_containers;
+
+struct adlb_dense_members_s
+{
+  int capacity; // Number of slots in vals
+  int size; // Number of members
+  /*
+    Member with subscript i, NULL if absent, or a marker if the
+    subscript was reserved without a value.
+   */
+  adlb_container_val vals[];
+};
+
+/**
+  Maximum length of dense subscript, including null terminator
+ */
+#define XLB_DENSE_KEY_MAX 12
+
+/**
+  Iterator over container members.  Initialize with
+  XLB_CONTAINER_ITER_INIT, or set pos and chain_pos to resume at a
+  position saved from an earlier iterator.
+ */
+typedef struct
+{
+  int pos; // Table bucket or array index of next member
+  int chain_pos; // Position of next member in bucket chain
+  table_bp_entry *entry; // Next member in table, if known
+
+  // Current member
+  const void *key;
+  size_t key_len;
+  adlb_container_val val; // May be NULL if reserved only
+
+  char key_buf[XLB_DENSE_KEY_MAX];
+} xlb_container_iter;
+
+#define XLB_CONTAINER_ITER_INIT { .pos = 0, .chain_pos = 0, \
+                                  .entry = NULL }
+
+#define XLB_CONTAINER_FOREACH(c, it) \
+  for (xlb_container_iter it = XLB_CONTAINER_ITER_INIT; \
+       xlb_container_iter_next((c), &(it)); )
+
+adlb_data_code xlb_container_init(adlb_container *c,
+        adlb_data_type key_type, adlb_data_type val_type);
+
+/**
+  Free memory for storage of members, but not member values
+ */
+void xlb_container_free(adlb_container *c);
+
+int xlb_container_size(const adlb_container *c);
+
+/**
+  Add member.  Subscript must not be present already.
+  val: may be NULL to reserve subscript
+ */
+adlb_data_code xlb_container_add(adlb_container *c, adlb_subscript sub,
+                                 adlb_container_val val);
+
+/**
+  Replace value of existing member
+  prev: set to previous value
+  returns false if subscript not present
+ */
+bool xlb_container_set(adlb_container *c, adlb_subscript sub,
+                       adlb_container_val val, adlb_container_val *prev);
+
+bool xlb_container_lookup(const adlb_container *c, adlb_subscript sub,
+                          adlb_container_val *val);
+
+/**
+  Look up member of integer-keyed container by integer value of
+  subscript: direct indexing if dense
+ */
+bool xlb_container_lookup_index(const adlb_container *c, int ix,
+                                adlb_container_val *val);
+
+/**
+  Move iterator to next member
+  returns false if no members remain
+ */
+bool xlb_container_iter_next(const adlb_container *c,
+                             xlb_container_iter *it);
+
+/**
+  Value that changes when members are moved around, so that a saved
+  iterator position is no longer valid
+ */
+static inline int
+xlb_container_layout(const adlb_container *c)
+{
+  return c->dense ? -1 : c->members->capacity;
+}
+
+#endif // XLB_CONTAINER_H
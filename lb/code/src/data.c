@@ -27,11 +27,13 @@
 #include <list_i.h>
 #include <list_l.h>
 #include <table_bp.h>
-#include <table_lp.h>
+#include <rhtable_lp.h>
 #include <vint.h>
 
 #include "adlb.h"
 #include "adlb_types.h"
+#include "closed_summary.h"
+#include "container.h"
 #include "data.h"
 #include "data_cleanup.h"
 #include "data_internal.h"
@@ -40,17 +42,28 @@
 #include "multiset.h"
 #include "notifications.h"
 #include "refcount.h"
+#include "slab.h"
 #include "sync.h"
 
 /**
    Map from adlb_datum_id to adlb_datum
 */
-static struct table_lp tds;
+static struct rhtable_lp tds;
 
 /**
    Map from adlb_datum_id to int rank if locked
 */
-static struct table_lp locked;
+static struct rhtable_lp locked;
+
+/**
+   Map from cursor number to enum_cursor for enumerations in progress
+*/
+static struct rhtable_lp cursors;
+
+/**
+   Next cursor number.  Note that 0 is used for no cursor.
+*/
+static int64_t next_cursor = 1;
 
 /**
    Number of ADLB servers
@@ -101,6 +114,12 @@ static adlb_data_code datum_gc(adlb_datum_id id, adlb_datum* d,
 static xlb_listener_reference *
 alloc_listener_reference(size_t subscript_len);
 
+static bool
+add_listener(adlb_datum *d, binkey_packed_t key, xlb_listener *listener);
+
+static void
+free_listener_node(struct rbtree_bp_node *node);
+
 static adlb_data_code
 data_store_root(adlb_datum_id id, adlb_datum *d,
     void *buffer, size_t length, bool copy, bool *took_ownership,
@@ -186,14 +205,20 @@ xlb_data_init(int s, int server_num)
   if (unique == 0) unique += s;
 
   bool result;
-  result = table_lp_init(&tds, 1024*1024);
+  result = rhtable_lp_init(&tds, 1024*1024);
   if (!result)
     return ADLB_DATA_ERROR_OOM;
 
-  result = table_lp_init(&locked, 16);
+  result = rhtable_lp_init(&locked, 16);
   if (!result)
     return ADLB_DATA_ERROR_OOM;
 
+  result = rhtable_lp_init(&cursors, 16);
+  if (!result)
+    return ADLB_DATA_ERROR_OOM;
+
+  getenv_boolean("ADLB_DENSE_CONTAINERS", true, &xlb_dense_containers);
+
   last_id = LONG_MAX - servers - 1;
 
   xlb_min_alloced_system_id = 0;
@@ -221,7 +246,8 @@ xlb_data_create(adlb_datum_id id, adlb_data_type type,
           ADLB_Data_type_tostring(type_extra->CONTAINER.val_type));
 
 #ifndef NDEBUG
-  ADLB_CHECK_MSG_CODE(!table_lp_contains(&tds, id), ADLB_DATA_ERROR_DOUBLE_DECLARE,
+  ADLB_CHECK_MSG_CODE(!rhtable_lp_contains(&tds, id),
+                ADLB_DATA_ERROR_DOUBLE_DECLARE,
                 ADLB_PRID" already exists",
                 ADLB_PRID_ARGS(id, props->symbol));
 #endif
@@ -233,14 +259,21 @@ xlb_data_create(adlb_datum_id id, adlb_data_type type,
     return ADLB_DATA_SUCCESS;
   }
 
-  adlb_datum* d = malloc(sizeof(adlb_datum));
+  adlb_datum* d = xlb_slab_alloc(&xlb_datum_slab);
   ADLB_CHECK_MSG_CODE(d != NULL, ADLB_DATA_ERROR_OOM,
                 "Out of memory while allocating datum");
   d->type = type;
   d->symbol = props->symbol;
   rbtree_bp_init(&d->listeners);
 
-  table_lp_add(&tds, id, d);
+  if (!rhtable_lp_add(&tds, id, d))
+  {
+    // Table rejects duplicate IDs, so this may not be out of memory
+    xlb_slab_free(&xlb_datum_slab, d);
+    ADLB_CHECK_MSG_CODE(false, ADLB_DATA_ERROR_OOM,
+                  "Could not add "ADLB_PRID" to data table",
+                  ADLB_PRID_ARGS(id, props->symbol));
+  }
 
   adlb_data_code dc = datum_init_props(id, d, props);
   ADLB_DATA_CHECK_CODE(dc);
@@ -304,7 +337,7 @@ xlb_data_exists(adlb_datum_id id, adlb_subscript subscript, bool* result)
 {
   adlb_data_code dc;
   adlb_datum* d;
-  table_lp_search(&tds, id, (void**)&d);
+  rhtable_lp_search(&tds, id, (void**)&d);
 
   // if subscript provided, check that subscript exists
   if (!adlb_has_sub(subscript))
@@ -388,7 +421,7 @@ adlb_data_code xlb_data_permanent(adlb_datum_id id)
 adlb_data_code
 xlb_datum_lookup(adlb_datum_id id, adlb_datum **d)
 {
-  bool found = table_lp_search(&tds, id, (void**)d);
+  bool found = rhtable_lp_search(&tds, id, (void**)d);
   ADLB_CHECK_MSG_CODE(found, ADLB_DATA_ERROR_NOT_FOUND,
                 "not found: "ADLB_PRID,
                 ADLB_PRID_ARGS(id, ADLB_DSYM_NULL));
@@ -426,6 +459,51 @@ xlb_data_reference_count(adlb_datum_id id, adlb_refc change,
                        garbage_collected, notifs);
 }
 
+/*
+  Check that change would not take refcounts of d negative
+ */
+static adlb_data_code
+refc_change_check(const adlb_datum *d, adlb_datum_id id,
+                  adlb_refc change)
+{
+  int read_incr = change.read_refcount;
+  int write_incr = change.write_refcount;
+
+  if (xlb_s.read_refc_enabled && read_incr != 0 &&
+                                   !d->status.permanent) {
+    /*
+      Should not go negative.  Can go to zero and back up if write
+      refcount still present.
+     */
+    ADLB_CHECK_MSG_CODE(d->read_refcount >= 0 &&
+                   d->read_refcount + read_incr >= 0,
+                ADLB_DATA_ERROR_REFCOUNT_NEGATIVE,
+                ADLB_PRID" read_refcount: %i incr: %i",
+                ADLB_PRID_ARGS(id, d->symbol),
+                d->read_refcount, read_incr);
+  }
+
+  if (write_incr != 0) {
+    // Should not go negative
+    ADLB_CHECK_MSG_CODE(d->write_refcount > 0 &&
+                   d->write_refcount + write_incr >= 0,
+                ADLB_DATA_ERROR_REFCOUNT_NEGATIVE,
+                ADLB_PRID" write_refcount: %i incr: %i",
+                ADLB_PRID_ARGS(id, d->symbol),
+                d->write_refcount, write_incr);
+  }
+  return ADLB_DATA_SUCCESS;
+}
+
+adlb_data_code
+xlb_data_reference_count_check(adlb_datum_id id, adlb_refc change)
+{
+  adlb_datum* d;
+  adlb_data_code dc = xlb_datum_lookup(id, &d);
+  ADLB_DATA_CHECK_CODE(dc);
+  return refc_change_check(d, id, change);
+}
+
 adlb_data_code
 xlb_refc_incr(adlb_datum *d, adlb_datum_id id,
           adlb_refc change, xlb_refc_acquire acquire,
@@ -443,23 +521,11 @@ xlb_refc_incr(adlb_datum *d, adlb_datum_id id,
   int read_incr = change.read_refcount;
   int write_incr = change.write_refcount;
 
+  dc = refc_change_check(d, id, change);
+  ADLB_DATA_CHECK_CODE(dc);
+
   if (xlb_s.read_refc_enabled && read_incr != 0 &&
                                    !d->status.permanent) {
-    // Shouldn't get here if disabled
-    ADLB_CHECK_MSG_CODE(xlb_s.read_refc_enabled, ADLB_DATA_ERROR_INVALID,
-                  "Internal error: should not get here with read reference "
-                  "counting disabled");
-
-    /*
-      Should not go negative.  Can go to zero and back up if write
-      refcount still present.
-     */
-    ADLB_CHECK_MSG_CODE(d->read_refcount >= 0 &&
-                   d->read_refcount + read_incr >= 0,
-                ADLB_DATA_ERROR_REFCOUNT_NEGATIVE,
-                ADLB_PRID" read_refcount: %i incr: %i",
-                ADLB_PRID_ARGS(id, d->symbol),
-                d->read_refcount, read_incr);
     d->read_refcount += read_incr;
     DEBUG("read_refcount: "ADLB_PRID" => %i",
           ADLB_PRID_ARGS(id, d->symbol), d->read_refcount);
@@ -469,13 +535,6 @@ xlb_refc_incr(adlb_datum *d, adlb_datum_id id,
   bool closed = false;
 
   if (write_incr != 0) {
-    // Should not go negative
-    ADLB_CHECK_MSG_CODE(d->write_refcount > 0 &&
-                   d->write_refcount + write_incr >= 0,
-                ADLB_DATA_ERROR_REFCOUNT_NEGATIVE,
-                ADLB_PRID" write_refcount: %i incr: %i",
-                ADLB_PRID_ARGS(id, d->symbol),
-                d->write_refcount, write_incr);
     d->write_refcount += write_incr;
     if (d->write_refcount == 0) {
       // If we're keeping around read-only version, release
@@ -484,6 +543,10 @@ xlb_refc_incr(adlb_datum *d, adlb_datum_id id,
       ADLB_DATA_CHECK_CODE(dc);
 
       closed = true;
+
+      // Only IDs from xlb_data_unique() are summarized
+      if (id > 0 && id < unique)
+        xlb_closed_summary_add(id);
     }
     DEBUG("write_refcount: "ADLB_PRID" => %i",
       ADLB_PRID_ARGS(id, d->symbol), d->write_refcount);
@@ -546,10 +609,10 @@ datum_gc(adlb_datum_id id, adlb_datum* d,
         d->listeners.size, ADLB_PRID_ARGS(id, d->symbol));
 
   void *tmp;
-  table_lp_remove(&tds, id, &tmp);
+  rhtable_lp_remove(&tds, id, &tmp);
   assert(tmp == d);
 
-  free(d);
+  xlb_slab_free(&xlb_datum_slab, d);
   return ADLB_DATA_SUCCESS;
 }
 
@@ -560,7 +623,7 @@ xlb_data_lock(adlb_datum_id id, int rank, bool* result)
   adlb_data_code dc = xlb_datum_lookup(id, &d);
   ADLB_DATA_CHECK_CODE(dc);
 
-  if (table_lp_contains(&locked, id))
+  if (rhtable_lp_contains(&locked, id))
   {
     *result = false;
     return ADLB_DATA_SUCCESS;
@@ -570,7 +633,7 @@ xlb_data_lock(adlb_datum_id id, int rank, bool* result)
     int* r = malloc(sizeof(int));
     *r = rank;
     *result = true;
-    table_lp_add(&locked, id, (void*)r);
+    rhtable_lp_add(&locked, id, (void*)r);
   }
 
   return ADLB_DATA_SUCCESS;
@@ -580,7 +643,7 @@ adlb_data_code
 xlb_data_unlock(adlb_datum_id id)
 {
   int* r;
-  bool found = table_lp_remove(&locked, id, (void**)&r);
+  bool found = rhtable_lp_remove(&locked, id, (void**)&r);
   ADLB_CHECK_MSG_CODE(found, ADLB_DATA_ERROR_NOT_FOUND,
                 "not found: "ADLB_PRID,
                 ADLB_PRID_ARGS(id, ADLB_DSYM_NULL));
@@ -631,13 +694,13 @@ xlb_data_subscribe(adlb_datum_id id, adlb_subscript subscript,
       binkey_packed_t key;
       binkey_packed_set_unsafe(&key, (void*)subscript.key, subscript.length);
 
-      xlb_listener *listener = malloc(sizeof(*listener));
+      xlb_listener *listener = xlb_slab_alloc(&xlb_listener_slab);
       ADLB_DATA_CHECK_MALLOC(listener);
       listener->tag = LISTENER_NOTIF;
       listener->notif.rank = rank;
       listener->notif.work_type = work_type;
 
-      bool ok = rbtree_bp_add(&d->listeners, key, listener);
+      bool ok = add_listener(d, key, listener);
       ADLB_CHECK_MSG_CODE(ok, ADLB_DATA_ERROR_OOM, "Out of memory");
 
       TRACE("Added %i to listeners for "ADLB_PRIDSUB, rank,
@@ -664,7 +727,7 @@ xlb_data_subscribe(adlb_datum_id id, adlb_subscript subscript,
     }
     else
     {
-      xlb_listener *listener = malloc(sizeof(*listener));
+      xlb_listener *listener = xlb_slab_alloc(&xlb_listener_slab);
       ADLB_DATA_CHECK_MALLOC(listener);
 
       listener->tag = LISTENER_NOTIF;
@@ -673,7 +736,7 @@ xlb_data_subscribe(adlb_datum_id id, adlb_subscript subscript,
       binkey_packed_t key;
       binkey_packed_set_unsafe(&key, NULL, 0);
 
-      bool ok = rbtree_bp_add(&d->listeners, key, listener);
+      bool ok = add_listener(d, key, listener);
       ADLB_CHECK_MSG_CODE(ok, ADLB_DATA_ERROR_OOM, "Out of memory");
       *subscribed = true;
     }
@@ -786,7 +849,7 @@ adlb_data_code xlb_data_container_reference(adlb_datum_id id,
   ADLB_CHECK_MSG_CODE(ref != NULL, ADLB_DATA_ERROR_OOM,
                 "Could not allocate memory");
 
-  xlb_listener *listener = malloc(sizeof(*listener));
+  xlb_listener *listener = xlb_slab_alloc(&xlb_listener_slab);
   ADLB_CHECK_MSG_CODE(listener != NULL, ADLB_DATA_ERROR_OOM,
                 "Could not allocate memory");
   listener->tag = LISTENER_REF;
@@ -804,13 +867,45 @@ adlb_data_code xlb_data_container_reference(adlb_datum_id id,
   TRACE("Added reference listener %p for [%.*s] %d", listener,
         (int)binkey_packed_len(&sub_key), (char*)binkey_packed_get(&sub_key),
         (int)binkey_packed_len(&sub_key));
-  rbtree_bp_add(&d->listeners, sub_key, listener);
+  bool ok = add_listener(d, sub_key, listener);
+  ADLB_CHECK_MSG_CODE(ok, ADLB_DATA_ERROR_OOM, "Out of memory");
   d->status.subscript_notifs = true;
 
   result->data = NULL;
   return ADLB_DATA_SUCCESS;
 }
 
+/*
+  Add listener to tree, using a tree node from the listener node slab
+ */
+static bool
+add_listener(adlb_datum *d, binkey_packed_t key, xlb_listener *listener)
+{
+  struct rbtree_bp_node *node = xlb_slab_alloc(&xlb_listener_node_slab);
+  if (node == NULL)
+    return false;
+
+  if (!rbtree_bp_node_init(node, key, listener))
+  {
+    xlb_slab_free(&xlb_listener_node_slab, node);
+    return false;
+  }
+
+  rbtree_bp_add_node(&d->listeners, node);
+  return true;
+}
+
+/*
+  Free a listener tree node allocated by add_listener(),
+  after it has been removed from the tree.
+ */
+static void
+free_listener_node(struct rbtree_bp_node *node)
+{
+  binkey_packed_free(&node->key);
+  xlb_slab_free(&xlb_listener_node_slab, node);
+}
+
 static xlb_listener_reference *
 alloc_listener_reference(size_t subscript_len)
 {
@@ -1380,9 +1475,7 @@ static adlb_data_code container_add(adlb_container *c, adlb_subscript sub,
                               adlb_container_val val)
 {
   TRACE("Adding %p to %p", val, c);
-  bool ok = table_bp_add(c->members, sub.key, sub.length, val);
-
-  return ok ? ADLB_DATA_SUCCESS : ADLB_DATA_ERROR_OOM;
+  return xlb_container_add(c, sub, val);
 }
 
 /**
@@ -1392,7 +1485,7 @@ static bool container_set(adlb_container *c, adlb_subscript sub,
                               adlb_container_val val,
                               adlb_container_val *prev)
 {
-  return table_bp_set(c->members, sub.key, sub.length, val, (void**)prev);
+  return xlb_container_set(c, sub, val, prev);
 }
 
 /**
@@ -1401,7 +1494,7 @@ static bool container_set(adlb_container *c, adlb_subscript sub,
 static bool container_lookup(const adlb_container *c, adlb_subscript sub,
                              adlb_container_val *val)
 {
-  return table_bp_search(c->members, sub.key, sub.length, (void**)val);
+  return xlb_container_lookup(c, sub, val);
 }
 
 /**
@@ -1421,13 +1514,13 @@ static bool container_value_exists(const adlb_container *c,
 }
 
 static adlb_data_code
-pack_member(adlb_container *cont, table_bp_entry *item,
+pack_member(adlb_container *cont, const xlb_container_iter *item,
             bool include_keys, bool include_vals,
             const adlb_buffer *tmp_buf, adlb_buffer *result,
             bool *result_caller_buffer, size_t* result_pos);
 
 /**
-   Extract the table members into a buffer.
+   Extract the container members into a buffer.
    count: -1 for all past offset, or the exact expected count based
         on the array size.
  */
@@ -1439,7 +1532,6 @@ extract_members(adlb_container *cont, int count, int offset,
 {
   int c = 0; // Count of members seen
   adlb_data_code dc;
-  struct table_bp* members = cont->members;
   bool use_caller_buf;
 
   dc = ADLB_Init_buf(caller_buffer, output, &use_caller_buf, 65536);
@@ -1453,7 +1545,7 @@ extract_members(adlb_container *cont, int count, int offset,
 
   size_t output_pos = 0; // Amount of output used
 
-  TABLE_BP_FOREACH(members, item)
+  XLB_CONTAINER_FOREACH(cont, item)
   {
     if (c >= offset)
     {
@@ -1462,7 +1554,7 @@ extract_members(adlb_container *cont, int count, int offset,
         TRACE("Got %i/%i items, done\n", c+1, count);
         goto extract_members_done;
       }
-      dc = pack_member(cont, item, include_keys, include_vals, &tmp_buf,
+      dc = pack_member(cont, &item, include_keys, include_vals, &tmp_buf,
                        output, &use_caller_buf, &output_pos);
       ADLB_DATA_CHECK_CODE(dc);
     }
@@ -1470,13 +1562,13 @@ extract_members(adlb_container *cont, int count, int offset,
   }
 
   TRACE("Got %i/%i entries at offset %i table size %i\n", c-offset, count,
-                offset, members->size);
+                offset, xlb_container_size(cont));
   // Should have found requested number
   if (count != -1 && c - offset != count)
   {
     DEBUG("Warning: did not get expected count when enumerating array. "
           "Got %i/%i entries at offset %i table size %i\n",
-          c-offset, count, offset, members->size);
+          c-offset, count, offset, xlb_container_size(cont));
   }
 
 extract_members_done:
@@ -1487,25 +1579,23 @@ extract_members_done:
 }
 
 static adlb_data_code
-pack_member(adlb_container *cont, table_bp_entry *item,
+pack_member(adlb_container *cont, const xlb_container_iter *item,
             bool include_keys, bool include_vals,
             const adlb_buffer *tmp_buf, adlb_buffer *result,
             bool *result_caller_buffer, size_t* result_pos)
 {
-  assert(table_bp_entry_valid(item));
-
   adlb_data_code dc;
   if (include_keys)
   {
-    assert(table_bp_key_len(item) <= INT_MAX);
+    assert(item->key_len <= INT_MAX);
     dc = ADLB_Append_buffer(ADLB_DATA_TYPE_NULL,
-            table_bp_get_key(item), table_bp_key_len(item),
+            item->key, item->key_len,
             true, result, result_caller_buffer, result_pos);
     ADLB_DATA_CHECK_CODE(dc);
   }
   if (include_vals)
   {
-    dc = ADLB_Pack_buffer(item->data, (adlb_data_type)cont->val_type,
+    dc = ADLB_Pack_buffer(item->val, (adlb_data_type)cont->val_type,
           true, tmp_buf, result, result_caller_buffer, result_pos);
     ADLB_DATA_CHECK_CODE(dc);
   }
@@ -1562,7 +1652,7 @@ xlb_data_enumerate(adlb_datum_id id, int count, int offset,
   if (d->type == ADLB_DATA_TYPE_CONTAINER)
   {
     int slice_size = enumerate_slice_size(offset, count,
-                        d->data.CONTAINER.members->size);
+                        xlb_container_size(&d->data.CONTAINER));
 
     if (include_keys || include_vals)
     {
@@ -1611,6 +1701,477 @@ xlb_data_enumerate(adlb_datum_id id, int count, int offset,
   return ADLB_DATA_ERROR_UNKNOWN;
 }
 
+/**
+   Server-side state of an enumeration in progress.  Containers resume
+   from the position where the previous chunk stopped, so each
+   member is visited once.  Closed containers can't change, so this is
+   exact.  If members are added to an open container in between, they
+   may be missed; if that moves members around, e.g. by resizing the
+   table, the position is found again by skipping as many members as
+   were already returned, so the count stays right but members may be
+   repeated or missed, as with offset-based enumeration.
+ */
+typedef struct
+{
+  adlb_datum_id id;
+  int returned; // Count of members returned so far
+  int pos; // Iterator position of next member
+  int chain_pos;
+  int layout; // Container layout when position was recorded
+} enum_cursor;
+
+/**
+   Extract next count members at cursor into a buffer.
+   count: negative for all remaining members
+   done: set to true if no members remain
+ */
+static adlb_data_code
+extract_members_cursor(adlb_container *cont, enum_cursor *cur, int count,
+                bool include_keys, bool include_vals,
+                const adlb_buffer *caller_buffer,
+                adlb_buffer *output, int *actual, bool *done)
+{
+  adlb_data_code dc;
+  xlb_container_iter it = XLB_CONTAINER_ITER_INIT;
+
+  if (cur->layout != xlb_container_layout(cont))
+  {
+    // Members were moved: count off members already returned
+    for (int i = 0; i < cur->returned; i++)
+    {
+      if (!xlb_container_iter_next(cont, &it))
+        break;
+    }
+    cur->layout = xlb_container_layout(cont);
+  }
+  else
+  {
+    it.pos = cur->pos;
+    it.chain_pos = cur->chain_pos;
+  }
+
+  bool pack = include_keys || include_vals;
+  bool use_caller_buf;
+  size_t output_pos = 0;
+  adlb_buffer tmp_buf;
+  char tmp_storage[XLB_STACK_BUFFER_LEN];
+  tmp_buf.length = XLB_STACK_BUFFER_LEN;
+  tmp_buf.data = tmp_storage;
+  if (pack)
+  {
+    dc = ADLB_Init_buf(caller_buffer, output, &use_caller_buf, 65536);
+    ADLB_DATA_CHECK_CODE(dc);
+  }
+
+  int c = 0;
+  *done = false;
+  while (count < 0 || c < count)
+  {
+    if (!xlb_container_iter_next(cont, &it))
+    {
+      *done = true;
+      break;
+    }
+    if (pack)
+    {
+      dc = pack_member(cont, &it, include_keys, include_vals, &tmp_buf,
+                       output, &use_caller_buf, &output_pos);
+      ADLB_DATA_CHECK_CODE(dc);
+    }
+    c++;
+  }
+
+  if (!*done)
+  {
+    // Check for members after chunk
+    xlb_container_iter peek = it;
+    *done = !xlb_container_iter_next(cont, &peek);
+  }
+
+  if (pack)
+    output->length = output_pos;
+  cur->pos = it.pos;
+  cur->chain_pos = it.chain_pos;
+  cur->returned += c;
+  *actual = c;
+  TRACE("extract_members_cursor: %i entries, %i total, done: %i\n",
+        c, cur->returned, (int)*done);
+  return ADLB_DATA_SUCCESS;
+}
+
+adlb_data_code
+xlb_data_enumerate_cursor(adlb_datum_id id, int64_t *cursor, int count,
+               bool include_keys, bool include_vals,
+               const adlb_buffer *caller_buffer,
+               adlb_buffer *data, int* actual,
+               adlb_data_type *key_type, adlb_data_type *val_type)
+{
+  TRACE("data_enumerate_cursor(%"PRId64", %"PRId64")", id, *cursor);
+  adlb_datum* d;
+  adlb_data_code dc = xlb_datum_lookup(id, &d);
+  if (dc != ADLB_DATA_SUCCESS)
+  {
+    xlb_data_enumerate_close(*cursor);
+    *cursor = 0;
+    return dc;
+  }
+
+  if (d->type == ADLB_DATA_TYPE_MULTISET)
+  {
+    ADLB_CHECK_MSG_CODE(!include_keys, ADLB_DATA_ERROR_TYPE, ADLB_PRID
+        " with type multiset does not have keys to enumerate",
+        ADLB_PRID_ARGS(id, d->symbol));
+  }
+  else if (d->type != ADLB_DATA_TYPE_CONTAINER)
+  {
+    verbose_error(ADLB_DATA_ERROR_TYPE, "enumeration of "ADLB_PRID
+      " with type %s not supported", ADLB_PRID_ARGS(id, d->symbol),
+      ADLB_Data_type_tostring(d->type));
+  }
+
+  enum_cursor *cur;
+  if (*cursor == 0)
+  {
+    cur = malloc(sizeof(*cur));
+    ADLB_DATA_CHECK_MALLOC(cur);
+    cur->id = id;
+    cur->returned = 0;
+    cur->pos = 0;
+    cur->chain_pos = 0;
+    cur->layout = (d->type == ADLB_DATA_TYPE_CONTAINER) ?
+                  xlb_container_layout(&d->data.CONTAINER) : 0;
+    *cursor = next_cursor++;
+    bool ok = rhtable_lp_add(&cursors, *cursor, cur);
+    if (!ok)
+    {
+      free(cur);
+      *cursor = 0;
+      return ADLB_DATA_ERROR_OOM;
+    }
+  }
+  else
+  {
+    void *tmp;
+    bool found = rhtable_lp_search(&cursors, *cursor, &tmp);
+    ADLB_CHECK_MSG_CODE(found, ADLB_DATA_ERROR_INVALID,
+          "enumeration cursor %"PRId64" not found", *cursor);
+    cur = tmp;
+    ADLB_CHECK_MSG_CODE(cur->id == id, ADLB_DATA_ERROR_INVALID,
+          "enumeration cursor %"PRId64" does not belong to "ADLB_PRID,
+          *cursor, ADLB_PRID_ARGS(id, d->symbol));
+  }
+
+  bool done;
+  if (d->type == ADLB_DATA_TYPE_CONTAINER)
+  {
+    dc = extract_members_cursor(&d->data.CONTAINER, cur, count,
+              include_keys, include_vals, caller_buffer, data,
+              actual, &done);
+    *key_type = (adlb_data_type)d->data.CONTAINER.key_type;
+    *val_type = (adlb_data_type)d->data.CONTAINER.val_type;
+  }
+  else
+  {
+    int size = (int)xlb_multiset_size(d->data.MULTISET);
+    int slice_size = enumerate_slice_size(cur->returned, count, size);
+    if (include_vals)
+    {
+      dc = xlb_multiset_extract_slice(d->data.MULTISET, cur->returned,
+                              slice_size, caller_buffer, data);
+    }
+    cur->returned += slice_size;
+    done = (cur->returned >= size);
+    *actual = slice_size;
+    *key_type = ADLB_DATA_TYPE_NULL;
+    *val_type = (adlb_data_type)d->data.MULTISET->elem_type;
+  }
+
+  if (dc != ADLB_DATA_SUCCESS || done)
+  {
+    // Release cursor: client must not use it again
+    xlb_data_enumerate_close(*cursor);
+    *cursor = 0;
+  }
+  return dc;
+}
+
+void
+xlb_data_enumerate_close(int64_t cursor)
+{
+  void *cur;
+  if (cursor != 0 && rhtable_lp_remove(&cursors, cursor, &cur))
+  {
+    TRACE("data_enumerate_close(%"PRId64")", cursor);
+    free(cur);
+  }
+}
+
+/*
+  Running state of reduction
+ */
+typedef struct
+{
+  adlb_reduce_op op;
+  adlb_data_type val_type;
+  int64_t count; // Values seen
+  adlb_datum_storage acc; // For sum/min/max
+  adlb_buffer *output; // For concat
+  bool output_caller_buffer;
+  size_t output_pos;
+} reduce_state;
+
+static adlb_data_code
+reduce_value(reduce_state *r, const adlb_datum_storage *val)
+{
+  if (val == NULL)
+  {
+    // Subscript reserved but not yet assigned
+    return ADLB_DATA_SUCCESS;
+  }
+
+  bool first = (r->count == 0);
+  r->count++;
+  switch (r->op)
+  {
+    case ADLB_REDUCE_SUM:
+      if (r->val_type == ADLB_DATA_TYPE_INTEGER)
+        r->acc.INTEGER += val->INTEGER;
+      else
+        r->acc.FLOAT += val->FLOAT;
+      break;
+    case ADLB_REDUCE_MIN:
+      if (r->val_type == ADLB_DATA_TYPE_INTEGER)
+      {
+        if (first || val->INTEGER < r->acc.INTEGER)
+          r->acc.INTEGER = val->INTEGER;
+      }
+      else if (first || val->FLOAT < r->acc.FLOAT)
+      {
+        r->acc.FLOAT = val->FLOAT;
+      }
+      break;
+    case ADLB_REDUCE_MAX:
+      if (r->val_type == ADLB_DATA_TYPE_INTEGER)
+      {
+        if (first || val->INTEGER > r->acc.INTEGER)
+          r->acc.INTEGER = val->INTEGER;
+      }
+      else if (first || val->FLOAT > r->acc.FLOAT)
+      {
+        r->acc.FLOAT = val->FLOAT;
+      }
+      break;
+    case ADLB_REDUCE_CONCAT:
+      // Append without null terminator
+      return ADLB_Append_buffer(ADLB_DATA_TYPE_STRING,
+            val->STRING.value, val->STRING.length - 1, false,
+            r->output, &r->output_caller_buffer, &r->output_pos);
+    case ADLB_REDUCE_COUNT:
+      break;
+  }
+  return ADLB_DATA_SUCCESS;
+}
+
+/**
+   Check that operator applies to values of type
+   Returns type of result
+ */
+static adlb_data_code
+reduce_result_type(adlb_reduce_op op, adlb_data_type val_type,
+                   adlb_data_type *result_type)
+{
+  switch (op)
+  {
+    case ADLB_REDUCE_SUM:
+    case ADLB_REDUCE_MIN:
+    case ADLB_REDUCE_MAX:
+      if (val_type != ADLB_DATA_TYPE_INTEGER &&
+          val_type != ADLB_DATA_TYPE_FLOAT)
+        return ADLB_DATA_ERROR_TYPE;
+      *result_type = val_type;
+      return ADLB_DATA_SUCCESS;
+    case ADLB_REDUCE_COUNT:
+      *result_type = ADLB_DATA_TYPE_INTEGER;
+      return ADLB_DATA_SUCCESS;
+    case ADLB_REDUCE_CONCAT:
+      if (val_type != ADLB_DATA_TYPE_STRING)
+        return ADLB_DATA_ERROR_TYPE;
+      *result_type = ADLB_DATA_TYPE_STRING;
+      return ADLB_DATA_SUCCESS;
+  }
+  return ADLB_DATA_ERROR_INVALID;
+}
+
+adlb_data_code
+xlb_data_reduce(adlb_datum_id id, adlb_reduce_op op,
+               const adlb_buffer *caller_buffer,
+               adlb_buffer *result, adlb_data_type *type)
+{
+  TRACE("data_reduce(%"PRId64", %i)", id, (int)op);
+  adlb_datum* d;
+  adlb_data_code dc = xlb_datum_lookup(id, &d);
+  ADLB_DATA_CHECK_CODE(dc);
+
+  adlb_data_type val_type;
+  if (d->type == ADLB_DATA_TYPE_CONTAINER)
+  {
+    val_type = (adlb_data_type)d->data.CONTAINER.val_type;
+  }
+  else if (d->type == ADLB_DATA_TYPE_MULTISET)
+  {
+    val_type = (adlb_data_type)d->data.MULTISET->elem_type;
+  }
+  else
+  {
+    verbose_error(ADLB_DATA_ERROR_TYPE, "reduction of "ADLB_PRID
+      " with type %s not supported", ADLB_PRID_ARGS(id, d->symbol),
+      ADLB_Data_type_tostring(d->type));
+  }
+
+  adlb_data_type result_type;
+  dc = reduce_result_type(op, val_type, &result_type);
+  ADLB_CHECK_MSG_CODE(dc == ADLB_DATA_SUCCESS, dc,
+        "reduction %i of "ADLB_PRID" with value type %s not supported",
+        (int)op, ADLB_PRID_ARGS(id, d->symbol),
+        ADLB_Data_type_tostring(val_type));
+
+  reduce_state r = { .op = op, .val_type = val_type, .count = 0,
+                     .output = result, .output_pos = 0 };
+  memset(&r.acc, 0, sizeof(r.acc));
+
+  // Scalar results fit in any buffer
+  dc = ADLB_Init_buf(caller_buffer, result, &r.output_caller_buffer,
+          op == ADLB_REDUCE_CONCAT ? 65536 : sizeof(adlb_datum_storage));
+  ADLB_DATA_CHECK_CODE(dc);
+
+  if (d->type == ADLB_DATA_TYPE_CONTAINER)
+  {
+    XLB_CONTAINER_FOREACH(&d->data.CONTAINER, item)
+    {
+      dc = reduce_value(&r, item.val);
+      ADLB_DATA_CHECK_CODE(dc);
+    }
+  }
+  else
+  {
+    xlb_multiset *ms = d->data.MULTISET;
+    for (uint i = 0; i < ms->chunk_count; i++)
+    {
+      uint chunk_elems = (i == ms->chunk_count - 1) ?
+            ms->last_chunk_elems : XLB_MULTISET_CHUNK_SIZE;
+      for (uint j = 0; j < chunk_elems; j++)
+      {
+        dc = reduce_value(&r, &ms->chunks[i]->arr[j]);
+        ADLB_DATA_CHECK_CODE(dc);
+      }
+    }
+  }
+
+  switch (op)
+  {
+    case ADLB_REDUCE_COUNT:
+      r.acc.INTEGER = r.count;
+      // Fall through
+    case ADLB_REDUCE_SUM:
+    case ADLB_REDUCE_MIN:
+    case ADLB_REDUCE_MAX:
+      if ((op == ADLB_REDUCE_MIN || op == ADLB_REDUCE_MAX) && r.count == 0)
+      {
+        // No values to take min/max of
+        result->length = 0;
+        *type = ADLB_DATA_TYPE_NULL;
+        return ADLB_DATA_SUCCESS;
+      }
+      if (result_type == ADLB_DATA_TYPE_INTEGER)
+      {
+        memcpy(result->data, &r.acc.INTEGER, sizeof(r.acc.INTEGER));
+        result->length = sizeof(r.acc.INTEGER);
+      }
+      else
+      {
+        memcpy(result->data, &r.acc.FLOAT, sizeof(r.acc.FLOAT));
+        result->length = sizeof(r.acc.FLOAT);
+      }
+      break;
+    case ADLB_REDUCE_CONCAT:
+    {
+      char nul = '\0';
+      dc = ADLB_Append_buffer(ADLB_DATA_TYPE_STRING, &nul, 1, false,
+            result, &r.output_caller_buffer, &r.output_pos);
+      ADLB_DATA_CHECK_CODE(dc);
+      result->length = r.output_pos;
+      break;
+    }
+  }
+
+  *type = result_type;
+  TRACE("Reduce "ADLB_PRID": %"PRId64" values %zu bytes",
+        ADLB_PRID_ARGS(id, d->symbol), r.count, result->length);
+  return ADLB_DATA_SUCCESS;
+}
+
+adlb_data_code
+xlb_data_retrieve_array(adlb_datum_id id,
+               const adlb_buffer *caller_buffer,
+               adlb_buffer *result, adlb_data_type *type, int *count)
+{
+  TRACE("data_retrieve_array(%"PRId64")", id);
+  adlb_datum* d;
+  adlb_data_code dc = xlb_datum_lookup(id, &d);
+  ADLB_DATA_CHECK_CODE(dc);
+
+  ADLB_CHECK_MSG_CODE(d->type == ADLB_DATA_TYPE_CONTAINER,
+      ADLB_DATA_ERROR_TYPE, "retrieve array of "ADLB_PRID
+      " with type %s not supported", ADLB_PRID_ARGS(id, d->symbol),
+      ADLB_Data_type_tostring(d->type));
+
+  adlb_container *c = &d->data.CONTAINER;
+  adlb_data_type val_type = (adlb_data_type)c->val_type;
+  ADLB_CHECK_MSG_CODE(c->key_type == ADLB_DATA_TYPE_INTEGER &&
+      (val_type == ADLB_DATA_TYPE_INTEGER ||
+       val_type == ADLB_DATA_TYPE_FLOAT), ADLB_DATA_ERROR_TYPE,
+      "retrieve array of "ADLB_PRID" with type %s[%s] not supported",
+      ADLB_PRID_ARGS(id, d->symbol), ADLB_Data_type_tostring(val_type),
+      ADLB_Data_type_tostring(c->key_type));
+
+  // Integers and floats are both 8 bytes
+  int n = xlb_container_size(c);
+  size_t elem_size = sizeof(adlb_int_t);
+  assert(sizeof(adlb_float_t) == elem_size);
+
+  bool use_caller_buf;
+  dc = ADLB_Init_buf(caller_buffer, result, &use_caller_buf,
+                     elem_size * (size_t)n);
+  ADLB_DATA_CHECK_CODE(dc);
+  if (n > 0)
+    ADLB_DATA_CHECK_MALLOC(result->data);
+
+  char *out = result->data;
+  for (int i = 0; i < n; i++)
+  {
+    adlb_container_val val;
+    if (!xlb_container_lookup_index(c, i, &val) || val == NULL)
+    {
+      if (!use_caller_buf)
+        free(result->data);
+      // Not an error for caller, who may fall back to enumerating
+      DEBUG("retrieve array of "ADLB_PRID": subscript %i not set, or "
+          "subscripts are not 0..%i", ADLB_PRID_ARGS(id, d->symbol),
+          i, n - 1);
+      return ADLB_DATA_ERROR_SUBSCRIPT_NOT_FOUND;
+    }
+    // Same offset for INTEGER and FLOAT in union
+    memcpy(out + elem_size * (size_t)i, val, elem_size);
+  }
+
+  result->length = elem_size * (size_t)n;
+  *type = val_type;
+  *count = n;
+  TRACE("Retrieve array "ADLB_PRID": %i values", ADLB_PRID_ARGS(id,
+        d->symbol), n);
+  return ADLB_DATA_SUCCESS;
+}
+
 adlb_data_code
 xlb_data_container_size(adlb_datum_id container_id, int* size)
 {
@@ -1621,7 +2182,7 @@ xlb_data_container_size(adlb_datum_id container_id, int* size)
   switch (d->type)
   {
     case ADLB_DATA_TYPE_CONTAINER:
-      *size = d->data.CONTAINER.members->size;
+      *size = xlb_container_size(&d->data.CONTAINER);
       return ADLB_DATA_SUCCESS;
     case ADLB_DATA_TYPE_MULTISET:
       *size = (int)xlb_multiset_size(d->data.MULTISET);
@@ -1830,10 +2391,10 @@ container_notifs_rec(adlb_datum *d, adlb_datum_id id,
    * we need to keep the subscript pointer pointed to it
    */
   bool subscript_uses_buf = (subscript.key == sub_buf->data);
-  TABLE_BP_FOREACH(c->members, item)
+  XLB_CONTAINER_FOREACH(c, item)
   {
-    adlb_subscript component = { .key = table_bp_get_key(item),
-                                 .length = table_bp_key_len(item) };
+    adlb_subscript component = { .key = item.key,
+                                 .length = item.key_len };
 
     // Ensure subscript valid in event of reallocation
     if (subscript_uses_buf)
@@ -1853,7 +2414,7 @@ container_notifs_rec(adlb_datum *d, adlb_datum_id id,
     ADLB_DATA_CHECK_CODE(dc);
 
     // Check for subscriptions on this subscript
-    dc = all_notifs_step(d, id, child_sub, true, item->data,
+    dc = all_notifs_step(d, id, child_sub, true, item.val,
             (adlb_data_type)c->val_type, notifs, garbage_collected);
     ADLB_DATA_CHECK_CODE(dc);
 
@@ -1864,7 +2425,7 @@ container_notifs_rec(adlb_datum *d, adlb_datum_id id,
       return ADLB_DATA_SUCCESS;
     }
 
-    dc = subscript_notifs_rec(d, id, item->data,
+    dc = subscript_notifs_rec(d, id, item.val,
         (adlb_data_type)c->val_type, sub_buf, sub_caller_buf, child_sub,
         notifs, garbage_collected);
     ADLB_DATA_CHECK_CODE(dc);
@@ -1989,7 +2550,7 @@ remove_listeners_node(struct rbtree_bp *listeners,
 
   // Take ownership of memory before freeing node
   binkey_packed_clear(&node->key);
-  rbtree_bp_free_node(node);
+  free_listener_node(node);
 
   return ADLB_DATA_SUCCESS;
 }
@@ -2070,7 +2631,7 @@ adlb_data_code append_notifs(adlb_datum_id id, adlb_datum *d,
       TRACE("Add notif "ADLB_PRIDSUB" to rank %i",
             ADLB_PRIDSUB_ARGS(id, d->symbol, sub), nrank->rank);
 
-      free(listener);
+      xlb_slab_free(&xlb_listener_slab, listener);
     }
     else
     {
@@ -2168,7 +2729,7 @@ adlb_data_code append_notifs(adlb_datum_id id, adlb_datum *d,
       ADLB_DATA_CHECK_ADLB(ac, ADLB_DATA_ERROR_OOM);
 
 
-      free(listener);
+      xlb_slab_free(&xlb_listener_slab, listener);
     }
 
     node = next;
@@ -2264,7 +2825,7 @@ xlb_data_refc_type_tostring(adlb_refcount_type refc_type)
 adlb_dsym xlb_get_dsym(adlb_datum_id id)
 {
   adlb_datum* d;
-  bool found = table_lp_search(&tds, id, (void**)&d);
+  bool found = rhtable_lp_search(&tds, id, (void**)&d);
   if (found)
   {
     assert(d != NULL);
@@ -2332,9 +2893,17 @@ static void free_td_entry(adlb_datum_id id, void *val)
         failed_during_finalize = true;
       }
     }
-    rbtree_bp_clear(&d->listeners);
 
-    free(d);
+    // Release listeners and tree nodes back to slabs
+    struct rbtree_bp_node *node;
+    while ((node = rbtree_bp_leftmost(&d->listeners)) != NULL)
+    {
+      rbtree_bp_remove_node(&d->listeners, node);
+      xlb_slab_free(&xlb_listener_slab, node->data);
+      free_listener_node(node);
+    }
+
+    xlb_slab_free(&xlb_datum_slab, d);
   }
 }
 
@@ -2344,16 +2913,27 @@ static void free_locked_entry(int64_t key, void *val)
   free(val);
 }
 
+static void free_cursor_entry(int64_t key, void *val)
+{
+  enum_cursor *cur = val;
+  assert(cur != NULL);
+  DEBUG("Enumeration of <%"PRId64"> left open: cursor %"PRId64,
+        cur->id, key);
+  free(cur);
+}
+
 adlb_data_code
 xlb_data_finalize()
 {
   // First report any leaks or other problems
   report_leaks();
 
-  table_lp_free_callback(&locked, false, free_locked_entry);
+  rhtable_lp_free_callback(&locked, false, free_locked_entry);
+  // Cursors of clients that stopped enumerating without closing
+  rhtable_lp_free_callback(&cursors, false, free_cursor_entry);
 
   // Finally free up memory allocated in this module
-  table_lp_free_callback(&tds, false, free_td_entry);
+  rhtable_lp_free_callback(&tds, false, free_td_entry);
 
   adlb_data_code dc = xlb_struct_finalize();
   ADLB_DATA_CHECK_CODE(dc);
@@ -2370,7 +2950,7 @@ report_leaks()
   bool report_leaks_setting;
   getenv_boolean("ADLB_REPORT_LEAKS", false, &report_leaks_setting);
 
-  TABLE_LP_FOREACH(&tds, item)
+  RHTABLE_LP_FOREACH(&tds, item)
   {
     adlb_datum *d = item->data;
     if (d == NULL || !d->status.permanent)
@@ -124,6 +124,52 @@ xlb_data_enumerate(adlb_datum_id id, int count, int offset,
                adlb_buffer *data, int* actual,
                adlb_data_type *key_type, adlb_data_type *val_type);
 
+/*
+  Enumerate the next chunk of a container or multiset, resuming from
+  where the previous chunk for the cursor stopped.  The server keeps
+  the position, so enumerating in chunks is linear in the size.
+  cursor: 0 to start a new enumeration, otherwise the cursor returned
+          by the previous call.  Set to 0 after the last chunk, or on
+          error, once the cursor was released.
+  count: maximum number of members to return, negative for all
+  actual: number of members returned
+ */
+adlb_data_code
+xlb_data_enumerate_cursor(adlb_datum_id id, int64_t *cursor, int count,
+               bool include_keys, bool include_vals,
+               const adlb_buffer *caller_buffer,
+               adlb_buffer *data, int* actual,
+               adlb_data_type *key_type, adlb_data_type *val_type);
+
+/*
+  Release cursor before enumeration finished.  Unknown cursors,
+  including 0, are ignored.
+ */
+void xlb_data_enumerate_close(int64_t cursor);
+
+/*
+  Reduce values of container or multiset to a scalar on this server.
+  caller_buffer: optional buffer to provide space for result
+  result: packed result, with allocated memory if not caller_buffer
+  type: type of result, ADLB_DATA_TYPE_NULL if min/max of no values
+ */
+adlb_data_code
+xlb_data_reduce(adlb_datum_id id, adlb_reduce_op op,
+               const adlb_buffer *caller_buffer,
+               adlb_buffer *result, adlb_data_type *type);
+
+/*
+  Gather values of integer-keyed container with integer or float
+  values into an array of int64_t or double indexed by subscript.
+  Subscripts must be exactly 0..count-1, all set.
+  caller_buffer: optional buffer to provide space for result
+  result: array, with allocated memory if not caller_buffer
+ */
+adlb_data_code
+xlb_data_retrieve_array(adlb_datum_id id,
+               const adlb_buffer *caller_buffer,
+               adlb_buffer *result, adlb_data_type *type, int *count);
+
 /*
     copy: if true, this function will not modify or hold a reference to
           buffer.  If false, xlb_data_store might take ownership of buffer
@@ -166,6 +212,13 @@ adlb_data_code xlb_data_reference_count(adlb_datum_id id,
                 xlb_refc_acquire acquire, bool *garbage_collected,
                 adlb_notif_t *notifs);
 
+/*
+  Check that a reference count change could be applied to id now,
+  without modifying anything
+ */
+adlb_data_code xlb_data_reference_count_check(adlb_datum_id id,
+                adlb_refc change);
+
 const char*
 xlb_data_refc_type_tostring(adlb_refcount_type refc_type);
 
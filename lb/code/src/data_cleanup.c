@@ -1,10 +1,10 @@
 #include "data_cleanup.h"
 
+#include "container.h"
 #include "data_structs.h"
 #include "debug.h"
 #include "multiset.h"
 #include "refcount.h"
-#include "table_bp.h"
 
 #include <assert.h>
 #include <stdio.h>
@@ -74,77 +74,53 @@ xlb_members_cleanup(adlb_container *container, bool free_mem,
   xlb_refc_changes *refcs)
 {
   adlb_data_code dc;
-  struct table_bp* members = container->members;
 
   // Whether we are making any refcount changes
   bool refcount_change = release_read || release_write ||
                           !ADLB_REFC_IS_NULL(to_acquire.refcounts);
 
   TRACE("Freeing container %p", container);
-  for (int i = 0; i < members->capacity; i++)
+  XLB_CONTAINER_FOREACH(container, item)
   {
-    table_bp_entry* head = &members->array[i];
-    if (!table_bp_entry_valid(head))
-    {
-      // Empty bucket
-      continue;
-    }
+    adlb_datum_storage *d = item.val;
 
-    // Keep next pointer to allow freeing of item
-    table_bp_entry* item, *next;
-    for (item = head, next = head->next; item != NULL;
-         item = next)
+    TRACE("Freeing %p in %p", d, container);
+    // Value may be null when insert_atomic occurred, but nothing inserted
+    if (refcount_change && d != NULL)
     {
-      next = item->next; // Store next pointer immediately
+      adlb_subscript *sub = &to_acquire.subscript;
+      bool acquire_field = (!adlb_has_sub(*sub) ||
+           (sub->length == item.key_len &&
+            memcmp(sub->key, item.key, item.key_len) == 0));
 
-      adlb_datum_storage *d = (adlb_datum_storage*)item->data;
-      
-      TRACE("Freeing %p in %p", d, container);
-      // Value may be null when insert_atomic occurred, but nothing inserted
-      if (refcount_change && d != NULL)
+      // create new acquire to remove subscript
+      xlb_refc_acquire field_acquire;
+      field_acquire.subscript = ADLB_NO_SUB;
+      if (acquire_field)
       {
-        adlb_subscript *sub = &to_acquire.subscript;
-        bool acquire_field = (!adlb_has_sub(*sub) ||
-             table_bp_key_match(sub->key, sub->length, item));
-
-        // create new acquire to remove subscript
-        xlb_refc_acquire field_acquire;
-        field_acquire.subscript = ADLB_NO_SUB;
-        if (acquire_field)
-        {
-          field_acquire.refcounts = to_acquire.refcounts;
-        }
-        else
-        {
-          field_acquire.refcounts = ADLB_NO_REFC;
-        }
-
-        dc = xlb_incr_referand(d, (adlb_data_type)container->val_type,
-                release_read, release_write, field_acquire, refcs);
-        ADLB_DATA_CHECK_CODE(dc);
+        field_acquire.refcounts = to_acquire.refcounts;
       }
-      // Free the memory for value and key
-      if (free_mem)
+      else
       {
-        if (d != NULL)
-        {
-          dc = ADLB_Free_storage(d, (adlb_data_type)container->val_type);
-          ADLB_DATA_CHECK_CODE(dc);
-          free(d);
-        }
+        field_acquire.refcounts = ADLB_NO_REFC;
       }
-      // Free list node and move to next
-      if (free_mem)
-        table_bp_free_entry(item, item == head);
-    }
-
 
-    // Mark bucket empty
-    if (free_mem)
-      table_bp_clear_entry(head);
+      dc = xlb_incr_referand(d, (adlb_data_type)container->val_type,
+              release_read, release_write, field_acquire, refcs);
+      ADLB_DATA_CHECK_CODE(dc);
+    }
+    // Free the memory for value
+    if (free_mem && d != NULL)
+    {
+      dc = ADLB_Free_storage(d, (adlb_data_type)container->val_type);
+      ADLB_DATA_CHECK_CODE(dc);
+      free(d);
+    }
   }
+
+  // Free keys and member storage
   if (free_mem)
-    table_bp_free(members);
+    xlb_container_free(container);
   return ADLB_DATA_SUCCESS;
 }
 
@@ -39,14 +39,15 @@
 
 #include <c-utils.h>
 #include <list.h>
+#include <jenkins-hash.h>
 #include <list2.h>
-#include <list2_b.h>
 #include <log.h>
 #include <table.h>
 #include <table_bp.h>
 #include <table_lp.h>
 #include <tools.h>
 
+#include "closed_summary.h"
 #include "data_internal.h"
 #include "debug.h"
 #include "sync.h"
@@ -60,6 +61,7 @@ static struct {
   int64_t id_subscribe_local; /* Subscribe to local data */
   int64_t id_subscribe_remote; /* Subscribe to remote data */
   int64_t id_subscribe_cached; /* Cached subscribe to remote data */
+  int64_t id_subscribe_summary; /* Cached via owner's closed summary */
   int64_t id_ready; /* Already closed upon subscribe */
   
   // Counters for ID/subscript combo
@@ -68,6 +70,16 @@ static struct {
   int64_t id_sub_subscribe_remote; /* Subscribe to remote data */
   int64_t id_sub_subscribe_cached; /* Cached subscribe to remote data */
   int64_t id_sub_ready; /* Already closed upon subscribe */
+
+  // Entries evicted from closed caches
+  int64_t id_closed_evicted;
+  int64_t id_sub_closed_evicted;
+
+  // Rule groups
+  int64_t groups; /* Groups created */
+  int64_t group_members; /* Transforms put into groups */
+  int64_t group_shared_inputs; /* Shared inputs registered once */
+  int64_t group_members_held; /* Members that waited for group */
 } xlb_engine_counters;
 
 #define INCR_COUNTER(name) \
@@ -95,39 +107,88 @@ typedef enum
 } transform_status;
 
 /**
-   In-memory structure for data-dependent task
+   In-memory structure for data-dependent task.
+
+   Allocated as a single block: the header is followed by the input
+   TDs, the input TD/subscript pairs, the closed input bit vector, then
+   the subscript keys of the pairs.
+
+   The shared inputs of a rule group are waited for by a transform with
+   no work unit.  Members of the group wait for their own inputs, and
+   are released when the group's transform is ready.
  */
 typedef struct
 {
-  /** Name for human debugging */
-  char* name;
+  /** Entry in transforms_waiting, or groups_waiting for a group */
+  struct list2_item list_entry;
+
+  /** Name for human debugging, interned in transform_names, or NULL */
+  const char* name;
 
-  /** Task to release when inputs are ready */
+  /** Task to release when inputs are ready, NULL for a group */
   xlb_work_unit *work;
 
-  /** Entry in transforms_waiting */
-  struct list2_item *list_entry;
+  /** Group this is a member of or waits for the inputs of.
+      NULL for a member once the group's inputs are closed */
+  xlb_engine_group *group;
 
   /** Number of input tds */
   int input_tds;
-  /** Array of input TDs */
-  adlb_datum_id* input_id_list;
-
   /** Number of input TD/subscript pairs */
   int input_id_subs;
-  /** Array of input TD/subscript pairs */
-  id_sub_pair* input_id_sub_list;
-
-  /** Closed inputs - bit vector for both tds and td/sub pairs */
-  unsigned char *closed_inputs;
   /** Index of next subscribed input (starts at 0 in input_td list,
-      continues into input_id_sub_list) */
+      continues into TD/subscript pairs) */
   int blocker; // Next input we're waiting for
   transform_status status;
+  /** Bytes allocated for this transform */
+  size_t size;
+
+  /** Array of input TDs */
+  adlb_datum_id input_id_list[];
 } transform;
 
 static size_t bitfield_size(int inputs);
 
+/**
+   Group of transforms with shared inputs
+ */
+struct xlb_engine_group
+{
+  /** Waits for the shared inputs, NULL once they are closed */
+  transform *shared;
+  /** Members waiting for the shared inputs */
+  transform **members;
+  int member_count;
+  int member_size;
+  /** True until xlb_engine_group_end() */
+  bool open;
+};
+
+static xlb_engine_code group_release(xlb_engine_group *G,
+                                     xlb_engine_work_array *ready);
+static void group_free(xlb_engine_group *G);
+
+/** Work unit ID for debugging, or -1 for a group */
+static inline xlb_work_unit_id
+transform_id(const transform *T)
+{
+  return T->work != NULL ? T->work->id : -1;
+}
+
+/** Array of input TD/subscript pairs */
+static inline id_sub_pair *
+transform_id_subs(transform *T)
+{
+  return (id_sub_pair*)&T->input_id_list[T->input_tds];
+}
+
+/** Closed inputs - bit vector for both tds and td/sub pairs */
+static inline unsigned char *
+transform_closed_inputs(transform *T)
+{
+  return (unsigned char*)&transform_id_subs(T)[T->input_id_subs];
+}
+
 // Check if input closed
 static inline bool input_id_closed(transform *T, int i);
 static inline void mark_input_id_closed(transform *T, int i);
@@ -169,6 +230,22 @@ bool xlb_engine_initialized = false;
  */
 static struct list2 transforms_waiting;
 
+/**
+   Transforms waiting for the shared inputs of groups.
+ */
+static struct list2 groups_waiting;
+
+/**
+   Names of transforms.  Map from name to count of transforms using it.
+   Transforms point to the key stored in the table.
+ */
+static struct table transform_names;
+
+/** Bytes allocated for transforms and their interned names */
+static size_t transform_bytes = 0;
+static size_t transform_bytes_hwm = 0;
+static size_t transform_name_bytes = 0;
+
 /**
    TD inputs blocking their transforms
    Map from TD ID to list of pointers to transforms.
@@ -202,35 +279,50 @@ static struct table_lp id_subscribed;
 static struct table_bp id_sub_subscribed;
 
 /**
-  LRU caches for TDs or TD/sub pairs known to be closed implemented with
-  doubly-linked list and hash table.  Hash table entries point to linked
-  list node.  Linked list node contains subscribe cache entry.  The head
-  of the LRU is next in line for eviction.  We only cache remote
-  subscribes, not local ones.
+  CLOCK caches for TDs or TD/sub pairs known to be closed.  Each cache
+  is a flat array of sets of CLOSED_CACHE_WAYS slots, and an entry can
+  only go in the set selected by its hash, so a lookup scans one set.
+  A hit sets the slot's reference bit.  Adding to a full set moves the
+  set's clock hand over the slots, clearing reference bits, until it
+  finds a slot without one to evict.  We only cache remote subscribes,
+  not local ones.
  */
-typedef struct {
-  adlb_datum_id id;
-} id_closed_cache_entry;
+#define CLOSED_CACHE_WAYS 8
 
-// Key created with xlb_write_id_sub
 typedef struct {
-  size_t key_len;
-  char key[];
-} id_sub_closed_cache_entry;
+  adlb_datum_id ids[CLOSED_CACHE_WAYS]; // ADLB_DATA_ID_NULL if empty
+} id_closed_cache_set;
 
-#define DEFAULT_CLOSED_CACHE_SIZE 4096
+// Key created with xlb_write_id_sub.  Longer keys are not cached
+#define ID_SUB_CLOSED_KEY_MAX 26
 
-static int id_closed_cache_size; // Number of entries
+typedef struct {
+  uint32_t hash;
+  uint16_t key_len; // 0 if empty
+  char key[ID_SUB_CLOSED_KEY_MAX];
+} id_sub_closed_cache_slot;
 
-static int id_sub_closed_cache_size; // Number of entries
+typedef struct {
+  id_sub_closed_cache_slot slots[CLOSED_CACHE_WAYS];
+} id_sub_closed_cache_set;
 
-static struct table_lp id_closed_cache;
+// Clock state of a set
+typedef struct {
+  uint8_t ref; // Reference bit per slot
+  uint8_t hand; // Next slot to consider for eviction
+} closed_cache_clock;
 
-static struct table_bp id_sub_closed_cache;
+/** Default memory for each cache, overridden by ADLB_CLOSED_CACHE_BYTES,
+    or ADLB_CLOSED_CACHE_SIZE in entries */
+#define DEFAULT_CLOSED_CACHE_BYTES (128 * 1024)
 
-static struct list2_b id_closed_cache_lru;
+static id_closed_cache_set *id_closed_cache = NULL;
+static closed_cache_clock *id_closed_cache_clock = NULL;
+static uint32_t id_closed_cache_sets = 0; // Power of two or zero
 
-static struct list2_b id_sub_closed_cache_lru;
+static id_sub_closed_cache_set *id_sub_closed_cache = NULL;
+static closed_cache_clock *id_sub_closed_cache_clock = NULL;
+static uint32_t id_sub_closed_cache_sets = 0; // Power of two or zero
 
 // Maximum length of buffer required for key
 #define ID_SUB_KEY_MAX (ADLB_DATA_SUBSCRIPT_MAX + 30)
@@ -347,6 +439,11 @@ xlb_engine_init(int rank)
   bool result;
 
   list2_init(&transforms_waiting); 
+  list2_init(&groups_waiting);
+
+  result = table_init(&transform_names, 1024);
+  if (!result)
+    return XLB_ENGINE_ERROR_OOM;
 
   result = table_lp_init(&id_blockers, table_init_capacity); 
   if (!result)
@@ -370,6 +467,7 @@ xlb_engine_init(int rank)
     xlb_engine_counters.id_subscribe_local = 0;
     xlb_engine_counters.id_subscribe_remote = 0;
     xlb_engine_counters.id_subscribe_cached = 0;
+    xlb_engine_counters.id_subscribe_summary = 0;
     xlb_engine_counters.id_ready = 0;
     
     xlb_engine_counters.id_sub_subscribed = 0;
@@ -377,6 +475,14 @@ xlb_engine_init(int rank)
     xlb_engine_counters.id_sub_subscribe_remote = 0;
     xlb_engine_counters.id_sub_subscribe_cached = 0;
     xlb_engine_counters.id_sub_ready = 0;
+
+    xlb_engine_counters.id_closed_evicted = 0;
+    xlb_engine_counters.id_sub_closed_evicted = 0;
+
+    xlb_engine_counters.groups = 0;
+    xlb_engine_counters.group_members = 0;
+    xlb_engine_counters.group_shared_inputs = 0;
+    xlb_engine_counters.group_members_held = 0;
   }
 
   xlb_engine_code tc = init_closed_caches();
@@ -407,6 +513,22 @@ xlb_engine_print_counters(void)
   PRINT_COUNTER("engine_ready=%"PRId64, xlb_engine_counters.id_ready +
                                 xlb_engine_counters.id_sub_ready);
 
+  // Memory for waiting transforms
+  PRINT_COUNTER("engine_transforms_waiting=%i", transforms_waiting.size);
+  PRINT_COUNTER("engine_transform_bytes=%zu", transform_bytes);
+  PRINT_COUNTER("engine_transform_bytes_hwm=%zu", transform_bytes_hwm);
+  PRINT_COUNTER("engine_transform_names=%i", transform_names.size);
+  PRINT_COUNTER("engine_transform_name_bytes=%zu",
+                transform_name_bytes);
+  PRINT_COUNTER("engine_groups=%"PRId64, xlb_engine_counters.groups);
+  PRINT_COUNTER("engine_groups_waiting=%i", groups_waiting.size);
+  PRINT_COUNTER("engine_group_members=%"PRId64,
+        xlb_engine_counters.group_members);
+  PRINT_COUNTER("engine_group_shared_inputs=%"PRId64,
+        xlb_engine_counters.group_shared_inputs);
+  PRINT_COUNTER("engine_group_members_held=%"PRId64,
+        xlb_engine_counters.group_members_held);
+
   PRINT_COUNTER("engine_id_subscribed=%"PRId64,
         xlb_engine_counters.id_subscribed);
   PRINT_COUNTER("engine_id_subscribe_local=%"PRId64,
@@ -415,6 +537,8 @@ xlb_engine_print_counters(void)
         xlb_engine_counters.id_subscribe_remote);
   PRINT_COUNTER("engine_id_subscribe_cached=%"PRId64,
         xlb_engine_counters.id_subscribe_cached);
+  PRINT_COUNTER("engine_id_subscribe_summary=%"PRId64,
+        xlb_engine_counters.id_subscribe_summary);
   PRINT_COUNTER("engine_id_ready=%"PRId64,
         xlb_engine_counters.id_ready);
   
@@ -428,6 +552,78 @@ xlb_engine_print_counters(void)
         xlb_engine_counters.id_sub_subscribe_cached);
   PRINT_COUNTER("engine_id_sub_ready=%"PRId64,
         xlb_engine_counters.id_sub_ready);
+
+  // Every remote subscribe was a cache miss
+  int64_t id_hits = xlb_engine_counters.id_subscribe_cached -
+                    xlb_engine_counters.id_subscribe_summary;
+  int64_t id_misses = xlb_engine_counters.id_subscribe_remote;
+  PRINT_COUNTER("engine_id_closed_cache_entries=%"PRIu32,
+        id_closed_cache_sets * CLOSED_CACHE_WAYS);
+  PRINT_COUNTER("engine_id_closed_cache_hits=%"PRId64, id_hits);
+  PRINT_COUNTER("engine_id_closed_cache_misses=%"PRId64, id_misses);
+  PRINT_COUNTER("engine_id_closed_cache_hit_rate=%.3f",
+        id_hits + id_misses == 0 ? 0.0 :
+        (double)id_hits / (double)(id_hits + id_misses));
+  PRINT_COUNTER("engine_id_closed_cache_evicted=%"PRId64,
+        xlb_engine_counters.id_closed_evicted);
+
+  int64_t id_sub_hits = xlb_engine_counters.id_sub_subscribe_cached;
+  int64_t id_sub_misses = xlb_engine_counters.id_sub_subscribe_remote;
+  PRINT_COUNTER("engine_id_sub_closed_cache_entries=%"PRIu32,
+        id_sub_closed_cache_sets * CLOSED_CACHE_WAYS);
+  PRINT_COUNTER("engine_id_sub_closed_cache_hits=%"PRId64, id_sub_hits);
+  PRINT_COUNTER("engine_id_sub_closed_cache_misses=%"PRId64,
+        id_sub_misses);
+  PRINT_COUNTER("engine_id_sub_closed_cache_hit_rate=%.3f",
+        id_sub_hits + id_sub_misses == 0 ? 0.0 :
+        (double)id_sub_hits / (double)(id_sub_hits + id_sub_misses));
+  PRINT_COUNTER("engine_id_sub_closed_cache_evicted=%"PRId64,
+        xlb_engine_counters.id_sub_closed_evicted);
+}
+
+/**
+   Find interned copy of name, adding it if needed
+ */
+static const char *
+transform_name_intern(const char *name, int name_strlen)
+{
+  char key[name_strlen + 1];
+  memcpy(key, name, (size_t)name_strlen);
+  key[name_strlen] = '\0';
+
+  void *count;
+  if (table_search(&transform_names, key, &count))
+  {
+    void *old;
+    table_set(&transform_names, key, (void*)((intptr_t)count + 1), &old);
+  }
+  else
+  {
+    if (!table_add(&transform_names, key, (void*)(intptr_t)1))
+      return NULL;
+    transform_name_bytes += (size_t)name_strlen + 1;
+  }
+  return table_locate_key(&transform_names, key);
+}
+
+static void
+transform_name_release(const char *name)
+{
+  void *count;
+  bool found = table_search(&transform_names, name, &count);
+  assert(found);
+  if ((intptr_t)count > 1)
+  {
+    void *old;
+    table_set(&transform_names, name, (void*)((intptr_t)count - 1), &old);
+  }
+  else
+  {
+    size_t name_size = strlen(name) + 1;
+    table_remove(&transform_names, name, &count);
+    transform_name_bytes -= name_size;
+  }
+  (void)found;
 }
 
 static inline xlb_engine_code
@@ -436,21 +632,35 @@ transform_create(const char* name, int name_strlen,
            int input_id_subs, const adlb_datum_id_sub* input_id_sub_list,
            xlb_work_unit *work, transform** result)
 {
-  assert(work);
   assert(input_tds >= 0);
   assert(input_tds == 0 || input_id_list != NULL);
   assert(input_id_subs >= 0);
   assert(input_id_subs == 0 || input_id_sub_list != NULL);
 
-  transform* T = malloc(sizeof(transform));
+  int total_inputs = input_tds + input_id_subs;
+  size_t ids_size = (size_t)input_tds * sizeof(adlb_datum_id);
+  size_t id_subs_size = (size_t)input_id_subs * sizeof(id_sub_pair);
+  size_t bitfield_bytes = bitfield_size(total_inputs);
+  size_t keys_size = 0;
+  for (int i = 0; i < input_id_subs; i++)
+  {
+    keys_size += input_id_sub_list[i].subscript.length;
+  }
+
+  size_t size = sizeof(transform) + ids_size + id_subs_size +
+                bitfield_bytes + keys_size;
+  transform* T = malloc(size);
   if (! T)
     return XLB_ENGINE_ERROR_OOM;
 
   if (name != NULL)
   {
-    T->name = malloc((size_t) name_strlen + 1);
-    memcpy(T->name, name, (size_t)name_strlen);
-    T->name[name_strlen] = '\0';
+    T->name = transform_name_intern(name, name_strlen);
+    if (T->name == NULL)
+    {
+      free(T);
+      return XLB_ENGINE_ERROR_OOM;
+    }
   }
   else
   {
@@ -458,72 +668,40 @@ transform_create(const char* name, int name_strlen,
   }
 
   T->work = work;
+  T->group = NULL;
   T->blocker = 0;
   T->input_tds = input_tds;
   T->input_id_subs = input_id_subs;
+  T->size = size;
 
   if (input_tds > 0)
   {
-    size_t sz = (size_t)input_tds*sizeof(adlb_datum_id);
-    T->input_id_list = malloc(sz);
-
-    if (! T->input_id_list)
-      return XLB_ENGINE_ERROR_OOM;
-
-    memcpy(T->input_id_list, input_id_list, sz);
-  }
-  else
-  {
-    T->input_id_list = NULL;
+    memcpy(T->input_id_list, input_id_list, ids_size);
   }
 
-  if (input_id_subs > 0)
+  // Copy across all subscripts into space after bit vector
+  id_sub_pair *id_subs = transform_id_subs(T);
+  unsigned char *closed_inputs = transform_closed_inputs(T);
+  char *keys = (char*)closed_inputs + bitfield_bytes;
+  for (int i = 0; i < input_id_subs; i++)
   {
-    size_t sz = (size_t)input_id_subs* sizeof(id_sub_pair);
-    T->input_id_sub_list = malloc(sz);
-
-    if (! T->input_id_sub_list)
-      return XLB_ENGINE_ERROR_OOM;
-    // Copy across all subscripts
-    for (int i = 0; i < input_id_subs; i++)
-    {
-      const adlb_datum_id_sub *src;
-      id_sub_pair *dst;
-      src = &input_id_sub_list[i];
-      dst = &T->input_id_sub_list[i];
-      dst->td = src->id;
-      dst->subscript.length = src->subscript.length;
-      dst->subscript.key = malloc(src->subscript.length);
-      if (!dst->subscript.key)
-        return XLB_ENGINE_ERROR_OOM;
-      memcpy(dst->subscript.key, src->subscript.key,
-             src->subscript.length);
-    }
-  }
-  else
-  {
-    T->input_id_sub_list = NULL;
-  }
-
-  int total_inputs = input_tds + input_id_subs;
-  if (total_inputs > 0)
-  {
-    size_t sz = bitfield_size(total_inputs)* sizeof(unsigned char);
-    T->closed_inputs = malloc(sz);
-
-    if (! T->closed_inputs)
-      return XLB_ENGINE_ERROR_OOM;
-
-    memset(T->closed_inputs, 0, sz);
-  }
-  else
-  {
-    T->closed_inputs = NULL;
+    const adlb_datum_id_sub *src = &input_id_sub_list[i];
+    id_sub_pair *dst = &id_subs[i];
+    dst->td = src->id;
+    dst->subscript.length = src->subscript.length;
+    dst->subscript.key = keys;
+    memcpy(keys, src->subscript.key, src->subscript.length);
+    keys += src->subscript.length;
   }
 
+  memset(closed_inputs, 0, bitfield_bytes);
 
   T->status = TRANSFORM_WAITING;
 
+  transform_bytes += size;
+  if (transform_bytes > transform_bytes_hwm)
+    transform_bytes_hwm = transform_bytes;
+
   *result = T;
   return XLB_ENGINE_SUCCESS;
 }
@@ -532,22 +710,10 @@ static inline void
 transform_free(transform* T)
 {
   if (T->name != NULL)
-    free(T->name);
+    transform_name_release(T->name);
   if (T->work)
     xlb_work_unit_free(T->work);
-  if (T->input_id_list)
-    free(T->input_id_list);
-  if (T->input_id_sub_list)
-  {
-    for (int i = 0; i < T->input_id_subs; i++)
-    {
-      // free subscript strings
-      free(T->input_id_sub_list[i].subscript.key);
-    }
-    free(T->input_id_sub_list);
-  }
-  if (T->closed_inputs)
-    free(T->closed_inputs);
+  transform_bytes -= T->size;
   free(T);
 }
 
@@ -592,6 +758,12 @@ subscribe_td(adlb_datum_id id, bool *subscribed)
         *subscribed = false;
         INCR_COUNTER(id_subscribe_cached);
       }
+      else if (xlb_closed_summary_check(server, id))
+      {
+        *subscribed = false;
+        INCR_COUNTER(id_subscribe_cached);
+        INCR_COUNTER(id_subscribe_summary);
+      }
       else
       {
         adlb_code ac = xlb_sync_subscribe(server, id, ADLB_NO_SUB,
@@ -751,10 +923,8 @@ xlb_engine_put(const char* name, int name_strlen,
   {
     DEBUG_ENGINE("waiting: {%"PRId64"}", work->id);
     assert(T != NULL);
-    struct list2_item *list_entry = list2_add(&transforms_waiting, T);
-    if (list_entry == NULL)
-      return XLB_ENGINE_ERROR_OOM;
-    T->list_entry = list_entry;
+    T->list_entry.data = T;
+    list2_add_item(&transforms_waiting, &T->list_entry);
     *ready = false;
   }
   else
@@ -770,6 +940,195 @@ xlb_engine_put(const char* name, int name_strlen,
   return XLB_ENGINE_SUCCESS;
 }
 
+xlb_engine_code
+xlb_engine_group_begin(int shared_tds,
+              const adlb_datum_id* shared_id_list,
+              int shared_id_subs,
+              const adlb_datum_id_sub* shared_id_sub_list,
+              xlb_engine_group **group)
+{
+  xlb_engine_code tc;
+
+  if (!xlb_engine_initialized)
+    return XLB_ENGINE_ERROR_UNINITIALIZED;
+
+  xlb_engine_group *G = malloc(sizeof(*G));
+  if (G == NULL)
+    return XLB_ENGINE_ERROR_OOM;
+  G->shared = NULL;
+  G->members = NULL;
+  G->member_count = 0;
+  G->member_size = 0;
+  G->open = true;
+
+  transform *T = NULL;
+  tc = transform_create(NULL, 0, shared_tds, shared_id_list,
+                        shared_id_subs, shared_id_sub_list, NULL, &T);
+  if (tc != XLB_ENGINE_SUCCESS)
+  {
+    free(G);
+    return tc;
+  }
+  T->group = G;
+
+  tc = init_inputs(T);
+  ENGINE_CHECK(tc);
+
+  bool subscribed;
+  tc = progress(T, &subscribed);
+  ENGINE_CHECK(tc);
+
+  INCR_COUNTER(groups);
+  if (xlb_s.perfc_enabled)
+  {
+    xlb_engine_counters.group_shared_inputs += shared_tds + shared_id_subs;
+  }
+
+  if (subscribed)
+  {
+    DEBUG_ENGINE("group waiting: %i shared inputs",
+                 shared_tds + shared_id_subs);
+    G->shared = T;
+    T->list_entry.data = T;
+    list2_add_item(&groups_waiting, &T->list_entry);
+  }
+  else
+  {
+    DEBUG_ENGINE("group ready: %i shared inputs",
+                 shared_tds + shared_id_subs);
+    transform_free(T);
+  }
+
+  *group = G;
+  return XLB_ENGINE_SUCCESS;
+}
+
+xlb_engine_code
+xlb_engine_group_put(xlb_engine_group *group,
+              const char* name, int name_strlen,
+              int input_tds,
+              const adlb_datum_id* input_id_list,
+              int input_id_subs,
+              const adlb_datum_id_sub* input_id_sub_list,
+              xlb_work_unit *work, bool *ready)
+{
+  xlb_engine_code tc;
+  assert(group != NULL && group->open);
+  assert(work != NULL);
+
+  transform* T = NULL;
+  tc = transform_create(name, name_strlen, input_tds, input_id_list,
+                       input_id_subs, input_id_sub_list, work, &T);
+  ENGINE_CHECK(tc);
+
+  // Only hold back for group if shared inputs are not yet closed
+  T->group = (group->shared != NULL) ? group : NULL;
+
+  tc = init_inputs(T);
+  ENGINE_CHECK(tc);
+
+  bool subscribed;
+  tc = progress(T, &subscribed);
+  ENGINE_CHECK(tc);
+
+  INCR_COUNTER(group_members);
+  DEBUG_XLB_ENGINE_TRANSFORM(T, work->id);
+
+  if (!subscribed)
+  {
+    DEBUG_ENGINE("ready: {%"PRId64"}", work->id);
+    *ready = true;
+
+    T->work = NULL;
+    transform_free(T);
+    return XLB_ENGINE_SUCCESS;
+  }
+
+  DEBUG_ENGINE("waiting: {%"PRId64"}", work->id);
+  T->list_entry.data = T;
+  list2_add_item(&transforms_waiting, &T->list_entry);
+  *ready = false;
+
+  if (T->group != NULL)
+  {
+    if (group->member_count == group->member_size)
+    {
+      int new_size = group->member_size == 0 ? 16 :
+                                               group->member_size * 2;
+      transform **tmp = realloc(group->members,
+                            sizeof(group->members[0]) * (size_t)new_size);
+      if (tmp == NULL)
+        return XLB_ENGINE_ERROR_OOM;
+      group->members = tmp;
+      group->member_size = new_size;
+    }
+    group->members[group->member_count++] = T;
+    INCR_COUNTER(group_members_held);
+  }
+
+  return XLB_ENGINE_SUCCESS;
+}
+
+void
+xlb_engine_group_end(xlb_engine_group *group)
+{
+  assert(group->open);
+  group->open = false;
+  if (group->shared == NULL)
+  {
+    // Otherwise freed once shared inputs are closed
+    group_free(group);
+  }
+}
+
+/*
+  Shared inputs of group are closed: release members that were
+  waiting only for them.
+ */
+static xlb_engine_code
+group_release(xlb_engine_group *G, xlb_engine_work_array *ready)
+{
+  xlb_engine_code tc;
+  DEBUG_ENGINE("group released: %i members", G->member_count);
+
+  list2_remove_item(&groups_waiting, &G->shared->list_entry);
+  transform_free(G->shared);
+  G->shared = NULL;
+
+  for (int i = 0; i < G->member_count; i++)
+  {
+    transform *T = G->members[i];
+    T->group = NULL;
+
+    bool subscribed;
+    tc = progress(T, &subscribed);
+    ENGINE_CHECK(tc);
+
+    if (!subscribed)
+    {
+      tc = move_to_ready(ready, T);
+      ENGINE_CHECK(tc);
+    }
+  }
+
+  free(G->members);
+  G->members = NULL;
+  G->member_count = G->member_size = 0;
+
+  if (!G->open)
+  {
+    group_free(G);
+  }
+  return XLB_ENGINE_SUCCESS;
+}
+
+static void
+group_free(xlb_engine_group *G)
+{
+  free(G->members);
+  free(G);
+}
+
 static inline xlb_engine_code add_blocker(adlb_datum_id id,
                                       transform *T);
 
@@ -814,7 +1173,7 @@ init_inputs(transform* T)
 
   for (int i = 0; i < T->input_id_subs; i++)
   {
-    id_sub_pair *id_sub = &T->input_id_sub_list[i];
+    id_sub_pair *id_sub = &transform_id_subs(T)[i];
     size_t id_sub_keylen = xlb_id_sub_buflen(sub_convert(id_sub->subscript));
     char id_sub_key[id_sub_keylen];
     assert(id_sub->subscript.key != NULL);
@@ -850,7 +1209,7 @@ add_blocker(adlb_datum_id id, transform *T)
 {
   assert(xlb_engine_initialized);
   DEBUG_ENGINE("add_blocker for {%"PRId64"}: <%"PRId64">",
-                T->work->id, id);
+                transform_id(T), id);
   struct list* blocked;
   table_lp_search(&id_blockers, id, (void**)&blocked);
   if (blocked == NULL)
@@ -871,7 +1230,7 @@ static inline xlb_engine_code add_blocker_sub(void *id_sub_key,
         size_t id_sub_keylen, transform *T)
 {
   assert(xlb_engine_initialized);
-  DEBUG_ENGINE("add_blocker_sub for {%"PRId64"}", T->work->id);
+  DEBUG_ENGINE("add_blocker_sub for {%"PRId64"}", transform_id(T));
   struct list* blocked;
   bool found = table_bp_search(&id_sub_blockers, id_sub_key,
                          id_sub_keylen, (void**)&blocked);
@@ -979,7 +1338,7 @@ xlb_engine_close_update(struct list *blocked, adlb_datum_id id,
     // update closed vector
     if (!adlb_has_sub(sub))
     {
-      DEBUG_ENGINE("Update {%"PRId64"} for close: <%"PRId64">", T->work->id, id);
+      DEBUG_ENGINE("Update {%"PRId64"} for close: <%"PRId64">", transform_id(T), id);
       for (int i = T->blocker; i < T->input_tds; i++) {
         if (T->input_id_list[i] == id) {
           mark_input_id_closed(T, i);
@@ -989,7 +1348,7 @@ xlb_engine_close_update(struct list *blocked, adlb_datum_id id,
     else
     {
       DEBUG_ENGINE("Update {%"PRId64"} for subscript close: <%"PRId64">",
-                    T->work->id, id);
+                    transform_id(T), id);
       // Check to see which ones remain to be checked
       int first_id_sub;
       if (T->blocker >= T->input_tds)
@@ -999,7 +1358,7 @@ xlb_engine_close_update(struct list *blocked, adlb_datum_id id,
 
       for (int i = first_id_sub; i < T->input_id_subs; i++)
       {
-        id_sub_pair *input_tdsub = &T->input_id_sub_list[i];
+        id_sub_pair *input_tdsub = &transform_id_subs(T)[i];
         engine_sub *input_sub = &input_tdsub->subscript;
         if (input_tdsub->td == id && input_sub->length == sub.length 
             && memcmp(input_sub->key, sub.key, sub.length) == 0)
@@ -1015,9 +1374,18 @@ xlb_engine_close_update(struct list *blocked, adlb_datum_id id,
       return tc;
 
     T_prev = T;
-    if (!subscribed)
+    if (!subscribed && T->work == NULL)
     {
-      DEBUG_ENGINE("Ready {%"PRId64"}", T->work->id);
+      /*
+       * Members released here are only freed if ready: a member that
+       * appears later in this list still waits for id.
+       */
+      tc = group_release(T->group, ready);
+      ENGINE_CHECK(tc);
+    }
+    else if (!subscribed)
+    {
+      DEBUG_ENGINE("Ready {%"PRId64"}", transform_id(T));
       tc = move_to_ready(ready, T);
       ENGINE_CHECK(tc);
     }
@@ -1034,7 +1402,7 @@ xlb_engine_close_update(struct list *blocked, adlb_datum_id id,
 static inline xlb_engine_code
 move_to_ready(xlb_engine_work_array *ready, transform *T)
 {
-  DEBUG_ENGINE("ready: {%"PRId64"}", T->work->id);
+  DEBUG_ENGINE("ready: {%"PRId64"}", transform_id(T));
   if (ready->size <= ready->count)
   {
     if (ready->size == 0)
@@ -1050,9 +1418,7 @@ move_to_ready(xlb_engine_work_array *ready, transform *T)
   }
   ready->work[ready->count++] = T->work;
 
-  list2_remove_item(&transforms_waiting, T->list_entry);
-  free(T->list_entry);
-  T->list_entry = NULL;
+  list2_remove_item(&transforms_waiting, &T->list_entry);
   
   T->work = NULL; // Don't free work
   transform_free(T);
@@ -1096,8 +1462,15 @@ progress(transform* T, bool* subscribed)
     }
   }
 
+  if (T->work != NULL && T->group != NULL)
+  {
+    // Still waiting for shared inputs of group
+    *subscribed = true;
+    return XLB_ENGINE_SUCCESS;
+  }
+
   // Ready to run
-  TRACE("{%"PRId64"} ready to run", T->work->id);
+  TRACE("{%"PRId64"} ready to run", transform_id(T));
   *subscribed = false;
   return XLB_ENGINE_SUCCESS;
 }
@@ -1167,7 +1540,7 @@ transform_tostring(char* output, transform* t)
 
     // Highlight the blocking variable
     bool blocking = !input_id_sub_closed(t, i);
-    id_sub_pair ts = t->input_id_sub_list[i];
+    id_sub_pair ts = transform_id_subs(t)[i];
     if (blocking)
       append(p, "/");
     // TODO: debug symbol?
@@ -1187,7 +1560,7 @@ static inline bool
 input_id_closed(transform *T, int i)
 {
   assert(i >= 0);
-  unsigned char field = T->closed_inputs[(unsigned int)i / 8];
+  unsigned char field = transform_closed_inputs(T)[(unsigned int)i / 8];
   return (field >> ((unsigned int)i % 8)) & 0x1;
 }
 
@@ -1195,18 +1568,18 @@ __attribute__((always_inline))
 static inline bool
 input_id_sub_closed(transform *T, int i)
 {
-  // closed_inputs had pairs come after tds
+  // closed inputs have pairs come after tds
   return input_id_closed(T, i + T->input_tds);
 }
 
 __attribute__((always_inline))
-// Extract bit from closed_inputs
+// Set bit in closed inputs
 static inline void
 mark_input_id_closed(transform *T, int i)
 {
   assert(i >= 0);
   unsigned char mask = (unsigned char) (0x1 << ((unsigned int)i % 8));
-  T->closed_inputs[i / 8] |= mask;
+  transform_closed_inputs(T)[i / 8] |= mask;
 }
 
 __attribute__((always_inline))
@@ -1224,10 +1597,50 @@ bitfield_size(int inputs) {
   return (size_t)(inputs - 1) / 8 + 1;
 }
 
-static xlb_engine_code init_closed_caches(void)
+/*
+  Largest power of two number of sets with total size at most bytes
+ */
+static uint32_t
+closed_cache_sets(long bytes, size_t set_size)
+{
+  long max_sets = bytes / (long)set_size;
+  if (max_sets <= 0)
+    return 0;
+
+  uint32_t sets = 1;
+  while (sets <= UINT32_MAX / 2 / CLOSED_CACHE_WAYS &&
+         (long)sets * 2 <= max_sets)
+    sets *= 2;
+  return sets;
+}
+
+/*
+  Smallest power of two number of sets with at least entries slots
+ */
+static uint32_t
+closed_cache_sets_for_entries(long entries)
 {
-  id_closed_cache_size = DEFAULT_CLOSED_CACHE_SIZE;
+  if (entries <= 0)
+    return 0;
+
+  long min_sets = (entries - 1) / CLOSED_CACHE_WAYS + 1;
+  uint32_t sets = 1;
+  while (sets <= UINT32_MAX / 2 / CLOSED_CACHE_WAYS &&
+         (long)sets < min_sets)
+    sets *= 2;
+  return sets;
+}
 
+static xlb_engine_code init_closed_caches(void)
+{
+  id_closed_cache_sets = closed_cache_sets(DEFAULT_CLOSED_CACHE_BYTES,
+          sizeof(id_closed_cache_set) + sizeof(closed_cache_clock));
+  id_sub_closed_cache_sets = closed_cache_sets(DEFAULT_CLOSED_CACHE_BYTES,
+          sizeof(id_sub_closed_cache_set) + sizeof(closed_cache_clock));
+
+  // Legacy setting: number of entries in each cache.  Rounded up to
+  // a power of two number of sets, so each cache holds at least this
+  // many entries
   long tmp;
   adlb_code rc = xlb_env_long("ADLB_CLOSED_CACHE_SIZE", &tmp);
   ENGINE_CHECK_ADLB(rc, XLB_ENGINE_ERROR_INVALID);
@@ -1236,149 +1649,196 @@ static xlb_engine_code init_closed_caches(void)
     ENGINE_CONDITION(tmp >= 0 && tmp < INT_MAX,
                               XLB_ENGINE_ERROR_INVALID,
           "Invalid ADLB_CLOSED_CACHE_SIZE %li", tmp);
-    id_closed_cache_size = (int)tmp;
+    id_closed_cache_sets = id_sub_closed_cache_sets =
+          closed_cache_sets_for_entries(tmp);
   }
 
-  // Same cache sizes for now
-  id_sub_closed_cache_size = id_closed_cache_size;
+  rc = xlb_env_long("ADLB_CLOSED_CACHE_BYTES", &tmp);
+  ENGINE_CHECK_ADLB(rc, XLB_ENGINE_ERROR_INVALID);
+  if (rc == ADLB_SUCCESS)
+  {
+    ENGINE_CONDITION(tmp >= 0, XLB_ENGINE_ERROR_INVALID,
+          "Invalid ADLB_CLOSED_CACHE_BYTES %li", tmp);
+    id_closed_cache_sets = closed_cache_sets(tmp,
+          sizeof(id_closed_cache_set) + sizeof(closed_cache_clock));
+    id_sub_closed_cache_sets = closed_cache_sets(tmp,
+          sizeof(id_sub_closed_cache_set) + sizeof(closed_cache_clock));
+  }
 
-  // Initialize to size large enough for all entries
-  table_lp_init_custom(&id_closed_cache, id_closed_cache_size, 1.0);
-  table_bp_init_custom(&id_sub_closed_cache, id_sub_closed_cache_size,
-                       1.0);
-  
-  list2_b_init(&id_closed_cache_lru);
-  list2_b_init(&id_sub_closed_cache_lru);
+  // Zeroed slots are empty
+  id_closed_cache = calloc(id_closed_cache_sets,
+                           sizeof(id_closed_cache[0]));
+  id_closed_cache_clock = calloc(id_closed_cache_sets,
+                                 sizeof(id_closed_cache_clock[0]));
+  id_sub_closed_cache = calloc(id_sub_closed_cache_sets,
+                               sizeof(id_sub_closed_cache[0]));
+  id_sub_closed_cache_clock = calloc(id_sub_closed_cache_sets,
+                                 sizeof(id_sub_closed_cache_clock[0]));
+  if ((id_closed_cache_sets > 0 &&
+       (id_closed_cache == NULL || id_closed_cache_clock == NULL)) ||
+      (id_sub_closed_cache_sets > 0 &&
+       (id_sub_closed_cache == NULL || id_sub_closed_cache_clock == NULL)))
+  {
+    return XLB_ENGINE_ERROR_OOM;
+  }
+
+  DEBUG_ENGINE("Closed caches: id entries: %"PRIu32" "
+               "id/sub entries: %"PRIu32,
+               id_closed_cache_sets * CLOSED_CACHE_WAYS,
+               id_sub_closed_cache_sets * CLOSED_CACHE_WAYS);
   return XLB_ENGINE_SUCCESS;
 }
 
 static void finalize_closed_caches(void)
 {
-  // Free tables.  Values are pointers to list nodes, which we free next
-  table_lp_free_callback(&id_closed_cache, false, NULL);
-  table_bp_free_callback(&id_sub_closed_cache, false, NULL);
-
-  // Free LRU list
-  list2_b_clear(&id_closed_cache_lru);
-  list2_b_clear(&id_sub_closed_cache_lru);
+  free(id_closed_cache);
+  free(id_closed_cache_clock);
+  free(id_sub_closed_cache);
+  free(id_sub_closed_cache_clock);
+  id_closed_cache = NULL;
+  id_closed_cache_clock = NULL;
+  id_sub_closed_cache = NULL;
+  id_sub_closed_cache_clock = NULL;
+  id_closed_cache_sets = id_sub_closed_cache_sets = 0;
 }
 
-// Move to top of lru list
-static void id_closed_update_lru(struct list2_b_item *entry)
+/*
+  Choose slot to fill in a set: an empty slot if there is one,
+  otherwise the first slot the clock hand finds without its reference
+  bit set.
+  used: bit per slot, set if slot holds an entry
+ */
+static inline int
+closed_cache_victim(closed_cache_clock *clock, uint8_t used)
 {
-  if (id_closed_cache_lru.tail != entry)
+  if (used != (uint8_t)((1 << CLOSED_CACHE_WAYS) - 1))
   {
-    // Remove and add back at tail
-    list2_b_remove_item(&id_closed_cache_lru, entry);
-    list2_b_add_item(&id_closed_cache_lru, entry);
+    for (int i = 0; i < CLOSED_CACHE_WAYS; i++)
+    {
+      if ((used & (1 << i)) == 0)
+        return i;
+    }
   }
-}
 
-static void id_sub_closed_update_lru(struct list2_b_item *entry)
-{
-  if (id_sub_closed_cache_lru.tail != entry)
+  // Terminates within two sweeps since bits are cleared as we go
+  while (clock->ref & (1 << clock->hand))
   {
-    // Remove and add back at tail
-    list2_b_remove_item(&id_sub_closed_cache_lru, entry);
-    list2_b_add_item(&id_sub_closed_cache_lru, entry);
+    clock->ref &= (uint8_t)~(1 << clock->hand);
+    clock->hand = (uint8_t)((clock->hand + 1) % CLOSED_CACHE_WAYS);
   }
+  int victim = clock->hand;
+  clock->hand = (uint8_t)((clock->hand + 1) % CLOSED_CACHE_WAYS);
+  return victim;
+}
+
+static inline uint32_t
+id_closed_cache_hash(adlb_datum_id id)
+{
+  return bj_hashlittle(&id, sizeof(id), 0u);
 }
 
 // Return true if closed
 static bool id_closed_cache_check(adlb_datum_id id)
 {
+  if (id_closed_cache_sets == 0)
+    return false;
 
-  struct list2_b_item *entry;
-  if (table_lp_search(&id_closed_cache, id, (void**)&entry))
+  uint32_t set = id_closed_cache_hash(id) & (id_closed_cache_sets - 1);
+  id_closed_cache_set *S = &id_closed_cache[set];
+  for (int i = 0; i < CLOSED_CACHE_WAYS; i++)
   {
-    // Was closed, just need to update LRU
-    id_closed_update_lru(entry);
-    return true;
-  }
-  else
-  {
-    return false;
+    if (S->ids[i] == id)
+    {
+      // Give second chance
+      id_closed_cache_clock[set].ref |= (uint8_t)(1 << i);
+      return true;
+    }
   }
+  return false;
 }
 
 // Return true if closed
 static bool id_sub_closed_cache_check(const void *key, size_t key_len)
 {
-  struct list2_b_item *entry;
+  if (id_sub_closed_cache_sets == 0 || key_len > ID_SUB_CLOSED_KEY_MAX)
+    return false;
 
-  if (table_bp_search(&id_sub_closed_cache, key, key_len, (void**)&entry))
+  uint32_t hash = bj_hashlittle(key, key_len, 0u);
+  uint32_t set = hash & (id_sub_closed_cache_sets - 1);
+  id_sub_closed_cache_set *S = &id_sub_closed_cache[set];
+  for (int i = 0; i < CLOSED_CACHE_WAYS; i++)
   {
-    // Was closed, just need to update LRU
-    id_sub_closed_update_lru(entry);
-    return true;
-  }
-  else
-  {
-    return false;
+    id_sub_closed_cache_slot *slot = &S->slots[i];
+    if (slot->hash == hash && slot->key_len == key_len &&
+        memcmp(slot->key, key, key_len) == 0)
+    {
+      // Give second chance
+      id_sub_closed_cache_clock[set].ref |= (uint8_t)(1 << i);
+      return true;
+    }
   }
+  return false;
 }
 
 // Add that it was closed to cache
 static xlb_engine_code id_closed_cache_add(adlb_datum_id id)
 {
-  if (id_closed_cache.size >= id_closed_cache_size)
+  assert(id != ADLB_DATA_ID_NULL);
+  if (id_closed_cache_sets == 0)
+    return XLB_ENGINE_SUCCESS;
+
+  uint32_t set = id_closed_cache_hash(id) & (id_closed_cache_sets - 1);
+  id_closed_cache_set *S = &id_closed_cache[set];
+  uint8_t used = 0;
+  for (int i = 0; i < CLOSED_CACHE_WAYS; i++)
   {
-    // Evict an entry
-    struct list2_b_item *victim = list2_b_pop_item(&id_closed_cache_lru);
-    id_closed_cache_entry *victim_entry = (id_closed_cache_entry*)
-                                          victim->data;
-    void *tmp;
-    bool removed = table_lp_remove(&id_closed_cache, victim_entry->id,
-                                   &tmp);
-    assert(removed && tmp == victim); // Should have had entry
-    free(victim);
+    if (S->ids[i] == id)
+      return XLB_ENGINE_SUCCESS;
+    if (S->ids[i] != ADLB_DATA_ID_NULL)
+      used |= (uint8_t)(1 << i);
   }
 
-  id_closed_cache_entry *entry;
-  struct list2_b_item *node = list2_b_item_alloc(sizeof(*entry));
-  entry = (id_closed_cache_entry*)&node->data;
-  entry->id = id;
-  
-  list2_b_add_item(&id_closed_cache_lru, node);
-
-  bool ok = table_lp_add(&id_closed_cache, id, node);
-  if (!ok)
-    return XLB_ENGINE_ERROR_OOM;
+  closed_cache_clock *clock = &id_closed_cache_clock[set];
+  int victim = closed_cache_victim(clock, used);
+  if (used & (1 << victim))
+    INCR_COUNTER(id_closed_evicted);
 
+  S->ids[victim] = id;
+  clock->ref &= (uint8_t)~(1 << victim);
   return XLB_ENGINE_SUCCESS;
 }
 
 static xlb_engine_code
 id_sub_closed_cache_add(const void *key, size_t key_len)
 {
-  if (id_sub_closed_cache.size >= id_sub_closed_cache_size)
+  if (id_sub_closed_cache_sets == 0 || key_len > ID_SUB_CLOSED_KEY_MAX)
+    return XLB_ENGINE_SUCCESS;
+
+  uint32_t hash = bj_hashlittle(key, key_len, 0u);
+  uint32_t set = hash & (id_sub_closed_cache_sets - 1);
+  id_sub_closed_cache_set *S = &id_sub_closed_cache[set];
+  uint8_t used = 0;
+  for (int i = 0; i < CLOSED_CACHE_WAYS; i++)
   {
-    // Evict an entry
-    struct list2_b_item *victim =
-                      list2_b_pop_item(&id_sub_closed_cache_lru);
-    id_sub_closed_cache_entry *victim_entry =
-                        (id_sub_closed_cache_entry*)victim->data;
-
-    void *tmp;
-    bool removed = table_bp_remove(&id_sub_closed_cache,
-        victim_entry->key, victim_entry->key_len, &tmp);
-    assert(removed && tmp == victim); // Should have had entry
-    free(victim);
+    id_sub_closed_cache_slot *slot = &S->slots[i];
+    if (slot->key_len == 0)
+      continue;
+    if (slot->hash == hash && slot->key_len == key_len &&
+        memcmp(slot->key, key, key_len) == 0)
+      return XLB_ENGINE_SUCCESS;
+    used |= (uint8_t)(1 << i);
   }
 
-  id_sub_closed_cache_entry *entry;
-  size_t entry_size = sizeof(*entry) + key_len;
-  struct list2_b_item *node = list2_b_item_alloc(entry_size);
-  entry = (id_sub_closed_cache_entry*)&node->data;
-  memcpy(entry->key, key, key_len);
-  entry->key_len = key_len;
-  
-  list2_b_add_item(&id_sub_closed_cache_lru, node);
-
-  bool ok = table_bp_add(&id_sub_closed_cache, key, key_len, node);
-  if (!ok)
-    return XLB_ENGINE_ERROR_OOM;
+  closed_cache_clock *clock = &id_sub_closed_cache_clock[set];
+  int victim = closed_cache_victim(clock, used);
+  if (used & (1 << victim))
+    INCR_COUNTER(id_sub_closed_evicted);
 
+  id_sub_closed_cache_slot *slot = &S->slots[victim];
+  slot->hash = hash;
+  slot->key_len = (uint16_t)key_len;
+  memcpy(slot->key, key, key_len);
+  clock->ref &= (uint8_t)~(1 << victim);
   return XLB_ENGINE_SUCCESS;
 }
 
@@ -1418,6 +1878,8 @@ void xlb_engine_finalize(void)
   // First report any problems we find
   if (transforms_waiting.size != 0)
     info_waiting();
+  if (groups_waiting.size != 0)
+    printf("WAITING GROUPS: %i\n", groups_waiting.size);
 
   // Now we're done reporting, free everything
   free_transforms_waiting();
@@ -1428,6 +1890,7 @@ void xlb_engine_finalize(void)
   // need to be freed
   table_lp_free_callback(&id_subscribed, false, NULL);
   table_bp_free_callback(&id_sub_subscribed, false, NULL);
+  table_free_callback(&transform_names, false, NULL);
 
   finalize_closed_caches();
 }
@@ -1441,7 +1904,16 @@ static void free_transforms_waiting(void)
     transform *T = item->data; 
     next = item->next;
     transform_free(T);
-    free(item);
+    item = next;
+  }
+
+  item = groups_waiting.head;
+  while (item != NULL)
+  {
+    transform *T = item->data;
+    next = item->next;
+    group_free(T->group);
+    transform_free(T);
     item = next;
   }
 }
@@ -85,6 +85,42 @@ xlb_engine_code xlb_engine_put(const char* name, int name_strlen,
                           const adlb_datum_id_sub* input_id_sub_list,
                           xlb_work_unit *work, bool *ready);
 
+/**
+   Group of transforms with shared inputs, e.g. the iterations of a
+   foreach loop that all read the same data.  The shared inputs are
+   subscribed to once for the group rather than once per member.
+ */
+typedef struct xlb_engine_group xlb_engine_group;
+
+/**
+   Start a group waiting for the shared inputs.
+   shared_id_list, shared_id_sub_list: ownership retained by caller
+   group: set to new group, valid until xlb_engine_group_end()
+ */
+xlb_engine_code xlb_engine_group_begin(int shared_tds,
+                          const adlb_datum_id* shared_id_list,
+                          int shared_id_subs,
+                          const adlb_datum_id_sub* shared_id_sub_list,
+                          xlb_engine_group **group);
+
+/**
+   As xlb_engine_put(), but work is also not ready until the
+   shared inputs of the group are closed.
+ */
+xlb_engine_code xlb_engine_group_put(xlb_engine_group *group,
+                          const char* name, int name_strlen,
+                          int input_tds,
+                          const adlb_datum_id* input_id_list,
+                          int input_id_subs,
+                          const adlb_datum_id_sub* input_id_sub_list,
+                          xlb_work_unit *work, bool *ready);
+
+/**
+   No more members will be added to group.  Members still waiting
+   are released by xlb_engine_close()/xlb_engine_sub_close().
+ */
+void xlb_engine_group_end(xlb_engine_group *group);
+
 /*
   Should be called when engine is notified that an id is closed
   remote: true if data was remote
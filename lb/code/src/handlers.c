@@ -38,6 +38,7 @@
 
 #include "adlb-defs.h"
 #include "checks.h"
+#include "closed_summary.h"
 #include "common.h"
 #include "data.h"
 #include "debug.h"
@@ -48,6 +49,8 @@
 #include "notifications.h"
 #include "requestqueue.h"
 #include "refcount.h"
+#include "rma.h"
+#include "sendqueue.h"
 #include "server.h"
 #include "steal.h"
 #include "sync.h"
@@ -79,6 +82,8 @@ static adlb_code handle_steal_response(int caller);
 static adlb_code handle_do_nothing(int caller);
 static adlb_code handle_put(int caller);
 static adlb_code handle_dput(int caller);
+static adlb_code handle_dput_batch(int caller);
+static adlb_code handle_dput_group(int caller);
 static adlb_code handle_get(int caller);
 static adlb_code handle_iget(int caller);
 static adlb_code handle_amget(int caller);
@@ -86,10 +91,16 @@ static adlb_code handle_create(int caller);
 static adlb_code handle_multicreate(int caller);
 static adlb_code handle_exists(int caller);
 static adlb_code handle_store(int caller);
+static adlb_code handle_store_batch(int caller);
 static adlb_code handle_retrieve(int caller);
+static adlb_code handle_retrieve_multi(int caller);
+static adlb_code handle_retrieve_array(int caller);
 static adlb_code handle_enumerate(int caller);
+static adlb_code handle_enumerate_cursor(int caller);
+static adlb_code handle_reduce(int caller);
 static adlb_code handle_subscribe(int caller);
 static adlb_code handle_notify(int caller);
+static adlb_code handle_notify_batch(int caller);
 static adlb_code handle_get_refcounts(int caller);
 static adlb_code handle_refcount_incr(int caller);
 static adlb_code handle_insert_atomic(int caller);
@@ -103,6 +114,8 @@ static adlb_code handle_unlock(int caller);
 static adlb_code handle_check_idle(int caller);
 static adlb_code handle_block_worker(int caller);
 static adlb_code handle_shutdown_worker(int caller);
+static adlb_code handle_closed_summary(int caller);
+static adlb_code handle_rma_done(int caller);
 static adlb_code handle_fail(int caller);
 
 static adlb_code find_req_bytes(int *bytes, int caller, adlb_tag tag);
@@ -114,6 +127,10 @@ static adlb_code send_work(int worker, xlb_work_unit_id wuid, int type,
                                   const void* payload, int length,
                                   int parallelism);
 
+static inline adlb_code send_work_header(int worker,
+    xlb_work_unit_id wuid, int type, int answer, int length,
+    int parallelism);
+
 static adlb_code
 send_parallel_work_unit(int *workers, xlb_work_unit *wu);
 
@@ -174,6 +191,8 @@ xlb_handlers_init(void)
   register_handler(ADLB_TAG_DO_NOTHING, handle_do_nothing);
   register_handler(ADLB_TAG_PUT, handle_put);
   register_handler(ADLB_TAG_DPUT, handle_dput);
+  register_handler(ADLB_TAG_DPUT_BATCH, handle_dput_batch);
+  register_handler(ADLB_TAG_DPUT_GROUP, handle_dput_group);
   register_handler(ADLB_TAG_GET, handle_get);
   register_handler(ADLB_TAG_IGET, handle_iget);
   register_handler(ADLB_TAG_AMGET, handle_amget);
@@ -181,10 +200,16 @@ xlb_handlers_init(void)
   register_handler(ADLB_TAG_MULTICREATE, handle_multicreate);
   register_handler(ADLB_TAG_EXISTS, handle_exists);
   register_handler(ADLB_TAG_STORE_HEADER, handle_store);
+  register_handler(ADLB_TAG_STORE_BATCH, handle_store_batch);
   register_handler(ADLB_TAG_RETRIEVE, handle_retrieve);
+  register_handler(ADLB_TAG_RETRIEVE_MULTI, handle_retrieve_multi);
+  register_handler(ADLB_TAG_RETRIEVE_ARRAY, handle_retrieve_array);
   register_handler(ADLB_TAG_ENUMERATE, handle_enumerate);
+  register_handler(ADLB_TAG_ENUMERATE_CURSOR, handle_enumerate_cursor);
+  register_handler(ADLB_TAG_REDUCE, handle_reduce);
   register_handler(ADLB_TAG_SUBSCRIBE, handle_subscribe);
   register_handler(ADLB_TAG_NOTIFY, handle_notify);
+  register_handler(ADLB_TAG_NOTIFY_BATCH, handle_notify_batch);
   register_handler(ADLB_TAG_GET_REFCOUNTS, handle_get_refcounts);
   register_handler(ADLB_TAG_REFCOUNT_INCR, handle_refcount_incr);
   register_handler(ADLB_TAG_INSERT_ATOMIC, handle_insert_atomic);
@@ -199,6 +224,8 @@ xlb_handlers_init(void)
   register_handler(ADLB_TAG_CHECK_IDLE, handle_check_idle);
   register_handler(ADLB_TAG_BLOCK_WORKER, handle_block_worker);
   register_handler(ADLB_TAG_SHUTDOWN_WORKER, handle_shutdown_worker);
+  register_handler(ADLB_TAG_CLOSED_SUMMARY, handle_closed_summary);
+  register_handler(ADLB_TAG_RMA_DONE, handle_rma_done);
   register_handler(ADLB_TAG_FAIL, handle_fail);
 }
 
@@ -302,45 +329,179 @@ handle_put(int caller)
   return ADLB_SUCCESS;
 }
 
-static adlb_code
-handle_dput(int caller)
+/*
+  Unpack data following dput request header.
+  wait_id_subs: array with room for p->id_sub_count entries
+  inline_data: set to inline task data, or NULL if not present
+  Returns pointer to end of request.
+ */
+static const char *
+unpack_dput(const struct packed_dput *p, const adlb_datum_id **wait_ids,
+            adlb_datum_id_sub *wait_id_subs, const char **name,
+            int *name_strlen, const void **inline_data)
 {
-  MPI_Status status;
-
-  MPE_LOG(xlb_mpe_svr_put_start);
-
-  RECV(xlb_xfer, ADLB_XFER_SIZE, MPI_BYTE, caller, ADLB_TAG_DPUT);
-  const struct packed_dput *p = (struct packed_dput*)xlb_xfer;
-
   // Put arrays first to avoid alignment issues
-  const adlb_datum_id *wait_ids = p->inline_data;
+  *wait_ids = p->inline_data;
 
   // Remainder of data is packed into array in binary form
   const char *p_pos = (const char*)p->inline_data;
-  p_pos += (int)sizeof(wait_ids[0]) * p->id_count;
+  p_pos += (int)sizeof((*wait_ids)[0]) * p->id_count;
 
-  adlb_datum_id_sub wait_id_subs[p->id_sub_count];
   for (int i = 0; i < p->id_sub_count; i++)
   {
     p_pos += xlb_unpack_id_sub(p_pos, &wait_id_subs[i].id,
                                &wait_id_subs[i].subscript);
   }
 
-  const char *name = NULL;
-  int name_strlen = 0;
+  *name = NULL;
+  *name_strlen = 0;
   #ifndef NDEBUG
   // Don't pack name for optimized build
-  name_strlen = p->name_strlen;
-  name = p_pos;
-  p_pos += name_strlen;
+  *name_strlen = p->name_strlen;
+  *name = p_pos;
+  p_pos += *name_strlen;
   #endif
 
-  const void *inline_data = NULL;
+  *inline_data = NULL;
   if (p->has_inline_data)
   {
-    inline_data = p_pos;
+    *inline_data = p_pos;
     p_pos += p->length;
   }
+
+  return p_pos;
+}
+
+/*
+  Add work unit from dput to engine, or put it if ready.
+  This takes ownership of entire work unit.
+  group: if not NULL, work also waits for the group's shared inputs
+ */
+static adlb_code
+dput_work_unit(xlb_work_unit *work, xlb_engine_group *group,
+            const char *name, int name_strlen,
+            int id_count, const adlb_datum_id *wait_ids,
+            int id_sub_count, const adlb_datum_id_sub *wait_id_subs)
+{
+  // Save info for counters: work unit may be freed after put
+  int type = work->type;
+  bool targeted = work->target >= 0;
+  bool parallel = work->opts.parallelism > 1;
+
+  bool ready;
+  xlb_engine_code tc;
+  if (group == NULL)
+    tc = xlb_engine_put(name, name_strlen,
+          id_count, wait_ids, id_sub_count, wait_id_subs,
+          work, &ready);
+  else
+    tc = xlb_engine_group_put(group, name, name_strlen,
+          id_count, wait_ids, id_sub_count, wait_id_subs,
+          work, &ready);
+  ADLB_CHECK_MSG(tc == XLB_ENGINE_SUCCESS, "Error adding data-dependent work");
+
+  if (ready)
+  {
+    // Didn't put into engine, need to move to work queue
+    adlb_code ac = xlb_put_work_unit(work);
+    ADLB_CHECK(ac);
+  }
+
+  // Update performance counters
+  xlb_task_data_count(type, targeted, parallel, !ready);
+
+  return ADLB_SUCCESS;
+}
+
+/*
+  Receive a message of inline dputs into a private buffer, then let
+  the caller proceed.  Can't use xlb_xfer: subscribing to inputs may
+  serve other requests while we are still reading records.
+  msg: set to buffer, caller must free
+ */
+static adlb_code
+recv_dput_msg(int caller, int tag, char **msg, int *msg_size)
+{
+  MPI_Status status;
+
+  adlb_code rc = find_req_bytes(msg_size, caller, tag);
+  ADLB_CHECK(rc);
+  *msg = malloc((size_t)*msg_size);
+  ADLB_CHECK_MALLOC(*msg);
+  RECV(*msg, *msg_size, MPI_BYTE, caller, tag);
+
+  // We have all info from caller now - caller can proceed.
+  int response = ADLB_SUCCESS;
+  SEND(&response, 1, MPI_INT, caller, ADLB_TAG_RESPONSE_PUT);
+
+  return ADLB_SUCCESS;
+}
+
+/*
+  Unpack count padded dput records with inline data, starting at
+  rec_pos in msg, and add each task to the engine.
+  group: passed to dput_work_unit()
+ */
+static adlb_code
+dput_records(int caller, const char *msg, int msg_size,
+             const char *rec_pos, int count, xlb_engine_group *group)
+{
+  #ifdef NDEBUG
+  // Only used for sanity checks
+  (void)msg;
+  (void)msg_size;
+  #endif
+
+  for (int i = 0; i < count; i++)
+  {
+    const struct packed_dput *p = (const struct packed_dput*)rec_pos;
+
+    const adlb_datum_id *wait_ids;
+    adlb_datum_id_sub wait_id_subs[p->id_sub_count];
+    const char *name;
+    int name_strlen;
+    const void *inline_data;
+    const char *p_end = unpack_dput(p, &wait_ids, wait_id_subs,
+                                    &name, &name_strlen, &inline_data);
+    assert(inline_data != NULL);
+    // Make sure we don't get garbage data
+    assert(p_end - msg <= msg_size);
+
+    xlb_work_unit *work = work_unit_alloc((size_t)p->length);
+    ADLB_CHECK_MALLOC(work);
+
+    xlb_work_unit_init(work, p->type, caller, p->answer,
+                       p->target, p->length, p->opts);
+    memcpy(work->payload, inline_data, (size_t)p->length);
+
+    adlb_code rc = dput_work_unit(work, group, name, name_strlen,
+          p->id_count, wait_ids, p->id_sub_count, wait_id_subs);
+    ADLB_CHECK(rc);
+
+    rec_pos += PACKED_BATCH_PAD((size_t)(p_end - rec_pos));
+  }
+
+  return ADLB_SUCCESS;
+}
+
+static adlb_code
+handle_dput(int caller)
+{
+  MPI_Status status;
+
+  MPE_LOG(xlb_mpe_svr_put_start);
+
+  RECV(xlb_xfer, ADLB_XFER_SIZE, MPI_BYTE, caller, ADLB_TAG_DPUT);
+  const struct packed_dput *p = (struct packed_dput*)xlb_xfer;
+
+  const adlb_datum_id *wait_ids;
+  adlb_datum_id_sub wait_id_subs[p->id_sub_count];
+  const char *name;
+  int name_strlen;
+  const void *inline_data;
+  const char *p_pos = unpack_dput(p, &wait_ids, wait_id_subs,
+                                  &name, &name_strlen, &inline_data);
+
   #ifndef NDEBUG
   // Sanity check size
   int msg_size;
@@ -348,6 +509,8 @@ handle_dput(int caller)
   assert(mc == MPI_SUCCESS);
   // Make sure we don't get garbage data
   assert(((const char*)p_pos) - ((const char*) p) <= msg_size);
+  #else
+  (void)p_pos;
   #endif
 
   MPI_Request request;
@@ -382,22 +545,84 @@ handle_dput(int caller)
   int response = ADLB_SUCCESS;
   SEND(&response, 1, MPI_INT, caller, ADLB_TAG_RESPONSE_PUT);
 
-  bool ready;
-  xlb_engine_code tc = xlb_engine_put(name, name_strlen,
-        p->id_count, wait_ids, p->id_sub_count, wait_id_subs,
-        work, &ready);
-  ADLB_CHECK_MSG(tc == XLB_ENGINE_SUCCESS, "Error adding data-dependent work");
+  adlb_code ac = dput_work_unit(work, NULL, name, name_strlen,
+        p->id_count, wait_ids, p->id_sub_count, wait_id_subs);
+  ADLB_CHECK(ac);
 
-  if (ready)
+  MPE_LOG(xlb_mpe_svr_dput_end);
+  return ADLB_SUCCESS;
+}
+
+/*
+  Handle batch of dputs from ADLB_Dput_batch.  All task data is inline
+  so we only need one message from the caller.
+ */
+static adlb_code
+handle_dput_batch(int caller)
+{
+  MPE_LOG(xlb_mpe_svr_dput_start);
+
+  char *msg;
+  int msg_size;
+  adlb_code rc = recv_dput_msg(caller, ADLB_TAG_DPUT_BATCH,
+                               &msg, &msg_size);
+  ADLB_CHECK(rc);
+  const struct packed_batch_hdr *hdr = (struct packed_batch_hdr*)msg;
+
+  DEBUG("handle_dput_batch: %i tasks from %i", hdr->count, caller);
+
+  rc = dput_records(caller, msg, msg_size, (const char*)hdr->records,
+                    hdr->count, NULL);
+  ADLB_CHECK(rc);
+
+  free(msg);
+
+  MPE_LOG(xlb_mpe_svr_dput_end);
+  return ADLB_SUCCESS;
+}
+
+/*
+  Handle group of dputs from ADLB_Dput_group.  The engine subscribes
+  to the shared inputs once for all tasks in the message.
+ */
+static adlb_code
+handle_dput_group(int caller)
+{
+  MPE_LOG(xlb_mpe_svr_dput_start);
+
+  char *msg;
+  int msg_size;
+  adlb_code rc = recv_dput_msg(caller, ADLB_TAG_DPUT_GROUP,
+                               &msg, &msg_size);
+  ADLB_CHECK(rc);
+  const struct packed_dput_group_hdr *hdr =
+        (struct packed_dput_group_hdr*)msg;
+
+  DEBUG("handle_dput_group: %i tasks from %i", hdr->count, caller);
+
+  const adlb_datum_id *shared_ids = hdr->shared_ids;
+  adlb_datum_id_sub shared_id_subs[hdr->shared_id_sub_count];
+  const char *shared_pos = (const char*)hdr->shared_ids;
+  shared_pos += sizeof(shared_ids[0]) * (size_t)hdr->shared_id_count;
+  for (int i = 0; i < hdr->shared_id_sub_count; i++)
   {
-    // Didn't put into engine, need to move to work queue
-    adlb_code ac = xlb_put_work_unit(work);
-    ADLB_CHECK(ac);
+    shared_pos += xlb_unpack_id_sub(shared_pos, &shared_id_subs[i].id,
+                                    &shared_id_subs[i].subscript);
   }
 
-  // Update performance counters
-  xlb_task_data_count(p->type, p->target >= 0, p->opts.parallelism > 1,
-                      !ready);
+  xlb_engine_group *group;
+  xlb_engine_code tc = xlb_engine_group_begin(hdr->shared_id_count,
+      shared_ids, hdr->shared_id_sub_count, shared_id_subs, &group);
+  ADLB_CHECK_MSG(tc == XLB_ENGINE_SUCCESS,
+                 "Error adding data-dependent group");
+
+  const char *rec_pos = (const char*)hdr->shared_ids +
+    PACKED_BATCH_PAD((size_t)(shared_pos - (const char*)hdr->shared_ids));
+  rc = dput_records(caller, msg, msg_size, rec_pos, hdr->count, group);
+  ADLB_CHECK(rc);
+
+  xlb_engine_group_end(group);
+  free(msg);
 
   MPE_LOG(xlb_mpe_svr_dput_end);
   return ADLB_SUCCESS;
@@ -504,10 +729,8 @@ xlb_put_work_unit(xlb_work_unit *work)
 
     if (worker != ADLB_RANK_NULL)
     {
-      code = send_work(worker, work->id, type, work->answer,
-                       work->payload, work->length, 1);
+      code = send_work_unit(worker, work);
       ADLB_CHECK(code);
-      xlb_work_unit_free(work);
 
       if (xlb_s.perfc_enabled)
       {
@@ -753,6 +976,7 @@ handle_iget(int caller)
   // MPE_LOG(xlb_mpe_svr_iget_start);
 
   RECV(&type, 1, MPI_INT, caller, ADLB_TAG_IGET);
+  xlb_task_runtime_end(caller);
   int matched = check_workqueue(caller, type, 1);
 
   if (matched == 0)
@@ -786,6 +1010,9 @@ process_get_request(int caller, int type, int count, bool blocking)
 {
   adlb_code code;
 
+  // Caller asking for more work has finished its last task
+  xlb_task_runtime_end(caller);
+
   int matched = check_workqueue(caller, type, count);
   if (matched > 0)
   {
@@ -839,8 +1066,8 @@ check_workqueue(int caller, int type, int count)
       break;
     }
 
-    send_work_unit(caller, wu);
-    xlb_work_unit_free(wu);
+    adlb_code rc = send_work_unit(caller, wu);
+    ASSERT(rc == ADLB_SUCCESS);
     matched++;
   }
   TRACE_END;
@@ -961,20 +1188,29 @@ static inline adlb_code send_parallel_work(int *workers,
     adlb_code rc = send_work(workers[i], wuid, type, answer,
                        payload, length, parallelism);
     ADLB_CHECK(rc);
-    SEND(workers, parallelism, MPI_INT, workers[i],
-         ADLB_TAG_RESPONSE_GET);
+    rc = xlb_sendq_copy(workers, sizeof(workers[0]) * (size_t)parallelism,
+                        workers[i], ADLB_TAG_RESPONSE_GET);
+    ADLB_CHECK(rc);
   }
   return ADLB_SUCCESS;
 }
 
 /**
-   Simple wrapper function
+   Send the work unit to a worker.
+   Takes ownership of wu: it is freed once the send completes
  */
 static inline adlb_code
 send_work_unit(int worker, xlb_work_unit* wu)
 {
-  return send_work(worker, wu->id, wu->type, wu->answer,
-                   wu->payload, wu->length, wu->opts.parallelism);
+  DEBUG("send_work_unit() to: %i wuid: %"PRId64"...", worker, wu->id);
+  adlb_code rc = send_work_header(worker, wu->id, wu->type, wu->answer,
+                                  wu->length, wu->opts.parallelism);
+  ADLB_CHECK(rc);
+
+  rc = xlb_sendq_work_unit(wu, worker, ADLB_TAG_WORK);
+  ADLB_CHECK(rc);
+
+  return ADLB_SUCCESS;
 }
 
 /**
@@ -985,10 +1221,27 @@ static adlb_code
 send_work(int worker, xlb_work_unit_id wuid, int type, int answer,
           const void* payload, int length, int parallelism)
 {
-  assert(!xlb_server_shutting_down); // Shouldn't shutdown if have work
-
   DEBUG("send_work() to: %i wuid: %"PRId64"...", worker, wuid);
   TRACE("work_unit: %s\n", (char*) payload);
+  adlb_code rc = send_work_header(worker, wuid, type, answer, length,
+                                  parallelism);
+  ADLB_CHECK(rc);
+
+  rc = xlb_sendq_copy(payload, (size_t)length, worker, ADLB_TAG_WORK);
+  ADLB_CHECK(rc);
+
+  return ADLB_SUCCESS;
+}
+
+/**
+   Send the response that precedes the work unit payload
+ */
+static inline adlb_code
+send_work_header(int worker, xlb_work_unit_id wuid, int type, int answer,
+                 int length, int parallelism)
+{
+  assert(!xlb_server_shutting_down); // Shouldn't shutdown if have work
+
   struct packed_get_response g;
   g.answer_rank = answer;
   g.code = ADLB_SUCCESS;
@@ -998,10 +1251,9 @@ send_work(int worker, xlb_work_unit_id wuid, int type, int answer,
   g.type = type;
   g.parallelism = parallelism;
 
-  SEND(&g, sizeof(g), MPI_BYTE, worker, ADLB_TAG_RESPONSE_GET);
-  SEND(payload, length, MPI_BYTE, worker, ADLB_TAG_WORK);
+  xlb_task_runtime_start(worker, type);
 
-  return ADLB_SUCCESS;
+  return xlb_sendq_copy(&g, sizeof(g), worker, ADLB_TAG_RESPONSE_GET);
 }
 
 /**
@@ -1019,9 +1271,7 @@ send_no_work(int worker)
   g.payload_source = mpi_rank;
   g.type = -1;
 
-  SEND(&g, sizeof(g), MPI_BYTE, worker, ADLB_TAG_RESPONSE_GET);
-
-  return ADLB_SUCCESS;
+  return xlb_sendq_copy(&g, sizeof(g), worker, ADLB_TAG_RESPONSE_GET);
 }
 
 static adlb_code
@@ -1118,6 +1368,21 @@ handle_exists(int caller)
   return ADLB_SUCCESS;
 }
 
+/** Store waiting for its payload to arrive through RMA window */
+typedef struct
+{
+  int caller;
+  struct packed_store_hdr hdr;
+  void *xfer;
+  char subscript[];
+} rma_store;
+
+static adlb_code rma_store_done(void *ctx);
+
+static adlb_code
+store_complete(int caller, const struct packed_store_hdr *hdr,
+               adlb_subscript subscript, void *xfer, bool xfer_alloced);
+
 static adlb_code
 handle_store(int caller)
 {
@@ -1145,6 +1410,23 @@ handle_store(int caller)
         ADLB_PRID_ARGS(hdr.id, ADLB_DSYM_NULL));
   }
 
+  if (hdr.rma_addr != 0)
+  {
+    // Read payload directly into new datum storage, finish later
+    rma_store *rs = malloc(sizeof(rma_store) + hdr.subscript_len);
+    ADLB_CHECK_MALLOC(rs);
+    rs->caller = caller;
+    rs->hdr = hdr;
+    memcpy(rs->subscript, subscript_buf, hdr.subscript_len);
+    rs->xfer = malloc(hdr.length);
+    ADLB_CHECK_MALLOC(rs->xfer);
+    adlb_code rc = xlb_rma_read_start(rs->xfer, hdr.length, caller,
+                            hdr.rma_addr, rma_store_done, rs);
+    ADLB_CHECK(rc);
+    MPE_LOG(xlb_mpe_svr_store_end);
+    return ADLB_SUCCESS;
+  }
+
   void* xfer;
   // Normally, we copy out of the same recv buffer:
   bool xfer_alloced = false;
@@ -1161,13 +1443,53 @@ handle_store(int caller)
 
   mpi_recv_big(xfer, hdr.length, caller, ADLB_TAG_STORE_PAYLOAD);
 
+  adlb_code rc = store_complete(caller, &hdr, subscript, xfer,
+                                xfer_alloced);
+  ADLB_CHECK(rc);
+
+  TRACE("STORE DONE");
+  MPE_LOG(xlb_mpe_svr_store_end);
+
+  return ADLB_SUCCESS;
+}
+
+/**
+  Payload of store arrived through RMA window
+ */
+static adlb_code
+rma_store_done(void *ctx)
+{
+  rma_store *rs = ctx;
+  adlb_subscript subscript = { .key = NULL,
+        .length = rs->hdr.subscript_len };
+  if (rs->hdr.subscript_len > 0)
+    subscript.key = rs->subscript;
+
+  adlb_code rc = store_complete(rs->caller, &rs->hdr, subscript,
+                                rs->xfer, true);
+  free(rs);
+  ADLB_CHECK(rc);
+
+  TRACE("STORE DONE (RMA)");
+  return ADLB_SUCCESS;
+}
+
+/**
+  Store received payload and respond to caller
+  xfer_alloced: if true, xfer was malloc'ed and is freed here unless
+                the datum took ownership of it
+ */
+static adlb_code
+store_complete(int caller, const struct packed_store_hdr *hdr,
+               adlb_subscript subscript, void *xfer, bool xfer_alloced)
+{
   adlb_notif_t notifs = ADLB_NO_NOTIFS;
 
   bool lost_xfer_ownership;
   adlb_data_code dc =
-      xlb_data_store(hdr.id, subscript, xfer, hdr.length, !xfer_alloced,
-          &lost_xfer_ownership,
-          hdr.type, hdr.refcount_decr, hdr.store_refcounts, &notifs);
+      xlb_data_store(hdr->id, subscript, xfer, hdr->length,
+          !xfer_alloced, &lost_xfer_ownership,
+          hdr->type, hdr->refcount_decr, hdr->store_refcounts, &notifs);
 
   struct packed_store_resp resp = { .dc = dc };
   // Can handle notifications on client or on server
@@ -1205,9 +1527,141 @@ handle_store(int caller)
     free(xfer);
   }
 
-  TRACE("STORE DONE");
+  return ADLB_SUCCESS;
+}
+
+/**
+  Apply stores and refcount decrements buffered by a worker, in order.
+  The worker merges decrements per ID and sends them after the stores;
+  they are checked, then applied together with refcount changes from
+  the stores.
+  A double write is reported after applying the remaining operations;
+  any other failure stops the batch.  Notifications for all applied
+  operations are returned together, even if the batch failed.
+ */
+static adlb_code
+handle_store_batch(int caller)
+{
+  MPE_LOG(xlb_mpe_svr_store_start);
+  MPI_Status status;
+
+  RECV(xlb_xfer, ADLB_XFER_SIZE, MPI_BYTE, caller, ADLB_TAG_STORE_BATCH);
+  const struct packed_batch_hdr *hdr =
+        (const struct packed_batch_hdr*)xlb_xfer;
+
+  #ifndef NDEBUG
+  int msg_size;
+  int mc = MPI_Get_count(&status, MPI_BYTE, &msg_size);
+  assert(mc == MPI_SUCCESS);
+  #endif
+
+  DEBUG("Store batch: %i ops from %i", hdr->count, caller);
+
+  adlb_notif_t notifs = ADLB_NO_NOTIFS;
+  adlb_data_code dc = ADLB_DATA_SUCCESS;
+  bool rejected = false;
+
+  const char *rec_pos = (const char*)hdr->records;
+  for (int i = 0; i < hdr->count && dc == ADLB_DATA_SUCCESS; i++)
+  {
+    const struct packed_store_batch_rec *rec =
+          (const struct packed_store_batch_rec*)rec_pos;
+    char *data = (char*)rec_pos +
+                  PACKED_BATCH_PAD(sizeof(struct packed_store_batch_rec));
+
+    if (rec->store)
+    {
+      adlb_subscript subscript = ADLB_NO_SUB;
+      if (rec->hdr.subscript_len > 0)
+      {
+        subscript.key = data + rec->hdr.length;
+        subscript.length = rec->hdr.subscript_len;
+      }
+
+      // Data is copied out of xfer buffer
+      dc = xlb_data_store(rec->hdr.id, subscript, data, rec->hdr.length,
+                true, NULL, rec->hdr.type, rec->hdr.refcount_decr,
+                rec->hdr.store_refcounts, &notifs);
+      rec_pos = data + PACKED_BATCH_PAD(rec->hdr.length +
+                                        rec->hdr.subscript_len);
+    }
+    else
+    {
+      // Applied with other refcount changes in one pass when
+      // notifications are processed.  Check first so that a bad
+      // decrement fails the batch like a failed store.
+      adlb_refc decr = adlb_refc_negate(rec->hdr.refcount_decr);
+      dc = xlb_data_reference_count_check(rec->hdr.id, decr);
+      if (dc == ADLB_DATA_SUCCESS)
+      {
+        adlb_code ac = xlb_refc_changes_add(&notifs.refcs, rec->hdr.id,
+                decr.read_refcount, decr.write_refcount, false);
+        ADLB_CHECK(ac);
+      }
+      rec_pos = data;
+    }
+    assert(rec_pos - xlb_xfer <= msg_size);
+
+    if (dc == ADLB_DATA_ERROR_DOUBLE_WRITE)
+    {
+      rejected = true;
+      dc = ADLB_DATA_SUCCESS;
+    }
+  }
+
+  // Client still receives notifications for operations applied
+  // before a failure
+  adlb_code rc;
+  // Can't use xlb_xfer: notifications may refer to subscripts in it
+  size_t tmp_len = 8192;
+  char tmp[tmp_len];
+  adlb_buffer tmp_buf = { .data = tmp, .length= tmp_len };
+  xlb_prepared_notifs prep;
+  bool send_notifs;
+
+  struct packed_store_resp resp = { .dc = dc };
+  rc = xlb_prepare_notif_work(&notifs, &tmp_buf, &resp.notifs,
+                              &prep, &send_notifs);
+  ADLB_CHECK(rc);
+
+  if (dc == ADLB_DATA_SUCCESS && rejected)
+    resp.dc = ADLB_DATA_ERROR_DOUBLE_WRITE;
+
+  RSEND(&resp, sizeof(resp), MPI_BYTE, caller, ADLB_TAG_RESPONSE);
+
+  if (send_notifs)
+  {
+    rc = xlb_send_notif_work(caller, &notifs, &resp.notifs, &prep);
+    ADLB_CHECK(rc)
+  }
+
+  xlb_free_notif(&notifs);
+
   MPE_LOG(xlb_mpe_svr_store_end);
+  return ADLB_SUCCESS;
+}
+
+/**
+  Lend retrieved data to caller through RMA window.  The data is
+  copied unless we own it, since the datum may be freed or the scratch
+  buffer reused before the caller reads it.
+ */
+static adlb_code
+rma_lend_result(adlb_binary_data *result, MPI_Aint *addr)
+{
+  if (result->caller_data == NULL || result->caller_data == xlb_scratch)
+  {
+    void *copy = malloc(result->length);
+    ADLB_CHECK_MALLOC(copy);
+    memcpy(copy, result->data, result->length);
+    result->data = result->caller_data = copy;
+  }
 
+  adlb_code rc = xlb_rma_lend(result->caller_data, result->length,
+                              addr);
+  ADLB_CHECK(rc);
+  // Freed when caller returns it
+  result->caller_data = NULL;
   return ADLB_SUCCESS;
 }
 
@@ -1252,6 +1706,7 @@ handle_retrieve(int caller)
   resp_hdr.code = dc;
   resp_hdr.type = type;
   resp_hdr.length = result.length;
+  resp_hdr.rma_addr = 0;
   if (dc == ADLB_DATA_SUCCESS)
   {
     adlb_code rc;
@@ -1265,11 +1720,21 @@ handle_retrieve(int caller)
                                 &prep, &send_notifs);
     ADLB_CHECK(rc);
 
+    if (xlb_rma_use(result.length))
+    {
+      rc = rma_lend_result(&result, &resp_hdr.rma_addr);
+      ADLB_CHECK(rc);
+    }
+
     RSEND(&resp_hdr, sizeof(resp_hdr), MPI_BYTE, caller,
           ADLB_TAG_RESPONSE);
 
-    // Send data then notifs
-    mpi_send_big(result.data, result.length, caller, ADLB_TAG_RESPONSE);
+    // Send data, unless caller reads it, then notifs
+    if (resp_hdr.rma_addr == 0)
+    {
+      mpi_send_big(result.data, result.length, caller,
+                   ADLB_TAG_RESPONSE);
+    }
     DEBUG("Retrieve: "ADLB_PRID,
           ADLB_PRID_ARGS(hdr->id, ADLB_DSYM_NULL));
 
@@ -1294,6 +1759,139 @@ handle_retrieve(int caller)
   return ADLB_SUCCESS;
 }
 
+/**
+  Retrieve several datums for one client.  Results for all requests
+  are packed into a single response, in the order requested.
+ */
+static adlb_code
+handle_retrieve_multi(int caller)
+{
+  MPE_LOG(xlb_mpe_svr_retrieve_start);
+  MPI_Status status;
+  adlb_code rc;
+  adlb_data_code dc;
+
+  RECV(xlb_xfer, ADLB_XFER_SIZE, MPI_BYTE, caller,
+       ADLB_TAG_RETRIEVE_MULTI);
+  const struct packed_batch_hdr *hdr =
+        (const struct packed_batch_hdr*)xlb_xfer;
+
+  DEBUG("Retrieve multi: %i from %i", hdr->count, caller);
+
+  adlb_buffer resp = { .data = malloc(4096), .length = 4096 };
+  ADLB_CHECK_MALLOC(resp.data);
+  size_t resp_len = 0;
+
+  adlb_notif_t notifs = ADLB_NO_NOTIFS;
+
+  const char *req_pos = (const char*)hdr->records;
+  for (int i = 0; i < hdr->count; i++)
+  {
+    const struct packed_retrieve_hdr *req =
+          (const struct packed_retrieve_hdr*)req_pos;
+    adlb_subscript subscript = ADLB_NO_SUB;
+    if (req->subscript_len > 0)
+    {
+      subscript.key = req->subscript;
+      subscript.length = req->subscript_len;
+    }
+
+    adlb_data_type type = ADLB_DATA_TYPE_NULL;
+    adlb_binary_data result;
+    adlb_data_code ret_dc = xlb_data_retrieve(req->id, subscript,
+                req->refcounts.decr_self, req->refcounts.incr_referand,
+                &type, &xlb_scratch_buf, &result, &notifs);
+
+    size_t data_len = (ret_dc == ADLB_DATA_SUCCESS) ? result.length : 0;
+    size_t rec_len = PACKED_BATCH_PAD(
+                        sizeof(struct retrieve_multi_resp_rec)) +
+                     PACKED_BATCH_PAD(data_len);
+    dc = ADLB_Resize_buf(&resp, NULL, resp_len + rec_len);
+    ADLB_DATA_CHECK(dc);
+
+    struct retrieve_multi_resp_rec *rec =
+          (struct retrieve_multi_resp_rec*)(resp.data + resp_len);
+    rec->code = ret_dc;
+    rec->type = type;
+    rec->length = data_len;
+    if (data_len > 0)
+    {
+      memcpy((char*)rec + PACKED_BATCH_PAD(sizeof(*rec)), result.data,
+             data_len);
+    }
+    resp_len += rec_len;
+
+    ADLB_Free_binary_data2(&result, xlb_scratch);
+
+    req_pos += PACKED_BATCH_PAD(sizeof(struct packed_retrieve_hdr) +
+                                req->subscript_len);
+  }
+
+  struct retrieve_multi_resp_hdr resp_hdr = { .length = resp_len };
+  size_t tmp_len = 8192;
+  char tmp[tmp_len];
+  adlb_buffer tmp_buf = { .data = tmp, .length= tmp_len };
+  xlb_prepared_notifs prep;
+  bool send_notifs;
+
+  rc = xlb_prepare_notif_work(&notifs, &tmp_buf, &resp_hdr.notifs,
+                              &prep, &send_notifs);
+  ADLB_CHECK(rc);
+
+  RSEND(&resp_hdr, sizeof(resp_hdr), MPI_BYTE, caller,
+        ADLB_TAG_RESPONSE);
+  mpi_send_big(resp.data, resp_len, caller, ADLB_TAG_RESPONSE);
+
+  if (send_notifs)
+  {
+    rc = xlb_send_notif_work(caller, &notifs, &resp_hdr.notifs, &prep);
+    ADLB_CHECK(rc)
+  }
+
+  xlb_free_notif(&notifs);
+  free(resp.data);
+
+  MPE_LOG(xlb_mpe_svr_retrieve_end);
+  return ADLB_SUCCESS;
+}
+
+static adlb_code
+handle_retrieve_array(int caller)
+{
+  TRACE("RETRIEVE_ARRAY\n");
+  struct packed_retrieve_array req;
+  adlb_code rc;
+  MPI_Status status;
+  RECV(&req, sizeof(req), MPI_BYTE, caller, ADLB_TAG_RETRIEVE_ARRAY);
+
+  adlb_buffer data = { .data = NULL, .length = 0 };
+  struct packed_retrieve_array_result res;
+  res.count = 0;
+  adlb_data_code dc = xlb_data_retrieve_array(req.id, &xlb_xfer_buf,
+                                    &data, &res.type, &res.count);
+  bool free_data = (dc == ADLB_DATA_SUCCESS &&
+                    xlb_xfer_buf.data != data.data);
+  if (dc == ADLB_DATA_SUCCESS)
+  {
+    rc = refcount_decr_helper(req.id, req.decr);
+    ADLB_CHECK(rc);
+  }
+
+  res.dc = dc;
+  res.length = (dc == ADLB_DATA_SUCCESS) ? data.length : 0;
+
+  RSEND(&res, sizeof(res), MPI_BYTE, caller, ADLB_TAG_RESPONSE);
+  if (res.length > 0)
+  {
+    rc = mpi_send_big(data.data, data.length, caller, ADLB_TAG_RESPONSE);
+    ADLB_CHECK(rc);
+  }
+
+  if (free_data)
+    free(data.data);
+  return ADLB_SUCCESS;
+}
+
 static adlb_code
 handle_enumerate(int caller)
 {
@@ -1339,6 +1937,96 @@ handle_enumerate(int caller)
   return ADLB_SUCCESS;
 }
 
+static adlb_code
+handle_enumerate_cursor(int caller)
+{
+  TRACE("ENUMERATE_CURSOR\n");
+  struct packed_enumerate_cursor opts;
+  adlb_code rc;
+  MPI_Status status;
+  RECV(&opts, sizeof(opts), MPI_BYTE, caller, ADLB_TAG_ENUMERATE_CURSOR);
+
+  adlb_buffer data = { .data = NULL, .length = 0 };
+  struct packed_enumerate_cursor_result res;
+  res.cursor = opts.cursor;
+  res.res.records = 0;
+  res.res.key_type = res.res.val_type = ADLB_DATA_TYPE_NULL;
+  adlb_data_code dc;
+  if (opts.close)
+  {
+    xlb_data_enumerate_close(opts.cursor);
+    res.cursor = 0;
+    dc = ADLB_DATA_SUCCESS;
+  }
+  else
+  {
+    dc = xlb_data_enumerate_cursor(opts.id, &res.cursor, opts.count,
+                    opts.request_subscripts, opts.request_members,
+                    &xlb_xfer_buf, &data, &res.res.records,
+                    &res.res.key_type, &res.res.val_type);
+  }
+  bool free_data = (dc == ADLB_DATA_SUCCESS &&
+                    data.data != NULL &&
+                    xlb_xfer_buf.data != data.data);
+  if (dc == ADLB_DATA_SUCCESS && res.cursor == 0)
+  {
+    // Caller is finished with container
+    rc = refcount_decr_helper(opts.id, opts.decr);
+    ADLB_CHECK(rc);
+  }
+
+  res.res.dc = dc;
+  res.res.length = data.length;
+
+  RSEND(&res, sizeof(res), MPI_BYTE, caller, ADLB_TAG_RESPONSE);
+  if (dc == ADLB_DATA_SUCCESS && !opts.close &&
+      (opts.request_subscripts || opts.request_members))
+  {
+    rc = mpi_send_big(data.data, data.length, caller, ADLB_TAG_RESPONSE);
+    ADLB_CHECK(rc);
+  }
+
+  if (free_data)
+    free(data.data);
+  return ADLB_SUCCESS;
+}
+
+static adlb_code
+handle_reduce(int caller)
+{
+  TRACE("REDUCE\n");
+  struct packed_reduce req;
+  adlb_code rc;
+  MPI_Status status;
+  RECV(&req, sizeof(req), MPI_BYTE, caller, ADLB_TAG_REDUCE);
+
+  adlb_buffer data = { .data = NULL, .length = 0 };
+  struct packed_reduce_result res;
+  adlb_data_code dc = xlb_data_reduce(req.id, req.op, &xlb_xfer_buf,
+                                      &data, &res.type);
+  bool free_data = (dc == ADLB_DATA_SUCCESS &&
+                    xlb_xfer_buf.data != data.data);
+  if (dc == ADLB_DATA_SUCCESS)
+  {
+    rc = refcount_decr_helper(req.id, req.decr);
+    ADLB_CHECK(rc);
+  }
+
+  res.dc = dc;
+  res.length = (dc == ADLB_DATA_SUCCESS) ? data.length : 0;
+
+  RSEND(&res, sizeof(res), MPI_BYTE, caller, ADLB_TAG_RESPONSE);
+  if (res.length > 0)
+  {
+    rc = mpi_send_big(data.data, data.length, caller, ADLB_TAG_RESPONSE);
+    ADLB_CHECK(rc);
+  }
+
+  if (free_data)
+    free(data.data);
+  return ADLB_SUCCESS;
+}
+
 static adlb_code
 handle_subscribe(int caller)
 {
@@ -1411,6 +2099,47 @@ handle_notify(int caller)
   return ADLB_SUCCESS;
 }
 
+/**
+  Deliver close notifications fanned out to this server's workers
+ */
+static adlb_code
+handle_notify_batch(int caller)
+{
+  MPI_Status status;
+  RECV(xlb_xfer, ADLB_XFER_SIZE, MPI_BYTE, caller, ADLB_TAG_NOTIFY_BATCH);
+  const struct packed_batch_hdr *hdr =
+        (const struct packed_batch_hdr*)xlb_xfer;
+
+  #ifndef NDEBUG
+  int msg_size;
+  int mc = MPI_Get_count(&status, MPI_BYTE, &msg_size);
+  assert(mc == MPI_SUCCESS);
+  #endif
+
+  DEBUG("Notify batch: %i notifications from %i", hdr->count, caller);
+
+  adlb_put_opts opts = ADLB_DEFAULT_PUT_OPTS;
+  opts.priority = 1;
+  adlb_code rc = ADLB_SUCCESS;
+  const char *rec_pos = (const char*)hdr->records;
+  for (int i = 0; i < hdr->count && rc == ADLB_SUCCESS; i++)
+  {
+    const struct packed_notify_batch_rec *rec =
+          (const struct packed_notify_batch_rec*)rec_pos;
+    assert(xlb_map_to_server(&xlb_s.layout, rec->target) ==
+           xlb_s.layout.rank);
+
+    rc = xlb_put_targeted_local(rec->work_type, caller, -1, rec->target,
+                                opts, rec->payload, rec->length);
+    rec_pos += PACKED_BATCH_PAD(sizeof(*rec) + (size_t)rec->length);
+    assert(rec_pos - xlb_xfer <= msg_size);
+  }
+
+  int resp = (int)rc;
+  RSEND(&resp, 1, MPI_INT, caller, ADLB_TAG_RESPONSE);
+  return ADLB_SUCCESS;
+}
+
 static adlb_code
 handle_get_refcounts(int caller)
 {
@@ -1859,6 +2588,34 @@ handle_shutdown_worker(int caller)
   return ADLB_SUCCESS;
 }
 
+/**
+   Another server sent a summary of its closed data
+ */
+static adlb_code
+handle_closed_summary(int caller)
+{
+  adlb_code code = xlb_closed_summary_recv(caller);
+  ADLB_CHECK(code);
+
+  return ADLB_SUCCESS;
+}
+
+/**
+   Worker finished reading retrieved data lent through RMA window
+ */
+static adlb_code
+handle_rma_done(int caller)
+{
+  MPI_Status status;
+  MPI_Aint addr;
+  RECV(&addr, sizeof(addr), MPI_BYTE, caller, ADLB_TAG_RMA_DONE);
+
+  adlb_code code = xlb_rma_return(addr);
+  ADLB_CHECK(code);
+
+  return ADLB_SUCCESS;
+}
+
 static adlb_code
 handle_fail(int caller)
 {
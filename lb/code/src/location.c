@@ -181,6 +181,32 @@ xlb_hostmap_init(const xlb_layout *layout,
 }
 
 
+adlb_code
+xlb_hostmap_host_servers(const struct xlb_hostmap *hostmap,
+      const xlb_layout *layout, int rank, int **servers, int *count)
+{
+  *servers = NULL;
+  *count = 0;
+
+  TABLE_FOREACH(&hostmap->map, item)
+  {
+    struct list_i *ranks = item->data;
+    if (!list_i_contains(ranks, rank))
+      continue;
+
+    *servers = malloc(sizeof((*servers)[0]) * (size_t)ranks->size);
+    ADLB_CHECK_MALLOC(*servers);
+    for (struct list_i_item *li = ranks->head; li != NULL; li = li->next)
+    {
+      if (li->data >= layout->workers && li->data != rank)
+        (*servers)[(*count)++] = li->data;
+    }
+    return ADLB_SUCCESS;
+  }
+
+  return ADLB_SUCCESS;
+}
+
 adlb_code
 xlb_get_hostmap_mode(xlb_hostmap_mode *mode)
 {
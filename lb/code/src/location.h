@@ -77,6 +77,15 @@ xlb_hostmap_init(const xlb_layout *layout,
 
 void xlb_hostmap_free(struct xlb_hostmap *hostmap);
 
+/**
+  Find the other servers on the same host as rank.
+  servers: set to array of server ranks, or NULL.  Caller must free
+  count: set to number of servers in array
+ */
+adlb_code
+xlb_hostmap_host_servers(const struct xlb_hostmap *hostmap,
+      const xlb_layout *layout, int rank, int **servers, int *count);
+
 /**
   Setup leader per node
  */
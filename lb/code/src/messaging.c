@@ -71,6 +71,8 @@ add_tags()
   /// tags incoming to server
   add_tag(ADLB_TAG_PUT);
   add_tag(ADLB_TAG_DPUT);
+  add_tag(ADLB_TAG_DPUT_BATCH);
+  add_tag(ADLB_TAG_DPUT_GROUP);
   add_tag(ADLB_TAG_GET);
   add_tag(ADLB_TAG_IGET);
 
@@ -82,10 +84,16 @@ add_tags()
   add_tag(ADLB_TAG_STORE_HEADER);
   add_tag(ADLB_TAG_STORE_SUBSCRIPT);
   add_tag(ADLB_TAG_STORE_PAYLOAD);
+  add_tag(ADLB_TAG_STORE_BATCH);
   add_tag(ADLB_TAG_RETRIEVE);
+  add_tag(ADLB_TAG_RETRIEVE_MULTI);
+  add_tag(ADLB_TAG_RETRIEVE_ARRAY);
   add_tag(ADLB_TAG_ENUMERATE);
+  add_tag(ADLB_TAG_ENUMERATE_CURSOR);
+  add_tag(ADLB_TAG_REDUCE);
   add_tag(ADLB_TAG_SUBSCRIBE);
   add_tag(ADLB_TAG_NOTIFY);
+  add_tag(ADLB_TAG_NOTIFY_BATCH);
   add_tag(ADLB_TAG_PERMANENT);
   add_tag(ADLB_TAG_GET_REFCOUNTS);
   add_tag(ADLB_TAG_REFCOUNT_INCR);
@@ -100,6 +108,8 @@ add_tags()
   add_tag(ADLB_TAG_SYNC_REQUEST);
   add_tag(ADLB_TAG_CHECK_IDLE);
   add_tag(ADLB_TAG_SHUTDOWN_WORKER);
+  add_tag(ADLB_TAG_CLOSED_SUMMARY);
+  add_tag(ADLB_TAG_RMA_DONE);
 
   // outgoing tags (server should not receive as request)
   add_tag(ADLB_TAG_RESPONSE);
@@ -238,6 +238,43 @@ struct packed_dput
   adlb_datum_id inline_data[];
 };
 
+/**
+   Header for batch of requests in one message, e.g. packed_dput
+   records for ADLB_TAG_DPUT_BATCH.
+   Header is followed by count records, each starting at a multiple
+   of PACKED_BATCH_ALIGN bytes from the start of the records array.
+   All tasks in a dput batch have inline data.
+ */
+struct packed_batch_hdr
+{
+  int count;
+  /* Use type adlb_datum_id to get correct alignment for records */
+  adlb_datum_id records[];
+};
+
+/**
+   Header for ADLB_TAG_DPUT_GROUP: a batch of dputs that all wait for
+   the shared ids and id/subscripts.  The shared ids are followed by
+   the packed shared id/subscripts, then count packed_dput records
+   with inline data, laid out as in a packed_batch_hdr.  The records
+   start at a multiple of PACKED_BATCH_ALIGN bytes from shared_ids.
+ */
+struct packed_dput_group_hdr
+{
+  int count;
+  int shared_id_count;
+  int shared_id_sub_count;
+  /* Use type adlb_datum_id to get correct alignment */
+  adlb_datum_id shared_ids[];
+};
+
+#define PACKED_BATCH_ALIGN (sizeof(adlb_datum_id))
+
+/** Round size of batch record up to alignment */
+#define PACKED_BATCH_PAD(size) \
+  (((size) + PACKED_BATCH_ALIGN - 1) / PACKED_BATCH_ALIGN * \
+   PACKED_BATCH_ALIGN)
+
 /**
   Struct with notification counts for embedding in other structure
  */
@@ -308,6 +345,8 @@ struct retrieve_response_hdr
   adlb_data_code code;
   adlb_data_type type;
   size_t length;
+  /** Data address in RMA window, 0 if data follows */
+  MPI_Aint rma_addr;
 };
 
 /**
@@ -332,11 +371,63 @@ struct packed_enumerate_result
   adlb_data_type val_type;
 };
 
+/**
+   Request for next chunk of enumeration with server-side cursor
+ */
+struct packed_enumerate_cursor
+{
+  adlb_datum_id id;
+  int64_t cursor; // 0 to start enumeration
+  int count;
+  char request_subscripts;
+  char request_members;
+  char close; // Release cursor without enumerating
+  adlb_refc decr; // Applied once enumeration finished or closed
+};
+
+struct packed_enumerate_cursor_result
+{
+  struct packed_enumerate_result res;
+  int64_t cursor; // 0 if enumeration finished
+};
+
+/**
+   Request for values of container as contiguous array
+ */
+struct packed_retrieve_array
+{
+  adlb_datum_id id;
+  adlb_refc decr;
+};
+
+struct packed_retrieve_array_result
+{
+  adlb_data_code dc;
+  adlb_data_type type; // Value type
+  int count; // Number of values
+  size_t length; // length of array in bytes
+};
+
+struct packed_reduce
+{
+  adlb_datum_id id;
+  adlb_reduce_op op;
+  adlb_refc decr;
+};
+
+struct packed_reduce_result
+{
+  adlb_data_code dc;
+  adlb_data_type type; // ADLB_DATA_TYPE_NULL if no result
+  size_t length; // length of packed result in bytes
+};
+
 struct packed_notif
 {
   adlb_datum_id id;
   int subscript_data; // index of extra data item, -1 for no subscript
   int rank; // Rank to notify
+  int work_type; // Work type of notification task
 };
 
 struct packed_reference
@@ -391,6 +482,18 @@ struct packed_store_hdr
   adlb_refc store_refcounts; // Refcounts to store
   uint64_t length; // Data length
   size_t subscript_len; // including null byte, 0 if no subscript
+  MPI_Aint rma_addr; // Payload address in RMA window, 0 if sent
+};
+
+/**
+ * Record in ADLB_TAG_STORE_BATCH message.  For stores, the header is
+ * followed by the data, then the subscript, starting at offset
+ * PACKED_BATCH_PAD(sizeof(struct packed_store_batch_rec)).
+ */
+struct packed_store_batch_rec
+{
+  struct packed_store_hdr hdr;
+  bool store; // If false, only decrement refcounts by hdr.refcount_decr
 };
 
 /**
@@ -413,6 +516,40 @@ struct packed_retrieve_hdr
   char subscript[];
 };
 
+/**
+ * ADLB_TAG_RETRIEVE_MULTI request is a packed_batch_hdr followed by
+ * packed_retrieve_hdr records, each padded with PACKED_BATCH_PAD.
+ * The response is a retrieve_multi_resp_hdr, then a message of length
+ * bytes holding a retrieve_multi_resp_rec for each request in order,
+ * each followed by its data padded with PACKED_BATCH_PAD, then any
+ * notification work.
+ */
+struct retrieve_multi_resp_hdr
+{
+  struct packed_notif_counts notifs;
+  size_t length;
+};
+
+struct retrieve_multi_resp_rec
+{
+  adlb_data_code code;
+  adlb_data_type type;
+  size_t length; // Bytes of data following record, 0 on failure
+};
+
+/**
+ * ADLB_TAG_CLOSED_SUMMARY message from one server to another: header
+ * followed by open_count int64_t indices, then words uint64_t bitmap
+ * words.  Indices number the IDs allocated by the sender from 0.
+ */
+struct packed_closed_summary
+{
+  int64_t low; // Indices below this are not reported
+  int64_t base;
+  int32_t open_count;
+  int32_t words;
+};
+
 #define PACKED_SUBSCRIPT_MAX (ADLB_DATA_SUBSCRIPT_MAX + \
           sizeof(adlb_datum_id) + sizeof(int))
 struct packed_insert_atomic_resp
@@ -464,6 +601,10 @@ static inline int
 xlb_unpack_id_sub(const void *buffer, adlb_datum_id *id,
                   adlb_subscript *subscript);
 
+/** Number of bytes xlb_pack_id_sub will use */
+static inline size_t
+xlb_pack_id_sub_size(adlb_subscript subscript);
+
 /**
  * Request to probe for steal work
  */
@@ -471,10 +612,13 @@ struct packed_steal
 {
   int max_memory;
   int64_t idle_check_attempt; // Sender's last idle check number
-  // Sender's work type counts packed into sync_data field as int[]
+  // Sender's work type counts packed into sync_data field as int[],
+  // followed by number of work units wanted of each type as int[],
+  // where -1 means no limit
 };
 
 #define WORK_TYPES_SIZE (sizeof(int) * (size_t)xlb_s.types_size)
+#define STEAL_DATA_SIZE (2 * WORK_TYPES_SIZE)
 
 struct packed_steal_resp
 {
@@ -492,6 +636,19 @@ struct packed_notify_hdr
   char subscript[]; // Small subscripts inline
 };
 
+/*
+   ADLB_TAG_NOTIFY_BATCH is a packed_batch_hdr followed by
+   packed_notify_batch_rec records, each padded with PACKED_BATCH_PAD:
+   close notifications for workers of the receiving server
+ */
+struct packed_notify_batch_rec
+{
+  int target;
+  int work_type;
+  int length; // Length of payload
+  char payload[];
+};
+
 /*
    Header for stolen task
  */
@@ -555,8 +712,8 @@ struct packed_sync
 };
 
 #define SYNC_DATA_SIZE \
-  (WORK_TYPES_SIZE > PACKED_SUBSCRIBE_INLINE_BYTES ? \
-   WORK_TYPES_SIZE : PACKED_SUBSCRIBE_INLINE_BYTES)
+  (STEAL_DATA_SIZE > PACKED_SUBSCRIBE_INLINE_BYTES ? \
+   STEAL_DATA_SIZE : PACKED_SUBSCRIBE_INLINE_BYTES)
 #define PACKED_SYNC_SIZE (sizeof(struct packed_sync) + SYNC_DATA_SIZE)
 
 /**
@@ -636,7 +793,19 @@ typedef enum
 
   /// tags that may be to/from server/worker
   /** Work unit payload */
-  ADLB_TAG_WORK
+  ADLB_TAG_WORK,
+
+  /// tags incoming to server, appended to keep numbers of above
+  ADLB_TAG_DPUT_BATCH,
+  ADLB_TAG_STORE_BATCH,
+  ADLB_TAG_RETRIEVE_MULTI,
+  ADLB_TAG_CLOSED_SUMMARY,
+  ADLB_TAG_DPUT_GROUP,
+  ADLB_TAG_REDUCE,
+  ADLB_TAG_ENUMERATE_CURSOR,
+  ADLB_TAG_RETRIEVE_ARRAY,
+  ADLB_TAG_NOTIFY_BATCH,
+  ADLB_TAG_RMA_DONE
 
 } adlb_tag;
 
@@ -645,6 +814,16 @@ typedef enum
  */
 
 
+/*
+ Bytes used by xlb_pack_id_sub()
+ */
+static inline size_t
+xlb_pack_id_sub_size(adlb_subscript subscript)
+{
+  return sizeof(adlb_datum_id) + sizeof(size_t) +
+         (subscript.key != NULL ? subscript.length : 0);
+}
+
 /*
  Pack into buffer of size at least PACKED_SUBSCRIPT_MAX
 
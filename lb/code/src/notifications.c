@@ -5,12 +5,32 @@
 #include "handlers.h"
 #include "messaging.h"
 #include "refcount.h"
+#include "sendqueue.h"
 #include "server.h"
 #include "sync.h"
 #include "engine.h"
 
 #define MAX_NOTIF_PAYLOAD (32+ADLB_DATA_SUBSCRIPT_MAX)
 
+#define XLB_NOTIFY_FANOUT_DEFAULT 16
+
+/** Minimum listeners in one round to fan out per server, 0 if never */
+static long fanout_min = XLB_NOTIFY_FANOUT_DEFAULT;
+
+/** Listener fanned out to server */
+typedef struct
+{
+  int server;
+  int ix; // Index in notification array
+} fanout_entry;
+
+/* Statistics */
+static int64_t fanout_rounds = 0;
+static int64_t fanout_listeners = 0;
+static int64_t fanout_msgs = 0;
+static int fanout_max_listeners = 0;
+static adlb_datum_id fanout_max_id = ADLB_DATA_ID_NULL;
+
 static adlb_code
 xlb_process_local_notif_ranks(adlb_notif_ranks *ranks);
 
@@ -79,7 +99,7 @@ static adlb_code notify_nonlocal(int target, int server,
                         int work_type)
 {
   int answer_rank = -1;
-  adlb_put_opts opts;
+  adlb_put_opts opts = ADLB_DEFAULT_PUT_OPTS;
   opts.priority = 1;
   adlb_code rc;
   if (xlb_s.layout.am_server)
@@ -93,6 +113,31 @@ static adlb_code notify_nonlocal(int target, int server,
 }
 
 
+adlb_code
+xlb_notifications_init(void)
+{
+  adlb_code ac = xlb_env_long("ADLB_NOTIFY_FANOUT", &fanout_min);
+  ADLB_CHECK(ac);
+  ADLB_CHECK_MSG(fanout_min >= 0, "ADLB_NOTIFY_FANOUT negative: %li",
+                 fanout_min);
+  return ADLB_SUCCESS;
+}
+
+void
+xlb_print_notif_counters(void)
+{
+  if (!xlb_s.perfc_enabled)
+  {
+    return;
+  }
+
+  PRINT_COUNTER("notify_fanout_rounds=%"PRId64, fanout_rounds);
+  PRINT_COUNTER("notify_fanout_listeners=%"PRId64, fanout_listeners);
+  PRINT_COUNTER("notify_fanout_msgs=%"PRId64, fanout_msgs);
+  PRINT_COUNTER("notify_fanout_max_listeners=%i", fanout_max_listeners);
+  PRINT_COUNTER("notify_fanout_max_id=%"PRId64, fanout_max_id);
+}
+
 void xlb_free_notif(adlb_notif_t *notifs)
 {
   xlb_free_ranks(&notifs->notify);
@@ -216,6 +261,107 @@ xlb_set_ref(adlb_datum_id id, adlb_subscript subscript,
 
 }
 
+static int
+fanout_entry_cmp(const void *a, const void *b)
+{
+  const fanout_entry *x = a, *y = b;
+  if (x->server != y->server)
+    return (x->server < y->server) ? -1 : 1;
+  return (x->ix < y->ix) ? -1 : (x->ix > y->ix);
+}
+
+/*
+  Send batch of notifications in buf to server
+ */
+static adlb_code
+send_notify_batch(int server, const char *buf, size_t length)
+{
+  MPI_Status status;
+  MPI_Request request;
+  adlb_code rc;
+
+  if (xlb_s.layout.am_server)
+  {
+    rc = xlb_sync(server);
+    ADLB_CHECK(rc);
+  }
+
+  DEBUG("Notify batch: %i notifications to %i",
+        ((const struct packed_batch_hdr*)buf)->count, server);
+
+  int response;
+  IRECV(&response, 1, MPI_INT, server, ADLB_TAG_RESPONSE);
+  SEND(buf, (int)length, MPI_BYTE, server, ADLB_TAG_NOTIFY_BATCH);
+  WAIT(&request, &status);
+  ADLB_CHECK((adlb_code)response);
+
+  fanout_msgs++;
+  return ADLB_SUCCESS;
+}
+
+/*
+  Send notifications for the listed entries, sorted by server, in one
+  message per server where they fit
+ */
+static adlb_code
+notify_fanout(const adlb_notif_ranks *ranks, fanout_entry *entries,
+              int count)
+{
+  adlb_code rc;
+  qsort(entries, (size_t)count, sizeof(entries[0]), fanout_entry_cmp);
+
+  size_t rec_max = PACKED_BATCH_PAD(
+        sizeof(struct packed_notify_batch_rec) + MAX_NOTIF_PAYLOAD);
+  size_t buf_size = sizeof(struct packed_batch_hdr) +
+                    rec_max * (size_t)count;
+  if (buf_size > ADLB_XFER_SIZE)
+    buf_size = ADLB_XFER_SIZE;
+
+  char *buf = malloc(buf_size);
+  ADLB_CHECK_MALLOC(buf);
+  struct packed_batch_hdr *hdr = (struct packed_batch_hdr*)buf;
+  char *pos = (char*)hdr->records;
+  hdr->count = 0;
+
+  for (int i = 0; i < count; i++)
+  {
+    const adlb_notif_rank *notif = &ranks->notifs[entries[i].ix];
+    struct packed_notify_batch_rec *rec =
+          (struct packed_notify_batch_rec*)pos;
+    rec->target = notif->rank;
+    rec->work_type = notif->work_type;
+    rec->length = fill_notif_payload(rec->payload, notif->id,
+                                     notif->subscript);
+    pos += PACKED_BATCH_PAD(sizeof(*rec) + (size_t)rec->length);
+    hdr->count++;
+
+    int server = entries[i].server;
+    if (i == count - 1 || entries[i + 1].server != server ||
+        (size_t)(buf + buf_size - pos) < rec_max)
+    {
+      rc = send_notify_batch(server, buf, (size_t)(pos - buf));
+      if (rc != ADLB_SUCCESS)
+      {
+        free(buf);
+        return rc;
+      }
+      pos = (char*)hdr->records;
+      hdr->count = 0;
+    }
+  }
+
+  free(buf);
+
+  fanout_rounds++;
+  fanout_listeners += count;
+  if (count > fanout_max_listeners)
+  {
+    fanout_max_listeners = count;
+    fanout_max_id = ranks->notifs[entries[0].ix].id;
+  }
+  return ADLB_SUCCESS;
+}
+
 /*
  * Send all notifications.
  */
@@ -225,8 +371,18 @@ xlb_close_notify(adlb_notif_ranks *ranks)
   adlb_code rc;
   char payload[MAX_NOTIF_PAYLOAD];
   int payload_len = 0;
+  adlb_datum_id last_id = ADLB_DATA_ID_NULL;
   adlb_subscript last_subscript = ADLB_NO_SUB;
 
+  // Workers of other servers to notify with one message per server
+  fanout_entry *fanout = NULL;
+  int fanout_count = 0;
+  if (fanout_min > 0 && ranks->count >= fanout_min)
+  {
+    fanout = malloc(sizeof(fanout[0]) * (size_t)ranks->count);
+    ADLB_CHECK_MALLOC(fanout);
+  }
+
   for (int i = 0; i < ranks->count; i++)
   {
     adlb_notif_rank *notif = &ranks->notifs[i];
@@ -246,18 +402,27 @@ xlb_close_notify(adlb_notif_ranks *ranks)
     }
     else
     {
-      if (i == 0 || notif->subscript.key != last_subscript.key ||
-                    notif->subscript.length != last_subscript.length)
+      if (payload_len == 0 || notif->id != last_id ||
+          notif->subscript.key != last_subscript.key ||
+          notif->subscript.length != last_subscript.length)
       {
-        // Skip refilling payload if possible 
+        // Skip refilling payload if possible
         payload_len = fill_notif_payload(payload, notif->id,
-                                          notif->subscript);
+                                         notif->subscript);
+        last_id = notif->id;
+        last_subscript = notif->subscript;
       }
       if (server == xlb_s.layout.rank)
       {
         rc = notify_local(target, payload, payload_len, notif->work_type);
         ADLB_CHECK(rc);
       }
+      else if (fanout != NULL)
+      {
+        fanout[fanout_count].server = server;
+        fanout[fanout_count].ix = i;
+        fanout_count++;
+      }
       else
       {
         rc = notify_nonlocal(target, server, payload, payload_len,
@@ -267,6 +432,13 @@ xlb_close_notify(adlb_notif_ranks *ranks)
     }
   }
 
+  if (fanout_count > 0)
+  {
+    rc = notify_fanout(ranks, fanout, fanout_count);
+    ADLB_CHECK(rc);
+  }
+  free(fanout);
+
   // Should be all processed now
   xlb_free_ranks(ranks);
   return ADLB_SUCCESS;
@@ -392,6 +564,7 @@ xlb_process_local_notif_ranks(adlb_notif_ranks *ranks)
   {
     char payload[MAX_NOTIF_PAYLOAD];
     int payload_len = 0;
+    adlb_datum_id last_id = ADLB_DATA_ID_NULL;
     adlb_subscript last_subscript = ADLB_NO_SUB;
 
     int i = 0;
@@ -410,12 +583,15 @@ xlb_process_local_notif_ranks(adlb_notif_ranks *ranks)
         if (server == xlb_s.layout.rank)
         {
           // Check to see if target is worker belonging to server
-          if (i == 0 || notif->subscript.key != last_subscript.key ||
-                        notif->subscript.length != last_subscript.length)
+          if (payload_len == 0 || notif->id != last_id ||
+              notif->subscript.key != last_subscript.key ||
+              notif->subscript.length != last_subscript.length)
           {
-            // Skip refilling payload if possible 
+            // Skip refilling payload if possible
             payload_len = fill_notif_payload(payload, notif->id,
-                                               notif->subscript);
+                                             notif->subscript);
+            last_id = notif->id;
+            last_subscript = notif->subscript;
           }
 
           // Swap with last and shorten array
@@ -698,8 +874,27 @@ xlb_refc_changes_expand(xlb_refc_changes *c, int to_add)
   if (new_size < needed)
     new_size = needed;
 
-  void *ptr = realloc(c->arr, (size_t)new_size * sizeof(c->arr[0]));
-  ADLB_CHECK_MALLOC(ptr);
+  void *ptr;
+  if (new_size == XLB_REFC_CHANGES_INIT_SIZE)
+  {
+    // Common case: small initial array from slab
+    assert(c->arr == NULL);
+    ptr = xlb_slab_alloc(&xlb_refc_changes_slab);
+    ADLB_CHECK_MALLOC(ptr);
+  }
+  else if (c->size == XLB_REFC_CHANGES_INIT_SIZE)
+  {
+    // Outgrew slab array
+    ptr = malloc((size_t)new_size * sizeof(c->arr[0]));
+    ADLB_CHECK_MALLOC(ptr);
+    memcpy(ptr, c->arr, (size_t)c->count * sizeof(c->arr[0]));
+    xlb_slab_free(&xlb_refc_changes_slab, c->arr);
+  }
+  else
+  {
+    ptr = realloc(c->arr, (size_t)new_size * sizeof(c->arr[0]));
+    ADLB_CHECK_MALLOC(ptr);
+  }
 
 #if XLB_INDEX_REFC_CHANGES
   // Init index, use 1.0 load factor so realloced at same pace as array
@@ -881,6 +1076,7 @@ xlb_prepare_for_send(adlb_notif_t *notifs,
   {
     adlb_notif_rank *rank = &notifs->notify.notifs[i];
     packed_notifs[i].rank = rank->rank;
+    packed_notifs[i].work_type = rank->work_type;
     packed_notifs[i].id = rank->id;
     if (adlb_has_sub(rank->subscript))
     {
@@ -972,11 +1168,26 @@ xlb_prepare_for_send(adlb_notif_t *notifs,
   return ADLB_SUCCESS;
 }
 
+/**
+  Queue a prepared buffer for sending to caller, passing ownership
+  to the send queue if the buffer was allocated for it
+ */
+static inline adlb_code
+send_prepared(void *data, size_t length, bool owned, int caller)
+{
+  if (owned)
+  {
+    return xlb_sendq_owned(data, length, caller, ADLB_TAG_RESPONSE_NOTIF);
+  }
+  return xlb_sendq_copy(data, length, caller, ADLB_TAG_RESPONSE_NOTIF);
+}
+
 adlb_code
 xlb_send_notif_work(int caller, adlb_notif_t *notifs,
        const struct packed_notif_counts *counts,
        const xlb_prepared_notifs *prepared)
 {
+  adlb_code rc;
   size_t extra_data_bytes = counts->extra_data_bytes;
   int notify_count = counts->notify_count;
   int refs_count = counts->reference_count;
@@ -987,43 +1198,36 @@ xlb_send_notif_work(int caller, adlb_notif_t *notifs,
     TRACE("Sending %i extra data count %zu bytes",
            counts->extra_data_count, extra_data_bytes);
     assert(counts->extra_data_count > 0);
-    mpi_send_big(prepared->extra_data, extra_data_bytes,
-                 caller, ADLB_TAG_RESPONSE_NOTIF);
-
-    if (prepared->free_extra_data)
-    {
-      free(prepared->extra_data);
-    }
+    rc = send_prepared(prepared->extra_data, extra_data_bytes,
+                       prepared->free_extra_data, caller);
+    ADLB_CHECK(rc);
   }
   if (notify_count > 0)
   {
     struct packed_notif *packed_notifs = prepared->packed_notifs;
     TRACE("Sending %i notifs", notify_count);
-    SEND(packed_notifs, notify_count * (int)sizeof(packed_notifs[0]),
-         MPI_BYTE, caller, ADLB_TAG_RESPONSE_NOTIF);
-    if (prepared->free_packed_notifs)
-    {
-      free(packed_notifs);
-    }
+    rc = send_prepared(packed_notifs,
+              (size_t)notify_count * sizeof(packed_notifs[0]),
+              prepared->free_packed_notifs, caller);
+    ADLB_CHECK(rc);
   }
   if (refs_count > 0)
   {
     TRACE("Sending %i refs", refs_count);
     struct packed_reference *packed_refs = prepared->packed_refs;
-    SEND(packed_refs, refs_count * (int)sizeof(packed_refs[0]), MPI_BYTE,
-         caller, ADLB_TAG_RESPONSE_NOTIF);
-    if (prepared->free_packed_refs)
-    {
-      free(packed_refs);
-    }
+    rc = send_prepared(packed_refs,
+              (size_t)refs_count * sizeof(packed_refs[0]),
+              prepared->free_packed_refs, caller);
+    ADLB_CHECK(rc);
   }
   if (refcs_count > 0)
   {
     TRACE("Sending %i rc changes", refcs_count);
     
-    SEND(notifs->refcs.arr, 
-         refcs_count * (int)sizeof(notifs->refcs.arr[0]), MPI_BYTE,
-         caller, ADLB_TAG_RESPONSE_NOTIF);
+    rc = xlb_sendq_copy(notifs->refcs.arr,
+              (size_t)refcs_count * sizeof(notifs->refcs.arr[0]),
+              caller, ADLB_TAG_RESPONSE_NOTIF);
+    ADLB_CHECK(rc);
   }
 
   TRACE("Done sending notifs");
@@ -1118,6 +1322,7 @@ xlb_recv_notif_work(const struct packed_notif_counts *counts,
       adlb_notif_rank *r;
       r = &notifs->notify.notifs[notifs->notify.count + i];
       r->rank = tmp[i].rank;
+      r->work_type = tmp[i].work_type;
       r->id = tmp[i].id;
       if (tmp[i].subscript_data == -1)
       {
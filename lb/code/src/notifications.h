@@ -30,6 +30,7 @@
 #include "adlb-defs.h"
 #include "checks.h"
 #include "messaging.h"
+#include "slab.h"
 
 #include <table_lp.h>
 
@@ -166,6 +167,19 @@ adlb_code xlb_refs_expand(adlb_ref_data *refs, int to_add);
 adlb_code xlb_refc_changes_expand(xlb_refc_changes *c, int to_add);
 adlb_code xlb_to_free_expand(adlb_notif_t *notifs, int to_add);
 
+/**
+  Read settings for sending notifications.
+
+  When one round of notifications has at least ADLB_NOTIFY_FANOUT
+  (default 16) listeners, e.g. when a datum with many subscribers is
+  closed, notifications for workers of each other server are sent to
+  that server in one ADLB_TAG_NOTIFY_BATCH message, which it delivers
+  locally.  ADLB_NOTIFY_FANOUT=0 sends one message per listener.
+ */
+adlb_code xlb_notifications_init(void);
+
+void xlb_print_notif_counters(void);
+
 /*
    When called from server, remove any notifications that can or must
    be handled locally.  Frees memory if all removed.
@@ -384,7 +398,11 @@ static inline adlb_code xlb_refc_changes_add(xlb_refc_changes *c,
 static inline void xlb_refc_changes_free(xlb_refc_changes *c)
 {
   if (c->arr != NULL) {
-    free(c->arr);
+    // Initial size arrays are allocated from slab
+    if (c->size == XLB_REFC_CHANGES_INIT_SIZE)
+      xlb_slab_free(&xlb_refc_changes_slab, c->arr);
+    else
+      free(c->arr);
 #if XLB_INDEX_REFC_CHANGES
     table_lp_free_callback(&c->index, false, NULL);
 #endif
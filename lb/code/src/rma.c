@@ -0,0 +1,449 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * rma.c
+ *
+ * Large payload transfer through an MPI-3 dynamic window.
+ */
+
+#include <assert.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdlib.h>
+
+#include <mpi.h>
+
+#include "checks.h"
+#include "common.h"
+#include "debug.h"
+#include "rma.h"
+
+#define RMA_THRESHOLD_DEFAULT (4*1024*1024)
+
+#define RMA_INIT_SLOTS 16
+
+/** A read started with xlb_rma_read_start() */
+typedef struct
+{
+  xlb_rma_callback cb;
+  void *ctx;
+} rma_read;
+
+/** Data lent with xlb_rma_lend() */
+typedef struct
+{
+  MPI_Aint addr;
+  void *data;
+} rma_loan;
+
+size_t xlb_rma_threshold = 0;
+
+int xlb_rma_pending = 0;
+
+/* Statistics */
+static int64_t reads_count = 0;
+static int64_t bytes_read = 0;
+static int64_t exposed_count = 0;
+static int64_t bytes_exposed = 0;
+static int max_pending = 0;
+
+#if ADLB_MPI_VERSION >= 3
+
+static MPI_Win win;
+
+/** Outstanding reads, and callback for each one */
+static MPI_Request *reqs = NULL;
+static rma_read *reads = NULL;
+/** Scratch arrays for MPI_Testsome */
+static int *done_ixs = NULL;
+static rma_read *done_reads = NULL;
+static int reads_size = 0;
+
+/** Data lent out and not yet returned */
+static rma_loan *loans = NULL;
+static int loans_count = 0;
+static int loans_size = 0;
+
+adlb_code
+xlb_rma_init(MPI_Comm comm)
+{
+  long threshold = RMA_THRESHOLD_DEFAULT;
+  adlb_code ac = xlb_env_long("ADLB_RMA_THRESHOLD", &threshold);
+  ADLB_CHECK(ac);
+  ADLB_CHECK_MSG(threshold >= 0, "ADLB_RMA_THRESHOLD must not be "
+                 "negative: %li", threshold);
+  xlb_rma_threshold = (size_t)threshold;
+  xlb_rma_pending = 0;
+  DEBUG("RMA threshold: %zu", xlb_rma_threshold);
+
+  if (xlb_rma_threshold == 0)
+  {
+    return ADLB_SUCCESS;
+  }
+
+  int rc = MPI_Win_create_dynamic(MPI_INFO_NULL, comm, &win);
+  MPI_CHECK(rc);
+  // Passive target for the whole run: no synchronization per read
+  rc = MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+  MPI_CHECK(rc);
+
+  reads_size = RMA_INIT_SLOTS;
+  reqs = malloc(sizeof(reqs[0]) * (size_t)reads_size);
+  reads = malloc(sizeof(reads[0]) * (size_t)reads_size);
+  done_ixs = malloc(sizeof(done_ixs[0]) * (size_t)reads_size);
+  done_reads = malloc(sizeof(done_reads[0]) * (size_t)reads_size);
+  ADLB_CHECK_MALLOC(reqs);
+  ADLB_CHECK_MALLOC(reads);
+  ADLB_CHECK_MALLOC(done_ixs);
+  ADLB_CHECK_MALLOC(done_reads);
+
+  loans_count = 0;
+  loans_size = 0;
+  loans = NULL;
+
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_rma_finalize(void)
+{
+  if (xlb_rma_threshold == 0)
+  {
+    return ADLB_SUCCESS;
+  }
+
+  adlb_code ac = xlb_rma_progress(true);
+  ADLB_CHECK(ac);
+
+  // Readers should have returned everything
+  for (int i = 0; i < loans_count; i++)
+  {
+    DEBUG("RMA: loan not returned: %p", loans[i].data);
+    MPI_Win_detach(win, loans[i].data);
+    free(loans[i].data);
+  }
+  free(loans);
+  loans = NULL;
+  loans_count = loans_size = 0;
+
+  free(reqs);
+  free(reads);
+  free(done_ixs);
+  free(done_reads);
+  reqs = NULL;
+  reads = NULL;
+  done_ixs = NULL;
+  done_reads = NULL;
+  reads_size = 0;
+
+  int rc = MPI_Win_unlock_all(win);
+  MPI_CHECK(rc);
+  rc = MPI_Win_free(&win);
+  MPI_CHECK(rc);
+
+  xlb_rma_threshold = 0;
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_rma_expose(const void *data, size_t length, MPI_Aint *addr)
+{
+  assert(xlb_rma_threshold > 0);
+  // Window does not modify data
+  int rc = MPI_Win_attach(win, (void*)data, (MPI_Aint)length);
+  MPI_CHECK(rc);
+  rc = MPI_Get_address(data, addr);
+  MPI_CHECK(rc);
+
+  exposed_count++;
+  bytes_exposed += (int64_t)length;
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_rma_unexpose(const void *data)
+{
+  int rc = MPI_Win_detach(win, data);
+  MPI_CHECK(rc);
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_rma_lend(void *data, size_t length, MPI_Aint *addr)
+{
+  adlb_code ac = xlb_rma_expose(data, length, addr);
+  ADLB_CHECK(ac);
+
+  if (loans_count == loans_size)
+  {
+    int new_size = loans_size == 0 ? RMA_INIT_SLOTS : loans_size * 2;
+    rma_loan *new_loans = realloc(loans, sizeof(loans[0]) *
+                                         (size_t)new_size);
+    ADLB_CHECK_MALLOC(new_loans);
+    loans = new_loans;
+    loans_size = new_size;
+  }
+  loans[loans_count].addr = *addr;
+  loans[loans_count].data = data;
+  loans_count++;
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_rma_return(MPI_Aint addr)
+{
+  for (int i = 0; i < loans_count; i++)
+  {
+    if (loans[i].addr == addr)
+    {
+      void *data = loans[i].data;
+      loans[i] = loans[--loans_count];
+
+      adlb_code ac = xlb_rma_unexpose(data);
+      ADLB_CHECK(ac);
+      free(data);
+      return ADLB_SUCCESS;
+    }
+  }
+  ADLB_CHECK_MSG(false, "RMA: returned address not lent: %p",
+                 (void*)addr);
+  return ADLB_ERROR;
+}
+
+adlb_code
+xlb_rma_read(void *buffer, size_t length, int rank, MPI_Aint addr)
+{
+  assert(xlb_rma_threshold > 0);
+  // Payloads are limited to ADLB_DATA_MAX
+  assert(length <= INT_MAX);
+  TRACE_MPI("RMA GET(from %i, %zu bytes)", rank, length);
+  int rc = MPI_Get(buffer, (int)length, MPI_BYTE, rank, addr,
+                   (int)length, MPI_BYTE, win);
+  MPI_CHECK(rc);
+  rc = MPI_Win_flush(rank, win);
+  MPI_CHECK(rc);
+
+  reads_count++;
+  bytes_read += (int64_t)length;
+  return ADLB_SUCCESS;
+}
+
+static adlb_code
+ensure_reads(void)
+{
+  if (xlb_rma_pending < reads_size)
+  {
+    return ADLB_SUCCESS;
+  }
+
+  int new_size = reads_size * 2;
+  MPI_Request *new_reqs = realloc(reqs, sizeof(reqs[0]) *
+                                        (size_t)new_size);
+  ADLB_CHECK_MALLOC(new_reqs);
+  reqs = new_reqs;
+  rma_read *new_reads = realloc(reads, sizeof(reads[0]) *
+                                       (size_t)new_size);
+  ADLB_CHECK_MALLOC(new_reads);
+  reads = new_reads;
+  int *new_ixs = realloc(done_ixs, sizeof(done_ixs[0]) *
+                                   (size_t)new_size);
+  ADLB_CHECK_MALLOC(new_ixs);
+  done_ixs = new_ixs;
+  rma_read *new_done = realloc(done_reads, sizeof(done_reads[0]) *
+                                           (size_t)new_size);
+  ADLB_CHECK_MALLOC(new_done);
+  done_reads = new_done;
+  reads_size = new_size;
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_rma_read_start(void *buffer, size_t length, int rank,
+              MPI_Aint addr, xlb_rma_callback cb, void *ctx)
+{
+  assert(xlb_rma_threshold > 0);
+  assert(length <= INT_MAX);
+  adlb_code ac = ensure_reads();
+  ADLB_CHECK(ac);
+
+  TRACE_MPI("RMA RGET(from %i, %zu bytes)", rank, length);
+  int rc = MPI_Rget(buffer, (int)length, MPI_BYTE, rank, addr,
+                    (int)length, MPI_BYTE, win, &reqs[xlb_rma_pending]);
+  MPI_CHECK(rc);
+  reads[xlb_rma_pending].cb = cb;
+  reads[xlb_rma_pending].ctx = ctx;
+  xlb_rma_pending++;
+
+  reads_count++;
+  bytes_read += (int64_t)length;
+  if (xlb_rma_pending > max_pending)
+    max_pending = xlb_rma_pending;
+  return ADLB_SUCCESS;
+}
+
+/**
+  Compact request array, then call callbacks of completed reads
+  ndone: number of completed requests in done_ixs
+ */
+static adlb_code
+complete(int ndone)
+{
+  for (int i = 0; i < ndone; i++)
+  {
+    done_reads[i] = reads[done_ixs[i]];
+  }
+
+  // Completed requests were set to MPI_REQUEST_NULL
+  int j = 0;
+  for (int i = 0; i < xlb_rma_pending; i++)
+  {
+    if (reqs[i] != MPI_REQUEST_NULL)
+    {
+      reqs[j] = reqs[i];
+      reads[j] = reads[i];
+      j++;
+    }
+  }
+  xlb_rma_pending = j;
+
+  // Request array is consistent in case callbacks start new reads
+  for (int i = 0; i < ndone; i++)
+  {
+    rma_read r = done_reads[i];
+    adlb_code ac = r.cb(r.ctx);
+    ADLB_CHECK(ac);
+  }
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_rma_progress(bool blocking)
+{
+  while (xlb_rma_pending > 0)
+  {
+    int ndone;
+    int rc;
+    if (blocking)
+    {
+      TRACE_MPI("WAITSOME");
+      rc = MPI_Waitsome(xlb_rma_pending, reqs, &ndone, done_ixs,
+                        MPI_STATUSES_IGNORE);
+    }
+    else
+    {
+      rc = MPI_Testsome(xlb_rma_pending, reqs, &ndone, done_ixs,
+                        MPI_STATUSES_IGNORE);
+    }
+    MPI_CHECK(rc);
+
+    if (ndone == MPI_UNDEFINED || ndone == 0)
+    {
+      break;
+    }
+    adlb_code ac = complete(ndone);
+    ADLB_CHECK(ac);
+
+    if (!blocking)
+    {
+      break;
+    }
+  }
+  return ADLB_SUCCESS;
+}
+
+#else // ADLB_MPI_VERSION < 3: no dynamic windows
+
+adlb_code
+xlb_rma_init(MPI_Comm comm)
+{
+  xlb_rma_threshold = 0;
+  xlb_rma_pending = 0;
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_rma_finalize(void)
+{
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_rma_expose(const void *data, size_t length, MPI_Aint *addr)
+{
+  ADLB_CHECK_MSG(false, "RMA requires MPI 3");
+  return ADLB_ERROR;
+}
+
+adlb_code
+xlb_rma_unexpose(const void *data)
+{
+  ADLB_CHECK_MSG(false, "RMA requires MPI 3");
+  return ADLB_ERROR;
+}
+
+adlb_code
+xlb_rma_lend(void *data, size_t length, MPI_Aint *addr)
+{
+  ADLB_CHECK_MSG(false, "RMA requires MPI 3");
+  return ADLB_ERROR;
+}
+
+adlb_code
+xlb_rma_return(MPI_Aint addr)
+{
+  ADLB_CHECK_MSG(false, "RMA requires MPI 3");
+  return ADLB_ERROR;
+}
+
+adlb_code
+xlb_rma_read(void *buffer, size_t length, int rank, MPI_Aint addr)
+{
+  ADLB_CHECK_MSG(false, "RMA requires MPI 3");
+  return ADLB_ERROR;
+}
+
+adlb_code
+xlb_rma_read_start(void *buffer, size_t length, int rank,
+              MPI_Aint addr, xlb_rma_callback cb, void *ctx)
+{
+  ADLB_CHECK_MSG(false, "RMA requires MPI 3");
+  return ADLB_ERROR;
+}
+
+adlb_code
+xlb_rma_progress(bool blocking)
+{
+  return ADLB_SUCCESS;
+}
+
+#endif
+
+void
+xlb_print_rma_counters(void)
+{
+  if (!xlb_s.perfc_enabled)
+  {
+    return;
+  }
+
+  PRINT_COUNTER("rma_threshold=%zu", xlb_rma_threshold);
+  PRINT_COUNTER("rma_reads=%"PRId64, reads_count);
+  PRINT_COUNTER("rma_bytes_read=%"PRId64, bytes_read);
+  PRINT_COUNTER("rma_exposed=%"PRId64, exposed_count);
+  PRINT_COUNTER("rma_bytes_exposed=%"PRId64, bytes_exposed);
+  PRINT_COUNTER("rma_max_pending=%i", max_pending);
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * rma.h
+ *
+ * Transfer of large data payloads through an MPI-3 dynamic window.
+ *
+ * Store and retrieve payloads of at least ADLB_RMA_THRESHOLD bytes
+ * (default 4MB) are not sent as messages.  The side that holds the
+ * payload attaches it to the window and sends its address; the other
+ * side reads it with MPI_Rget directly into its final buffer.
+ *
+ * For stores, the worker exposes its buffer and the server reads it
+ * into new datum storage.  The store completes from the server loop,
+ * so the server handles other requests while the payload is in
+ * flight.  For retrieves, the server lends the value to the worker,
+ * which reads it into the caller's buffer, then returns it with
+ * ADLB_TAG_RMA_DONE.
+ *
+ * All ranks hold a shared lock on the window from init to finalize.
+ * ADLB_RMA_THRESHOLD=0 disables the window; the setting must be the
+ * same on all ranks.
+ */
+
+#ifndef XLB_RMA_H
+#define XLB_RMA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <mpi.h>
+
+#include "adlb-defs.h"
+
+/** Smallest payload sent through window, or 0 if disabled */
+extern size_t xlb_rma_threshold;
+
+/** Number of reads in flight */
+extern int xlb_rma_pending;
+
+/**
+  Collective over comm: create window
+ */
+adlb_code xlb_rma_init(MPI_Comm comm);
+
+/**
+  Collective: complete reads, release loans and free window
+ */
+adlb_code xlb_rma_finalize(void);
+
+/**
+  return true if payload of length bytes goes through window
+ */
+static inline bool
+xlb_rma_use(size_t length)
+{
+  return xlb_rma_threshold > 0 && length >= xlb_rma_threshold;
+}
+
+/**
+  Make data readable by other ranks until xlb_rma_unexpose()
+  addr: set to address to send to reader
+ */
+adlb_code xlb_rma_expose(const void *data, size_t length,
+                         MPI_Aint *addr);
+
+adlb_code xlb_rma_unexpose(const void *data);
+
+/**
+  Expose malloc'ed data, taking ownership of it.  The data is freed
+  when the reader returns it with xlb_rma_return().
+ */
+adlb_code xlb_rma_lend(void *data, size_t length, MPI_Aint *addr);
+
+adlb_code xlb_rma_return(MPI_Aint addr);
+
+/**
+  Read length bytes exposed at addr on rank into buffer, waiting until
+  complete
+ */
+adlb_code xlb_rma_read(void *buffer, size_t length,
+                       int rank, MPI_Aint addr);
+
+/**
+  Called from xlb_rma_progress() once a read is complete
+ */
+typedef adlb_code (*xlb_rma_callback)(void *ctx);
+
+/**
+  Start reading length bytes exposed at addr on rank into buffer.
+  cb is called with ctx once the data is in buffer.
+ */
+adlb_code xlb_rma_read_start(void *buffer, size_t length,
+            int rank, MPI_Aint addr, xlb_rma_callback cb, void *ctx);
+
+/**
+  Call callbacks of completed reads
+  blocking: if true, wait until all reads are complete
+ */
+adlb_code xlb_rma_progress(bool blocking);
+
+/**
+  Check for completed reads.  Cheap if nothing is in flight.
+ */
+static inline adlb_code
+xlb_rma_poll(void)
+{
+  if (xlb_rma_pending == 0)
+  {
+    return ADLB_SUCCESS;
+  }
+  return xlb_rma_progress(false);
+}
+
+void xlb_print_rma_counters(void);
+
+#endif // XLB_RMA_H
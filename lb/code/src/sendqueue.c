@@ -0,0 +1,498 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * sendqueue.c
+ *
+ * Server outbound message queue built on MPI_Isend.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include <mpi.h>
+
+#include <tools.h>
+
+#include "checks.h"
+#include "common.h"
+#include "debug.h"
+#include "messaging.h"
+#include "sendqueue.h"
+
+/** Chunk size for large messages: must match mpi_send_big() */
+#define SENDQ_CHUNK (100*1024*1024)
+
+#define SENDQ_MAX_BYTES_DEFAULT (256*1024*1024)
+
+/** Smallest pooled buffer is 1 << SENDQ_POOL_MIN_SHIFT bytes */
+#define SENDQ_POOL_MIN_SHIFT 7
+/** Largest pooled buffer is 64KB */
+#define SENDQ_POOL_CLASSES 10
+/** Max free buffers kept per class */
+#define SENDQ_POOL_MAX_FREE 64
+#define SENDQ_POOL_NONE -1
+
+#define SENDQ_INIT_REQS 64
+
+typedef enum
+{
+  /** Copy of data follows header in same allocation */
+  SENDQ_COPY,
+  /** Data is separate malloc'ed buffer */
+  SENDQ_OWNED,
+  /** Data is a work unit */
+  SENDQ_WORK_UNIT,
+} sendq_kind;
+
+/** A message being sent, possibly in several chunks */
+typedef struct
+{
+  sendq_kind kind;
+  /** Pool class of this allocation, or SENDQ_POOL_NONE */
+  int pool_class;
+  /** Chunk sends not yet complete */
+  int pending;
+  size_t length;
+  /** Owned buffer or work unit, NULL for copies */
+  void *data;
+} sendq_msg;
+
+/** Header size, keeping copied data aligned */
+#define SENDQ_HDR_SIZE ((sizeof(sendq_msg) + 15) & ~(size_t)15)
+
+typedef struct
+{
+  /** Free buffers, linked through first word */
+  void *free_list;
+  int free_count;
+} sendq_pool_class;
+
+int xlb_sendq_depth = 0;
+
+static bool enabled = false;
+static size_t max_bytes = SENDQ_MAX_BYTES_DEFAULT;
+
+/** Outstanding requests, and message each one belongs to */
+static MPI_Request *reqs = NULL;
+static sendq_msg **req_msgs = NULL;
+/** Scratch array for MPI_Testsome */
+static int *done_ixs = NULL;
+static int reqs_size = 0;
+
+static size_t bytes_in_flight = 0;
+
+static sendq_pool_class pool[SENDQ_POOL_CLASSES];
+
+/* Statistics */
+static int64_t msgs_sent = 0;
+static int64_t bytes_sent = 0;
+static int max_depth = 0;
+static size_t max_bytes_in_flight = 0;
+static int64_t pool_allocs = 0;
+static int64_t pool_reused = 0;
+static int64_t flow_waits = 0;
+
+static adlb_code wait_some(void);
+
+adlb_code
+xlb_sendq_init(void)
+{
+  getenv_boolean("ADLB_SEND_QUEUE", true, &enabled);
+
+  long max = SENDQ_MAX_BYTES_DEFAULT;
+  adlb_code ac = xlb_env_long("ADLB_SEND_QUEUE_MAX_BYTES", &max);
+  ADLB_CHECK(ac);
+  ADLB_CHECK_MSG(max > 0, "ADLB_SEND_QUEUE_MAX_BYTES must be positive: "
+                 "%li", max);
+  max_bytes = (size_t)max;
+
+  xlb_sendq_depth = 0;
+  bytes_in_flight = 0;
+  memset(pool, 0, sizeof(pool));
+
+  if (enabled)
+  {
+    reqs_size = SENDQ_INIT_REQS;
+    reqs = malloc(sizeof(reqs[0]) * (size_t)reqs_size);
+    req_msgs = malloc(sizeof(req_msgs[0]) * (size_t)reqs_size);
+    done_ixs = malloc(sizeof(done_ixs[0]) * (size_t)reqs_size);
+    ADLB_CHECK_MALLOC(reqs);
+    ADLB_CHECK_MALLOC(req_msgs);
+    ADLB_CHECK_MALLOC(done_ixs);
+  }
+
+  DEBUG("Send queue: %s max bytes: %zu",
+        enabled ? "enabled" : "disabled", max_bytes);
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_sendq_finalize(void)
+{
+  adlb_code rc = xlb_sendq_progress(true);
+  ADLB_CHECK(rc);
+  assert(xlb_sendq_depth == 0);
+
+  free(reqs);
+  free(req_msgs);
+  free(done_ixs);
+  reqs = NULL;
+  req_msgs = NULL;
+  done_ixs = NULL;
+  reqs_size = 0;
+
+  for (int c = 0; c < SENDQ_POOL_CLASSES; c++)
+  {
+    void *buf = pool[c].free_list;
+    while (buf != NULL)
+    {
+      void *next = *(void**)buf;
+      free(buf);
+      buf = next;
+    }
+    pool[c].free_list = NULL;
+    pool[c].free_count = 0;
+  }
+  return ADLB_SUCCESS;
+}
+
+static inline int
+pool_class_of(size_t size)
+{
+  size_t class_size = (size_t)1 << SENDQ_POOL_MIN_SHIFT;
+  for (int c = 0; c < SENDQ_POOL_CLASSES; c++)
+  {
+    if (size <= class_size)
+      return c;
+    class_size <<= 1;
+  }
+  return SENDQ_POOL_NONE;
+}
+
+/**
+  Allocate message header with room for length bytes of data after it
+ */
+static sendq_msg *
+msg_alloc(size_t length)
+{
+  size_t size = SENDQ_HDR_SIZE + length;
+  int c = pool_class_of(size);
+  sendq_msg *m;
+  if (c == SENDQ_POOL_NONE)
+  {
+    m = malloc(size);
+  }
+  else
+  {
+    pool_allocs++;
+    if (pool[c].free_list != NULL)
+    {
+      m = pool[c].free_list;
+      pool[c].free_list = *(void**)m;
+      pool[c].free_count--;
+      pool_reused++;
+    }
+    else
+    {
+      m = malloc((size_t)1 << (SENDQ_POOL_MIN_SHIFT + c));
+    }
+  }
+
+  if (m != NULL)
+  {
+    m->pool_class = c;
+    m->length = length;
+    m->data = NULL;
+  }
+  return m;
+}
+
+static inline void *
+msg_data(sendq_msg *m)
+{
+  switch (m->kind)
+  {
+    case SENDQ_COPY:
+      return (char*)m + SENDQ_HDR_SIZE;
+    case SENDQ_WORK_UNIT:
+      return ((xlb_work_unit*)m->data)->payload;
+    default:
+      return m->data;
+  }
+}
+
+static void
+msg_release(sendq_msg *m)
+{
+  if (m->kind == SENDQ_OWNED)
+  {
+    free(m->data);
+  }
+  else if (m->kind == SENDQ_WORK_UNIT)
+  {
+    xlb_work_unit_free(m->data);
+  }
+
+  int c = m->pool_class;
+  if (c == SENDQ_POOL_NONE || pool[c].free_count >= SENDQ_POOL_MAX_FREE)
+  {
+    free(m);
+  }
+  else
+  {
+    *(void**)m = pool[c].free_list;
+    pool[c].free_list = m;
+    pool[c].free_count++;
+  }
+}
+
+/**
+  Send message in the same chunks as mpi_send_big(), then release
+  it.  Used if queue is disabled.
+ */
+static adlb_code
+send_now(sendq_msg *m, int rank, int tag)
+{
+  size_t length = m->length;
+  adlb_code rc = mpi_send_big(msg_data(m), length, rank, tag);
+  msg_release(m);
+  ADLB_CHECK(rc);
+
+  msgs_sent++;
+  bytes_sent += (int64_t)length;
+  return ADLB_SUCCESS;
+}
+
+static adlb_code
+ensure_reqs(int n)
+{
+  if (xlb_sendq_depth + n <= reqs_size)
+  {
+    return ADLB_SUCCESS;
+  }
+
+  int new_size = reqs_size * 2;
+  while (new_size < xlb_sendq_depth + n)
+    new_size *= 2;
+
+  MPI_Request *new_reqs = realloc(reqs, sizeof(reqs[0]) *
+                                        (size_t)new_size);
+  ADLB_CHECK_MALLOC(new_reqs);
+  reqs = new_reqs;
+  sendq_msg **new_msgs = realloc(req_msgs, sizeof(req_msgs[0]) *
+                                           (size_t)new_size);
+  ADLB_CHECK_MALLOC(new_msgs);
+  req_msgs = new_msgs;
+  int *new_ixs = realloc(done_ixs, sizeof(done_ixs[0]) *
+                                   (size_t)new_size);
+  ADLB_CHECK_MALLOC(new_ixs);
+  done_ixs = new_ixs;
+
+  reqs_size = new_size;
+  return ADLB_SUCCESS;
+}
+
+/**
+  Start sends for message.  Takes ownership of m.
+ */
+static adlb_code
+enqueue(sendq_msg *m, int rank, int tag)
+{
+  adlb_code rc;
+  if (!enabled)
+  {
+    return send_now(m, rank, tag);
+  }
+
+  // Same chunking as mpi_send_big(): full chunks then remainder
+  size_t chunks_full = m->length / SENDQ_CHUNK;
+  int nreqs = (int)chunks_full + 1;
+  rc = ensure_reqs(nreqs);
+  ADLB_CHECK(rc);
+
+  TRACE("sendq: %zu bytes to %i tag %s", m->length, rank,
+        xlb_get_tag_name(tag));
+
+  const char *p = msg_data(m);
+  for (int i = 0; i < nreqs; i++)
+  {
+    int chunk_len = (i < (int)chunks_full) ?
+                    SENDQ_CHUNK : (int)(m->length % SENDQ_CHUNK);
+    int ix = xlb_sendq_depth;
+    ISEND(p, chunk_len, MPI_BYTE, rank, tag, &reqs[ix]);
+    req_msgs[ix] = m;
+    xlb_sendq_depth++;
+    p += chunk_len;
+  }
+  m->pending = nreqs;
+
+  msgs_sent++;
+  bytes_sent += (int64_t)m->length;
+  bytes_in_flight += m->length;
+  if (xlb_sendq_depth > max_depth)
+    max_depth = xlb_sendq_depth;
+  if (bytes_in_flight > max_bytes_in_flight)
+    max_bytes_in_flight = bytes_in_flight;
+
+  // Bound memory held by in-flight messages
+  while (bytes_in_flight > max_bytes && xlb_sendq_depth > 0)
+  {
+    flow_waits++;
+    rc = wait_some();
+    ADLB_CHECK(rc);
+  }
+
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_sendq_copy(const void *data, size_t length, int rank, int tag)
+{
+  if (!enabled)
+  {
+    // Avoid copy
+    adlb_code rc = mpi_send_big(data, length, rank, tag);
+    ADLB_CHECK(rc);
+    msgs_sent++;
+    bytes_sent += (int64_t)length;
+    return ADLB_SUCCESS;
+  }
+
+  sendq_msg *m = msg_alloc(length);
+  ADLB_CHECK_MALLOC(m);
+  m->kind = SENDQ_COPY;
+  memcpy(msg_data(m), data, length);
+  return enqueue(m, rank, tag);
+}
+
+adlb_code
+xlb_sendq_owned(void *data, size_t length, int rank, int tag)
+{
+  sendq_msg *m = msg_alloc(0);
+  ADLB_CHECK_MALLOC(m);
+  m->kind = SENDQ_OWNED;
+  m->length = length;
+  m->data = data;
+  return enqueue(m, rank, tag);
+}
+
+adlb_code
+xlb_sendq_work_unit(xlb_work_unit *wu, int rank, int tag)
+{
+  sendq_msg *m = msg_alloc(0);
+  ADLB_CHECK_MALLOC(m);
+  m->kind = SENDQ_WORK_UNIT;
+  m->length = (size_t)wu->length;
+  m->data = wu;
+  return enqueue(m, rank, tag);
+}
+
+/**
+  Release messages for completed requests and compact request array
+  ndone: number of completed requests in done_ixs
+ */
+static void
+complete(int ndone)
+{
+  for (int i = 0; i < ndone; i++)
+  {
+    sendq_msg *m = req_msgs[done_ixs[i]];
+    m->pending--;
+    if (m->pending == 0)
+    {
+      bytes_in_flight -= m->length;
+      msg_release(m);
+    }
+  }
+
+  // Completed requests were set to MPI_REQUEST_NULL
+  int j = 0;
+  for (int i = 0; i < xlb_sendq_depth; i++)
+  {
+    if (reqs[i] != MPI_REQUEST_NULL)
+    {
+      reqs[j] = reqs[i];
+      req_msgs[j] = req_msgs[i];
+      j++;
+    }
+  }
+  xlb_sendq_depth = j;
+}
+
+/**
+  Wait until at least one send completes
+ */
+static adlb_code
+wait_some(void)
+{
+  int ndone;
+  TRACE_MPI("WAITSOME");
+  int rc = MPI_Waitsome(xlb_sendq_depth, reqs, &ndone, done_ixs,
+                        MPI_STATUSES_IGNORE);
+  MPI_CHECK(rc);
+  if (ndone != MPI_UNDEFINED)
+  {
+    complete(ndone);
+  }
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_sendq_progress(bool blocking)
+{
+  while (xlb_sendq_depth > 0)
+  {
+    if (blocking)
+    {
+      adlb_code rc = wait_some();
+      ADLB_CHECK(rc);
+    }
+    else
+    {
+      int ndone;
+      int rc = MPI_Testsome(xlb_sendq_depth, reqs, &ndone, done_ixs,
+                            MPI_STATUSES_IGNORE);
+      MPI_CHECK(rc);
+      if (ndone != MPI_UNDEFINED && ndone > 0)
+      {
+        complete(ndone);
+      }
+      break;
+    }
+  }
+  return ADLB_SUCCESS;
+}
+
+void
+xlb_print_sendq_counters(void)
+{
+  if (!xlb_s.perfc_enabled)
+  {
+    return;
+  }
+
+  PRINT_COUNTER("sendq_enabled=%i", (int)enabled);
+  PRINT_COUNTER("sendq_msgs=%"PRId64, msgs_sent);
+  PRINT_COUNTER("sendq_bytes=%"PRId64, bytes_sent);
+  PRINT_COUNTER("sendq_depth=%i", xlb_sendq_depth);
+  PRINT_COUNTER("sendq_max_depth=%i", max_depth);
+  PRINT_COUNTER("sendq_bytes_in_flight=%zu", bytes_in_flight);
+  PRINT_COUNTER("sendq_max_bytes_in_flight=%zu", max_bytes_in_flight);
+  PRINT_COUNTER("sendq_pool_allocs=%"PRId64, pool_allocs);
+  PRINT_COUNTER("sendq_pool_reused=%"PRId64, pool_reused);
+  PRINT_COUNTER("sendq_flow_waits=%"PRId64, flow_waits);
+}
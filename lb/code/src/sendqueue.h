@@ -0,0 +1,91 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * sendqueue.h
+ *
+ * Server outbound message queue.
+ *
+ * Messages from the server to a rank that is already waiting for them
+ * (work units, notifications) are started with MPI_Isend and completed
+ * later from the server loop, so a large payload or a slow receiver
+ * does not stall the handling of other requests.  MPI message ordering
+ * still holds between queued and blocking sends to the same rank.
+ *
+ * Copies of small messages are made into pooled buffers that are
+ * recycled when the send completes.
+ *
+ * ADLB_SEND_QUEUE=0 disables the queue: messages are sent with
+ * blocking sends.  ADLB_SEND_QUEUE_MAX_BYTES bounds the bytes in
+ * flight; when exceeded, the server waits for sends to complete.
+ */
+
+#ifndef XLB_SENDQUEUE_H
+#define XLB_SENDQUEUE_H
+
+#include <stddef.h>
+
+#include "adlb-defs.h"
+#include "workqueue.h"
+
+/** Number of sends in flight */
+extern int xlb_sendq_depth;
+
+adlb_code xlb_sendq_init(void);
+
+/**
+  Wait for all queued sends to complete and release memory
+ */
+adlb_code xlb_sendq_finalize(void);
+
+/**
+  Queue a copy of data for sending
+ */
+adlb_code xlb_sendq_copy(const void *data, size_t length,
+                         int rank, int tag);
+
+/**
+  Queue malloc'ed data for sending, taking ownership of it
+ */
+adlb_code xlb_sendq_owned(void *data, size_t length, int rank, int tag);
+
+/**
+  Queue payload of work unit for sending, taking ownership of it
+ */
+adlb_code xlb_sendq_work_unit(xlb_work_unit *wu, int rank, int tag);
+
+/**
+  Release buffers of completed sends
+  blocking: if true, wait until all sends are complete
+ */
+adlb_code xlb_sendq_progress(bool blocking);
+
+/**
+  Check for completed sends.  Cheap if nothing is queued.
+ */
+static inline adlb_code
+xlb_sendq_poll(void)
+{
+  if (xlb_sendq_depth == 0)
+  {
+    return ADLB_SUCCESS;
+  }
+  return xlb_sendq_progress(false);
+}
+
+void xlb_print_sendq_counters(void);
+
+#endif // XLB_SENDQUEUE_H
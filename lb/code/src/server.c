@@ -34,15 +34,20 @@
 #include "adlb-mpe.h"
 #include "backoffs.h"
 #include "checks.h"
+#include "closed_summary.h"
 #include "common.h"
 #include "data.h"
 #include "debug.h"
 #include "handlers.h"
 #include "messaging.h"
 #include "mpe-tools.h"
+#include "notifications.h"
 #include "refcount.h"
 #include "requestqueue.h"
+#include "rma.h"
+#include "sendqueue.h"
 #include "server.h"
+#include "slab.h"
 #include "steal.h"
 #include "sync.h"
 #include "engine.h"
@@ -161,7 +166,14 @@ xlb_server_init(const struct xlb_state *state)
   ADLB_CHECK(code);
   code = xlb_requestqueue_init(state->types_size, &state->layout);
   ADLB_CHECK(code);
+  code = xlb_slabs_init();
+  ADLB_CHECK(code);
+  code = xlb_sendq_init();
+  ADLB_CHECK(code);
   xlb_data_init(state->layout.servers, xlb_server_number(state->layout.rank));
+  code = xlb_closed_summary_init(state->layout.servers,
+                        xlb_server_number(state->layout.rank));
+  ADLB_CHECK(code);
   code = setup_idle_time();
   ADLB_CHECK(code);
   code = setup_load_min();
@@ -236,6 +248,9 @@ ADLB_Server(long max_memory)
 
     update_cached_time(); // Periodically refresh timestamp
 
+    code = xlb_closed_summary_gossip();
+    ADLB_CHECK(code);
+
     check_steal();
   }
 
@@ -270,6 +285,14 @@ serve_several()
     adlb_code code;
     bool handled = false;
 
+    // Release buffers of completed sends to workers
+    code = xlb_sendq_poll();
+    ADLB_CHECK(code);
+
+    // Finish stores whose payloads have arrived
+    code = xlb_rma_poll();
+    ADLB_CHECK(code);
+
     // Prioritize server-to-server syncs to avoid blocking other servers
     if (other_servers)
     {
@@ -847,10 +870,14 @@ static adlb_code
 server_shutdown()
 {
   DEBUG("server down.");
+  // Stores may still send responses
+  xlb_rma_progress(true);
+  xlb_sendq_finalize();
   xlb_requestqueue_shutdown();
   xlb_workq_finalize();
   xlb_steal_finalize();
   xlb_sync_finalize();
+  xlb_closed_summary_finalize();
 
   xlb_engine_finalize();
 
@@ -879,4 +906,10 @@ static inline void print_final_stats()
   xlb_print_workq_perf_counters();
   xlb_print_sync_counters();
   xlb_engine_print_counters();
+  xlb_print_slab_counters();
+  xlb_print_sendq_counters();
+  xlb_print_rma_counters();
+  xlb_print_steal_counters();
+  xlb_print_closed_summary_counters();
+  xlb_print_notif_counters();
 }
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * slab.c
+ *
+ * Slab allocator for small fixed-size server objects.
+ */
+
+#include <tools.h>
+#include <rbtree_bp.h>
+
+#include "checks.h"
+#include "common.h"
+#include "data_internal.h"
+#include "debug.h"
+#include "notifications.h"
+#include "slab.h"
+
+/** Align objects to this many bytes */
+#define XLB_SLAB_ALIGN 16
+
+struct xlb_slab_block
+{
+  xlb_slab_block *next;
+  // Padding to keep objects aligned
+  char pad[XLB_SLAB_ALIGN - sizeof(xlb_slab_block*)];
+};
+
+xlb_slab xlb_datum_slab =
+    XLB_SLAB_INITIALIZER("datum", adlb_datum, 4096);
+
+xlb_slab xlb_listener_slab =
+    XLB_SLAB_INITIALIZER("listener", xlb_listener, 4096);
+
+xlb_slab xlb_listener_node_slab =
+    XLB_SLAB_INITIALIZER("listener_node", struct rbtree_bp_node, 4096);
+
+xlb_slab xlb_refc_changes_slab =
+    XLB_SLAB_INITIALIZER("refc_changes",
+          xlb_refc_change[XLB_REFC_CHANGES_INIT_SIZE], 256);
+
+static xlb_slab *all_slabs[] = {
+  &xlb_datum_slab,
+  &xlb_listener_slab,
+  &xlb_listener_node_slab,
+  &xlb_refc_changes_slab,
+};
+
+#define NUM_SLABS (sizeof(all_slabs) / sizeof(all_slabs[0]))
+
+static inline size_t
+slab_stride(const xlb_slab *slab)
+{
+  size_t size = slab->obj_size;
+  if (size < sizeof(void*))
+    size = sizeof(void*);
+  return (size + XLB_SLAB_ALIGN - 1) / XLB_SLAB_ALIGN * XLB_SLAB_ALIGN;
+}
+
+adlb_code
+xlb_slabs_init(void)
+{
+  bool enabled;
+  getenv_boolean("ADLB_SLAB_ALLOC", true, &enabled);
+
+  DEBUG("Slab allocation: %s", enabled ? "enabled" : "disabled");
+
+  for (size_t i = 0; i < NUM_SLABS; i++)
+  {
+    xlb_slab *slab = all_slabs[i];
+    // Objects left over from an earlier run must go back where
+    // they came from
+    if (slab->in_use == 0)
+      slab->enabled = enabled;
+  }
+
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_slab_expand(xlb_slab *slab)
+{
+  assert(slab->enabled);
+  size_t stride = slab_stride(slab);
+  xlb_slab_block *block = malloc(sizeof(xlb_slab_block) +
+                                 stride * (size_t)slab->objs_per_block);
+  ADLB_CHECK_MALLOC(block);
+
+  block->next = slab->blocks;
+  slab->blocks = block;
+  slab->blocks_allocated++;
+
+  // Thread objects onto free list in address order
+  char *objs = (char*)(block + 1);
+  for (int i = slab->objs_per_block - 1; i >= 0; i--)
+  {
+    void *obj = objs + stride * (size_t)i;
+    *(void**)obj = slab->free_list;
+    slab->free_list = obj;
+  }
+
+  return ADLB_SUCCESS;
+}
+
+void
+xlb_slabs_finalize(void)
+{
+  for (size_t i = 0; i < NUM_SLABS; i++)
+  {
+    xlb_slab *slab = all_slabs[i];
+    if (slab->enabled && slab->in_use != 0)
+    {
+      // Objects may still be freed later, onto the free list: keep
+      // blocks until exit rather than free() objects inside them
+      DEBUG("Slab %s: %"PRId64" objects still in use at finalize",
+            slab->name, slab->in_use);
+      continue;
+    }
+
+    xlb_slab_block *block = slab->blocks;
+    while (block != NULL)
+    {
+      xlb_slab_block *next = block->next;
+      free(block);
+      block = next;
+    }
+    slab->blocks = NULL;
+    slab->free_list = NULL;
+    slab->enabled = false;
+  }
+}
+
+void
+xlb_print_slab_counters(void)
+{
+  if (!xlb_s.perfc_enabled)
+  {
+    return;
+  }
+
+  for (size_t i = 0; i < NUM_SLABS; i++)
+  {
+    xlb_slab *slab = all_slabs[i];
+    int64_t capacity = slab->blocks_allocated * slab->objs_per_block;
+
+    PRINT_COUNTER("slab_%s_enabled=%i", slab->name,
+                  (int)slab->enabled);
+    PRINT_COUNTER("slab_%s_allocs=%"PRId64, slab->name, slab->allocs);
+    PRINT_COUNTER("slab_%s_in_use=%"PRId64, slab->name, slab->in_use);
+    PRINT_COUNTER("slab_%s_in_use_hwm=%"PRId64, slab->name,
+                  slab->in_use_hwm);
+    PRINT_COUNTER("slab_%s_blocks=%"PRId64, slab->name,
+                  slab->blocks_allocated);
+    PRINT_COUNTER("slab_%s_bytes=%"PRId64, slab->name,
+                  slab->blocks_allocated * (int64_t)(sizeof(xlb_slab_block)
+                  + slab_stride(slab) * (size_t)slab->objs_per_block));
+    PRINT_COUNTER("slab_%s_occupancy=%.3f", slab->name,
+                  capacity == 0 ? 0.0 :
+                  (double)slab->in_use / (double)capacity);
+    PRINT_COUNTER("slab_%s_peak_occupancy=%.3f", slab->name,
+                  capacity == 0 ? 0.0 :
+                  (double)slab->in_use_hwm / (double)capacity);
+  }
+}
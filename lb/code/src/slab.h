@@ -0,0 +1,160 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * slab.h
+ *
+ * Slab allocator for small fixed-size server objects.
+ *
+ * Objects are carved out of large blocks and recycled through an
+ * intrusive free list, avoiding a malloc/free per datum or listener
+ * and keeping these objects packed together in memory.  Blocks are
+ * only returned to the system at finalize.
+ *
+ * Slabs fall back to plain malloc/free until xlb_slabs_init() is
+ * called, which only happens on servers, or if ADLB_SLAB_ALLOC=0.
+ */
+
+#ifndef XLB_SLAB_H
+#define XLB_SLAB_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "adlb-defs.h"
+
+typedef struct xlb_slab_block xlb_slab_block;
+
+typedef struct
+{
+  const char *name;
+  size_t obj_size; // Size of objects in bytes
+  int objs_per_block;
+
+  /** If false, just use malloc/free */
+  bool enabled;
+
+  /** Free objects, linked through their first word */
+  void *free_list;
+
+  /** All blocks allocated, for cleanup */
+  xlb_slab_block *blocks;
+
+  /* Statistics */
+  int64_t blocks_allocated;
+  int64_t in_use; // Currently allocated objects
+  int64_t in_use_hwm; // High water mark of in_use
+  int64_t allocs; // Total allocations
+} xlb_slab;
+
+/** Static initializer for a disabled slab of given type */
+#define XLB_SLAB_INITIALIZER(slab_name, type, per_block) \
+  { .name = slab_name, .obj_size = sizeof(type), \
+    .objs_per_block = per_block, .enabled = false, \
+    .free_list = NULL, .blocks = NULL, .blocks_allocated = 0, \
+    .in_use = 0, .in_use_hwm = 0, .allocs = 0 }
+
+/*
+ * Per-server slabs for frequently allocated objects
+ */
+
+/** adlb_datum headers */
+extern xlb_slab xlb_datum_slab;
+
+/** xlb_listener records */
+extern xlb_slab xlb_listener_slab;
+
+/** Nodes for rbtree_bp of listeners */
+extern xlb_slab xlb_listener_node_slab;
+
+/** Initial arrays of refcount change records */
+extern xlb_slab xlb_refc_changes_slab;
+
+/**
+  Enable slabs on this process, unless disabled by ADLB_SLAB_ALLOC
+ */
+adlb_code xlb_slabs_init(void);
+
+/**
+  Release memory held by slabs and fall back to malloc/free.
+  A slab with objects still in use keeps its blocks and stays enabled,
+  so that those objects can still be freed.
+ */
+void xlb_slabs_finalize(void);
+
+/**
+  Print slab occupancy stats if performance counters enabled
+ */
+void xlb_print_slab_counters(void);
+
+/**
+  Allocate new block and add its objects to free list
+ */
+adlb_code xlb_slab_expand(xlb_slab *slab);
+
+static inline void *
+xlb_slab_alloc(xlb_slab *slab)
+{
+  void *obj;
+  if (!slab->enabled)
+  {
+    obj = malloc(slab->obj_size);
+  }
+  else
+  {
+    if (slab->free_list == NULL)
+    {
+      adlb_code ac = xlb_slab_expand(slab);
+      if (ac != ADLB_SUCCESS)
+        return NULL;
+    }
+    obj = slab->free_list;
+    slab->free_list = *(void**)obj;
+  }
+
+  if (obj != NULL)
+  {
+    slab->allocs++;
+    slab->in_use++;
+    if (slab->in_use > slab->in_use_hwm)
+      slab->in_use_hwm = slab->in_use;
+  }
+  return obj;
+}
+
+static inline void
+xlb_slab_free(xlb_slab *slab, void *obj)
+{
+  if (obj == NULL)
+    return;
+
+  assert(slab->in_use > 0);
+  slab->in_use--;
+  if (!slab->enabled)
+  {
+    free(obj);
+  }
+  else
+  {
+    *(void**)obj = slab->free_list;
+    slab->free_list = obj;
+  }
+}
+
+#endif // XLB_SLAB_H
@@ -22,6 +22,9 @@
  *      Authors: wozniak, armstrong
  */
 
+#include <stdint.h>
+#include <string.h>
+
 #include <mpi.h>
 
 #include <table_ip.h>
@@ -31,6 +34,7 @@
 #include "common.h"
 #include "debug.h"
 #include "handlers.h"
+#include "location.h"
 #include "messaging.h"
 #include "mpe-tools.h"
 #include "requestqueue.h"
@@ -40,28 +44,228 @@
 
 double xlb_steal_last = 0.0;
 int xlb_failed_steals_since_backoff = 0;
+int xlb_steal_host_early = 0;
+bool xlb_steal_host_only = false;
+
+xlb_steal_sizing xlb_steal_sizing_policy = XLB_STEAL_SIZING_FRACTION;
+
+/** Weight of newest sample in task runtime estimates */
+#define TASK_RUNTIME_ALPHA 0.25
+
+/** Most tasks to take per idle worker with adaptive sizing */
+#define STEAL_MAX_PER_WORKER 64
+
+/** Seconds of work to take per idle worker with adaptive sizing */
+static double steal_horizon = 0.1;
+
+/** Estimated runtime per work type: negative if unknown */
+static double *task_runtime = NULL;
+
+/** Time last task was sent to each of my workers, negative if none.
+    Indexed by xlb_my_worker_idx() */
+static double *task_start = NULL;
+static int *task_type = NULL;
+
+/* Statistics */
+static int64_t units_wanted = 0;
+static int64_t units_stolen = 0;
 
 /*
   Table to track ranks that we have sent steal probes to but not
-  received a response from.
+  received a response from.  Value is the steal_tier that chose the
+  victim, plus one so that it is not NULL.
  */
 static struct table_ip sent_steal_probes;
 
+/**
+   How a steal victim was chosen
+ */
+typedef enum
+{
+  STEAL_TIER_LAST,   // Server we last stole from successfully
+  STEAL_TIER_HOST,   // Server on the same host
+  STEAL_TIER_NEARBY, // Server with nearby rank
+  STEAL_TIER_RANDOM, // Any server
+  STEAL_TIER_COUNT
+} steal_tier;
+
+static const char *steal_tier_names[STEAL_TIER_COUNT] =
+  { "last", "host", "nearby", "random" };
+
+/**
+   Victim selection policy, set with ADLB_STEAL_POLICY.
+   select: choose a victim not already probed, or return
+           ADLB_RANK_NULL if none could be found
+ */
+typedef struct
+{
+  const char *name;
+  int (*select)(steal_tier *tier);
+} steal_policy;
+
+static int select_random(steal_tier *tier);
+static int select_locality(steal_tier *tier);
+
+static const steal_policy steal_policies[] = {
+  { "RANDOM", select_random },
+  { "LOCALITY", select_locality },
+};
+
+#define STEAL_POLICY_COUNT \
+  (sizeof(steal_policies) / sizeof(steal_policies[0]))
+
+static const steal_policy *policy = &steal_policies[0];
+
+/** Other servers on this host, from the hostmap */
+static int *host_servers = NULL;
+static int host_servers_count = 0;
+
+/** Servers within this distance in server number are nearby */
+static int nearby_distance = 2;
+
+/** Last server we stole from, or ADLB_RANK_NULL */
+static int last_victim = ADLB_RANK_NULL;
+
+/** Tier to try next in locality policy: moves outward on failures */
+static steal_tier next_tier = STEAL_TIER_HOST;
+
+/* Statistics, indexed by steal_tier */
+static int64_t tier_probes[STEAL_TIER_COUNT];
+static int64_t tier_steals[STEAL_TIER_COUNT];
+
+/** Probes to servers on this host made during the backoff */
+static int64_t host_only_probes = 0;
+
+static inline bool
+probe_pending(int rank)
+{
+  return table_ip_contains(&sent_steal_probes, rank);
+}
+
 /**
    Target: another server
  */
-static inline void
-get_target_server(int* result)
+static int
+select_random(steal_tier *tier)
 {
+  int result;
   do
   {
-    *result = xlb_random_server();
-  } while (*result == xlb_s.layout.rank);
+    result = xlb_random_server();
+  } while (result == xlb_s.layout.rank);
+
+  *tier = STEAL_TIER_RANDOM;
+  return probe_pending(result) ? ADLB_RANK_NULL : result;
+}
+
+/**
+   Pick a random server from candidates without a pending probe.
+   Starts at a random position and scans, so stays cheap
+ */
+static int
+select_from(const int *candidates, int count)
+{
+  if (count == 0)
+    return ADLB_RANK_NULL;
+
+  int start = random_between(0, count);
+  for (int i = 0; i < count; i++)
+  {
+    int rank = candidates[(start + i) % count];
+    if (!probe_pending(rank))
+      return rank;
+  }
+  return ADLB_RANK_NULL;
+}
+
+static int
+select_nearby(void)
+{
+  int servers = xlb_s.layout.servers;
+  int me = xlb_s.layout.rank - xlb_s.layout.workers;
+  int count = 0;
+  int candidates[2 * nearby_distance + 1];
+  for (int d = 1; d <= nearby_distance && 2 * d <= servers; d++)
+  {
+    int below = (me - d + servers) % servers;
+    int above = (me + d) % servers;
+    candidates[count++] = below + xlb_s.layout.workers;
+    if (above != below)
+      candidates[count++] = above + xlb_s.layout.workers;
+  }
+  return select_from(candidates, count);
+}
+
+/**
+   Prefer the last successful victim, then servers on the same host,
+   then nearby ranks, then any server.  Each failed probe moves the
+   next probe one tier further out, so distant servers are still
+   probed regularly if nearby ones have no work.
+ */
+static int
+select_locality(steal_tier *tier)
+{
+  if (last_victim != ADLB_RANK_NULL && !probe_pending(last_victim))
+  {
+    *tier = STEAL_TIER_LAST;
+    return last_victim;
+  }
+
+  for (steal_tier t = next_tier; t < STEAL_TIER_COUNT; t++)
+  {
+    int rank = ADLB_RANK_NULL;
+    switch (t)
+    {
+      case STEAL_TIER_HOST:
+        rank = select_from(host_servers, host_servers_count);
+        break;
+      case STEAL_TIER_NEARBY:
+        rank = select_nearby();
+        break;
+      case STEAL_TIER_RANDOM:
+        return select_random(tier);
+      default:
+        break;
+    }
+    if (rank != ADLB_RANK_NULL)
+    {
+      *tier = t;
+      return rank;
+    }
+  }
+  return ADLB_RANK_NULL;
+}
+
+/**
+   Record outcome of a probe for victim selection and statistics
+ */
+static void
+probe_done(int victim, steal_tier tier, bool stole)
+{
+  if (stole)
+  {
+    tier_steals[tier]++;
+    last_victim = victim;
+    next_tier = STEAL_TIER_HOST;
+  }
+  else
+  {
+    if (victim == last_victim)
+      last_victim = ADLB_RANK_NULL;
+
+    // Look further out next time, wrapping around after random
+    if (tier != STEAL_TIER_LAST)
+      next_tier = (tier >= STEAL_TIER_RANDOM) ?
+                  STEAL_TIER_HOST : tier + 1;
+  }
 }
 
 static bool xlb_can_steal(const int *work_type_counts);
-static adlb_code xlb_steal(int target, bool* stole_single, bool *stole_par);
-static adlb_code steal_sync(int target, int max_memory, int *response);
+static adlb_code xlb_steal(int target, const int *victim_counts,
+                           bool* stole_single, bool *stole_par);
+static adlb_code steal_sync(int target, const int *want_counts,
+                            int max_memory, int *response);
+static adlb_code steal_sizing_init(void);
 static adlb_code steal_payloads(int target, int count,
                int *single_count, int *par_count, bool discard);
 
@@ -71,16 +275,237 @@ static adlb_code steal_payloads(int target, int count,
 adlb_code
 xlb_steal_init(void)
 {
+  adlb_code ac;
   bool ok = table_ip_init(&sent_steal_probes, 128);
   ADLB_CHECK_MSG(ok, "Error initing table_ip");
 
+  const char *policy_name = getenv("ADLB_STEAL_POLICY");
+  if (policy_name == NULL || strlen(policy_name) == 0)
+    policy_name = "LOCALITY";
+
+  policy = NULL;
+  for (size_t i = 0; i < STEAL_POLICY_COUNT; i++)
+  {
+    if (strcmp(policy_name, steal_policies[i].name) == 0)
+      policy = &steal_policies[i];
+  }
+  ADLB_CHECK_MSG(policy != NULL, "Unknown ADLB_STEAL_POLICY: %s",
+                 policy_name);
+
+  long distance = 2;
+  ac = xlb_env_long("ADLB_STEAL_NEARBY", &distance);
+  ADLB_CHECK(ac);
+  ADLB_CHECK_MSG(distance >= 0, "ADLB_STEAL_NEARBY negative: %li",
+                 distance);
+  nearby_distance = (int)distance;
+
+  host_servers = NULL;
+  host_servers_count = 0;
+  if (xlb_s.hostmap != NULL)
+  {
+    ac = xlb_hostmap_host_servers(xlb_s.hostmap, &xlb_s.layout,
+                    xlb_s.layout.rank, &host_servers, &host_servers_count);
+    ADLB_CHECK(ac);
+  }
+
+  bool host_early;
+  ok = getenv_boolean("ADLB_STEAL_HOST_EARLY", false, &host_early);
+  ADLB_CHECK_MSG(ok, "Invalid ADLB_STEAL_HOST_EARLY");
+  xlb_steal_host_early = 0;
+  if (host_early && policy->select == select_locality)
+    xlb_steal_host_early = host_servers_count;
+  xlb_steal_host_only = false;
+
+  last_victim = ADLB_RANK_NULL;
+  next_tier = STEAL_TIER_HOST;
+  memset(tier_probes, 0, sizeof(tier_probes));
+  memset(tier_steals, 0, sizeof(tier_steals));
+  host_only_probes = 0;
+
+  DEBUG("Steal policy: %s host servers: %i nearby: %i host early: %i",
+        policy->name, host_servers_count, nearby_distance,
+        xlb_steal_host_early);
+
+  ac = steal_sizing_init();
+  ADLB_CHECK(ac);
+
   return ADLB_SUCCESS;
 }
 
+static adlb_code
+steal_sizing_init(void)
+{
+  const char *sizing = getenv("ADLB_STEAL_SIZING");
+  if (sizing == NULL || strlen(sizing) == 0 ||
+      strcmp(sizing, "FRACTION") == 0)
+  {
+    xlb_steal_sizing_policy = XLB_STEAL_SIZING_FRACTION;
+  }
+  else if (strcmp(sizing, "ADAPTIVE") == 0)
+  {
+    xlb_steal_sizing_policy = XLB_STEAL_SIZING_ADAPTIVE;
+  }
+  else
+  {
+    ERR_PRINTF("Unknown ADLB_STEAL_SIZING: %s\n", sizing);
+    return ADLB_ERROR;
+  }
+
+  bool ok = getenv_double("ADLB_STEAL_HORIZON", 0.1, &steal_horizon);
+  ADLB_CHECK_MSG(ok && steal_horizon > 0.0, "Invalid ADLB_STEAL_HORIZON");
+
+  units_wanted = 0;
+  units_stolen = 0;
+
+  if (xlb_steal_sizing_policy != XLB_STEAL_SIZING_ADAPTIVE)
+    return ADLB_SUCCESS;
+
+  task_runtime = malloc(sizeof(task_runtime[0]) *
+                        (size_t)xlb_s.types_size);
+  ADLB_CHECK_MALLOC(task_runtime);
+  for (int t = 0; t < xlb_s.types_size; t++)
+    task_runtime[t] = -1.0;
+
+  int workers = xlb_s.layout.my_workers;
+  task_start = malloc(sizeof(task_start[0]) * (size_t)workers);
+  ADLB_CHECK_MALLOC(task_start);
+  task_type = malloc(sizeof(task_type[0]) * (size_t)workers);
+  ADLB_CHECK_MALLOC(task_type);
+  for (int i = 0; i < workers; i++)
+    task_start[i] = -1.0;
+
+  return ADLB_SUCCESS;
+}
+
+void
+xlb_task_runtime_start_impl(int worker, int type)
+{
+  if (!xlb_worker_maps_to_server(&xlb_s.layout, worker,
+                                 xlb_s.layout.rank))
+    return;
+
+  int idx = xlb_my_worker_idx(&xlb_s.layout, worker);
+  task_start[idx] = MPI_Wtime();
+  task_type[idx] = type;
+}
+
+void
+xlb_task_runtime_end_impl(int worker)
+{
+  if (!xlb_worker_maps_to_server(&xlb_s.layout, worker,
+                                 xlb_s.layout.rank))
+    return;
+
+  int idx = xlb_my_worker_idx(&xlb_s.layout, worker);
+  if (task_start[idx] < 0.0)
+    return;
+
+  double runtime = MPI_Wtime() - task_start[idx];
+  task_start[idx] = -1.0;
+
+  double *est = &task_runtime[task_type[idx]];
+  if (*est < 0.0)
+    *est = runtime;
+  else
+    *est = TASK_RUNTIME_ALPHA * runtime + (1 - TASK_RUNTIME_ALPHA) * *est;
+}
+
+/**
+   Decide how many work units of each type to ask for.
+   victim_counts: work type counts from victim's probe response
+   want: filled with count for each type, or -1 for no limit
+ */
+static void
+steal_want_counts(const int *victim_counts, int *want)
+{
+  if (xlb_steal_sizing_policy != XLB_STEAL_SIZING_ADAPTIVE)
+  {
+    for (int t = 0; t < xlb_s.types_size; t++)
+      want[t] = -1;
+    return;
+  }
+
+  int idle[xlb_s.types_size];
+  xlb_requestqueue_type_counts(idle, xlb_s.types_size);
+  for (int t = 0; t < xlb_s.types_size; t++)
+  {
+    if (task_runtime[t] < 0.0)
+    {
+      // Nothing to go on yet
+      want[t] = -1;
+      continue;
+    }
+
+    // Short tasks: take enough to last until we could steal again.
+    // Long tasks: take only one per idle worker to avoid ping-pong
+    double per_worker = steal_horizon / task_runtime[t];
+    if (per_worker < 1.0)
+      per_worker = 1.0;
+    else if (per_worker > STEAL_MAX_PER_WORKER)
+      per_worker = STEAL_MAX_PER_WORKER;
+    want[t] = idle[t] * (int)per_worker;
+
+    // Leave victim at least half of its work
+    int victim_max = (victim_counts[t] + 1) / 2;
+    if (want[t] > victim_max)
+      want[t] = victim_max;
+
+    units_wanted += want[t];
+  }
+}
+
 void
 xlb_steal_finalize(void)
 {
   table_ip_free_callback(&sent_steal_probes, false, NULL);
+  free(host_servers);
+  host_servers = NULL;
+  host_servers_count = 0;
+  free(task_runtime);
+  free(task_start);
+  free(task_type);
+  task_runtime = NULL;
+  task_start = NULL;
+  task_type = NULL;
+}
+
+void
+xlb_print_steal_counters(void)
+{
+  if (!xlb_s.perfc_enabled)
+  {
+    return;
+  }
+
+  PRINT_COUNTER("steal_policy=%s", policy->name);
+  for (int t = 0; t < STEAL_TIER_COUNT; t++)
+  {
+    if (tier_probes[t] == 0)
+      continue;
+    PRINT_COUNTER("steal_%s_probes=%"PRId64, steal_tier_names[t],
+                  tier_probes[t]);
+    PRINT_COUNTER("steal_%s_steals=%"PRId64, steal_tier_names[t],
+                  tier_steals[t]);
+    PRINT_COUNTER("steal_%s_success_rate=%.3f", steal_tier_names[t],
+                  (double)tier_steals[t] / (double)tier_probes[t]);
+  }
+
+  PRINT_COUNTER("steal_host_early_servers=%i", xlb_steal_host_early);
+  PRINT_COUNTER("steal_host_only_probes=%"PRId64, host_only_probes);
+
+  PRINT_COUNTER("steal_sizing=%s",
+      xlb_steal_sizing_policy == XLB_STEAL_SIZING_ADAPTIVE ?
+      "ADAPTIVE" : "FRACTION");
+  PRINT_COUNTER("steal_units_stolen=%"PRId64, units_stolen);
+  if (xlb_steal_sizing_policy == XLB_STEAL_SIZING_ADAPTIVE)
+  {
+    PRINT_COUNTER("steal_units_wanted=%"PRId64, units_wanted);
+    for (int t = 0; t < xlb_s.types_size; t++)
+    {
+      PRINT_COUNTER("steal_task_runtime_type_%i=%.6f", t,
+                    task_runtime[t]);
+    }
+  }
 }
 
 adlb_code
@@ -92,20 +517,32 @@ xlb_random_steal_probe(void)
     return ADLB_NOTHING;
   }
 
+  steal_tier tier;
   int target;
-  get_target_server(&target);
-
-  if (table_ip_contains(&sent_steal_probes, target))
+  if (xlb_steal_host_only)
+  {
+    tier = STEAL_TIER_HOST;
+    target = select_from(host_servers, host_servers_count);
+    if (target != ADLB_RANK_NULL)
+      host_only_probes++;
+  }
+  else
+  {
+    target = policy->select(&tier);
+  }
+  if (target == ADLB_RANK_NULL)
   {
-    // do nothing - already sent probe
+    // do nothing - already sent probes to candidates
     return ADLB_NOTHING;
   }
  
   adlb_code rc = xlb_sync_steal_probe(target);
   ADLB_CHECK(rc);
+  tier_probes[tier]++;
   
   // Mark as sent to avoid duplicates
-  bool ok = table_ip_add(&sent_steal_probes, target, (void*)0x1);
+  bool ok = table_ip_add(&sent_steal_probes, target,
+                         (void*)(uintptr_t)(tier + 1));
   ADLB_CHECK_MSG(ok, "error adding to table");
 
   return ADLB_SUCCESS;
@@ -140,13 +577,15 @@ xlb_handle_steal_probe_resp(int caller,
   void *tmp;
   bool found = table_ip_remove(&sent_steal_probes, caller, &tmp);
   ADLB_CHECK_MSG(found, "probe not found");
+  steal_tier tier = (steal_tier)((uintptr_t)tmp - 1);
 
   const int *caller_type_counts = (int*)hdr->sync_data;
   if (xlb_can_steal(caller_type_counts))
   {
     bool stole_single, stole_par;
-    rc = xlb_steal(caller, &stole_single, &stole_par);
+    rc = xlb_steal(caller, caller_type_counts, &stole_single, &stole_par);
     ADLB_CHECK(rc);
+    probe_done(caller, tier, stole_single || stole_par);
   
     DEBUG("[%i] Completed steal from %i stole_single: %i stole_par: %i",
           xlb_s.layout.rank, caller, (int)stole_single, (int)stole_par);
@@ -158,6 +597,7 @@ xlb_handle_steal_probe_resp(int caller,
   {
     DEBUG("[%i] No matching work to steal from %i",
           xlb_s.layout.rank, caller);
+    probe_done(caller, tier, false);
   }
 
   return ADLB_SUCCESS;
@@ -193,7 +633,8 @@ static bool xlb_can_steal(const int *work_type_counts)
    @param stole_par true if stole parallel task, else false
  */
 static adlb_code
-xlb_steal(int target, bool *stole_single, bool *stole_par)
+xlb_steal(int target, const int *victim_counts,
+          bool *stole_single, bool *stole_par)
 {
   adlb_code rc;
   *stole_single = false;
@@ -214,7 +655,9 @@ xlb_steal(int target, bool *stole_single, bool *stole_par)
   int max_memory = 1;
   int total_single = 0, total_par = 0;
   int response;
-  rc = steal_sync(target, max_memory, &response);
+  int want_counts[xlb_s.types_size];
+  steal_want_counts(victim_counts, want_counts);
+  rc = steal_sync(target, want_counts, max_memory, &response);
   if (!response || rc == ADLB_SHUTDOWN)
   {
     CANCEL(&request);
@@ -234,6 +677,7 @@ xlb_steal(int target, bool *stole_single, bool *stole_par)
       ADLB_CHECK(rc);
       total_single += single;
       total_par += par;
+      units_stolen += single + par;
     }
     if (hdr.last)
       break;
@@ -274,7 +718,8 @@ xlb_steal(int target, bool *stole_single, bool *stole_par)
   accepted: if true, steal response will be sent to us
  */
 static adlb_code
-steal_sync(int target, int max_memory, int *response)
+steal_sync(int target, const int *want_counts, int max_memory,
+           int *response)
 {
   // Need to give server information about which work types we have:
   // we only want to steal work types where the other server has more
@@ -284,8 +729,8 @@ steal_sync(int target, int max_memory, int *response)
   // Fill counts
   xlb_workq_type_counts(work_counts, xlb_s.types_size);
 
-  adlb_code code = xlb_sync_steal(target, work_counts, xlb_s.types_size,
-                        max_memory, response);
+  adlb_code code = xlb_sync_steal(target, work_counts, want_counts,
+                        xlb_s.types_size, max_memory, response);
   if (code == ADLB_SUCCESS)
   {
     if (*response)
@@ -439,7 +884,7 @@ handle_steal_callback(void *cb_data, xlb_work_unit *work)
 
 adlb_code
 xlb_handle_steal(int caller, const struct packed_steal *req,
-                 const int *work_type_counts)
+                 const int *work_type_counts, const int *want_counts)
 {
   TRACE_START;
   MPE_LOG(xlb_mpe_svr_steal_start);
@@ -460,7 +905,8 @@ xlb_handle_steal(int caller, const struct packed_steal *req,
 
   // Maximum amount of memory to return- currently unused
   // Call steal.  This function will call back to send messages
-  code = xlb_workq_steal(req->max_memory, work_type_counts, cb);
+  code = xlb_workq_steal(req->max_memory, work_type_counts, want_counts,
+                         cb);
   ADLB_CHECK(code);
  
   // send any remaining.  If nothing left (or nothing was stolen)
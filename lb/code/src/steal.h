@@ -37,6 +37,21 @@
 // The number of work units to send at a time
 #define XLB_STEAL_CHUNK_SIZE 16
 
+/**
+   How a stealer decides how many work units to take,
+   set with ADLB_STEAL_SIZING
+ */
+typedef enum
+{
+  /** Take half of the imbalance with the victim */
+  XLB_STEAL_SIZING_FRACTION,
+  /** Take enough to keep idle workers busy for ADLB_STEAL_HORIZON
+      seconds, based on estimated task runtimes, up to the fraction */
+  XLB_STEAL_SIZING_ADAPTIVE,
+} xlb_steal_sizing;
+
+extern xlb_steal_sizing xlb_steal_sizing_policy;
+
 /**
    When was the last time we tried to steal?  In seconds.
    Updated by steal()
@@ -45,6 +60,20 @@ extern double xlb_steal_last;
 
 extern int xlb_failed_steals_since_backoff;
 
+/**
+   Number of other servers on this host that may still be probed
+   during the failed-steal backoff, or 0 if disabled.  These probes
+   are ordinary steal messages and still obey xlb_steal_rate_limit.
+   Off by default: set ADLB_STEAL_HOST_EARLY=1 to enable.
+ */
+extern int xlb_steal_host_early;
+
+/**
+   Set by xlb_steal_allowed() if only a server on this host may
+   be probed by the next xlb_random_steal_probe()
+ */
+extern bool xlb_steal_host_only;
+
 /**
   Initialize steal internal state before use
  */
@@ -55,6 +84,31 @@ adlb_code xlb_steal_init(void);
  */
 void xlb_steal_finalize(void);
 
+void xlb_print_steal_counters(void);
+
+void xlb_task_runtime_start_impl(int worker, int type);
+void xlb_task_runtime_end_impl(int worker);
+
+/**
+  Record that a task of type was sent to worker.  Used to estimate
+  task runtimes for adaptive steal sizing.
+ */
+static inline void xlb_task_runtime_start(int worker, int type)
+{
+  if (xlb_steal_sizing_policy == XLB_STEAL_SIZING_ADAPTIVE)
+    xlb_task_runtime_start_impl(worker, type);
+}
+
+/**
+  Record that worker asked for more work, so has finished the last
+  task sent to it
+ */
+static inline void xlb_task_runtime_end(int worker)
+{
+  if (xlb_steal_sizing_policy == XLB_STEAL_SIZING_ADAPTIVE)
+    xlb_task_runtime_end_impl(worker);
+}
+
 /**
   Check if this server is allowed to initiate a steal request
   according to the steal throttling/backoff algorithms.
@@ -85,9 +139,11 @@ adlb_code xlb_handle_steal_probe_resp(int caller,
 /**
    Handle an accepted steal request
    work_type_counts: array of size xlb_s.types_size
+   want_counts: array of size xlb_s.types_size, see xlb_workq_steal()
   */
 adlb_code xlb_handle_steal(int caller, const struct packed_steal *req,
-                           const int *work_type_counts);
+                           const int *work_type_counts,
+                           const int *want_counts);
 
 // Inline functions:
 static inline bool xlb_steal_allowed(void)
@@ -110,9 +166,15 @@ static inline bool xlb_steal_allowed(void)
     interval = xlb_steal_rate_limit;
   }
   if (t - xlb_steal_last < interval)
-    // Too soon to try again
-    return false;
+  {
+    // Too soon to try again, except from a server on this host
+    // while backing off, within the normal rate limit
+    xlb_steal_host_only = (backoff && xlb_steal_host_early > 0 &&
+                t - xlb_steal_last >= xlb_steal_rate_limit);
+    return xlb_steal_host_only;
+  }
 
+  xlb_steal_host_only = false;
   if (backoff)
   {
     // Backoff expired, reset
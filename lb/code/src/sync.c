@@ -27,6 +27,7 @@
 #include <mpi.h>
 
 #include "backoffs.h"
+#include "closed_summary.h"
 #include "common.h"
 #include "debug.h"
 #include "messaging.h"
@@ -591,7 +592,8 @@ xlb_sync_steal_probe_resp(int target, const int *work_counts,
 }
 
 adlb_code
-xlb_sync_steal(int target, const int *work_counts, int size,
+xlb_sync_steal(int target, const int *work_counts,
+               const int *want_counts, int size,
                int max_memory, int *response)
 {
   char req_storage[PACKED_SYNC_SIZE]; // Temporary stack storage for struct
@@ -600,9 +602,10 @@ xlb_sync_steal(int target, const int *work_counts, int size,
   req->steal.max_memory = max_memory;
   req->steal.idle_check_attempt = xlb_idle_check_attempt;
 
-  // Include work types in sync data field
-  memcpy(req->sync_data, work_counts,
-         sizeof(work_counts[0] * (size_t)xlb_s.types_size));
+  // Include work types and wanted counts in sync data field
+  assert(size == xlb_s.types_size);
+  memcpy(req->sync_data, work_counts, WORK_TYPES_SIZE);
+  memcpy(req->sync_data + WORK_TYPES_SIZE, want_counts, WORK_TYPES_SIZE);
 
   return xlb_sync2(target, req, response);
 }
@@ -799,7 +802,8 @@ adlb_code xlb_accept_sync(int rank, const struct packed_sync *hdr,
 
     case ADLB_SYNC_STEAL:
       // Respond to steal
-      code = xlb_handle_steal(rank, &hdr->steal, (int*)hdr->sync_data);
+      code = xlb_handle_steal(rank, &hdr->steal, (int*)hdr->sync_data,
+                  (int*)(hdr->sync_data + WORK_TYPES_SIZE));
       break;
 
     case ADLB_SYNC_REFCOUNT:
@@ -957,6 +961,9 @@ static adlb_code xlb_handle_subscribe_sync(int rank,
     sub.key = malloced_subscript;
   }
 
+  // Subscriber may skip subscribes to data it knows is closed
+  xlb_closed_summary_subscriber(rank);
+
   // call data module to subscribe
   bool subscribed;
   dc = xlb_data_subscribe(sub_hdr->id, sub, rank, 0, &subscribed);
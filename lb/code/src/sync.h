@@ -110,12 +110,15 @@ xlb_sync_steal_probe_resp(int target, const int *work_counts,
   Send a request to initiate a steal, to be followed up by actual steal
   communication once accepted.
   work_counts: counts of request types
-  size: number of entries in work_counts array
+  want_counts: number of work units wanted of each type, or -1 for
+               no limit
+  size: number of entries in work_counts and want_counts arrays
   max_memory: max additional memory to accept
   response: logical, true if we will receive work
  */
 adlb_code
-xlb_sync_steal(int target, const int *work_counts, int size,
+xlb_sync_steal(int target, const int *work_counts,
+               const int *want_counts, int size,
                int max_memory, int *response);
 
 /*
@@ -26,7 +26,6 @@
 #include <limits.h>
 #include <stdlib.h>
 
-#include <heap_iu32.h>
 #include <list.h>
 #include <ptr_array.h>
 #include <table_ip.h>
@@ -46,33 +45,68 @@
 
 #define XLB_SOFT_TARGET_PRIORITY_PENALTY 65536
 
-static adlb_code init_work_heaps(heap_iu32_t** heap_array, int count);
+/**
+  Position of a work unit in each kind of heap, indexed like wu_array.
+  Updated by the heaps as entries move, so that a work unit taken from
+  one heap can be removed from the other heap directly.
+ */
+typedef struct
+{
+  uint32_t untargeted;
+  /** Position in targeted_work or host_targeted_work */
+  uint32_t targeted;
+} wu_heap_pos;
+
+/** Position of work unit not in heap */
+#define WU_HEAP_POS_NONE UINT32_MAX
+
+static wu_heap_pos *wu_pos = NULL;
+static uint32_t wu_pos_size = 0;
+
+/*
+  4-ary heaps of wu_array indices keyed by negated priority.
+  Entries are 8 bytes, so all children of a node are in one cache line.
+ */
+#define XLB_WORKQ_HEAP_ARITY 4
+
+#define HEAP_KEY_T int
+#define HEAP_VAL_T uint32_t
+#define HEAP_PFX untgt_heap_
+#define HEAP_ARITY XLB_WORKQ_HEAP_ARITY
+#define HEAP_SET_POS(wu_idx, i) (wu_pos[(wu_idx)].untargeted = (i))
+#include <heap-template.h>
+
+#define HEAP_KEY_T int
+#define HEAP_VAL_T uint32_t
+#define HEAP_PFX tgt_heap_
+#define HEAP_ARITY XLB_WORKQ_HEAP_ARITY
+#define HEAP_SET_POS(wu_idx, i) (wu_pos[(wu_idx)].targeted = (i))
+#include <heap-template.h>
+
+static adlb_code wu_pos_expand(void);
+static adlb_code init_untgt_heaps(untgt_heap_t** heap_array, int count);
+static adlb_code init_tgt_heaps(tgt_heap_t** heap_array, int count);
 static adlb_code xlb_workq_add_parallel(xlb_work_unit* wu);
 static adlb_code xlb_workq_add_serial(xlb_work_unit* wu);
 static adlb_code add_untargeted(xlb_work_unit* wu, uint32_t wu_idx);
 static adlb_code add_targeted(xlb_work_unit* wu, uint32_t wu_idx);
 
 static int targeted_work_entries(int work_types, int my_workers);
-static inline heap_iu32_t *targeted_work_heap(int rank, int type);
-static inline heap_iu32_t *host_targeted_work_heap(int host_idx, int type);
+static inline tgt_heap_t *targeted_work_heap(int rank, int type);
+static inline tgt_heap_t *host_targeted_work_heap(int host_idx, int type);
+static inline tgt_heap_t *wu_targeted_heap(const xlb_work_unit *wu);
 static inline int host_idx_from_rank2(int rank);
 
 static void wu_array_finalize(void);
-static inline xlb_work_unit *
-wu_array_try_remove_untargeted(uint32_t wu_idx, int type, int priority);
-static inline xlb_work_unit *
-wu_array_try_remove_targeted(uint32_t wu_idx, int type, int target, int priority);
-static inline xlb_work_unit *
-wu_array_try_remove_host_targeted(uint32_t wu_idx, int type, int host_idx,
-                                  int priority);
+static inline xlb_work_unit *wu_array_remove(uint32_t wu_idx);
 
 static xlb_work_unit* pop_untargeted(int type);
 static xlb_work_unit* pop_targeted(int type, int target);
 static xlb_work_unit* pop_host_targeted(int type, int host_idx);
 
 static adlb_code
-heap_steal_type(heap_iu32_t *q, int type, double p, int *stolen,
-                xlb_workq_steal_callback cb);
+heap_steal_type(untgt_heap_t *q, double p, int max,
+                int *stolen, xlb_workq_steal_callback cb);
 static adlb_code
 rbtree_steal_type(struct rbtree *q, int num, xlb_workq_steal_callback cb);
 
@@ -112,19 +146,25 @@ static struct ptr_array wu_array = PTR_ARRAY_EMPTY;
   hard host targeted work goes in host_targeted_work only
   soft host targeted work goes in both untargeted_work and host_targeted_work
 
-  These indices are allowed to get out of sync with wu_array - stale
-  entries are allowed in the indices.  This is ok so long as we check
-  that the type and priority of the work unit match before returning.
+  When a work unit is taken from one index, it is removed from the
+  other index too, through its position in wu_pos, so the indices
+  never hold stale entries.
  */
 
-static heap_iu32_t* untargeted_work;
+static untgt_heap_t* untargeted_work;
 
-static heap_iu32_t *targeted_work;
+static tgt_heap_t *targeted_work;
 static int targeted_work_size;  // Number of individual heaps
 
-static heap_iu32_t *host_targeted_work;
+static tgt_heap_t *host_targeted_work;
 static int host_targeted_work_size; // Number of heaps (hosts * types)
 
+/* Heap statistics */
+static int64_t heap_entries = 0;
+static int64_t heap_entries_hwm = 0;
+/** Entries removed from a second heap when a work unit was taken */
+static int64_t heap_cross_removals = 0;
+
 /** We should free heaps that are empty but more than this number of
  * unused entries. */
 #define HEAP_FREE_THRESHOLD_TARGETED 64
@@ -149,6 +189,21 @@ int64_t xlb_workq_parallel_task_count;
 
 work_type_counters *xlb_task_counters;
 
+bool xlb_wu_pool_enabled = false;
+
+/** Default for xlb_wu_pool_max_free: override with
+    ADLB_WORK_UNIT_POOL_MAX */
+#define XLB_WU_POOL_MAX_FREE_DEFAULT (1024 * 16)
+
+int xlb_wu_pool_max_free = 0;
+
+xlb_wu_pool_class xlb_wu_pool[XLB_WU_POOL_CLASSES];
+
+int64_t xlb_wu_pool_unpooled = 0;
+
+static adlb_code wu_pool_init(void);
+static void wu_pool_finalize(void);
+
 adlb_code
 xlb_workq_init(int work_types, const xlb_layout *layout)
 {
@@ -157,22 +212,34 @@ xlb_workq_init(int work_types, const xlb_layout *layout)
 
   adlb_code ac;
 
+  ac = wu_pool_init();
+  ADLB_CHECK(ac);
+
   bool ok = ptr_array_init(&wu_array, WU_ARRAY_INIT_SIZE);
   ADLB_CHECK_MSG(ok, "wu_array initialisation failed");
 
+  wu_pos = NULL;
+  wu_pos_size = 0;
+  ac = wu_pos_expand();
+  ADLB_CHECK(ac);
+
   targeted_work_size = targeted_work_entries(work_types,
                                     layout->my_workers);
-  ac = init_work_heaps(&targeted_work, targeted_work_size);
+  ac = init_tgt_heaps(&targeted_work, targeted_work_size);
   ADLB_CHECK(ac);
 
   host_targeted_work_size = targeted_work_entries(work_types,
                                           layout->my_worker_hosts);
-  ac = init_work_heaps(&host_targeted_work, host_targeted_work_size);
+  ac = init_tgt_heaps(&host_targeted_work, host_targeted_work_size);
   ADLB_CHECK(ac);
 
-  ac = init_work_heaps(&untargeted_work, work_types);
+  ac = init_untgt_heaps(&untargeted_work, work_types);
   ADLB_CHECK(ac);
 
+  heap_entries = 0;
+  heap_entries_hwm = 0;
+  heap_cross_removals = 0;
+
   parallel_work = malloc(sizeof(parallel_work[0]) * (size_t)work_types);
   xlb_workq_parallel_task_count = 0;
   valgrind_assert(parallel_work != NULL);
@@ -214,20 +281,50 @@ xlb_workq_init(int work_types, const xlb_layout *layout)
   return ADLB_SUCCESS;
 }
 
-static adlb_code init_work_heaps(heap_iu32_t** heap_array, int count)
+static adlb_code init_untgt_heaps(untgt_heap_t** heap_array, int count)
 {
   *heap_array = malloc(sizeof((*heap_array)[0]) * (size_t)count);
   ADLB_CHECK_MALLOC(*heap_array);
 
   for (int i = 0; i < count; i++)
   {
-    bool ok = heap_iu32_init_empty(&(*heap_array)[i]);
+    bool ok = untgt_heap_init_empty(&(*heap_array)[i]);
     ADLB_CHECK_MSG(ok, "Could not allocate memory for heap");
   }
 
   return ADLB_SUCCESS;
 }
 
+static adlb_code init_tgt_heaps(tgt_heap_t** heap_array, int count)
+{
+  *heap_array = malloc(sizeof((*heap_array)[0]) * (size_t)count);
+  ADLB_CHECK_MALLOC(*heap_array);
+
+  for (int i = 0; i < count; i++)
+  {
+    bool ok = tgt_heap_init_empty(&(*heap_array)[i]);
+    ADLB_CHECK_MSG(ok, "Could not allocate memory for heap");
+  }
+
+  return ADLB_SUCCESS;
+}
+
+/*
+  Grow wu_pos to match capacity of wu_array
+ */
+static adlb_code wu_pos_expand(void)
+{
+  if (wu_pos_size >= wu_array.capacity)
+    return ADLB_SUCCESS;
+
+  wu_heap_pos *new_pos = realloc(wu_pos,
+                          sizeof(wu_pos[0]) * wu_array.capacity);
+  ADLB_CHECK_MALLOC(new_pos);
+  wu_pos = new_pos;
+  wu_pos_size = wu_array.capacity;
+  return ADLB_SUCCESS;
+}
+
 static int targeted_work_entries(int work_types, int my_workers)
 {
   TRACE("work_types: %i my_workers: %i", work_types, my_workers);
@@ -238,7 +335,7 @@ static int targeted_work_entries(int work_types, int my_workers)
  * Return targeted work index, or -1 if not targeted to current server.
  */
 __attribute__((always_inline))
-static inline heap_iu32_t *targeted_work_heap(int rank, int type)
+static inline tgt_heap_t *targeted_work_heap(int rank, int type)
 {
   int idx = xlb_my_worker_idx(&xlb_s.layout, rank) * xlb_s.types_size
             + (int)type;
@@ -247,13 +344,45 @@ static inline heap_iu32_t *targeted_work_heap(int rank, int type)
 }
 
 __attribute__((always_inline))
-static inline heap_iu32_t *host_targeted_work_heap(int host_idx, int type)
+static inline tgt_heap_t *host_targeted_work_heap(int host_idx, int type)
 {
   int idx = host_idx * xlb_s.types_size + (int)type;
-  assert(idx >= 0 && idx < targeted_work_size);
+  assert(idx >= 0 && idx < host_targeted_work_size);
   return &host_targeted_work[idx];
 }
 
+/*
+ * Return targeted or host targeted heap for work unit, or NULL if
+ * it is not targeted to a worker of this server.
+ */
+static inline tgt_heap_t *wu_targeted_heap(const xlb_work_unit *wu)
+{
+  if (wu->target < 0 ||
+      !xlb_worker_maps_to_server(&xlb_s.layout, wu->target,
+                                 xlb_s.layout.rank))
+  {
+    return NULL;
+  }
+
+  if (wu->opts.accuracy == ADLB_TGT_ACCRY_RANK)
+  {
+    return targeted_work_heap(wu->target, wu->type);
+  }
+  else
+  {
+    assert(wu->opts.accuracy == ADLB_TGT_ACCRY_NODE);
+    return host_targeted_work_heap(host_idx_from_rank2(wu->target),
+                                   wu->type);
+  }
+}
+
+static inline void heap_entry_added(void)
+{
+  heap_entries++;
+  if (heap_entries > heap_entries_hwm)
+    heap_entries_hwm = heap_entries;
+}
+
 adlb_code
 xlb_workq_add(xlb_work_unit* wu)
 {
@@ -292,6 +421,11 @@ static adlb_code xlb_workq_add_serial(xlb_work_unit* wu)
   bool ok = ptr_array_add(&wu_array, wu, &wu_idx);
   ADLB_CHECK_MSG(ok, "Could not add work unit");
 
+  adlb_code ac = wu_pos_expand();
+  ADLB_CHECK(ac);
+  wu_pos[wu_idx].untargeted = WU_HEAP_POS_NONE;
+  wu_pos[wu_idx].targeted = WU_HEAP_POS_NONE;
+
   if (wu->target >= 0)
   {
     return add_targeted(wu, wu_idx);
@@ -305,9 +439,10 @@ static adlb_code xlb_workq_add_serial(xlb_work_unit* wu)
 static adlb_code add_untargeted(xlb_work_unit* wu, uint32_t wu_idx)
 {
   // Untargeted single-process task
-  heap_iu32_t* H = &untargeted_work[wu->type];
-  bool b = heap_iu32_add(H, -wu->opts.priority, wu_idx);
+  untgt_heap_t* H = &untargeted_work[wu->type];
+  bool b = untgt_heap_add(H, -wu->opts.priority, wu_idx);
   ADLB_CHECK_MSG(b, "out of memory expanding heap");
+  heap_entry_added();
 
   if (xlb_s.perfc_enabled)
   {
@@ -320,22 +455,12 @@ static adlb_code add_untargeted(xlb_work_unit* wu, uint32_t wu_idx)
 static adlb_code add_targeted(xlb_work_unit* wu, uint32_t wu_idx)
 {
   // Targeted task
-  if (xlb_worker_maps_to_server(&xlb_s.layout, wu->target,
-                                xlb_s.layout.rank))
+  tgt_heap_t* TH = wu_targeted_heap(wu);
+  if (TH != NULL)
   {
-    heap_iu32_t* H;
-    if (wu->opts.accuracy == ADLB_TGT_ACCRY_RANK)
-    {
-      H = targeted_work_heap(wu->target, wu->type);
-    }
-    else
-    {
-      assert(wu->opts.accuracy == ADLB_TGT_ACCRY_NODE);
-      int host_idx = host_idx_from_rank2(wu->target);
-      H = host_targeted_work_heap(host_idx, wu->type);
-    }
-    bool b = heap_iu32_add(H, -wu->opts.priority, wu_idx);
+    bool b = tgt_heap_add(TH, -wu->opts.priority, wu_idx);
     ADLB_CHECK_MSG(b, "out of memory expanding heap");
+    heap_entry_added();
   }
   else
   {
@@ -350,9 +475,10 @@ static adlb_code add_targeted(xlb_work_unit* wu, uint32_t wu_idx)
     // Also add entry to untargeted work
     DEBUG("Add to soft targeted: wu: %p key: %i\n", wu, -modified_priority);
 
-    heap_iu32_t* H = &untargeted_work[wu->type];
-    bool b = heap_iu32_add(H, -modified_priority, wu_idx);
+    untgt_heap_t* H = &untargeted_work[wu->type];
+    bool b = untgt_heap_add(H, -modified_priority, wu_idx);
     ADLB_CHECK_MSG(b, "out of memory expanding heap");
+    heap_entry_added();
   }
 
   if (xlb_s.perfc_enabled)
@@ -389,89 +515,45 @@ static void wu_array_finalize(void)
   }
 
   ptr_array_clear(&wu_array);
+  free(wu_pos);
+  wu_pos = NULL;
+  wu_pos_size = 0;
 }
 
 /*
-  Try to remove and return untargeted entry.
-   type: expected type
-   priority: expected priority (from index)
-   Return NULL if no longer present.
+  Remove work unit from wu_array and from all heaps it is in.
+  Return the work unit.
  */
 __attribute__((always_inline))
 static inline xlb_work_unit *
-wu_array_try_remove_untargeted(uint32_t wu_idx, int type, int priority)
+wu_array_remove(uint32_t wu_idx)
 {
   xlb_work_unit* wu = ptr_array_get(&wu_array, wu_idx);
-  /*
-    Check not stale.  There is a corner case here where all of these
-    match but it was a different work unit to the one the targeted
-    entry was created for.  In that case it doesn't matter which
-    was returned.
+  assert(wu != NULL);
 
-    We need to modify priority check for adjusted priority for soft
-    targeted tasks.
-   */
-  if (wu != NULL && wu->type == type &&
-      (wu->target < 0 || wu->opts.strictness != ADLB_TGT_STRICT_HARD)) {
-    int modified_priority = wu->opts.priority;
-    if (wu->opts.strictness != ADLB_TGT_STRICT_HARD)
-    {
-      modified_priority = soft_target_priority(modified_priority);
-    }
-    
-    if (modified_priority == priority) {
-      ptr_array_remove(&wu_array, wu_idx);
-      return wu;
-    }
+  int removed = 0;
+  wu_heap_pos *pos = &wu_pos[wu_idx];
+  if (pos->untargeted != WU_HEAP_POS_NONE)
+  {
+    untgt_heap_del_entry(&untargeted_work[wu->type], pos->untargeted);
+    pos->untargeted = WU_HEAP_POS_NONE;
+    removed++;
   }
-
-  return NULL;
-}
-
-/* Try to remove and return targeted entry.
-   Return NULL if no longer present. */
-__attribute__((always_inline))
-static inline xlb_work_unit *
-wu_array_try_remove_targeted(uint32_t wu_idx, int type, int target, int priority)
-{
-  xlb_work_unit* wu = ptr_array_get(&wu_array, wu_idx);
-  /*
-    Check not stale.  There is a corner case here where all of these
-    match but it was a different work unit to the one the targeted
-    entry was created for.  In that case it doesn't matter which
-    was returned.
-   */
-  if (wu != NULL && wu->type == type && wu->target == target &&
-      wu->opts.priority == priority) {
-    ptr_array_remove(&wu_array, wu_idx);
-    return wu;
+  if (pos->targeted != WU_HEAP_POS_NONE)
+  {
+    tgt_heap_t *H = wu_targeted_heap(wu);
+    assert(H != NULL);
+    tgt_heap_del_entry(H, pos->targeted);
+    pos->targeted = WU_HEAP_POS_NONE;
+    removed++;
   }
+  assert(removed > 0);
 
-  return NULL;
-}
-
-/* Try to remove and return host targeted entry.
-   Return NULL if no longer present. */
-__attribute__((always_inline))
-static inline xlb_work_unit *
-wu_array_try_remove_host_targeted(uint32_t wu_idx, int type, int host_idx,
-                                  int priority)
-{
-  xlb_work_unit* wu = ptr_array_get(&wu_array, wu_idx);
-  /*
-    Check not stale.  There is a corner case here where all of these
-    match but it was a different work unit to the one the targeted
-    entry was created for.  In that case it doesn't matter which
-    was returned.
-   */
-  if (wu != NULL && wu->type == type &&
-      host_idx_from_rank2(wu->target) == host_idx &&
-      wu->opts.priority == priority) {
-    ptr_array_remove(&wu_array, wu_idx);
-    return wu;
-  }
+  heap_entries -= removed;
+  heap_cross_removals += removed - 1;
 
-  return NULL;
+  ptr_array_remove(&wu_array, wu_idx);
+  return wu;
 }
 
 // Soft-targeted work has reduced priority compared with non-targeted work
@@ -523,35 +605,23 @@ xlb_workq_get(int target, int type)
   Pop an entry from a targeted queue, return NULL if none left.
 
   Implementation notes:
-   Does not remove entry in untargeted_work if soft targeted
+   Also removes entry in untargeted_work if soft targeted
    Frees per target/type queue if empty
  */
 static xlb_work_unit* pop_targeted(int type, int target)
 {
-  heap_iu32_t* H = targeted_work_heap(target, type);
-  while (H->size > 0)
+  tgt_heap_t* H = targeted_work_heap(target, type);
+  if (H->size > 0)
   {
-    heap_iu32_entry_t root = heap_iu32_root(H);
-
-    int priority = -root.key;
-    uint32_t wu_idx = root.val;
-
-    heap_iu32_del_root(H);
-
-    xlb_work_unit* wu = wu_array_try_remove_targeted(wu_idx, type,
-                                                target, priority);
-    if (wu != NULL)
-    {
-
-      DEBUG("xlb_workq_get(): targeted: %"PRId64"", wu->id);
-      return wu;
-    }
+    xlb_work_unit* wu = wu_array_remove(tgt_heap_root_val(H));
+    DEBUG("xlb_workq_get(): targeted: %"PRId64"", wu->id);
+    return wu;
   }
 
   // Clear empty heaps
   if (H->malloced_size > HEAP_FREE_THRESHOLD_TARGETED)
   {
-    heap_iu32_clear(H);
+    tgt_heap_clear(H);
   }
   return NULL;
 }
@@ -560,63 +630,41 @@ static xlb_work_unit* pop_targeted(int type, int target)
   Pop an entry from a host_targeted queue, return NULL if none left.
 
   Implementation notes:
-   Does not remove entry in untargeted_work if soft targeted
+   Also removes entry in untargeted_work if soft targeted
    Frees per target/type queue if empty
  */
 static xlb_work_unit* pop_host_targeted(int type, int host_idx)
 {
-  heap_iu32_t* H = host_targeted_work_heap(host_idx, type);
-  while (H->size > 0)
+  tgt_heap_t* H = host_targeted_work_heap(host_idx, type);
+  if (H->size > 0)
   {
-    heap_iu32_entry_t root = heap_iu32_root(H);
-
-    int priority = -root.key;
-    uint32_t wu_idx = root.val;
-
-    heap_iu32_del_root(H);
-
-    xlb_work_unit* wu = wu_array_try_remove_host_targeted(wu_idx, type,
-                                                    host_idx, priority);
-    if (wu != NULL)
-    {
-
-      DEBUG("xlb_workq_get(): host targeted: %"PRId64"", wu->id);
-      return wu;
-    }
+    xlb_work_unit* wu = wu_array_remove(tgt_heap_root_val(H));
+    DEBUG("xlb_workq_get(): host targeted: %"PRId64"", wu->id);
+    return wu;
   }
 
   // Clear empty heaps
   if (H->malloced_size > HEAP_FREE_THRESHOLD_TARGETED)
   {
-    heap_iu32_clear(H);
+    tgt_heap_clear(H);
   }
   return NULL;
 }
 
 static xlb_work_unit* pop_untargeted(int type)
 {
-  heap_iu32_t *H = &untargeted_work[type];
-  while (H->size > 0)
+  untgt_heap_t *H = &untargeted_work[type];
+  if (H->size > 0)
   {
-    heap_iu32_entry_t root = heap_iu32_root(H);
-
-    int priority = -root.key;
-    uint32_t wu_idx = root.val;
-
-    heap_iu32_del_root(H);
-
-    xlb_work_unit* wu = wu_array_try_remove_untargeted(wu_idx, type,
-                                                       priority);
-    if (wu != NULL) {
-      DEBUG("xlb_workq_get(): untargeted: %"PRId64"", wu->id);
-      return wu;
-    }
+    xlb_work_unit* wu = wu_array_remove(untgt_heap_root_val(H));
+    DEBUG("xlb_workq_get(): untargeted: %"PRId64"", wu->id);
+    return wu;
   }
 
   // Clear empty heaps
   if (H->malloced_size > HEAP_FREE_THRESHOLD_UNTARGETED)
   {
-    heap_iu32_clear(H);
+    untgt_heap_clear(H);
   }
   return NULL;
 }
@@ -697,6 +745,7 @@ pop_parallel_cb(struct rbtree_node* node, void* user_data)
 
 adlb_code
 xlb_workq_steal(int max_memory, const int *steal_type_counts,
+                          const int *want_counts,
                           xlb_workq_steal_callback cb)
 {
   // for each type:
@@ -732,14 +781,26 @@ xlb_workq_steal(int max_memory, const int *steal_type_counts,
           par_to_send = 1;
         }
 
-        TRACE("xlb_workq_steal(): stealing type=%i single=%lf of %i par=%i/%i"
-              " This server count: %i versus %i",
-                        t, send_pc, single_count, par_to_send, par_count,
-                        tot_count, stealer_count);
+        // Stealer may want fewer: never send more than the fraction
+        int single_max = -1;
+        if (want_counts[t] >= 0)
+        {
+          // Round up so that at least one is sent
+          single_max = (int)(send_pc * single_count);
+          if (single_max < single_count)
+            single_max++;
+          if (want_counts[t] < single_max)
+            single_max = want_counts[t];
+        }
+
+        TRACE("xlb_workq_steal(): stealing type=%i single=%lf of %i "
+              "(max %i) par=%i/%i This server count: %i versus %i",
+                        t, send_pc, single_count, single_max,
+                        par_to_send, par_count, tot_count, stealer_count);
         adlb_code code;
         int single_sent;
-        code = heap_steal_type(&(untargeted_work[t]), t, send_pc,
-                               &single_sent, cb);
+        code = heap_steal_type(&(untargeted_work[t]), send_pc,
+                               single_max, &single_sent, cb);
         ADLB_CHECK(code);
         code = rbtree_steal_type(&(parallel_work[t]), par_to_send, cb);
         xlb_workq_parallel_task_count -= par_to_send;
@@ -759,37 +820,61 @@ xlb_workq_steal(int max_memory, const int *steal_type_counts,
 /*
  * Steal work of a given type.
  * p: probability of stealing a given task
+ * max: if non-negative, steal this many tasks chosen uniformly
+ *      instead, ignoring p
  * Note: we allow soft-targeted tasks to be stolen.
  */
 static adlb_code
-heap_steal_type(heap_iu32_t *q, int type, double p, int *stolen,
-                xlb_workq_steal_callback cb)
+heap_steal_type(untgt_heap_t *q, double p, int max,
+                int *stolen, xlb_workq_steal_callback cb)
 {
   int p_threshold = (int)(p * RAND_MAX);
   *stolen = 0;
 
+  long size = untgt_heap_size(q);
+  if (size == 0)
+    return ADLB_SUCCESS;
+
   /*
-    Iterate backwards because removing entries sifts them down -
-    best to remove from bottom first
+    Choose entries before removing any: removal moves entries between
+    heap positions
    */
-  for (long i = heap_iu32_size(q) - 1; i >= 0; i--)
+  uint32_t *chosen = malloc(sizeof(chosen[0]) * (size_t)size);
+  ADLB_CHECK_MALLOC(chosen);
+  int count = 0;
+  for (long i = size - 1; i >= 0; i--)
   {
-    if (rand() < p_threshold)
+    bool take;
+    if (max >= 0)
     {
-      int priority = -q->array[i].key;
-      uint32_t wu_idx = q->array[i].val;
-      heap_iu32_del_entry(q, (heap_idx_t)i);
+      // Selection sampling: take (still needed) of (i + 1) remaining
+      if (count >= max)
+        break;
+      take = (double)rand() * (double)(i + 1) <
+             (double)(max - count) * ((double)RAND_MAX + 1.0);
+    }
+    else
+    {
+      take = rand() < p_threshold;
+    }
 
-      xlb_work_unit* wu;
-      wu = wu_array_try_remove_untargeted(wu_idx, type, priority);
-      if (wu != NULL)
-      {
-        adlb_code code = cb.f(cb.data, wu);
-        ADLB_CHECK(code);
-        (*stolen)++;
-      }
+    if (take)
+      chosen[count++] = q->array[i].val;
+  }
+
+  for (int i = 0; i < count; i++)
+  {
+    // Removes heap entry, and targeted entry if soft targeted
+    xlb_work_unit* wu = wu_array_remove(chosen[i]);
+    adlb_code code = cb.f(cb.data, wu);
+    if (ADLB_IS_ERROR(code))
+    {
+      free(chosen);
+      ADLB_CHECK(code);
     }
+    (*stolen)++;
   }
+  free(chosen);
   return ADLB_SUCCESS;
 }
 
@@ -828,7 +913,6 @@ void xlb_workq_type_counts(int *types, int size)
   {
     assert(untargeted_work[t].size >= 0);
     assert(parallel_work[t].size >= 0);
-    // TODO: it's possible that this will miscount because of removed soft-targeted work
     types[t] = (int)untargeted_work[t].size + parallel_work[t].size;
   }
 }
@@ -897,6 +981,57 @@ void xlb_print_workq_perf_counters(void)
     PRINT_COUNTER("worktype_%i_parallel_data_no_wait=%"PRId64"\n",
             t, c->parallel_data_no_wait);
   }
+
+  int64_t untargeted_entries = 0, targeted_entries = 0,
+          host_targeted_entries = 0, heap_bytes = 0;
+  for (int i = 0; i < xlb_s.types_size; i++)
+  {
+    untargeted_entries += untargeted_work[i].size;
+    heap_bytes += untargeted_work[i].malloced_size *
+                  (int64_t)sizeof(untgt_heap_entry_t);
+  }
+  for (int i = 0; i < targeted_work_size; i++)
+  {
+    targeted_entries += targeted_work[i].size;
+    heap_bytes += targeted_work[i].malloced_size *
+                  (int64_t)sizeof(tgt_heap_entry_t);
+  }
+  for (int i = 0; i < host_targeted_work_size; i++)
+  {
+    host_targeted_entries += host_targeted_work[i].size;
+    heap_bytes += host_targeted_work[i].malloced_size *
+                  (int64_t)sizeof(tgt_heap_entry_t);
+  }
+  PRINT_COUNTER("workq_heap_arity=%i\n", XLB_WORKQ_HEAP_ARITY);
+  PRINT_COUNTER("workq_untargeted_heap_entries=%"PRId64"\n",
+                untargeted_entries);
+  PRINT_COUNTER("workq_targeted_heap_entries=%"PRId64"\n",
+                targeted_entries);
+  PRINT_COUNTER("workq_host_targeted_heap_entries=%"PRId64"\n",
+                host_targeted_entries);
+  PRINT_COUNTER("workq_heap_entries_hwm=%"PRId64"\n", heap_entries_hwm);
+  PRINT_COUNTER("workq_heap_bytes=%"PRId64"\n", heap_bytes);
+  // Heaps hold no stale entries: these are the entries that would
+  // have been left stale by lazy removal
+  PRINT_COUNTER("workq_heap_cross_removals=%"PRId64"\n",
+                heap_cross_removals);
+
+  PRINT_COUNTER("work_unit_pool_enabled=%i\n", (int)xlb_wu_pool_enabled);
+  PRINT_COUNTER("work_unit_pool_unpooled=%"PRId64"\n",
+                xlb_wu_pool_unpooled);
+  for (int c = 0; c < XLB_WU_POOL_CLASSES; c++)
+  {
+    xlb_wu_pool_class *pc = &xlb_wu_pool[c];
+    int class_size = XLB_WU_POOL_MIN_PAYLOAD << c;
+    PRINT_COUNTER("work_unit_pool_%i_allocs=%"PRId64"\n",
+                  class_size, pc->allocs);
+    PRINT_COUNTER("work_unit_pool_%i_reused=%"PRId64"\n",
+                  class_size, pc->reused);
+    PRINT_COUNTER("work_unit_pool_%i_in_use_hwm=%"PRId64"\n",
+                  class_size, pc->in_use_hwm);
+    PRINT_COUNTER("work_unit_pool_%i_free_hwm=%i\n",
+                  class_size, pc->free_hwm);
+  }
 }
 
 void
@@ -911,14 +1046,14 @@ xlb_workq_finalize()
   // Clear up targeted_work heaps
   for (int i = 0; i < targeted_work_size; i++)
   {
-    heap_iu32_clear_callback(&targeted_work[i], NULL);
+    tgt_heap_clear(&targeted_work[i]);
   }
   free(targeted_work);
   targeted_work = NULL;
 
   for (int i = 0; i < host_targeted_work_size; i++)
   {
-    heap_iu32_clear_callback(&host_targeted_work[i], NULL);
+    tgt_heap_clear(&host_targeted_work[i]);
   }
   free(host_targeted_work);
   host_targeted_work = NULL;
@@ -926,7 +1061,7 @@ xlb_workq_finalize()
   // Clear up untargeted_work heaps
   for (int i = 0; i < xlb_s.types_size; i++)
   {
-    heap_iu32_clear_callback(&untargeted_work[i], NULL);
+    untgt_heap_clear(&untargeted_work[i]);
   }
   free(untargeted_work);
   untargeted_work = NULL;
@@ -949,5 +1084,58 @@ xlb_workq_finalize()
     free(xlb_task_counters);
     xlb_task_counters = NULL;
   }
+
+  wu_pool_finalize();
   TRACE_END;
 }
+
+static adlb_code wu_pool_init(void)
+{
+  getenv_boolean("ADLB_WORK_UNIT_POOL", true, &xlb_wu_pool_enabled);
+
+  long max_free = XLB_WU_POOL_MAX_FREE_DEFAULT;
+  adlb_code ac = xlb_env_long("ADLB_WORK_UNIT_POOL_MAX", &max_free);
+  ADLB_CHECK(ac);
+  ADLB_CHECK_MSG(max_free >= 0 && max_free <= INT_MAX,
+                 "ADLB_WORK_UNIT_POOL_MAX out of range: %li", max_free);
+  xlb_wu_pool_max_free = (int)max_free;
+
+  DEBUG("Work unit pool: %s max_free: %i",
+        xlb_wu_pool_enabled ? "enabled" : "disabled",
+        xlb_wu_pool_max_free);
+
+  for (int c = 0; c < XLB_WU_POOL_CLASSES; c++)
+  {
+    xlb_wu_pool_class *pc = &xlb_wu_pool[c];
+    pc->free_list = NULL;
+    pc->free_count = 0;
+    pc->free_hwm = 0;
+    pc->allocs = 0;
+    pc->reused = 0;
+    pc->in_use = 0;
+    pc->in_use_hwm = 0;
+  }
+  xlb_wu_pool_unpooled = 0;
+
+  return ADLB_SUCCESS;
+}
+
+/*
+  Release cached work units.  Work units freed after this point
+  are released with free().
+ */
+static void wu_pool_finalize(void)
+{
+  xlb_wu_pool_max_free = 0;
+  for (int c = 0; c < XLB_WU_POOL_CLASSES; c++)
+  {
+    xlb_wu_pool_class *pc = &xlb_wu_pool[c];
+    while (pc->free_list != NULL)
+    {
+      void *next = *(void**)pc->free_list;
+      free(pc->free_list);
+      pc->free_list = next;
+    }
+    pc->free_count = 0;
+  }
+}
@@ -26,6 +26,8 @@
 #define WORKQUEUE_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
 
 #include "adlb-defs.h"
 
@@ -52,6 +54,8 @@ typedef struct
   int target;
   /** Length of item */
   int length;
+  /** Pool size class of allocation, or XLB_WU_POOL_NONE */
+  int8_t pool_class;
   /** Additional flags */
   adlb_put_opts opts;
 
@@ -73,11 +77,101 @@ static inline xlb_work_unit_id xlb_workq_unique(void)
   return xlb_workq_next_id++;
 }
 
+/*
+ * Work unit pool: freed work units with small payloads are kept on
+ * per-size-class free lists for reuse, to avoid malloc/free on
+ * every task passing through the server.  Size classes are powers
+ * of two from XLB_WU_POOL_MIN_PAYLOAD to XLB_WU_POOL_MAX_PAYLOAD bytes
+ * of payload.  Larger work units are allocated with malloc.
+ * The pool can be disabled with ADLB_WORK_UNIT_POOL=0
+ */
+#define XLB_WU_POOL_MIN_PAYLOAD 64
+#define XLB_WU_POOL_MAX_PAYLOAD 1024
+#define XLB_WU_POOL_CLASSES 5
+#define XLB_WU_POOL_NONE (-1)
+
+typedef struct
+{
+  /** Free work units, linked through first word */
+  void *free_list;
+  /** Length of free list */
+  int free_count;
+  /** Maximum length of free list reached */
+  int free_hwm;
+
+  /** Total allocations in this class */
+  int64_t allocs;
+  /** Allocations served from free list */
+  int64_t reused;
+  /** Work units currently allocated */
+  int64_t in_use;
+  /** Maximum of in_use */
+  int64_t in_use_hwm;
+} xlb_wu_pool_class;
+
+/** Whether new work units are allocated from pool */
+extern bool xlb_wu_pool_enabled;
+
+/** Maximum number of cached free work units per size class */
+extern int xlb_wu_pool_max_free;
+
+extern xlb_wu_pool_class xlb_wu_pool[XLB_WU_POOL_CLASSES];
+
+/** Work units allocated with malloc because too large */
+extern int64_t xlb_wu_pool_unpooled;
+
+/** Find size class for payload, or XLB_WU_POOL_NONE if too large */
+static inline int xlb_wu_pool_class_of(size_t payload_length)
+{
+  size_t class_size = XLB_WU_POOL_MIN_PAYLOAD;
+  for (int c = 0; c < XLB_WU_POOL_CLASSES; c++)
+  {
+    if (payload_length <= class_size)
+      return c;
+    class_size *= 2;
+  }
+  return XLB_WU_POOL_NONE;
+}
+
 /** Allocate work unit with space for payload */
 static inline xlb_work_unit *work_unit_alloc(size_t payload_length)
 {
-  // Allocate header struct plus following array
-  return malloc(sizeof(xlb_work_unit) + payload_length);
+  xlb_work_unit *wu;
+  int c = xlb_wu_pool_enabled ?
+          xlb_wu_pool_class_of(payload_length) : XLB_WU_POOL_NONE;
+  if (c == XLB_WU_POOL_NONE)
+  {
+    // Allocate header struct plus following array
+    wu = malloc(sizeof(xlb_work_unit) + payload_length);
+    if (wu == NULL)
+      return NULL;
+    xlb_wu_pool_unpooled++;
+  }
+  else
+  {
+    xlb_wu_pool_class *pc = &xlb_wu_pool[c];
+    if (pc->free_list != NULL)
+    {
+      wu = pc->free_list;
+      pc->free_list = *(void**)wu;
+      pc->free_count--;
+      pc->reused++;
+    }
+    else
+    {
+      // Allocate enough for any payload in class
+      wu = malloc(sizeof(xlb_work_unit) +
+                  ((size_t)XLB_WU_POOL_MIN_PAYLOAD << c));
+      if (wu == NULL)
+        return NULL;
+    }
+    pc->allocs++;
+    pc->in_use++;
+    if (pc->in_use > pc->in_use_hwm)
+      pc->in_use_hwm = pc->in_use;
+  }
+  wu->pool_class = (int8_t)c;
+  return wu;
 }
 
 /** Initialize work unit fields, aside from payload */
@@ -130,10 +224,13 @@ typedef struct {
 
 /*
  * steal_type_counts: counts that stealer has of each type
+ * want_counts: max number of single-worker units to send of each type,
+ *              or -1 to send a fixed fraction of the imbalance
  * callback: called for every stolen unit.  The callback
             function is responsible for freeing work unit
  */
 adlb_code xlb_workq_steal(int max_memory, const int *steal_type_counts,
+                      const int *want_counts,
                       xlb_workq_steal_callback cb);
 
 /* present should be an array of size >= number of request types
@@ -147,7 +244,26 @@ void xlb_workq_type_counts(int *types, int size);
 
 static inline void xlb_work_unit_free(xlb_work_unit* wu)
 {
-  free(wu);
+  if (wu == NULL || wu->pool_class == XLB_WU_POOL_NONE)
+  {
+    free(wu);
+    return;
+  }
+
+  xlb_wu_pool_class *pc = &xlb_wu_pool[wu->pool_class];
+  pc->in_use--;
+  if (pc->free_count < xlb_wu_pool_max_free)
+  {
+    *(void**)wu = pc->free_list;
+    pc->free_list = wu;
+    pc->free_count++;
+    if (pc->free_count > pc->free_hwm)
+      pc->free_hwm = pc->free_count;
+  }
+  else
+  {
+    free(wu);
+  }
 }
 
 void xlb_print_workq_perf_counters(void);
@@ -0,0 +1,478 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * write_buffer.c
+ *
+ * Client-side write-behind buffer for small stores and refcount
+ * decrements.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include <mpi.h>
+
+#include <rhtable_lp.h>
+#include <tools.h>
+
+#include "checks.h"
+#include "client_internal.h"
+#include "common.h"
+#include "debug.h"
+#include "messaging.h"
+#include "notifications.h"
+#include "write_buffer.h"
+
+#define XLB_WRITE_BUFFER_SIZE_DEFAULT (32 * 1024)
+#define XLB_WRITE_BUFFER_DELAY_DEFAULT 0.1
+
+/** Size of record for refcount decrement */
+#define REFC_REC_SIZE PACKED_BATCH_PAD(sizeof(struct packed_store_batch_rec))
+
+/** Pending refcount decrement for one ID */
+typedef struct
+{
+  adlb_datum_id id;
+  adlb_refc decr;
+} refc_decr;
+
+/** Buffered operations for one server */
+typedef struct
+{
+  /** packed_batch_hdr followed by records, NULL if not yet used */
+  char *data;
+  /** Bytes used in data, including header */
+  size_t length;
+
+  /** Refcount decrements, one per ID, appended to data when sent.
+      Space for their records is reserved in data */
+  refc_decr *decrs;
+  int decr_count;
+  int decr_size;
+  /** Map from ID to index in decrs */
+  rhtable_lp decr_index;
+} server_buffer;
+
+int xlb_write_buffer_pending = 0;
+
+/** Per-server buffers, indexed by server number.  Size in bytes of
+    each buffer, or 0 if buffering disabled */
+static server_buffer *buffers = NULL;
+static size_t buffer_size = 0;
+
+/** Max seconds to hold an operation in the buffer */
+static double max_delay = XLB_WRITE_BUFFER_DELAY_DEFAULT;
+
+/** Time first currently pending operation was buffered */
+static double oldest_time;
+
+/* Statistics */
+static int64_t ops_buffered = 0;
+static int64_t ops_direct = 0;
+static int64_t decrs_merged = 0;
+static int64_t batches_sent = 0;
+
+static adlb_code flush_server(int server, adlb_notif_t *notifs);
+
+adlb_code
+xlb_write_buffer_init(void)
+{
+  long size = XLB_WRITE_BUFFER_SIZE_DEFAULT;
+  adlb_code ac = xlb_env_long("ADLB_WRITE_BUFFER_SIZE", &size);
+  ADLB_CHECK(ac);
+  ADLB_CHECK_MSG(size >= 0, "ADLB_WRITE_BUFFER_SIZE negative: %li",
+                 size);
+
+  // Server receives batch into xfer buffer
+  if (size > ADLB_XFER_SIZE)
+    size = ADLB_XFER_SIZE;
+
+  bool ok = getenv_double("ADLB_WRITE_BUFFER_DELAY",
+                          XLB_WRITE_BUFFER_DELAY_DEFAULT, &max_delay);
+  ADLB_CHECK_MSG(ok && max_delay >= 0.0,
+                 "Invalid ADLB_WRITE_BUFFER_DELAY");
+
+  xlb_write_buffer_pending = 0;
+  buffers = NULL;
+  buffer_size = 0;
+
+  // Servers apply operations immediately
+  if (size == 0 || xlb_s.layout.am_server)
+  {
+    DEBUG("Write buffer: disabled");
+    return ADLB_SUCCESS;
+  }
+
+  buffer_size = (size_t)size;
+  buffers = calloc((size_t)xlb_s.layout.servers, sizeof(buffers[0]));
+  ADLB_CHECK_MALLOC(buffers);
+
+  DEBUG("Write buffer: size: %zu delay: %f", buffer_size, max_delay);
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_write_buffer_finalize(void)
+{
+  adlb_code rc = xlb_write_buffer_sync();
+  ADLB_CHECK(rc);
+
+  if (buffers != NULL)
+  {
+    PRINT_COUNTER("write_buffer_ops=%"PRId64, ops_buffered);
+    PRINT_COUNTER("write_buffer_direct_ops=%"PRId64, ops_direct);
+    PRINT_COUNTER("write_buffer_decrs_merged=%"PRId64, decrs_merged);
+    PRINT_COUNTER("write_buffer_batches=%"PRId64, batches_sent);
+
+    for (int i = 0; i < xlb_s.layout.servers; i++)
+    {
+      server_buffer *b = &buffers[i];
+      if (b->data != NULL)
+      {
+        free(b->data);
+        free(b->decrs);
+        rhtable_lp_free_callback(&b->decr_index, false, NULL);
+      }
+    }
+    free(buffers);
+    buffers = NULL;
+  }
+  buffer_size = 0;
+  return ADLB_SUCCESS;
+}
+
+/**
+  Make space for a record of rec_size bytes in the buffer for the
+  server that owns id, sending buffered operations to that server
+  first if needed.
+  b: set to buffer, or NULL if the record can't be buffered
+ */
+static adlb_code
+reserve_space(adlb_datum_id id, size_t rec_size, server_buffer **b_out)
+{
+  *b_out = NULL;
+  if (buffers == NULL ||
+      sizeof(struct packed_batch_hdr) + rec_size > buffer_size)
+  {
+    return ADLB_SUCCESS;
+  }
+
+  int server = ADLB_Locate(id) - xlb_s.layout.workers;
+  server_buffer *b = &buffers[server];
+
+  if (b->data == NULL)
+  {
+    b->data = malloc(buffer_size);
+    ADLB_CHECK_MALLOC(b->data);
+    b->length = sizeof(struct packed_batch_hdr);
+    ((struct packed_batch_hdr*)b->data)->count = 0;
+
+    b->decrs = NULL;
+    b->decr_count = b->decr_size = 0;
+    bool ok = rhtable_lp_init(&b->decr_index, 16);
+    ADLB_CHECK_MSG(ok, "Could not allocate table");
+  }
+  else if (b->length + REFC_REC_SIZE * (size_t)b->decr_count + rec_size
+           > buffer_size)
+  {
+    adlb_notif_t notifs = ADLB_NO_NOTIFS;
+    adlb_code rc = flush_server(server, &notifs);
+    if (rc == ADLB_SUCCESS || rc == ADLB_REJECTED)
+    {
+      adlb_code rc2 = xlb_notify_all(&notifs);
+      ADLB_CHECK(rc2);
+    }
+    xlb_free_notif(&notifs);
+    if (rc != ADLB_SUCCESS)
+    {
+      return rc;
+    }
+  }
+
+  if (xlb_write_buffer_pending == 0)
+  {
+    oldest_time = MPI_Wtime();
+  }
+
+  xlb_write_buffer_pending++;
+  ops_buffered++;
+  *b_out = b;
+  return ADLB_SUCCESS;
+}
+
+/**
+  Find space for a record in the buffer for the server that owns id.
+  rec: set to location for record, or NULL if it can't be buffered
+ */
+static adlb_code
+reserve(adlb_datum_id id, size_t rec_size, char **rec)
+{
+  server_buffer *b;
+  adlb_code rc = reserve_space(id, rec_size, &b);
+  ADLB_CHECK(rc);
+
+  *rec = NULL;
+  if (b != NULL)
+  {
+    *rec = b->data + b->length;
+    b->length += rec_size;
+    ((struct packed_batch_hdr*)b->data)->count++;
+  }
+  return ADLB_SUCCESS;
+}
+
+/**
+  Flush everything if the oldest buffered operation is too old
+ */
+static inline adlb_code
+check_delay(void)
+{
+  if (xlb_write_buffer_pending > 0 &&
+      MPI_Wtime() - oldest_time >= max_delay)
+  {
+    return xlb_write_buffer_flush();
+  }
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_write_buffer_store(adlb_datum_id id, adlb_subscript subscript,
+      adlb_data_type type, const void *data, size_t length,
+      adlb_refc refcount_decr, adlb_refc store_refcounts)
+{
+  adlb_code rc;
+
+  ADLB_CHECK_MSG(length < ADLB_DATA_MAX,
+            "ADLB_Store(): value too long: %llu max: %llu\n",
+            (long long unsigned) length, ADLB_DATA_MAX);
+
+  size_t sub_len = adlb_has_sub(subscript) ? subscript.length : 0;
+  size_t rec_size =
+      PACKED_BATCH_PAD(sizeof(struct packed_store_batch_rec)) +
+      PACKED_BATCH_PAD(length + sub_len);
+
+  char *rec;
+  rc = reserve(id, rec_size, &rec);
+  ADLB_CHECK(rc);
+
+  if (rec == NULL)
+  {
+    // Send directly, after any operations already buffered
+    ops_direct++;
+    rc = xlb_write_buffer_sync();
+    ADLB_CHECK(rc);
+
+    adlb_notif_t notifs = ADLB_NO_NOTIFS;
+    adlb_code final_rc = xlb_store(id, subscript, type, data, length,
+                          refcount_decr, store_refcounts, &notifs);
+    ADLB_CHECK(final_rc);
+
+    rc = xlb_notify_all(&notifs);
+    ADLB_CHECK(rc);
+
+    xlb_free_notif(&notifs);
+    return final_rc;
+  }
+
+  struct packed_store_batch_rec *r = (struct packed_store_batch_rec*)rec;
+  r->hdr.id = id;
+  r->hdr.type = type;
+  r->hdr.length = length;
+  r->hdr.subscript_len = sub_len;
+  r->hdr.refcount_decr = refcount_decr;
+  r->hdr.store_refcounts = store_refcounts;
+  r->store = true;
+
+  char *pos = rec + PACKED_BATCH_PAD(sizeof(*r));
+  memcpy(pos, data, length);
+  if (sub_len > 0)
+  {
+    memcpy(pos + length, subscript.key, sub_len);
+  }
+
+  return check_delay();
+}
+
+adlb_code
+xlb_write_buffer_refc_decr(adlb_datum_id id, adlb_refc decr)
+{
+  adlb_code rc;
+
+  if (!xlb_s.read_refc_enabled)
+    decr.read_refcount = 0;
+
+  if (ADLB_REFC_IS_NULL(decr))
+    return ADLB_SUCCESS;
+
+  if (buffers != NULL)
+  {
+    // Merge with pending decrement of same ID
+    server_buffer *b = &buffers[ADLB_Locate(id) - xlb_s.layout.workers];
+    void *tmp;
+    if (b->data != NULL && rhtable_lp_search(&b->decr_index, id, &tmp))
+    {
+      refc_decr *d = &b->decrs[(long)tmp];
+      assert(d->id == id);
+      d->decr.read_refcount += decr.read_refcount;
+      d->decr.write_refcount += decr.write_refcount;
+      decrs_merged++;
+      return check_delay();
+    }
+  }
+
+  server_buffer *b;
+  rc = reserve_space(id, REFC_REC_SIZE, &b);
+  ADLB_CHECK(rc);
+
+  if (b == NULL)
+  {
+    ops_direct++;
+    rc = xlb_write_buffer_sync();
+    ADLB_CHECK(rc);
+
+    adlb_notif_t notifs = ADLB_NO_NOTIFS;
+    rc = xlb_refcount_incr(id, adlb_refc_negate(decr), &notifs);
+    ADLB_CHECK(rc);
+
+    rc = xlb_notify_all(&notifs);
+    ADLB_CHECK(rc);
+
+    xlb_free_notif(&notifs);
+    return ADLB_SUCCESS;
+  }
+
+  if (b->decr_count == b->decr_size)
+  {
+    int new_size = (b->decr_size == 0) ? 16 : b->decr_size * 2;
+    refc_decr *tmp = realloc(b->decrs, sizeof(b->decrs[0]) *
+                                       (size_t)new_size);
+    ADLB_CHECK_MALLOC(tmp);
+    b->decrs = tmp;
+    b->decr_size = new_size;
+  }
+
+  long ix = b->decr_count++;
+  b->decrs[ix].id = id;
+  b->decrs[ix].decr = decr;
+  bool ok = rhtable_lp_add(&b->decr_index, id, (void*)ix);
+  ADLB_CHECK_MSG(ok, "Could not add to table");
+
+  return check_delay();
+}
+
+/**
+  Append records for pending refcount decrements to buffer.  They go
+  after all stores, so are never applied earlier than requested.
+ */
+static void
+append_decrs(server_buffer *b)
+{
+  struct packed_batch_hdr *hdr = (struct packed_batch_hdr*)b->data;
+  for (int i = 0; i < b->decr_count; i++)
+  {
+    struct packed_store_batch_rec *r =
+          (struct packed_store_batch_rec*)(b->data + b->length);
+    memset(r, 0, sizeof(*r));
+    r->hdr.id = b->decrs[i].id;
+    r->hdr.refcount_decr = b->decrs[i].decr;
+    r->store = false;
+    b->length += REFC_REC_SIZE;
+    hdr->count++;
+  }
+  assert(b->length <= buffer_size);
+  b->decr_count = 0;
+  rhtable_lp_clear(&b->decr_index);
+}
+
+/**
+  Send buffered operations to server and reset its buffer.
+  Notifications are added to notifs, also if the batch failed.
+  return ADLB_REJECTED if any store was a double write
+ */
+static adlb_code
+flush_server(int server, adlb_notif_t *notifs)
+{
+  MPI_Status status;
+  MPI_Request request;
+
+  server_buffer *b = &buffers[server];
+  struct packed_batch_hdr *hdr = (struct packed_batch_hdr*)b->data;
+  if (hdr == NULL || (hdr->count == 0 && b->decr_count == 0))
+  {
+    return ADLB_SUCCESS;
+  }
+  append_decrs(b);
+
+  int to_server_rank = server + xlb_s.layout.workers;
+  DEBUG("Write buffer: flush %i ops to %i", hdr->count, to_server_rank);
+
+  struct packed_store_resp resp;
+  IRECV(&resp, sizeof(resp), MPI_BYTE, to_server_rank,
+        ADLB_TAG_RESPONSE);
+  SEND(b->data, (int)b->length, MPI_BYTE, to_server_rank,
+       ADLB_TAG_STORE_BATCH);
+  WAIT(&request, &status);
+
+  xlb_write_buffer_pending -= hdr->count;
+  assert(xlb_write_buffer_pending >= 0);
+  hdr->count = 0;
+  b->length = sizeof(struct packed_batch_hdr);
+  batches_sent++;
+
+  // Server sends notifications for applied operations even on failure
+  adlb_code rc = xlb_recv_notif_work(&resp.notifs, to_server_rank,
+                                     notifs);
+  ADLB_CHECK(rc);
+
+  if (resp.dc == ADLB_DATA_ERROR_DOUBLE_WRITE)
+  {
+    // Other operations in batch were applied
+    return ADLB_REJECTED;
+  }
+  ADLB_DATA_CHECK(resp.dc);
+
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+xlb_write_buffer_flush(void)
+{
+  adlb_code rc = ADLB_SUCCESS;
+  if (xlb_write_buffer_pending == 0)
+  {
+    return ADLB_SUCCESS;
+  }
+
+  // Empty all buffers before processing notifications, which may
+  // trigger more data operations.  Notifications for applied
+  // operations are delivered before reporting any failure.
+  adlb_notif_t notifs = ADLB_NO_NOTIFS;
+  for (int i = 0; i < xlb_s.layout.servers; i++)
+  {
+    adlb_code rc2 = flush_server(i, &notifs);
+    if (ADLB_IS_ERROR(rc2) || rc == ADLB_SUCCESS)
+      rc = rc2;
+  }
+  assert(xlb_write_buffer_pending == 0);
+
+  adlb_code rc2 = xlb_notify_all(&notifs);
+  ADLB_CHECK(rc2);
+
+  xlb_free_notif(&notifs);
+  ADLB_CHECK(rc);
+  return rc;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * write_buffer.h
+ *
+ * Client-side write-behind buffer for small stores and refcount
+ * decrements.
+ *
+ * Buffered operations are packed per destination server and sent as
+ * a single ADLB_TAG_STORE_BATCH message when the buffer for that
+ * server fills, when the oldest buffered operation is older than
+ * ADLB_WRITE_BUFFER_DELAY seconds, when the client asks for its next
+ * task, or before any unbuffered data operation from this client, so
+ * that a client always observes its own writes.
+ *
+ * Refcount decrements of the same ID are merged while buffered, and
+ * sent after the buffered stores, so a decrement is only ever applied
+ * later than requested.  Increments are never buffered, since applying
+ * them late could free data early.
+ *
+ * ADLB_WRITE_BUFFER_SIZE sets the per-server buffer size in bytes;
+ * 0 disables buffering, so buffered operations are sent immediately.
+ */
+
+#ifndef XLB_WRITE_BUFFER_H
+#define XLB_WRITE_BUFFER_H
+
+#include "adlb-defs.h"
+#include "checks.h"
+
+/** Number of operations currently buffered */
+extern int xlb_write_buffer_pending;
+
+adlb_code xlb_write_buffer_init(void);
+
+adlb_code xlb_write_buffer_finalize(void);
+
+/**
+  Buffer store, or send immediately if buffering is not possible.
+  ADLB_REJECTED for a double write may be reported by a later flush.
+ */
+adlb_code xlb_write_buffer_store(adlb_datum_id id,
+      adlb_subscript subscript, adlb_data_type type,
+      const void *data, size_t length,
+      adlb_refc refcount_decr, adlb_refc store_refcounts);
+
+/**
+  Buffer decrement of refcounts by decr, merging with any buffered
+  decrement of the same ID
+ */
+adlb_code xlb_write_buffer_refc_decr(adlb_datum_id id, adlb_refc decr);
+
+/**
+  Send all buffered operations and process resulting notifications
+ */
+adlb_code xlb_write_buffer_flush(void);
+
+/**
+  Flush if anything is buffered.  Cheap enough to call before every
+  client data operation.
+ */
+static inline adlb_code
+xlb_write_buffer_sync(void)
+{
+  if (xlb_write_buffer_pending == 0)
+  {
+    return ADLB_SUCCESS;
+  }
+  return xlb_write_buffer_flush();
+}
+
+/**
+  Flush before a client operation.  A rejected buffered store can no
+  longer be reported to the caller that made it, so is an error here.
+ */
+#define XLB_WRITE_BUFFER_SYNC() {                               \
+    adlb_code _wb_rc = xlb_write_buffer_sync();                 \
+    ADLB_CHECK_MSG(_wb_rc == ADLB_SUCCESS,                      \
+                   "Buffered write failed: code %i", _wb_rc); }
+
+#endif // XLB_WRITE_BUFFER_H
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+
+/*
+ * closed-summary.c
+ *
+ * Test data-dependent tasks on data owned by other servers, so that
+ * servers exchange summaries of closed data.  Each worker puts tasks
+ * in rounds on data that another worker already closed, and on data
+ * that is closed only later.  Each task checks that its input is set.
+ * IDs from ADLB_Unique() among the closed data are never closed, and
+ * are enough to slide the summary window, so servers must age them
+ * out of their summaries.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <mpi.h>
+#include <adlb.h>
+
+#include "common/api_checks.h"
+
+#define CLOSED_PER_WORKER 4000
+#define OPEN_PER_WORKER 200
+#define ROUNDS 10
+/** ADLB_Unique() calls per closed datum created */
+#define UNIQUE_PER_CLOSED 4
+
+static void
+create_ints(adlb_datum_id *ids, int count, int uniques)
+{
+  for (int i = 0; i < count; i++)
+  {
+    adlb_code rc = ADLB_Create_integer(ADLB_DATA_ID_NULL,
+                            DEFAULT_CREATE_PROPS, &ids[i]);
+    check(rc, "ADLB_Create_integer");
+    for (int j = 0; j < uniques; j++)
+    {
+      adlb_datum_id unique;
+      rc = ADLB_Unique(&unique);
+      check(rc, "ADLB_Unique");
+    }
+  }
+}
+
+static void
+store_ints(const adlb_datum_id *ids, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    int64_t val = ids[i];
+    adlb_code rc = ADLB_Store(ids[i], ADLB_NO_SUB,
+            ADLB_DATA_TYPE_INTEGER, &val, sizeof(val),
+            ADLB_WRITE_REFC, ADLB_NO_REFC);
+    check(rc, "ADLB_Store");
+  }
+}
+
+static void
+put_task(adlb_datum_id id, int rank)
+{
+  adlb_code rc = ADLB_Dput(&id, sizeof(id), ADLB_RANK_ANY, rank, 0,
+                   ADLB_DEFAULT_PUT_OPTS, "wait", &id, 1, NULL, 0);
+  check(rc, "ADLB_Dput");
+}
+
+int
+main()
+{
+  int mpi_argc = 0;
+  char** mpi_argv = NULL;
+  MPI_Init(&mpi_argc, &mpi_argv);
+  int types[1] = {0};
+  int nservers = 2;
+  int am_server;
+  MPI_Comm adlb_comm = MPI_COMM_WORLD;
+  MPI_Comm worker_comm;
+  adlb_code rc = ADLB_Init(nservers, 1, types, &am_server, adlb_comm,
+                           &worker_comm);
+  check(rc, "ADLB_Init");
+
+  if (am_server)
+  {
+    rc = ADLB_Server(1);
+    check(rc, "ADLB_Server");
+  }
+  else
+  {
+    int rank, nworkers;
+    MPI_Comm_rank(worker_comm, &rank);
+    MPI_Comm_size(worker_comm, &nworkers);
+    int other = (rank + 1) % nworkers;
+
+    static adlb_datum_id closed[CLOSED_PER_WORKER];
+    static adlb_datum_id open[OPEN_PER_WORKER];
+    create_ints(closed, CLOSED_PER_WORKER, UNIQUE_PER_CLOSED);
+    create_ints(open, OPEN_PER_WORKER, 0);
+    store_ints(closed, CLOSED_PER_WORKER);
+
+    adlb_datum_id *all_closed = malloc(sizeof(adlb_datum_id) *
+                          CLOSED_PER_WORKER * (size_t)nworkers);
+    adlb_datum_id *all_open = malloc(sizeof(adlb_datum_id) *
+                          OPEN_PER_WORKER * (size_t)nworkers);
+    MPI_Allgather(closed, CLOSED_PER_WORKER, MPI_INT64_T,
+                  all_closed, CLOSED_PER_WORKER, MPI_INT64_T, worker_comm);
+    MPI_Allgather(open, OPEN_PER_WORKER, MPI_INT64_T,
+                  all_open, OPEN_PER_WORKER, MPI_INT64_T, worker_comm);
+
+    // Different inputs each round, so closed caches don't help
+    const adlb_datum_id *other_closed =
+                      &all_closed[other * CLOSED_PER_WORKER];
+    int per_round = CLOSED_PER_WORKER / ROUNDS;
+    for (int round = 0; round < ROUNDS; round++)
+    {
+      for (int i = round * per_round; i < (round + 1) * per_round; i++)
+      {
+        put_task(other_closed[i], rank);
+      }
+      // Give servers time to exchange summaries
+      usleep(20000);
+    }
+
+    const adlb_datum_id *other_open = &all_open[other * OPEN_PER_WORKER];
+    for (int i = 0; i < OPEN_PER_WORKER; i++)
+    {
+      put_task(other_open[i], rank);
+    }
+
+    MPI_Barrier(worker_comm);
+    store_ints(open, OPEN_PER_WORKER);
+
+    int received = 0;
+    while (true)
+    {
+      void *payload = NULL;
+      int len = 1024, answer, work_type;
+      MPI_Comm task_comm;
+      rc = ADLB_Get(0, &payload, &len, 1024, &answer, &work_type,
+                    &task_comm);
+      if (rc == ADLB_SHUTDOWN)
+        break;
+      check(rc, "ADLB_Get");
+      assert(len == sizeof(adlb_datum_id));
+
+      // Input must have been set before task was released
+      adlb_datum_id id;
+      memcpy(&id, payload, sizeof(id));
+      int64_t val = -1;
+      adlb_data_type type;
+      size_t length;
+      rc = ADLB_Retrieve(id, ADLB_NO_SUB, ADLB_RETRIEVE_NO_REFC,
+                         &type, &val, &length);
+      check(rc, "ADLB_Retrieve");
+      assert(length == sizeof(val) && val == id);
+
+      received++;
+      free(payload);
+    }
+
+    int total;
+    MPI_Reduce(&received, &total, 1, MPI_INT, MPI_SUM, 0, worker_comm);
+    if (rank == 0)
+    {
+      int expected = (CLOSED_PER_WORKER + OPEN_PER_WORKER) * nworkers;
+      printf("received: %i expected: %i\n", total, expected);
+      if (total != expected)
+      {
+        printf("FAILED\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+      }
+    }
+    free(all_closed);
+    free(all_open);
+  }
+
+  ADLB_Finalize();
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * api_checks.h
+ *
+ * Error checks for tests of the ADLB API
+ */
+
+#ifndef __API_CHECKS_H
+#define __API_CHECKS_H
+
+#include <stdio.h>
+
+#include <mpi.h>
+#include <adlb.h>
+
+/*
+  Abort all ranks unless rc is ADLB_SUCCESS
+  what: name of failed operation to print
+ */
+static inline void check(adlb_code rc, const char *what)
+{
+  if (rc != ADLB_SUCCESS)
+  {
+    printf("%s failed: %i\n", what, rc);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+}
+
+#endif
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+
+/*
+ * dense-container.c
+ *
+ * Test integer-keyed containers with Turbine-style decimal string
+ * subscripts, which are stored densely: members inserted out of order,
+ * subscripts reserved before being set, and containers that must be
+ * converted to hash tables by a sparse or non-canonical subscript.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include <adlb.h>
+#include <adlb_types.h>
+
+#include "common/api_checks.h"
+
+#define MEMBERS 5000
+
+static adlb_subscript
+make_sub(const char *key)
+{
+  adlb_subscript sub = { .key = key, .length = strlen(key) + 1 };
+  return sub;
+}
+
+static void
+store(adlb_datum_id id, const char *key, int64_t val)
+{
+  adlb_code rc = ADLB_Store(id, make_sub(key), ADLB_DATA_TYPE_INTEGER,
+            &val, sizeof(val), ADLB_NO_REFC, ADLB_NO_REFC);
+  check(rc, "ADLB_Store");
+}
+
+static void
+store_int_key(adlb_datum_id id, int key, int64_t val)
+{
+  char buf[32];
+  sprintf(buf, "%i", key);
+  store(id, buf, val);
+}
+
+static int64_t
+lookup(adlb_datum_id id, const char *key)
+{
+  adlb_data_type type;
+  int64_t val;
+  size_t length;
+  adlb_code rc = ADLB_Retrieve(id, make_sub(key), ADLB_RETRIEVE_NO_REFC,
+                               &type, &val, &length);
+  check(rc, "ADLB_Retrieve");
+  assert(type == ADLB_DATA_TYPE_INTEGER && length == sizeof(val));
+  return val;
+}
+
+static adlb_datum_id
+create(void)
+{
+  adlb_datum_id id;
+  adlb_code rc = ADLB_Create_container(ADLB_DATA_ID_NULL,
+        ADLB_DATA_TYPE_INTEGER, ADLB_DATA_TYPE_INTEGER,
+        DEFAULT_CREATE_PROPS, &id);
+  check(rc, "ADLB_Create_container");
+  return id;
+}
+
+/*
+  Check container has members 0..count-1 with value key*10 and
+  return keys in enumeration order
+ */
+static void
+check_members(adlb_datum_id id, int count, int *keys)
+{
+  void *data = NULL;
+  size_t length;
+  int records;
+  adlb_type_extra kv_type;
+  adlb_code rc = ADLB_Enumerate(id, -1, 0, ADLB_NO_REFC, true, true,
+                    &data, &length, &records, &kv_type);
+  check(rc, "ADLB_Enumerate");
+  assert(records == count);
+
+  size_t pos = 0;
+  for (int i = 0; i < records; i++)
+  {
+    const void *key, *val;
+    size_t key_len, val_len;
+    adlb_data_code dc = ADLB_Unpack_buffer(ADLB_DATA_TYPE_NULL, data,
+                              length, &pos, &key, &key_len);
+    assert(dc == ADLB_DATA_SUCCESS);
+    dc = ADLB_Unpack_buffer(ADLB_DATA_TYPE_INTEGER, data, length, &pos,
+                            &val, &val_len);
+    assert(dc == ADLB_DATA_SUCCESS);
+    assert(key_len == strlen(key) + 1);
+    keys[i] = atoi(key);
+    int64_t v;
+    memcpy(&v, val, sizeof(v));
+    assert(v == keys[i] * 10);
+  }
+  free(data);
+}
+
+int
+main()
+{
+  int mpi_argc = 0;
+  char** mpi_argv = NULL;
+  MPI_Init(&mpi_argc, &mpi_argv);
+  int types[1] = {0};
+  int nservers = 2;
+  int am_server;
+  MPI_Comm adlb_comm = MPI_COMM_WORLD;
+  MPI_Comm worker_comm;
+  adlb_code rc = ADLB_Init(nservers, 1, types, &am_server, adlb_comm,
+                           &worker_comm);
+  check(rc, "ADLB_Init");
+
+  if (am_server)
+  {
+    rc = ADLB_Server(1);
+    check(rc, "ADLB_Server");
+  }
+  else
+  {
+    int *keys = malloc(sizeof(int) * (MEMBERS + 1));
+
+    // Out of order, as from parallel loop
+    adlb_datum_id dense = create();
+    for (int i = 0; i < MEMBERS; i += 2)
+    {
+      int key = (i + 97) % MEMBERS;
+      key -= key % 2;
+      store_int_key(dense, key + 1, (key + 1) * 10);
+    }
+    for (int i = MEMBERS - 2; i >= 0; i -= 2)
+      store_int_key(dense, i, i * 10);
+    assert(lookup(dense, "0") == 0);
+    assert(lookup(dense, "4999") == 49990);
+
+    // Reserve subscript, then set it
+    bool created, value_present;
+    rc = ADLB_Insert_atomic(dense, make_sub("5000"), ADLB_RETRIEVE_NO_REFC,
+            &created, &value_present, NULL, NULL, NULL);
+    check(rc, "ADLB_Insert_atomic");
+    assert(created && !value_present);
+    rc = ADLB_Insert_atomic(dense, make_sub("5000"), ADLB_RETRIEVE_NO_REFC,
+            &created, &value_present, NULL, NULL, NULL);
+    check(rc, "ADLB_Insert_atomic");
+    assert(!created && !value_present);
+    store(dense, "5000", 50000);
+
+    // Dense members are enumerated in order
+    check_members(dense, MEMBERS + 1, keys);
+    for (int i = 0; i <= MEMBERS; i++)
+      assert(keys[i] == i);
+
+    adlb_data_type type;
+    void *result;
+    size_t length;
+    rc = ADLB_Reduce(dense, ADLB_REDUCE_SUM, ADLB_NO_REFC, &type,
+                     &result, &length);
+    check(rc, "ADLB_Reduce");
+    int64_t sum;
+    memcpy(&sum, result, sizeof(sum));
+    free(result);
+    assert(sum == (int64_t)MEMBERS * (MEMBERS + 1) / 2 * 10);
+
+    // Subscripts that don't fit dense storage
+    adlb_datum_id sparse = create();
+    adlb_datum_id other = create();
+    for (int i = 0; i < 100; i++)
+    {
+      store_int_key(sparse, i, i * 10);
+      store_int_key(other, i, i * 10);
+    }
+    store(sparse, "1000000", 10000000);
+    store(other, "0100", 1000);
+    store(other, "-1", -10);
+
+    check_members(sparse, 101, keys);
+    assert(lookup(sparse, "1000000") == 10000000);
+    assert(lookup(sparse, "99") == 990);
+    check_members(other, 102, keys);
+    assert(lookup(other, "0100") == 1000);
+    assert(lookup(other, "-1") == -10);
+    assert(lookup(other, "42") == 420);
+
+    free(keys);
+    int rank;
+    MPI_Comm_rank(worker_comm, &rank);
+    if (rank == 0)
+      printf("dense-container: OK\n");
+  }
+
+  ADLB_Finalize();
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+
+/*
+ * dput-group.c
+ *
+ * Test ADLB_Dput_group: each worker puts a group of tasks waiting for
+ * shared inputs that are set later, plus one input of their own,
+ * and a group whose shared inputs are already set.  Each task checks
+ * that all of its inputs are set.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include <adlb.h>
+
+#include "common/api_checks.h"
+
+#define SHARED 3
+#define TASKS_PER_GROUP 500
+
+static void
+create_ints(adlb_datum_id *ids, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    adlb_code rc = ADLB_Create_integer(ADLB_DATA_ID_NULL,
+                            DEFAULT_CREATE_PROPS, &ids[i]);
+    check(rc, "ADLB_Create_integer");
+  }
+}
+
+static void
+store_ints(const adlb_datum_id *ids, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    int64_t val = ids[i];
+    adlb_code rc = ADLB_Store(ids[i], ADLB_NO_SUB,
+            ADLB_DATA_TYPE_INTEGER, &val, sizeof(val),
+            ADLB_WRITE_REFC, ADLB_NO_REFC);
+    check(rc, "ADLB_Store");
+  }
+}
+
+static void
+check_set(adlb_datum_id id)
+{
+  int64_t val = -1;
+  adlb_data_type type;
+  size_t length;
+  adlb_code rc = ADLB_Retrieve(id, ADLB_NO_SUB, ADLB_RETRIEVE_NO_REFC,
+                               &type, &val, &length);
+  check(rc, "ADLB_Retrieve");
+  assert(length == sizeof(val) && val == id);
+}
+
+/*
+  Payload of each task: its own input, then the shared inputs
+ */
+static void
+put_group(const adlb_datum_id *shared, const adlb_datum_id *own,
+          int rank)
+{
+  static adlb_datum_id payloads[TASKS_PER_GROUP][SHARED + 1];
+  adlb_put_spec tasks[TASKS_PER_GROUP];
+  for (int i = 0; i < TASKS_PER_GROUP; i++)
+  {
+    payloads[i][0] = own[i];
+    memcpy(&payloads[i][1], shared, sizeof(shared[0]) * SHARED);
+
+    adlb_put_spec *t = &tasks[i];
+    t->payload = payloads[i];
+    t->length = (int)sizeof(payloads[i]);
+    t->target = ADLB_RANK_ANY;
+    t->answer = rank;
+    t->type = 0;
+    t->opts = ADLB_DEFAULT_PUT_OPTS;
+    t->name = "group";
+    t->wait_ids = &own[i];
+    t->wait_id_count = 1;
+    t->wait_id_subs = NULL;
+    t->wait_id_sub_count = 0;
+  }
+
+  adlb_code rc = ADLB_Dput_group(shared, SHARED, NULL, 0,
+                                 tasks, TASKS_PER_GROUP);
+  check(rc, "ADLB_Dput_group");
+}
+
+int
+main()
+{
+  int mpi_argc = 0;
+  char** mpi_argv = NULL;
+  MPI_Init(&mpi_argc, &mpi_argv);
+  int types[1] = {0};
+  int nservers = 2;
+  int am_server;
+  MPI_Comm adlb_comm = MPI_COMM_WORLD;
+  MPI_Comm worker_comm;
+  adlb_code rc = ADLB_Init(nservers, 1, types, &am_server, adlb_comm,
+                           &worker_comm);
+  check(rc, "ADLB_Init");
+
+  if (am_server)
+  {
+    rc = ADLB_Server(1);
+    check(rc, "ADLB_Server");
+  }
+  else
+  {
+    int rank, nworkers;
+    MPI_Comm_rank(worker_comm, &rank);
+    MPI_Comm_size(worker_comm, &nworkers);
+
+    adlb_datum_id shared_open[SHARED], shared_closed[SHARED];
+    static adlb_datum_id own_open[TASKS_PER_GROUP];
+    static adlb_datum_id own_closed[TASKS_PER_GROUP];
+    create_ints(shared_open, SHARED);
+    create_ints(shared_closed, SHARED);
+    create_ints(own_open, TASKS_PER_GROUP);
+    create_ints(own_closed, TASKS_PER_GROUP);
+    store_ints(shared_closed, SHARED);
+    // Half of the tasks have their own input set before the put
+    store_ints(own_closed, TASKS_PER_GROUP / 2);
+
+    put_group(shared_open, own_closed, rank);
+    put_group(shared_closed, own_open, rank);
+
+    MPI_Barrier(worker_comm);
+    store_ints(shared_open, SHARED);
+    store_ints(&own_closed[TASKS_PER_GROUP / 2], TASKS_PER_GROUP / 2);
+    store_ints(own_open, TASKS_PER_GROUP);
+
+    int received = 0;
+    while (true)
+    {
+      void *payload = NULL;
+      int len = 1024, answer, work_type;
+      MPI_Comm task_comm;
+      rc = ADLB_Get(0, &payload, &len, 1024, &answer, &work_type,
+                    &task_comm);
+      if (rc == ADLB_SHUTDOWN)
+        break;
+      check(rc, "ADLB_Get");
+      assert(len == sizeof(adlb_datum_id) * (SHARED + 1));
+
+      // Inputs must have been set before task was released
+      adlb_datum_id ids[SHARED + 1];
+      memcpy(ids, payload, sizeof(ids));
+      for (int i = 0; i < SHARED + 1; i++)
+      {
+        check_set(ids[i]);
+      }
+
+      received++;
+      free(payload);
+    }
+
+    int total;
+    MPI_Reduce(&received, &total, 1, MPI_INT, MPI_SUM, 0, worker_comm);
+    if (rank == 0)
+    {
+      int expected = 2 * TASKS_PER_GROUP * nworkers;
+      printf("received: %i expected: %i\n", total, expected);
+      if (total != expected)
+      {
+        printf("FAILED\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+      }
+    }
+  }
+
+  ADLB_Finalize();
+  MPI_Finalize();
+  return 0;
+}
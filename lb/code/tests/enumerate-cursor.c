@@ -0,0 +1,233 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+
+/*
+ * enumerate-cursor.c
+ *
+ * Test ADLB_Enumerate_next: each worker fills a container and a
+ * multiset, then lists them in chunks with a server-side cursor,
+ * checking that each member is returned once.  Members are added
+ * during one enumeration so that the table is resized in between
+ * chunks, after which members may be repeated or missed, but the
+ * count stays consistent.
+ */
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include <adlb.h>
+#include <adlb_types.h>
+
+#include "common/api_checks.h"
+
+#define MEMBERS 10000
+#define CHUNK 333
+
+static void
+store_member(adlb_datum_id id, int64_t key, int64_t val)
+{
+  adlb_subscript sub = { .key = &key, .length = sizeof(key) };
+  adlb_code rc = ADLB_Store(id, sub, ADLB_DATA_TYPE_INTEGER, &val,
+                            sizeof(val), ADLB_NO_REFC, ADLB_NO_REFC);
+  check(rc, "ADLB_Store");
+}
+
+static void
+unpack_int(adlb_data_type type, const void *data, size_t length,
+           size_t *pos, int64_t *val)
+{
+  const void *entry;
+  size_t entry_length;
+  adlb_data_code dc = ADLB_Unpack_buffer(type, data, length, pos,
+                                         &entry, &entry_length);
+  assert(dc == ADLB_DATA_SUCCESS);
+  assert(entry_length == sizeof(*val));
+  memcpy(val, entry, sizeof(*val));
+}
+
+/*
+  Enumerate container in chunks, counting times each key is seen.
+  grow: number of members to add after first chunk
+  Returns number of members returned
+ */
+static int
+enumerate_container(adlb_datum_id id, char *seen, int grow)
+{
+  int64_t cursor = 0;
+  int total = 0;
+  int chunks = 0;
+  do
+  {
+    void *data = NULL;
+    size_t length;
+    int records;
+    adlb_type_extra kv_type;
+    adlb_code rc = ADLB_Enumerate_next(id, &cursor, CHUNK, ADLB_NO_REFC,
+                        true, true, &data, &length, &records, &kv_type);
+    check(rc, "ADLB_Enumerate_next");
+    assert(records <= CHUNK);
+    assert(kv_type.CONTAINER.val_type == ADLB_DATA_TYPE_INTEGER);
+
+    size_t pos = 0;
+    for (int i = 0; i < records; i++)
+    {
+      int64_t key, val;
+      unpack_int(ADLB_DATA_TYPE_NULL, data, length, &pos, &key);
+      unpack_int(ADLB_DATA_TYPE_INTEGER, data, length, &pos, &val);
+      assert(key >= 0 && key < MEMBERS + grow);
+      assert(val == key * 2);
+      seen[key]++;
+    }
+    assert(pos == length);
+    free(data);
+    total += records;
+
+    if (chunks++ == 0)
+    {
+      for (int i = MEMBERS; i < MEMBERS + grow; i++)
+        store_member(id, i, i * 2);
+    }
+  } while (cursor != 0);
+  return total;
+}
+
+int
+main()
+{
+  int mpi_argc = 0;
+  char** mpi_argv = NULL;
+  MPI_Init(&mpi_argc, &mpi_argv);
+  int types[1] = {0};
+  int nservers = 2;
+  int am_server;
+  MPI_Comm adlb_comm = MPI_COMM_WORLD;
+  MPI_Comm worker_comm;
+  adlb_code rc = ADLB_Init(nservers, 1, types, &am_server, adlb_comm,
+                           &worker_comm);
+  check(rc, "ADLB_Init");
+
+  if (am_server)
+  {
+    rc = ADLB_Server(1);
+    check(rc, "ADLB_Server");
+  }
+  else
+  {
+    adlb_datum_id container, growing, multiset;
+    rc = ADLB_Create_container(ADLB_DATA_ID_NULL, ADLB_DATA_TYPE_INTEGER,
+              ADLB_DATA_TYPE_INTEGER, DEFAULT_CREATE_PROPS, &container);
+    check(rc, "ADLB_Create_container");
+    rc = ADLB_Create_container(ADLB_DATA_ID_NULL, ADLB_DATA_TYPE_INTEGER,
+              ADLB_DATA_TYPE_INTEGER, DEFAULT_CREATE_PROPS, &growing);
+    check(rc, "ADLB_Create_container");
+    rc = ADLB_Create_multiset(ADLB_DATA_ID_NULL, ADLB_DATA_TYPE_INTEGER,
+              DEFAULT_CREATE_PROPS, &multiset);
+    check(rc, "ADLB_Create_multiset");
+
+    int64_t expected_sum = 0;
+    for (int i = 0; i < MEMBERS; i++)
+    {
+      store_member(container, i, i * 2);
+      store_member(growing, i, i * 2);
+      store_member(multiset, i, i);
+      expected_sum += i;
+    }
+
+    // Each member returned exactly once
+    char *seen = calloc(MEMBERS * 2, 1);
+    int total = enumerate_container(container, seen, 0);
+    assert(total == MEMBERS);
+    for (int i = 0; i < MEMBERS; i++)
+    {
+      if (seen[i] != 1)
+      {
+        printf("key %i returned %i times\n", i, (int)seen[i]);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+      }
+    }
+
+    memset(seen, 0, MEMBERS * 2);
+    total = enumerate_container(growing, seen, MEMBERS);
+    assert(total == MEMBERS * 2);
+    free(seen);
+
+    // Multiset values, then count only
+    int64_t cursor = 0, sum = 0;
+    total = 0;
+    do
+    {
+      void *data = NULL;
+      size_t length;
+      int records;
+      adlb_type_extra kv_type;
+      rc = ADLB_Enumerate_next(multiset, &cursor, CHUNK, ADLB_NO_REFC,
+                  false, true, &data, &length, &records, &kv_type);
+      check(rc, "ADLB_Enumerate_next");
+      size_t pos = 0;
+      for (int i = 0; i < records; i++)
+      {
+        int64_t val;
+        unpack_int(ADLB_DATA_TYPE_INTEGER, data, length, &pos, &val);
+        sum += val;
+      }
+      free(data);
+      total += records;
+    } while (cursor != 0);
+    assert(total == MEMBERS && sum == expected_sum);
+
+    cursor = 0;
+    total = 0;
+    do
+    {
+      size_t length;
+      int records;
+      adlb_type_extra kv_type;
+      rc = ADLB_Enumerate_next(container, &cursor, CHUNK, ADLB_NO_REFC,
+                  false, false, NULL, &length, &records, &kv_type);
+      check(rc, "ADLB_Enumerate_next");
+      total += records;
+    } while (cursor != 0);
+    assert(total == MEMBERS);
+
+    // Stop early
+    cursor = 0;
+    void *data = NULL;
+    size_t length;
+    int records;
+    adlb_type_extra kv_type;
+    rc = ADLB_Enumerate_next(container, &cursor, CHUNK, ADLB_NO_REFC,
+                false, true, &data, &length, &records, &kv_type);
+    check(rc, "ADLB_Enumerate_next");
+    assert(records == CHUNK && cursor != 0);
+    free(data);
+    rc = ADLB_Enumerate_close(container, cursor, ADLB_NO_REFC);
+    check(rc, "ADLB_Enumerate_close");
+
+    int rank;
+    MPI_Comm_rank(worker_comm, &rank);
+    if (rank == 0)
+      printf("enumerate-cursor: OK\n");
+  }
+
+  ADLB_Finalize();
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+
+/*
+ * notify-fanout.c
+ *
+ * Test close notifications for data with many subscribers: each
+ * worker subscribes many times to a datum and to a container member,
+ * so the notifications for workers of other servers are fanned out in
+ * batches.  Each worker checks that it receives all of them.
+ */
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include <adlb.h>
+
+#include "common/api_checks.h"
+
+#define SUBSCRIPTIONS 100
+
+int
+main()
+{
+  int mpi_argc = 0;
+  char** mpi_argv = NULL;
+  MPI_Init(&mpi_argc, &mpi_argv);
+  int types[1] = {0};
+  int nservers = 2;
+  int am_server;
+  MPI_Comm adlb_comm = MPI_COMM_WORLD;
+  MPI_Comm worker_comm;
+  adlb_code rc = ADLB_Init(nservers, 1, types, &am_server, adlb_comm,
+                           &worker_comm);
+  check(rc, "ADLB_Init");
+
+  if (am_server)
+  {
+    rc = ADLB_Server(1);
+    check(rc, "ADLB_Server");
+  }
+  else
+  {
+    int rank, nworkers;
+    MPI_Comm_rank(worker_comm, &rank);
+    MPI_Comm_size(worker_comm, &nworkers);
+
+    adlb_datum_id ids[2];
+    if (rank == 0)
+    {
+      rc = ADLB_Create_integer(ADLB_DATA_ID_NULL, DEFAULT_CREATE_PROPS,
+                               &ids[0]);
+      check(rc, "ADLB_Create_integer");
+      rc = ADLB_Create_container(ADLB_DATA_ID_NULL, ADLB_DATA_TYPE_STRING,
+                ADLB_DATA_TYPE_INTEGER, DEFAULT_CREATE_PROPS, &ids[1]);
+      check(rc, "ADLB_Create_container");
+    }
+    MPI_Bcast(ids, 2, MPI_INT64_T, 0, worker_comm);
+
+    adlb_subscript sub = { .key = "k", .length = 2 };
+    for (int i = 0; i < SUBSCRIPTIONS; i++)
+    {
+      int subscribed;
+      rc = ADLB_Subscribe(ids[0], ADLB_NO_SUB, 0, &subscribed);
+      check(rc, "ADLB_Subscribe");
+      assert(subscribed);
+      rc = ADLB_Subscribe(ids[1], sub, 0, &subscribed);
+      check(rc, "ADLB_Subscribe");
+      assert(subscribed);
+    }
+    MPI_Barrier(worker_comm);
+
+    if (rank == 0)
+    {
+      int64_t val = 42;
+      rc = ADLB_Store(ids[0], ADLB_NO_SUB, ADLB_DATA_TYPE_INTEGER,
+              &val, sizeof(val), ADLB_WRITE_REFC, ADLB_NO_REFC);
+      check(rc, "ADLB_Store");
+      rc = ADLB_Store(ids[1], sub, ADLB_DATA_TYPE_INTEGER,
+              &val, sizeof(val), ADLB_NO_REFC, ADLB_NO_REFC);
+      check(rc, "ADLB_Store");
+    }
+
+    char expected[2][64];
+    sprintf(expected[0], "close %"PRId64, ids[0]);
+    sprintf(expected[1], "close %"PRId64" k", ids[1]);
+    int received[2] = { 0, 0 };
+    while (true)
+    {
+      void *payload = NULL;
+      int len = 1024, answer, work_type;
+      MPI_Comm task_comm;
+      rc = ADLB_Get(0, &payload, &len, 1024, &answer, &work_type,
+                    &task_comm);
+      if (rc == ADLB_SHUTDOWN)
+        break;
+      check(rc, "ADLB_Get");
+      if (strcmp(payload, expected[0]) == 0)
+        received[0]++;
+      else if (strncmp(payload, expected[1], strlen(expected[1])) == 0)
+        received[1]++;
+      else
+      {
+        printf("unexpected task: %s\n", (char*)payload);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+      }
+      free(payload);
+    }
+
+    printf("rank %i received: %i %i\n", rank, received[0], received[1]);
+    if (received[0] != SUBSCRIPTIONS || received[1] != SUBSCRIPTIONS)
+    {
+      printf("FAILED\n");
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+  }
+
+  ADLB_Finalize();
+  MPI_Finalize();
+  return 0;
+}
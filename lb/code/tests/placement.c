@@ -0,0 +1,142 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+
+/*
+ * placement.c
+ *
+ * Test placement hints for new data: near another datum, on the
+ * server of a rank, and by key hash.  Each worker checks with
+ * ADLB_Locate that data landed on the expected server.
+ */
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include <adlb.h>
+
+#include "common/api_checks.h"
+
+#define MAX_WORKERS 64
+
+static adlb_datum_id
+create_placed(adlb_placement placement, int64_t arg)
+{
+  adlb_create_props props = DEFAULT_CREATE_PROPS;
+  props.placement = placement;
+  props.placement_arg = arg;
+  adlb_datum_id id;
+  adlb_code rc = ADLB_Create_integer(ADLB_DATA_ID_NULL, props, &id);
+  check(rc, "ADLB_Create_integer");
+  return id;
+}
+
+static void
+check_server(adlb_datum_id id, int server, const char *what)
+{
+  if (ADLB_Locate(id) != server)
+  {
+    printf("%s: <%"PRId64"> on server %i, expected %i\n", what, id,
+           ADLB_Locate(id), server);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+}
+
+int
+main()
+{
+  int mpi_argc = 0;
+  char** mpi_argv = NULL;
+  MPI_Init(&mpi_argc, &mpi_argv);
+  int types[1] = {0};
+  int nservers = 2;
+  int am_server;
+  MPI_Comm adlb_comm = MPI_COMM_WORLD;
+  MPI_Comm worker_comm;
+  adlb_code rc = ADLB_Init(nservers, 1, types, &am_server, adlb_comm,
+                           &worker_comm);
+  check(rc, "ADLB_Init");
+
+  if (am_server)
+  {
+    rc = ADLB_Server(1);
+    check(rc, "ADLB_Server");
+  }
+  else
+  {
+    int rank, nworkers;
+    MPI_Comm_rank(worker_comm, &rank);
+    MPI_Comm_size(worker_comm, &nworkers);
+    assert(nworkers <= MAX_WORKERS);
+
+    // Find server of each worker from data placed locally
+    adlb_datum_id local = create_placed(ADLB_PLACE_LOCAL, 0);
+    adlb_datum_id locals[MAX_WORKERS];
+    MPI_Allgather(&local, 1, MPI_INT64_T, locals, 1, MPI_INT64_T,
+                  worker_comm);
+
+    for (int r = 0; r < nworkers; r++)
+    {
+      int server = ADLB_Locate(locals[r]);
+      check_server(create_placed(ADLB_PLACE_RANK, r), server, "rank");
+      check_server(create_placed(ADLB_PLACE_DATUM, locals[r]), server,
+                   "datum");
+    }
+
+    // Same key must give same server on all workers
+    const char *key = "placement-test";
+    adlb_datum_id hashed = create_placed(ADLB_PLACE_HASH,
+                    ADLB_Placement_hash(key, strlen(key)));
+    adlb_datum_id all_hashed[MAX_WORKERS];
+    MPI_Allgather(&hashed, 1, MPI_INT64_T, all_hashed, 1, MPI_INT64_T,
+                  worker_comm);
+    for (int r = 0; r < nworkers; r++)
+    {
+      check_server(all_hashed[r], ADLB_Locate(hashed), "hash");
+    }
+
+    // Hints also apply to batched creates
+    ADLB_create_spec specs[MAX_WORKERS];
+    for (int r = 0; r < nworkers; r++)
+    {
+      specs[r].id = ADLB_DATA_ID_NULL;
+      specs[r].type = ADLB_DATA_TYPE_INTEGER;
+      specs[r].type_extra = ADLB_TYPE_EXTRA_NULL;
+      specs[r].props = DEFAULT_CREATE_PROPS;
+      specs[r].props.placement = ADLB_PLACE_DATUM;
+      specs[r].props.placement_arg = locals[nworkers - r - 1];
+    }
+    rc = ADLB_Multicreate(specs, nworkers);
+    check(rc, "ADLB_Multicreate");
+    for (int r = 0; r < nworkers; r++)
+    {
+      check_server(specs[r].id, ADLB_Locate(locals[nworkers - r - 1]),
+                   "multicreate");
+    }
+
+    MPI_Barrier(worker_comm);
+    if (rank == 0)
+      printf("placement OK\n");
+  }
+
+  ADLB_Finalize();
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2013 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+
+/*
+ * put-batch.c
+ *
+ * Test ADLB_Put_batch and ADLB_Dput_batch: each worker puts a mix of
+ * ready, data-dependent and oversized tasks, then all tasks are
+ * retrieved and counted.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include <adlb.h>
+
+#include "common/api_checks.h"
+
+#define TASKS_PER_WORKER 1000
+
+/** Larger than a batch message: sent separately */
+#define BIG_TASK_LENGTH (200 * 1024)
+
+int
+main()
+{
+  int mpi_argc = 0;
+  char** mpi_argv = NULL;
+  MPI_Init(&mpi_argc, &mpi_argv);
+  int types[1] = {0};
+  int nservers = 2;
+  int am_server;
+  MPI_Comm adlb_comm = MPI_COMM_WORLD;
+  MPI_Comm worker_comm;
+  adlb_code rc = ADLB_Init(nservers, 1, types, &am_server, adlb_comm,
+                           &worker_comm);
+  check(rc, "ADLB_Init");
+
+  if (am_server)
+  {
+    rc = ADLB_Server(1);
+    check(rc, "ADLB_Server");
+  }
+  else
+  {
+    int rank, nworkers;
+    MPI_Comm_rank(worker_comm, &rank);
+    MPI_Comm_size(worker_comm, &nworkers);
+
+    static adlb_put_spec tasks[TASKS_PER_WORKER];
+    static char payloads[TASKS_PER_WORKER][32];
+    static adlb_datum_id ids[TASKS_PER_WORKER];
+    char *big = malloc(BIG_TASK_LENGTH);
+    memset(big, 'x', BIG_TASK_LENGTH);
+    big[BIG_TASK_LENGTH - 1] = '\0';
+
+    for (int i = 0; i < TASKS_PER_WORKER; i++)
+    {
+      adlb_put_spec *t = &tasks[i];
+      memset(t, 0, sizeof(*t));
+      t->length = sprintf(payloads[i], "TASK %i from %i", i, rank) + 1;
+      t->payload = payloads[i];
+      if (i % 250 == 0)
+      {
+        t->payload = big;
+        t->length = BIG_TASK_LENGTH;
+      }
+      // Spread tasks over workers, and therefore servers
+      t->target = (i % 2 == 0) ? ADLB_RANK_ANY : i % nworkers;
+      t->answer = rank;
+      t->type = 0;
+      t->opts = ADLB_DEFAULT_PUT_OPTS;
+      t->name = "batch";
+    }
+
+    // First half has no dependencies
+    rc = ADLB_Put_batch(tasks, TASKS_PER_WORKER / 2);
+    check(rc, "ADLB_Put_batch");
+
+    // Second half waits on data
+    for (int i = TASKS_PER_WORKER / 2; i < TASKS_PER_WORKER; i++)
+    {
+      rc = ADLB_Create_integer(ADLB_DATA_ID_NULL, DEFAULT_CREATE_PROPS,
+                               &ids[i]);
+      check(rc, "ADLB_Create_integer");
+      tasks[i].wait_ids = &ids[i];
+      tasks[i].wait_id_count = 1;
+    }
+    rc = ADLB_Dput_batch(&tasks[TASKS_PER_WORKER / 2],
+                         TASKS_PER_WORKER - TASKS_PER_WORKER / 2);
+    check(rc, "ADLB_Dput_batch");
+
+    for (int i = TASKS_PER_WORKER / 2; i < TASKS_PER_WORKER; i++)
+    {
+      int64_t val = i;
+      rc = ADLB_Store(ids[i], ADLB_NO_SUB, ADLB_DATA_TYPE_INTEGER,
+                      &val, sizeof(val), ADLB_WRITE_REFC, ADLB_NO_REFC);
+      check(rc, "ADLB_Store");
+    }
+
+    int received = 0;
+    while (true)
+    {
+      void *payload = NULL;
+      int length, answer, type;
+      MPI_Comm task_comm;
+      rc = ADLB_Get(0, &payload, &length, BIG_TASK_LENGTH, &answer,
+                    &type, &task_comm);
+      if (rc == ADLB_SHUTDOWN)
+        break;
+      check(rc, "ADLB_Get");
+      assert(length == BIG_TASK_LENGTH ||
+             strncmp(payload, "TASK ", 5) == 0);
+      received++;
+      free(payload);
+    }
+
+    int total;
+    MPI_Reduce(&received, &total, 1, MPI_INT, MPI_SUM, 0, worker_comm);
+    if (rank == 0)
+    {
+      printf("received: %i expected: %i\n",
+             total, TASKS_PER_WORKER * nworkers);
+      if (total != TASKS_PER_WORKER * nworkers)
+      {
+        printf("FAILED\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+      }
+    }
+    free(big);
+  }
+
+  ADLB_Finalize();
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+
+/*
+ * reduce.c
+ *
+ * Test ADLB_Reduce: each worker fills containers of integers, floats
+ * and strings and a multiset of integers, then checks each reduction.
+ * The strings concatenate to more than the server's xfer buffer.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include <adlb.h>
+
+#include "common/api_checks.h"
+
+#define MEMBERS 10000
+
+/** Length of each string member without null terminator */
+#define STRING_LENGTH 100
+
+static void
+store_member(adlb_datum_id id, int64_t key, adlb_data_type type,
+             const void *val, size_t length)
+{
+  adlb_subscript sub = { .key = &key, .length = sizeof(key) };
+  adlb_code rc = ADLB_Store(id, sub, type, val, length, ADLB_NO_REFC,
+                            ADLB_NO_REFC);
+  check(rc, "ADLB_Store");
+}
+
+static int64_t
+reduce_integer(adlb_datum_id id, adlb_reduce_op op)
+{
+  adlb_data_type type;
+  void *result;
+  size_t length;
+  adlb_code rc = ADLB_Reduce(id, op, ADLB_NO_REFC, &type, &result,
+                             &length);
+  check(rc, "ADLB_Reduce");
+  assert(type == ADLB_DATA_TYPE_INTEGER && length == sizeof(int64_t));
+  int64_t val;
+  memcpy(&val, result, sizeof(val));
+  free(result);
+  return val;
+}
+
+static double
+reduce_float(adlb_datum_id id, adlb_reduce_op op)
+{
+  adlb_data_type type;
+  void *result;
+  size_t length;
+  adlb_code rc = ADLB_Reduce(id, op, ADLB_NO_REFC, &type, &result,
+                             &length);
+  check(rc, "ADLB_Reduce");
+  assert(type == ADLB_DATA_TYPE_FLOAT && length == sizeof(double));
+  double val;
+  memcpy(&val, result, sizeof(val));
+  free(result);
+  return val;
+}
+
+int
+main()
+{
+  int mpi_argc = 0;
+  char** mpi_argv = NULL;
+  MPI_Init(&mpi_argc, &mpi_argv);
+  int types[1] = {0};
+  int nservers = 2;
+  int am_server;
+  MPI_Comm adlb_comm = MPI_COMM_WORLD;
+  MPI_Comm worker_comm;
+  adlb_code rc = ADLB_Init(nservers, 1, types, &am_server, adlb_comm,
+                           &worker_comm);
+  check(rc, "ADLB_Init");
+
+  if (am_server)
+  {
+    rc = ADLB_Server(1);
+    check(rc, "ADLB_Server");
+  }
+  else
+  {
+    int rank;
+    MPI_Comm_rank(worker_comm, &rank);
+
+    adlb_datum_id ints, floats, strings, multiset, empty;
+    rc = ADLB_Create_container(ADLB_DATA_ID_NULL, ADLB_DATA_TYPE_INTEGER,
+                  ADLB_DATA_TYPE_INTEGER, DEFAULT_CREATE_PROPS, &ints);
+    check(rc, "ADLB_Create_container");
+    rc = ADLB_Create_container(ADLB_DATA_ID_NULL, ADLB_DATA_TYPE_INTEGER,
+                  ADLB_DATA_TYPE_FLOAT, DEFAULT_CREATE_PROPS, &floats);
+    check(rc, "ADLB_Create_container");
+    rc = ADLB_Create_container(ADLB_DATA_ID_NULL, ADLB_DATA_TYPE_INTEGER,
+                  ADLB_DATA_TYPE_STRING, DEFAULT_CREATE_PROPS, &strings);
+    check(rc, "ADLB_Create_container");
+    rc = ADLB_Create_multiset(ADLB_DATA_ID_NULL, ADLB_DATA_TYPE_INTEGER,
+                  DEFAULT_CREATE_PROPS, &multiset);
+    check(rc, "ADLB_Create_multiset");
+    rc = ADLB_Create_container(ADLB_DATA_ID_NULL, ADLB_DATA_TYPE_INTEGER,
+                  ADLB_DATA_TYPE_INTEGER, DEFAULT_CREATE_PROPS, &empty);
+    check(rc, "ADLB_Create_container");
+
+    char str[STRING_LENGTH + 1];
+    memset(str, 'a' + rank, STRING_LENGTH);
+    str[STRING_LENGTH] = '\0';
+    for (int i = 0; i < MEMBERS; i++)
+    {
+      int64_t ival = i - MEMBERS / 2;
+      double fval = 0.5 * i;
+      store_member(ints, i, ADLB_DATA_TYPE_INTEGER, &ival, sizeof(ival));
+      store_member(floats, i, ADLB_DATA_TYPE_FLOAT, &fval, sizeof(fval));
+      store_member(strings, i, ADLB_DATA_TYPE_STRING, str, sizeof(str));
+      store_member(multiset, i, ADLB_DATA_TYPE_INTEGER, &ival,
+                   sizeof(ival));
+    }
+
+    int64_t isum = 0;
+    double fsum = 0.0;
+    for (int i = 0; i < MEMBERS; i++)
+    {
+      isum += i - MEMBERS / 2;
+      fsum += 0.5 * i;
+    }
+
+    assert(reduce_integer(ints, ADLB_REDUCE_SUM) == isum);
+    assert(reduce_integer(ints, ADLB_REDUCE_MIN) == -MEMBERS / 2);
+    assert(reduce_integer(ints, ADLB_REDUCE_MAX) == MEMBERS / 2 - 1);
+    assert(reduce_integer(ints, ADLB_REDUCE_COUNT) == MEMBERS);
+    assert(reduce_integer(multiset, ADLB_REDUCE_SUM) == isum);
+    assert(reduce_integer(multiset, ADLB_REDUCE_COUNT) == MEMBERS);
+    assert(reduce_float(floats, ADLB_REDUCE_SUM) == fsum);
+    assert(reduce_float(floats, ADLB_REDUCE_MIN) == 0.0);
+    assert(reduce_float(floats, ADLB_REDUCE_MAX) == 0.5 * (MEMBERS - 1));
+    assert(reduce_integer(empty, ADLB_REDUCE_SUM) == 0);
+
+    adlb_data_type type;
+    void *result;
+    size_t length;
+    rc = ADLB_Reduce(empty, ADLB_REDUCE_MAX, ADLB_NO_REFC, &type,
+                     &result, &length);
+    check(rc, "ADLB_Reduce");
+    assert(type == ADLB_DATA_TYPE_NULL && length == 0);
+
+    rc = ADLB_Reduce(strings, ADLB_REDUCE_CONCAT, ADLB_NO_REFC, &type,
+                     &result, &length);
+    check(rc, "ADLB_Reduce");
+    assert(type == ADLB_DATA_TYPE_STRING);
+    assert(length == (size_t)MEMBERS * STRING_LENGTH + 1);
+    char *s = result;
+    assert(s[0] == 'a' + rank && s[length - 2] == 'a' + rank);
+    assert(s[length - 1] == '\0');
+    free(result);
+
+    // Wrong value type for operator
+    rc = ADLB_Reduce(strings, ADLB_REDUCE_SUM, ADLB_NO_REFC, &type,
+                     &result, &length);
+    assert(rc == ADLB_ERROR);
+
+    printf("worker %i: OK\n", rank);
+  }
+
+  ADLB_Finalize();
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+
+/*
+ * retrieve-array.c
+ *
+ * Test retrieving integer and float containers as arrays, from dense
+ * storage and from hash tables, and failures when subscripts are not
+ * 0..N-1.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include <adlb.h>
+
+#include "common/api_checks.h"
+
+#define MEMBERS 1000
+
+static adlb_datum_id
+create(adlb_data_type val_type)
+{
+  adlb_datum_id id;
+  adlb_code rc = ADLB_Create_container(ADLB_DATA_ID_NULL,
+        ADLB_DATA_TYPE_INTEGER, val_type, DEFAULT_CREATE_PROPS, &id);
+  check(rc, "ADLB_Create_container");
+  return id;
+}
+
+static void
+store(adlb_datum_id id, int key, adlb_data_type type, const void *val)
+{
+  char buf[32];
+  sprintf(buf, "%i", key);
+  adlb_subscript sub = { .key = buf, .length = strlen(buf) + 1 };
+  adlb_code rc = ADLB_Store(id, sub, type, val, 8,
+                            ADLB_NO_REFC, ADLB_NO_REFC);
+  check(rc, "ADLB_Store");
+}
+
+static void
+store_int(adlb_datum_id id, int key)
+{
+  int64_t val = key * 3;
+  store(id, key, ADLB_DATA_TYPE_INTEGER, &val);
+}
+
+static void
+check_ints(adlb_datum_id id, int count)
+{
+  adlb_data_type type;
+  void *data;
+  int n;
+  adlb_code rc = ADLB_Retrieve_array(id, ADLB_NO_REFC, &type, &data, &n);
+  check(rc, "ADLB_Retrieve_array");
+  assert(type == ADLB_DATA_TYPE_INTEGER && n == count);
+  int64_t *vals = data;
+  for (int i = 0; i < count; i++)
+    assert(vals[i] == i * 3);
+  free(data);
+}
+
+int
+main()
+{
+  int mpi_argc = 0;
+  char** mpi_argv = NULL;
+  MPI_Init(&mpi_argc, &mpi_argv);
+  int types[1] = {0};
+  int nservers = 2;
+  int am_server;
+  MPI_Comm adlb_comm = MPI_COMM_WORLD;
+  MPI_Comm worker_comm;
+  adlb_code rc = ADLB_Init(nservers, 1, types, &am_server, adlb_comm,
+                           &worker_comm);
+  check(rc, "ADLB_Init");
+
+  if (am_server)
+  {
+    rc = ADLB_Server(1);
+    check(rc, "ADLB_Server");
+  }
+  else
+  {
+    adlb_data_type type;
+    void *data;
+    int n;
+
+    // Dense storage, filled in reverse
+    adlb_datum_id ints = create(ADLB_DATA_TYPE_INTEGER);
+    for (int i = MEMBERS - 1; i >= 0; i--)
+      store_int(ints, i);
+    check_ints(ints, MEMBERS);
+
+    adlb_datum_id floats = create(ADLB_DATA_TYPE_FLOAT);
+    for (int i = 0; i < MEMBERS; i++)
+    {
+      double val = i * 0.5;
+      store(floats, i, ADLB_DATA_TYPE_FLOAT, &val);
+    }
+    rc = ADLB_Retrieve_array(floats, ADLB_NO_REFC, &type, &data, &n);
+    check(rc, "ADLB_Retrieve_array");
+    assert(type == ADLB_DATA_TYPE_FLOAT && n == MEMBERS);
+    for (int i = 0; i < MEMBERS; i++)
+      assert(((double*)data)[i] == i * 0.5);
+    free(data);
+
+    // First subscript too large for dense storage: hash table
+    adlb_datum_id table = create(ADLB_DATA_TYPE_INTEGER);
+    store_int(table, MEMBERS - 1);
+    for (int i = 0; i < MEMBERS - 1; i++)
+      store_int(table, i);
+    check_ints(table, MEMBERS);
+
+    adlb_datum_id empty = create(ADLB_DATA_TYPE_INTEGER);
+    rc = ADLB_Retrieve_array(empty, ADLB_NO_REFC, &type, &data, &n);
+    check(rc, "ADLB_Retrieve_array");
+    assert(n == 0 && data == NULL);
+
+    // Subscripts not 0..N-1
+    adlb_datum_id sparse = create(ADLB_DATA_TYPE_INTEGER);
+    for (int i = 0; i < 10; i++)
+      store_int(sparse, i * 2);
+    rc = ADLB_Retrieve_array(sparse, ADLB_NO_REFC, &type, &data, &n);
+    assert(rc == ADLB_ERROR);
+
+    adlb_datum_id strings;
+    rc = ADLB_Create_container(ADLB_DATA_ID_NULL, ADLB_DATA_TYPE_INTEGER,
+            ADLB_DATA_TYPE_STRING, DEFAULT_CREATE_PROPS, &strings);
+    check(rc, "ADLB_Create_container");
+    rc = ADLB_Retrieve_array(strings, ADLB_NO_REFC, &type, &data, &n);
+    assert(rc == ADLB_ERROR);
+
+    int rank;
+    MPI_Comm_rank(worker_comm, &rank);
+    if (rank == 0)
+      printf("retrieve-array: OK\n");
+  }
+
+  ADLB_Finalize();
+  MPI_Finalize();
+  return 0;
+}
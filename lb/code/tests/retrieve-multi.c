@@ -0,0 +1,162 @@
+/*
+ * Copyright 2013 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+
+/*
+ * retrieve-multi.c
+ *
+ * Test ADLB_Retrieve_multi: each worker stores integers, container
+ * members and a large blob, then fetches them all with one call.
+ * Enough values are requested that each server gets several request
+ * messages.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include <adlb.h>
+
+#include "common/api_checks.h"
+
+#define VALUES_PER_WORKER 5000
+
+#define MEMBERS 10
+
+/** Larger than xfer buffer */
+#define BIG_VALUE_LENGTH (200 * 1024)
+
+int
+main()
+{
+  int mpi_argc = 0;
+  char** mpi_argv = NULL;
+  MPI_Init(&mpi_argc, &mpi_argv);
+  int types[1] = {0};
+  int nservers = 2;
+  int am_server;
+  MPI_Comm adlb_comm = MPI_COMM_WORLD;
+  MPI_Comm worker_comm;
+  adlb_code rc = ADLB_Init(nservers, 1, types, &am_server, adlb_comm,
+                           &worker_comm);
+  check(rc, "ADLB_Init");
+
+  if (am_server)
+  {
+    rc = ADLB_Server(1);
+    check(rc, "ADLB_Server");
+  }
+  else
+  {
+    int rank;
+    MPI_Comm_rank(worker_comm, &rank);
+
+    // Integers, then container members plus one missing, then blob
+    int count = VALUES_PER_WORKER + MEMBERS + 2;
+    adlb_retrieve_spec *specs = malloc(sizeof(specs[0]) * (size_t)count);
+    adlb_retrieve_result *results =
+                      malloc(sizeof(results[0]) * (size_t)count);
+    int64_t keys[MEMBERS + 1];
+
+    for (int i = 0; i < VALUES_PER_WORKER; i++)
+    {
+      adlb_datum_id id;
+      rc = ADLB_Create_integer(ADLB_DATA_ID_NULL, DEFAULT_CREATE_PROPS,
+                               &id);
+      check(rc, "ADLB_Create_integer");
+      int64_t val = i * 10 + rank;
+      rc = ADLB_Store(id, ADLB_NO_SUB, ADLB_DATA_TYPE_INTEGER, &val,
+                      sizeof(val), ADLB_WRITE_REFC, ADLB_NO_REFC);
+      check(rc, "ADLB_Store");
+
+      specs[i].id = id;
+      specs[i].subscript = ADLB_NO_SUB;
+      specs[i].refcounts = ADLB_RETRIEVE_READ_REFC;
+    }
+
+    adlb_datum_id c;
+    rc = ADLB_Create_container(ADLB_DATA_ID_NULL, ADLB_DATA_TYPE_INTEGER,
+                  ADLB_DATA_TYPE_INTEGER, DEFAULT_CREATE_PROPS, &c);
+    check(rc, "ADLB_Create_container");
+    for (int i = 0; i <= MEMBERS; i++)
+    {
+      keys[i] = i;
+      adlb_subscript sub = { .key = &keys[i], .length = sizeof(keys[i]) };
+      if (i < MEMBERS)
+      {
+        int64_t val = -i;
+        rc = ADLB_Store(c, sub, ADLB_DATA_TYPE_INTEGER, &val, sizeof(val),
+                        ADLB_NO_REFC, ADLB_NO_REFC);
+        check(rc, "ADLB_Store");
+      }
+      adlb_retrieve_spec *spec = &specs[VALUES_PER_WORKER + i];
+      spec->id = c;
+      spec->subscript = sub;
+      spec->refcounts = ADLB_RETRIEVE_NO_REFC;
+    }
+
+    adlb_datum_id big;
+    rc = ADLB_Create_blob(ADLB_DATA_ID_NULL, DEFAULT_CREATE_PROPS, &big);
+    check(rc, "ADLB_Create_blob");
+    char *big_value = malloc(BIG_VALUE_LENGTH);
+    memset(big_value, 'x', BIG_VALUE_LENGTH);
+    rc = ADLB_Store(big, ADLB_NO_SUB, ADLB_DATA_TYPE_BLOB, big_value,
+                    BIG_VALUE_LENGTH, ADLB_WRITE_REFC, ADLB_NO_REFC);
+    check(rc, "ADLB_Store");
+    free(big_value);
+    specs[count - 1].id = big;
+    specs[count - 1].subscript = ADLB_NO_SUB;
+    specs[count - 1].refcounts = ADLB_RETRIEVE_NO_REFC;
+
+    void *storage;
+    rc = ADLB_Retrieve_multi(specs, count, results, &storage);
+    check(rc, "ADLB_Retrieve_multi");
+
+    for (int i = 0; i < VALUES_PER_WORKER; i++)
+    {
+      assert(results[i].code == ADLB_SUCCESS);
+      assert(results[i].type == ADLB_DATA_TYPE_INTEGER);
+      assert(results[i].length == sizeof(int64_t));
+      int64_t val;
+      memcpy(&val, results[i].data, sizeof(val));
+      assert(val == i * 10 + rank);
+    }
+    for (int i = 0; i < MEMBERS; i++)
+    {
+      adlb_retrieve_result *r = &results[VALUES_PER_WORKER + i];
+      assert(r->code == ADLB_SUCCESS);
+      int64_t val;
+      memcpy(&val, r->data, sizeof(val));
+      assert(val == -i);
+    }
+    assert(results[VALUES_PER_WORKER + MEMBERS].code == ADLB_NOTHING);
+    adlb_retrieve_result *r = &results[count - 1];
+    assert(r->code == ADLB_SUCCESS && r->type == ADLB_DATA_TYPE_BLOB);
+    assert(r->length == BIG_VALUE_LENGTH);
+    assert(((char*)r->data)[BIG_VALUE_LENGTH - 1] == 'x');
+    free(storage);
+
+    free(specs);
+    free(results);
+    printf("worker %i: OK\n", rank);
+  }
+
+  ADLB_Finalize();
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+
+/*
+ * rma-payload.c
+ *
+ * Test storing and retrieving blobs large enough to be transferred
+ * through the RMA window, including container members, alongside
+ * small blobs sent as messages.  Each worker checks the contents of
+ * blobs stored by another worker.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include <adlb.h>
+
+#include "common/api_checks.h"
+
+// Above default ADLB_RMA_THRESHOLD
+#define LARGE (6*1024*1024)
+#define SMALL (64*1024)
+#define MEMBERS 3
+
+static void
+fill(char *buf, size_t length, int seed)
+{
+  for (size_t i = 0; i < length; i++)
+  {
+    buf[i] = (char)(i * 7 + (size_t)seed);
+  }
+}
+
+static void
+check_blob(const char *buf, size_t length, size_t expected, int seed)
+{
+  if (length != expected)
+  {
+    printf("wrong length: %zu expected: %zu\n", length, expected);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+  for (size_t i = 0; i < length; i++)
+  {
+    if (buf[i] != (char)(i * 7 + (size_t)seed))
+    {
+      printf("wrong byte at %zu of %zu\n", i, length);
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+  }
+}
+
+static void
+store_blob(adlb_datum_id id, adlb_subscript sub, const char *buf,
+           size_t length, adlb_refc decr)
+{
+  adlb_code rc = ADLB_Store(id, sub, ADLB_DATA_TYPE_BLOB, buf, length,
+                            decr, ADLB_NO_REFC);
+  check(rc, "ADLB_Store");
+}
+
+static void
+retrieve_blob(adlb_datum_id id, adlb_subscript sub, char *buf,
+              size_t expected, int seed)
+{
+  adlb_data_type type;
+  size_t length;
+  adlb_code rc = ADLB_Retrieve(id, sub, ADLB_RETRIEVE_NO_REFC, &type,
+                               buf, &length);
+  check(rc, "ADLB_Retrieve");
+  assert(type == ADLB_DATA_TYPE_BLOB);
+  check_blob(buf, length, expected, seed);
+}
+
+int
+main()
+{
+  int mpi_argc = 0;
+  char** mpi_argv = NULL;
+  MPI_Init(&mpi_argc, &mpi_argv);
+  int types[1] = {0};
+  int nservers = 2;
+  int am_server;
+  MPI_Comm adlb_comm = MPI_COMM_WORLD;
+  MPI_Comm worker_comm;
+  adlb_code rc = ADLB_Init(nservers, 1, types, &am_server, adlb_comm,
+                           &worker_comm);
+  check(rc, "ADLB_Init");
+
+  if (am_server)
+  {
+    rc = ADLB_Server(1);
+    check(rc, "ADLB_Server");
+  }
+  else
+  {
+    int rank, nworkers;
+    MPI_Comm_rank(worker_comm, &rank);
+    MPI_Comm_size(worker_comm, &nworkers);
+    int other = (rank + 1) % nworkers;
+
+    char *buf = malloc(LARGE);
+    assert(buf != NULL);
+
+    // ids: large blob, small blob, container of blobs
+    adlb_datum_id ids[3];
+    rc = ADLB_Create_blob(ADLB_DATA_ID_NULL, DEFAULT_CREATE_PROPS,
+                          &ids[0]);
+    check(rc, "ADLB_Create_blob");
+    rc = ADLB_Create_blob(ADLB_DATA_ID_NULL, DEFAULT_CREATE_PROPS,
+                          &ids[1]);
+    check(rc, "ADLB_Create_blob");
+    rc = ADLB_Create_container(ADLB_DATA_ID_NULL, ADLB_DATA_TYPE_INTEGER,
+            ADLB_DATA_TYPE_BLOB, DEFAULT_CREATE_PROPS, &ids[2]);
+    check(rc, "ADLB_Create_container");
+
+    fill(buf, LARGE, rank);
+    store_blob(ids[0], ADLB_NO_SUB, buf, LARGE, ADLB_WRITE_REFC);
+    fill(buf, SMALL, rank + 1);
+    store_blob(ids[1], ADLB_NO_SUB, buf, SMALL, ADLB_WRITE_REFC);
+    for (int i = 0; i < MEMBERS; i++)
+    {
+      char key[16];
+      sprintf(key, "%i", i);
+      adlb_subscript sub = { .key = key, .length = strlen(key) + 1 };
+      size_t length = (i % 2 == 0) ? LARGE : SMALL;
+      fill(buf, length, rank + 2 + i);
+      store_blob(ids[2], sub, buf, length, ADLB_NO_REFC);
+    }
+
+    // Large blob is closed: second store is rejected
+    rc = ADLB_Store(ids[0], ADLB_NO_SUB, ADLB_DATA_TYPE_BLOB, buf, LARGE,
+                    ADLB_NO_REFC, ADLB_NO_REFC);
+    assert(rc == ADLB_REJECTED);
+
+    adlb_datum_id all_ids[3 * nworkers];
+    MPI_Allgather(ids, 3, MPI_INT64_T, all_ids, 3, MPI_INT64_T,
+                  worker_comm);
+    const adlb_datum_id *other_ids = &all_ids[3 * other];
+
+    // Retrieve twice: server lends a fresh copy each time
+    for (int round = 0; round < 2; round++)
+    {
+      retrieve_blob(other_ids[0], ADLB_NO_SUB, buf, LARGE, other);
+      retrieve_blob(other_ids[1], ADLB_NO_SUB, buf, SMALL, other + 1);
+      for (int i = 0; i < MEMBERS; i++)
+      {
+        char key[16];
+        sprintf(key, "%i", i);
+        adlb_subscript sub = { .key = key, .length = strlen(key) + 1 };
+        size_t length = (i % 2 == 0) ? LARGE : SMALL;
+        retrieve_blob(other_ids[2], sub, buf, length, other + 2 + i);
+      }
+    }
+
+    MPI_Barrier(worker_comm);
+    if (rank == 0)
+    {
+      printf("OK\n");
+    }
+    free(buf);
+  }
+
+  ADLB_Finalize();
+  MPI_Finalize();
+  return 0;
+}
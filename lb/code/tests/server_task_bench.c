@@ -60,9 +60,33 @@ int min_init_qlen = 128;
 int max_init_qlen = 16 * 1024;
 int qlen_growth = 2;
 
+/** Number of servers */
+int nservers = 1;
+
+/** Simulated task runtime in microseconds */
+int task_usec = 0;
+
+/** If true, compare steal sizing policies instead: all initial work
+    is put by one worker, so other servers must steal it */
+bool steal_expts = false;
+
 static adlb_code run(void);
-static adlb_code expt(prio_mix prios, tgt_mix tgts, int init_qlen,
-                         bool report);
+static adlb_code run_steal_expts(void);
+static adlb_code expt(const char *name, prio_mix prios, tgt_mix tgts,
+                      int init_qlen, bool one_producer, bool report);
+static void spin(int usec);
+
+/*
+  Busy wait to simulate work
+ */
+static void spin(int usec)
+{
+  if (usec <= 0)
+    return;
+
+  double end = MPI_Wtime() + usec * 1e-6;
+  while (MPI_Wtime() < end);
+}
 
 static void report_hdr(void);
 static void report_expt(const char *expt, prio_mix prios, tgt_mix tgts,
@@ -73,7 +97,7 @@ int main(int argc, char **argv)
   int c;
   int n;
 
-  while ((c = getopt(argc, argv, "n:r:Q:w:")) != -1)
+  while ((c = getopt(argc, argv, "n:r:Q:w:s:t:S")) != -1)
   {
     switch (c) {
       case 'n':
@@ -121,6 +145,29 @@ int main(int argc, char **argv)
         fprintf(stderr, "Number of distinct work units: %i\n",
                 num_distinct_wus);
         break;
+      case 's':
+        nservers = atoi(optarg);
+        if (nservers < 1)
+        {
+          fprintf(stderr, "Invalid number of servers: %s\n", optarg);
+          return 1;
+        }
+
+        fprintf(stderr, "Number of servers: %i\n", nservers);
+        break;
+      case 't':
+        task_usec = atoi(optarg);
+        if (task_usec < 0)
+        {
+          fprintf(stderr, "Invalid task runtime: %s\n", optarg);
+          return 1;
+        }
+
+        fprintf(stderr, "Task runtime (usec): %i\n", task_usec);
+        break;
+      case 'S':
+        steal_expts = true;
+        break;
       case '?':
         fprintf(stderr, "Unknown option %c\n", (char)(c));
         return 1;
@@ -151,6 +198,13 @@ static adlb_code run()
   fprintf(stderr, "Running benchmarks...\n");
   report_hdr();
 
+  if (steal_expts)
+  {
+    ac = run_steal_expts();
+    ADLB_CHECK(ac);
+    goto done;
+  }
+
   // TODO: Omitting NODE_SOFT_TARGETED, too tricky to generate right ranks
   tgt_mix tgts[] = {UNTARGETED, RANK_TARGETED, NODE_TARGETED,
           EQUAL_MIX, RANK_SOFT_TARGETED, /*NODE_SOFT_TARGETED*/};
@@ -169,13 +223,15 @@ static adlb_code run()
         for (int init_qlen = min_init_qlen; init_qlen <= max_init_qlen;
                 init_qlen = init_qlen == 0 ? 1 : init_qlen * qlen_growth)
         {
-          ac = expt(prios[prio_idx], tgts[tgt_idx], init_qlen, report);
+          ac = expt("server_task_bench", prios[prio_idx], tgts[tgt_idx],
+                    init_qlen, false, report);
           ADLB_CHECK(ac);
         }
       }
     }
   }
 
+done:
   fprintf(stderr, "Finalizing...\n");
 
   MPI_Finalize();
@@ -185,18 +241,54 @@ static adlb_code run()
   return ADLB_SUCCESS;
 }
 
+/*
+  Compare steal sizing policies.  Run with -s > 1 and -t to set the
+  task runtime.
+ */
+static adlb_code run_steal_expts(void)
+{
+  adlb_code ac;
+
+  const char *policies[] = {"FRACTION", "ADAPTIVE"};
+  int npolicies = sizeof(policies)/sizeof(policies[0]);
+
+  for (int exp_iter = 0; exp_iter < 3; exp_iter++)
+  {
+    bool report = exp_iter > 0;
+
+    for (int i = 0; i < npolicies; i++)
+    {
+      // Read by each ADLB_Init
+      setenv("ADLB_STEAL_SIZING", policies[i], 1);
+
+      char name[64];
+      sprintf(name, "steal_%s", policies[i]);
+
+      for (int init_qlen = min_init_qlen; init_qlen <= max_init_qlen;
+              init_qlen *= qlen_growth)
+      {
+        ac = expt(name, EQUAL, UNTARGETED, init_qlen, true, report);
+        ADLB_CHECK(ac);
+      }
+    }
+  }
+
+  unsetenv("ADLB_STEAL_SIZING");
+  return ADLB_SUCCESS;
+}
+
 /*
   Run experiment on request queue + work queue flow
+  one_producer: if true, worker 0 puts all initial work units
  */
-static adlb_code expt(prio_mix prios, tgt_mix tgts, int init_qlen,
-                          bool report)
+static adlb_code expt(const char *name, prio_mix prios, tgt_mix tgts,
+                      int init_qlen, bool one_producer, bool report)
 {
   int my_rank;
   MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
 
   int comm_size;
   MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
-  int nservers = 1;
   int nworkers = comm_size - nservers;
   int ntypes = 1;
   int types[1] = { 0 };
@@ -243,9 +335,10 @@ static adlb_code expt(prio_mix prios, tgt_mix tgts, int init_qlen,
 
     time_end(&timers);
 
-    if (report)
+    // Report once per experiment
+    if (report && my_rank == nworkers)
     {
-      report_expt("server_task_bench", prios, tgts, init_qlen, benchmark_nops, timers);
+      report_expt(name, prios, tgts, init_qlen, benchmark_nops, timers);
     }
   }
   else
@@ -259,14 +352,18 @@ static adlb_code expt(prio_mix prios, tgt_mix tgts, int init_qlen,
     MPI_Barrier(comm);
 
     // Prepopulate queues from workers
-    int init_qlen_mine = init_qlen / nworkers + (my_rank < init_qlen % nworkers);
+    int producers = one_producer ? 1 : nworkers;
+    int init_qlen_mine = 0;
+    if (my_rank < producers)
+      init_qlen_mine = init_qlen / producers +
+                       (my_rank < init_qlen % producers);
     // fprintf(stderr, "init_qlen_min = %i\n", init_qlen_mine);
     for (int i = 0; i < init_qlen_mine; i++)
     {
       // Work out number of work units that need to be run per work unit
       // Two ops per work unit
       int payload_val = benchmark_ntasks / init_qlen +
-                (i * nworkers + my_rank < benchmark_ntasks % init_qlen);
+                (i * producers + my_rank < benchmark_ntasks % init_qlen);
 
       /*fprintf(stderr, "payload_val = %i = %i + %i\n", payload_val,
                 benchmark_nops / (2 * init_qlen),
@@ -291,6 +388,7 @@ static adlb_code expt(prio_mix prios, tgt_mix tgts, int init_qlen,
     while (true)
     {
       void* p = wus[wu_idx]->payload;
+      len = (int)payload_size; // Size of buffer p
       ac = ADLB_Get(0, &p, &len, max_len, &answer, &type, &tmp_comm);
       if (ac != ADLB_SUCCESS)
         break;
@@ -301,6 +399,8 @@ static adlb_code expt(prio_mix prios, tgt_mix tgts, int init_qlen,
         ADLB_Abort(1);
       }
 
+      spin(task_usec);
+
       int counter;
       xlb_work_unit *wu = wus[wu_idx];
       memcpy(&counter, wu->payload, sizeof(counter));
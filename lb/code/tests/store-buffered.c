@@ -0,0 +1,230 @@
+/*
+ * Copyright 2013 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+
+/*
+ * store-buffered.c
+ *
+ * Test ADLB_Store_buffered and ADLB_Refcount_decr_buffered: each
+ * worker buffers stores that release data-dependent tasks, stores
+ * into a container and closes it, reads back its own writes, and
+ * checks that a buffered double write is reported.  Buffered
+ * decrements of one container between stores into it are merged.
+ * Stores before a failed store in a batch still release tasks, and a
+ * failed decrement is reported to the worker.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include <adlb.h>
+
+#include "common/api_checks.h"
+
+#define VALUES_PER_WORKER 1000
+
+/** Extra write references on container closed by merged decrements */
+#define EXTRA_WRITERS 50
+
+/** Larger than write buffer: sent directly */
+#define BIG_VALUE_LENGTH (200 * 1024)
+
+int
+main()
+{
+  int mpi_argc = 0;
+  char** mpi_argv = NULL;
+  MPI_Init(&mpi_argc, &mpi_argv);
+  int types[1] = {0};
+  int nservers = 2;
+  int am_server;
+  MPI_Comm adlb_comm = MPI_COMM_WORLD;
+  MPI_Comm worker_comm;
+  adlb_code rc = ADLB_Init(nservers, 1, types, &am_server, adlb_comm,
+                           &worker_comm);
+  check(rc, "ADLB_Init");
+
+  if (am_server)
+  {
+    rc = ADLB_Server(1);
+    check(rc, "ADLB_Server");
+  }
+  else
+  {
+    int rank, nworkers;
+    MPI_Comm_rank(worker_comm, &rank);
+    MPI_Comm_size(worker_comm, &nworkers);
+
+    static adlb_datum_id ids[VALUES_PER_WORKER];
+    for (int i = 0; i < VALUES_PER_WORKER; i++)
+    {
+      rc = ADLB_Create_integer(ADLB_DATA_ID_NULL, DEFAULT_CREATE_PROPS,
+                               &ids[i]);
+      check(rc, "ADLB_Create_integer");
+      char payload[32];
+      int length = sprintf(payload, "TASK %i from %i", i, rank) + 1;
+      rc = ADLB_Dput(payload, length, ADLB_RANK_ANY, rank, 0,
+                     ADLB_DEFAULT_PUT_OPTS, "wait", &ids[i], 1, NULL, 0);
+      check(rc, "ADLB_Dput");
+    }
+
+    adlb_datum_id c, big;
+    rc = ADLB_Create_container(ADLB_DATA_ID_NULL, ADLB_DATA_TYPE_INTEGER,
+                  ADLB_DATA_TYPE_INTEGER, DEFAULT_CREATE_PROPS, &c);
+    check(rc, "ADLB_Create_container");
+    rc = ADLB_Create_blob(ADLB_DATA_ID_NULL, DEFAULT_CREATE_PROPS, &big);
+    check(rc, "ADLB_Create_blob");
+
+    // Task to run once container is closed
+    rc = ADLB_Dput("CLOSED", 7, ADLB_RANK_ANY, rank, 0,
+                   ADLB_DEFAULT_PUT_OPTS, "close", &c, 1, NULL, 0);
+    check(rc, "ADLB_Dput");
+
+    for (int i = 0; i < VALUES_PER_WORKER; i++)
+    {
+      int64_t val = i;
+      rc = ADLB_Store_buffered(ids[i], ADLB_NO_SUB,
+              ADLB_DATA_TYPE_INTEGER, &val, sizeof(val),
+              ADLB_WRITE_REFC, ADLB_NO_REFC);
+      check(rc, "ADLB_Store_buffered");
+
+      int64_t key = i;
+      adlb_subscript sub = { .key = &key, .length = sizeof(key) };
+      rc = ADLB_Store_buffered(c, sub, ADLB_DATA_TYPE_INTEGER,
+              &val, sizeof(val), ADLB_NO_REFC, ADLB_NO_REFC);
+      check(rc, "ADLB_Store_buffered");
+    }
+
+    char *big_value = malloc(BIG_VALUE_LENGTH);
+    memset(big_value, 'x', BIG_VALUE_LENGTH);
+    rc = ADLB_Store_buffered(big, ADLB_NO_SUB, ADLB_DATA_TYPE_BLOB,
+            big_value, BIG_VALUE_LENGTH, ADLB_WRITE_REFC, ADLB_NO_REFC);
+    check(rc, "ADLB_Store_buffered");
+    free(big_value);
+
+    rc = ADLB_Refcount_decr_buffered(c, ADLB_WRITE_REFC);
+    check(rc, "ADLB_Refcount_decr_buffered");
+
+    // Decrements merged into one, applied after the stores
+    adlb_datum_id c2;
+    rc = ADLB_Create_container(ADLB_DATA_ID_NULL, ADLB_DATA_TYPE_INTEGER,
+                  ADLB_DATA_TYPE_INTEGER, DEFAULT_CREATE_PROPS, &c2);
+    check(rc, "ADLB_Create_container");
+    adlb_refc writers = { .read_refcount = 0,
+                          .write_refcount = EXTRA_WRITERS };
+    rc = ADLB_Refcount_incr(c2, writers);
+    check(rc, "ADLB_Refcount_incr");
+    rc = ADLB_Dput("CLOSED", 7, ADLB_RANK_ANY, rank, 0,
+                   ADLB_DEFAULT_PUT_OPTS, "close", &c2, 1, NULL, 0);
+    check(rc, "ADLB_Dput");
+    for (int i = 0; i <= EXTRA_WRITERS; i++)
+    {
+      int64_t key = i, v = i;
+      adlb_subscript sub = { .key = &key, .length = sizeof(key) };
+      rc = ADLB_Store_buffered(c2, sub, ADLB_DATA_TYPE_INTEGER,
+              &v, sizeof(v), ADLB_NO_REFC, ADLB_NO_REFC);
+      check(rc, "ADLB_Store_buffered");
+      rc = ADLB_Refcount_decr_buffered(c2, ADLB_WRITE_REFC);
+      check(rc, "ADLB_Refcount_decr_buffered");
+    }
+
+    // Should see our own writes
+    int size;
+    rc = ADLB_Container_size(c, &size, ADLB_NO_REFC);
+    check(rc, "ADLB_Container_size");
+    assert(size == VALUES_PER_WORKER);
+    rc = ADLB_Container_size(c2, &size, ADLB_NO_REFC);
+    check(rc, "ADLB_Container_size");
+    assert(size == EXTRA_WRITERS + 1);
+
+    int64_t val = -1;
+    adlb_data_type type;
+    size_t length;
+    rc = ADLB_Retrieve(ids[VALUES_PER_WORKER - 1], ADLB_NO_SUB,
+                       ADLB_RETRIEVE_NO_REFC, &type, &val, &length);
+    check(rc, "ADLB_Retrieve");
+    assert(length == sizeof(val) && val == VALUES_PER_WORKER - 1);
+
+    // Double write is reported by flush, or immediately if unbuffered
+    val = 0;
+    rc = ADLB_Store_buffered(ids[0], ADLB_NO_SUB, ADLB_DATA_TYPE_INTEGER,
+                    &val, sizeof(val), ADLB_NO_REFC, ADLB_NO_REFC);
+    if (rc == ADLB_SUCCESS)
+      rc = ADLB_Flush_writes();
+    assert(rc == ADLB_REJECTED);
+
+    // Failed batch still releases tasks waiting on earlier stores
+    adlb_datum_id last;
+    rc = ADLB_Create_integer(ADLB_DATA_ID_NULL, DEFAULT_CREATE_PROPS,
+                             &last);
+    check(rc, "ADLB_Create_integer");
+    rc = ADLB_Dput("LAST", 5, ADLB_RANK_ANY, rank, 0,
+                   ADLB_DEFAULT_PUT_OPTS, "wait", &last, 1, NULL, 0);
+    check(rc, "ADLB_Dput");
+    val = 1;
+    rc = ADLB_Store_buffered(last, ADLB_NO_SUB, ADLB_DATA_TYPE_INTEGER,
+                    &val, sizeof(val), ADLB_WRITE_REFC, ADLB_NO_REFC);
+    check(rc, "ADLB_Store_buffered");
+    // Never created, on same server
+    adlb_datum_id missing = last + nservers * 1000000;
+    rc = ADLB_Store_buffered(missing, ADLB_NO_SUB, ADLB_DATA_TYPE_INTEGER,
+                    &val, sizeof(val), ADLB_NO_REFC, ADLB_NO_REFC);
+    if (rc == ADLB_SUCCESS)
+      rc = ADLB_Flush_writes();
+    assert(rc == ADLB_ERROR);
+
+    // Failed decrement is reported to worker, server keeps running
+    rc = ADLB_Refcount_decr_buffered(missing, ADLB_WRITE_REFC);
+    if (rc == ADLB_SUCCESS)
+      rc = ADLB_Flush_writes();
+    assert(rc == ADLB_ERROR);
+
+    int received = 0;
+    while (true)
+    {
+      void *payload = NULL;
+      int len, answer, work_type;
+      MPI_Comm task_comm;
+      rc = ADLB_Get(0, &payload, &len, 1024, &answer, &work_type,
+                    &task_comm);
+      if (rc == ADLB_SHUTDOWN)
+        break;
+      check(rc, "ADLB_Get");
+      received++;
+      free(payload);
+    }
+
+    int total;
+    MPI_Reduce(&received, &total, 1, MPI_INT, MPI_SUM, 0, worker_comm);
+    if (rank == 0)
+    {
+      int expected = (VALUES_PER_WORKER + 3) * nworkers;
+      printf("received: %i expected: %i\n", total, expected);
+      if (total != expected)
+      {
+        printf("FAILED\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+      }
+    }
+  }
+
+  ADLB_Finalize();
+  MPI_Finalize();
+  return 0;
+}
@@ -71,6 +71,8 @@ static adlb_code expt_wq(prio_mix prios, tgt_mix tgts, int init_qlen,
                          bool report);
 static adlb_code expt_rwq(prio_mix prios, tgt_mix tgts, int init_qlen,
                          bool report);
+static adlb_code expt_wq_alloc(prio_mix prios, tgt_mix tgts, int init_qlen,
+                         bool use_pool, bool report);
 
 static void report_hdr(void);
 static void report_expt(const char *expt, prio_mix prios, tgt_mix tgts,
@@ -193,6 +195,14 @@ static adlb_code run(bool run_benchmarks)
 
             ac = expt_rwq(prios[prio_idx], tgts[tgt_idx], init_qlen, report);
             ADLB_CHECK(ac);
+
+            ac = expt_wq_alloc(prios[prio_idx], tgts[tgt_idx], init_qlen,
+                               true, report);
+            ADLB_CHECK(ac);
+
+            ac = expt_wq_alloc(prios[prio_idx], tgts[tgt_idx], init_qlen,
+                               false, report);
+            ADLB_CHECK(ac);
           }
         }
       }
@@ -524,6 +534,109 @@ static adlb_code expt_rwq(prio_mix prios, tgt_mix tgts, int init_qlen,
   return ADLB_SUCCESS;
 }
 
+/*
+  Make a fresh copy of a work unit, as the server does for each put
+ */
+static xlb_work_unit *copy_wu(const xlb_work_unit *src)
+{
+  xlb_work_unit *wu = work_unit_alloc((size_t)src->length);
+  if (wu == NULL)
+    return NULL;
+
+  xlb_work_unit_init(wu, src->type, src->putter, src->answer,
+                     src->target, src->length, src->opts);
+  memcpy(wu->payload, src->payload, (size_t)src->length);
+  return wu;
+}
+
+/*
+  Run experiment on work queue where work units are allocated on put
+  and freed on get, as in the server.  Compare the work unit pool
+  against plain malloc.
+ */
+static adlb_code expt_wq_alloc(prio_mix prios, tgt_mix tgts, int init_qlen,
+                         bool use_pool, bool report)
+{
+  // Reseed before experiment
+  srand(random_seed);
+
+  adlb_code ac;
+
+  struct expt_wq_op {
+    int rank;
+    bool add;
+  };
+
+  // Precompute random sequence to avoid calling rand() in loop
+  struct expt_wq_op rand_ops[rand_seq_len];
+  for (int i = 0; i < rand_seq_len; i++)
+  {
+    rand_ops[i].add = (rand() >> 16) % 2;
+    // Target for incoming request
+    rand_ops[i].rank = (rand() >> 8) % xlb_s.layout.workers;
+  }
+
+  // Templates to copy work units from
+  xlb_work_unit **wus;
+
+  ac = make_wus(prios, tgts, payload_size, num_distinct_wus, &wus);
+  ADLB_CHECK(ac);
+
+  bool pool_was_enabled = xlb_wu_pool_enabled;
+  xlb_wu_pool_enabled = use_pool;
+
+  // Prepopulate queue
+  for (int i = 0; i < init_qlen; i++)
+  {
+    xlb_work_unit *wu = copy_wu(
+          wus[num_distinct_wus - 1 - (i % num_distinct_wus)]);
+    ADLB_CHECK_MALLOC(wu);
+    ac = xlb_workq_add(wu);
+    ADLB_CHECK(ac);
+  }
+
+  expt_timers timers;
+  time_begin(&timers);
+
+  int wu_idx = 0;
+
+  for (int op = 0; op < benchmark_nops; op++)
+  {
+    struct expt_wq_op *curr_op = &rand_ops[op % rand_seq_len];
+
+    if (curr_op->add)
+    {
+      xlb_work_unit *wu = copy_wu(wus[wu_idx++ % num_distinct_wus]);
+      ADLB_CHECK_MALLOC(wu);
+      ac = xlb_workq_add(wu);
+      ADLB_CHECK(ac);
+    }
+    else
+    {
+      // Get work unit and free it, as if sent to worker
+      xlb_work_unit *wu = xlb_workq_get(curr_op->rank, 0);
+      xlb_work_unit_free(wu);
+    }
+  }
+
+  time_end(&timers);
+
+  ac = drain_wq((int)payload_size, -1, true);
+  ADLB_CHECK(ac);
+
+  xlb_wu_pool_enabled = pool_was_enabled;
+
+  if (report)
+  {
+    report_expt(use_pool ? "wq_alloc_pool" : "wq_alloc_malloc",
+                prios, tgts, init_qlen, benchmark_nops, timers);
+  }
+
+  free_wus(num_distinct_wus, wus);
+
+  return ADLB_SUCCESS;
+}
+
 static void report_hdr(void)
 {
   printf("experiment,priorities,targets,init_qlen,nops,nsec,sec,nsec_op,"
@@ -131,6 +131,7 @@ class Turbine {
   private static final Token RETRIEVE_FLOAT = turbFn("retrieve_float");
   private static final Token RETRIEVE_STRING = turbFn("retrieve_string");
   private static final Token RETRIEVE_BLOB = turbFn("retrieve_blob");
+  private static final Token RETRIEVE_MULTI = turbFn("retrieve_multi");
   private static final Token ACQUIRE_REF = adlbFn("acquire_ref");
   private static final Token ACQUIRE_WRITE_REF = adlbFn("acquire_write_ref");
   private static final Token ACQUIRE_STRUCT_REF = turbFn("acquire_struct");
@@ -138,6 +139,8 @@ class Turbine {
   private static final Token ADLB_STORE = adlbFn("store");
   private static final Token CACHED = new Token("CACHED");
   private static final Token UNCACHED_MODE = new Token("UNCACHED");
+  private static final Token PLACEMENT = new Token("placement");
+  private static final Token PLACE_LOCAL = new Token("local");
 
   /**
    * Used to specify what caching is allowed for retrieve
@@ -506,6 +509,43 @@ class Turbine {
     return new Command(ADLB_STORE, args);
   }
 
+  /**
+   * Consecutive scalar retrieves, emitted as a single retrieve_multi
+   * so that values not in the cache are fetched with one request per
+   * server.  A batch with one member is emitted as a plain retrieve.
+   */
+  public static class RetrieveBatch extends TclTree {
+    private final SetVariable single;
+    private final List<String> targets = new ArrayList<String>();
+    private final List<Expression> args = new ArrayList<Expression>();
+
+    public RetrieveBatch(SetVariable single, String target, Value src,
+                         TypeName type, Expression decr) {
+      this.single = single;
+      add(target, src, type, decr);
+    }
+
+    public void add(String target, Value src, TypeName type,
+                    Expression decr) {
+      targets.add(target);
+      args.add(src);
+      args.add(type);
+      args.add(decr);
+    }
+
+    @Override
+    public void appendTo(StringBuilder sb) {
+      TclTree tree;
+      if (targets.size() == 1) {
+        tree = single;
+      } else {
+        tree = lassign(Square.fnCall(RETRIEVE_MULTI, args), targets);
+      }
+      tree.setIndentation(indentation);
+      tree.appendTo(sb);
+    }
+  }
+
   public static SetVariable integerDecrGet(String target, Value src,
           Expression decr) {
     return new SetVariable(target, new Square(RETRIEVE_INTEGER, src, CACHED,
@@ -1645,6 +1685,13 @@ class Turbine {
                   typeList), typeListStartIx, new LiteralInt(writeDecr)));
   }
 
+  /**
+   * Create args to hint that data be placed on the local server
+   */
+  public static List<Expression> localPlacement() {
+    return Arrays.<Expression>asList(PLACEMENT, PLACE_LOCAL);
+  }
+
   public static TclTree batchDeclare(List<String> batchedVarNames,
           List<TclList> batched) {
     assert(batchedVarNames.size() == batched.size());
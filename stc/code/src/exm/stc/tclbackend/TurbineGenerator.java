@@ -221,6 +221,13 @@ public class TurbineGenerator implements CompilerBackend {
    */
   private final StackLite<EnclosingLoop> loopStack = new StackLite<EnclosingLoop>();
 
+  /**
+   * Number of foreach and range loop bodies enclosing the current point.
+   * Data declared inside them is placed on the local server, close to the
+   * tasks of the iteration that produce and consume it.
+   */
+  private int loopBodyDepth = 0;
+
   /**
    * Stack for function ids
    */
@@ -624,6 +631,9 @@ public class TurbineGenerator implements CompilerBackend {
     createArgs.add(argToExpr(initReaders));
     createArgs.add(argToExpr(initWriters));
     createArgs.add(new LiteralInt(nextDebugSymbol(var)));
+    if (loopBodyDepth > 0 && !var.storage().isGlobal()) {
+      createArgs.addAll(Turbine.localPlacement());
+    }
     TclList createArgsL = new TclList(createArgs);
     return createArgsL;
   }
@@ -793,28 +803,34 @@ public class TurbineGenerator implements CompilerBackend {
         break;
       case FLOAT:
         if (hasDecrement) {
-          pointAdd(Turbine.floatDecrGet(prefixVar(dst), varToExpr(src),
-                                      argToExpr(decr)));
+          batchRetrieve(Turbine.floatDecrGet(prefixVar(dst), varToExpr(src),
+                        argToExpr(decr)), dst, src, Turbine.ADLB_FLOAT_TYPE,
+                        decr);
         } else {
-          pointAdd(Turbine.floatGet(prefixVar(dst), varToExpr(src)));
+          batchRetrieve(Turbine.floatGet(prefixVar(dst), varToExpr(src)),
+                        dst, src, Turbine.ADLB_FLOAT_TYPE, decr);
         }
         break;
       case BOOL:
       case INT:
         // Bool and int are represented internally as integers
         if (hasDecrement) {
-          pointAdd(Turbine.integerDecrGet(prefixVar(dst), varToExpr(src),
-                                      argToExpr(decr)));
+          batchRetrieve(Turbine.integerDecrGet(prefixVar(dst),
+                        varToExpr(src), argToExpr(decr)), dst, src,
+                        Turbine.ADLB_INT_TYPE, decr);
         } else {
-          pointAdd(Turbine.integerGet(prefixVar(dst), varToExpr(src)));
+          batchRetrieve(Turbine.integerGet(prefixVar(dst), varToExpr(src)),
+                        dst, src, Turbine.ADLB_INT_TYPE, decr);
         }
         break;
       case STRING:
         if (hasDecrement) {
-          pointAdd(Turbine.stringDecrGet(prefixVar(dst), varToExpr(src),
-              argToExpr(decr)));
+          batchRetrieve(Turbine.stringDecrGet(prefixVar(dst),
+                        varToExpr(src), argToExpr(decr)), dst, src,
+                        Turbine.ADLB_STRING_TYPE, decr);
         } else {
-          pointAdd(Turbine.stringGet(prefixVar(dst), varToExpr(src)));
+          batchRetrieve(Turbine.stringGet(prefixVar(dst), varToExpr(src)),
+                        dst, src, Turbine.ADLB_STRING_TYPE, decr);
         }
         break;
       case VOID:
@@ -831,6 +847,23 @@ public class TurbineGenerator implements CompilerBackend {
     }
   }
 
+  /**
+   * Add scalar retrieve to the current point, merging it with the
+   * previous retrieve if that was also a scalar retrieve
+   * @param single code for the retrieve on its own
+   */
+  private void batchRetrieve(SetVariable single, Var dst, Var src,
+                             Turbine.TypeName type, Arg decr) {
+    TclTree last = point().last();
+    if (last instanceof Turbine.RetrieveBatch) {
+      ((Turbine.RetrieveBatch)last).add(prefixVar(dst), varToExpr(src),
+                                         type, argToExpr(decr));
+    } else {
+      pointAdd(new Turbine.RetrieveBatch(single, prefixVar(dst),
+                            varToExpr(src), type, argToExpr(decr)));
+    }
+  }
+
   @Override
   public void dereferenceScalar(Var dst, Var src) {
     assert(Types.isScalarFuture(dst));
@@ -2722,6 +2755,7 @@ public class TurbineGenerator implements CompilerBackend {
     }
     curr.add(tclLoop);
     pointPush(loopBody);
+    loopBodyDepth++;
   }
 
 
@@ -2730,6 +2764,7 @@ public class TurbineGenerator implements CompilerBackend {
                   List<RefCount> perIterDecrements) {
     assert(pointStack.size() >= 2);
     pointPop(); // tclloop body
+    loopBodyDepth--;
     if (splitDegree > 0) {
       endRangeSplit(perIterDecrements);
     }
@@ -2847,6 +2882,7 @@ public class TurbineGenerator implements CompilerBackend {
   public void endRangeLoop(int splitDegree, List<RefCount> perIterDecrements) {
     assert(pointStack.size() >= 2);
     pointPop(); // for loop body
+    loopBodyDepth--;
 
     if (splitDegree > 0) {
       endRangeSplit(perIterDecrements);
@@ -2859,6 +2895,7 @@ public class TurbineGenerator implements CompilerBackend {
     ForLoop tclLoop = new ForLoop(loopVarName, startE, endE, incrE, loopBody);
     pointAdd(tclLoop);
     pointPush(loopBody);
+    loopBodyDepth++;
   }
 
   /**
@@ -66,6 +66,13 @@ public class Sequence extends TclTree {
     members.addAll(seq.members);
   }
 
+  /**
+   * @return last member of sequence, or null if empty
+   */
+  public TclTree last() {
+    return members.isEmpty() ? null : members.get(members.size() - 1);
+  }
+
   @Override
   public void appendTo(StringBuilder sb) {
     for (TclTree member: members) {
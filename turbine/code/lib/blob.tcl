@@ -117,8 +117,11 @@ namespace eval turbine {
   }
 
   proc floats2blob_body { blob floats } {
-    set floats_val [ adlb::retrieve $floats container ]
-    set blob_val [ floats2blob_impl $floats_val ]
+    # Fast path needs subscripts 0..N-1
+    if { [ catch { adlb::blob_from_container $floats } blob_val ] } {
+      set floats_val [ adlb::retrieve $floats container ]
+      set blob_val [ floats2blob_impl $floats_val ]
+    }
 
     store_blob $blob $blob_val
     adlb::local_blob_free $blob_val
@@ -135,8 +138,11 @@ namespace eval turbine {
   }
 
   proc ints2blob_body { blob ints } {
-    set ints_val [ adlb::retrieve $ints container ]
-    set blob_val [ ints2blob_impl $ints_val ]
+    # Fast path needs subscripts 0..N-1
+    if { [ catch { adlb::blob_from_container $ints } blob_val ] } {
+      set ints_val [ adlb::retrieve $ints container ]
+      set blob_val [ ints2blob_impl $ints_val ]
+    }
 
     store_blob $blob $blob_val
     adlb::local_blob_free $blob_val
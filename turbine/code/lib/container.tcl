@@ -22,7 +22,7 @@
 namespace eval turbine {
     namespace export container_f_get container_f_insert
     namespace export c_f_lookup deeprule
-    namespace export swift_array_build
+    namespace export swift_array_build container_foreach
 
     namespace import ::adlb::create_nested* \
                      ::adlb::struct_create_nested*
@@ -163,6 +163,9 @@ namespace eval turbine {
               }
               set val_dict [ dict create ]
 
+              # Send stores of members and container to servers in
+              # batches
+              adlb::write_buffer_begin
               set i 0
               dict for { key val } $cval {
                 set val_id [ lindex $val_ids $i ]
@@ -185,6 +188,9 @@ namespace eval turbine {
           }
           # Store values all at once
           adlb::store $id container $key_type $val_type $val_dict $write_decr
+          if { $val_type in { ref file_ref } } {
+            adlb::write_buffer_end
+          }
         }
         multiset {
           set n [ llength $cval ]
@@ -206,6 +212,9 @@ namespace eval turbine {
                 set val_list [ list ]
               }
 
+              # Send stores of members and multiset to servers in
+              # batches
+              adlb::write_buffer_begin
               set i 0
               foreach val $cval {
                 set val_id [ lindex $val_list $i ]
@@ -226,6 +235,9 @@ namespace eval turbine {
           }
           # Store values all at once
           adlb::store $id multiset $val_type $val_list $write_decr
+          if { $val_type in { ref file_ref } } {
+            adlb::write_buffer_end
+          }
         }
         file {
           store_file $id cval
@@ -692,6 +704,64 @@ namespace eval turbine {
       return [ adlb::container_size $container $read_decr ]
     }
 
+    # Iterate over container or multiset like foreach, fetching
+    # members in chunks from a cursor on the server, so the whole
+    # container is never held in memory and each chunk costs the same.
+    # vars: variable for member, or list of variables for subscript
+    #       and member
+    # read_decr: read refcount to decrement when iteration finishes,
+    #            including by break, return or error
+    # chunk: number of members to fetch at a time
+    proc container_foreach { vars container body {read_decr 0}
+                             {chunk 1024} } {
+      switch [ llength $vars ] {
+        1 { set token members }
+        2 { set token dict }
+        default {
+          error "container_foreach: expected 1 or 2 variables: $vars"
+        }
+      }
+      set names [ list ]
+      foreach v $vars {
+        set name "item_[ llength $names ]"
+        upvar 1 $v $name
+        lappend names $name
+      }
+
+      set cursor 0
+      while { true } {
+        lassign [ adlb::enumerate_next $container $cursor $token \
+                                       $chunk $read_decr ] cursor items
+        foreach $names $items {
+          set code [ catch { uplevel 1 $body } result options ]
+          switch $code {
+            0 -
+            4 {
+              # ok or continue
+            }
+            3 {
+              # break
+              if { $cursor != 0 } {
+                adlb::enumerate_close $container $cursor $read_decr
+              }
+              return
+            }
+            default {
+              if { $cursor != 0 } {
+                adlb::enumerate_close $container $cursor $read_decr
+              }
+              dict incr options -level
+              return -options $options $result
+            }
+          }
+        }
+        if { $cursor == 0 } {
+          # Server released cursor and decremented refcount
+          return
+        }
+      }
+    }
+
     # When integer i is closed,
     #        return whether exists c[i]
     # Does not wait for container c to be closed.
@@ -960,6 +1030,8 @@ namespace eval turbine {
         container_deep_wait $inner [ expr {$nest_level - 1} ] $base_type \
                             $signal
       } else {
+        # Send rules for members to servers in batches
+        adlb::batch_begin
         foreach inner $members {
           set inner_signal [ allocate void ]
           lappend inner_signals $inner_signal
@@ -968,6 +1040,7 @@ namespace eval turbine {
         }
         rule $inner_signals \
             "deeprule_fire_signal \"$inner_signals\" $signal"
+        adlb::batch_end
       }
     }
 
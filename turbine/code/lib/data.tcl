@@ -34,7 +34,7 @@ namespace eval turbine {
         retrieve_ref retrieve_decr_ref acquire_ref    \
         create_struct     store_struct                \
         retrieve_struct retrieve_decr_struct acquire_struct \
-        retrieve_decr_blob_string                     \
+        retrieve_decr_blob_string retrieve_multi      \
         allocate_container                            \
         container_lookup container_list               \
         container_insert notify_waiter                \
@@ -377,6 +377,39 @@ namespace eval turbine {
       return [ retrieve_string $id $cachemode 1 ]
     }
 
+    # Retrieve several scalars, fetching any not in the cache with one
+    # request per server
+    # args: triples of id, type and read refcount decrement
+    # returns list of values
+    proc retrieve_multi { args } {
+        set result [ list ]
+        set fetch [ list ]
+        set fetch_pos [ list ]
+        foreach { id type decrref } $args {
+            if { [ c::cache_check $id ] } {
+                lappend result [ c::cache_retrieve $id ]
+                if { $decrref } {
+                  read_refcount_decr $id $decrref
+                }
+            } else {
+                lappend fetch_pos [ llength $result ]
+                lappend result {}
+                lappend fetch $id $decrref $type
+            }
+        }
+
+        if { [ llength $fetch ] > 0 } {
+            set values [ adlb::retrieve_multi {*}$fetch ]
+            foreach pos $fetch_pos { id decrref type } $fetch \
+                    value $values {
+                lset result $pos $value
+                c::cache_store $id $type $value
+            }
+        }
+        debug "retrieve_multi: $args => [ log_string $result ]"
+        return $result
+    }
+
     proc create_void { id {read_refcount 1} {write_refcount 1} \
                           {debug_symbol 0} {permanent 0} } {
         # emulating void with integer
@@ -29,27 +29,9 @@ namespace eval turbine {
     }
 
     proc sum_integer_body { container result } {
-        # TODO: could divide and conquer instead of doing linear search
-        set CHUNK_SIZE 65536
-        set accum 0
-        set pos 0
-        set maybe_more 1
-
-        while { $maybe_more } {
-          set members [ adlb::enumerate $container members $CHUNK_SIZE $pos ]
-          set members_len [ llength $members ]
-          set maybe_more [ expr $members_len == $CHUNK_SIZE ]
-          incr pos $members_len
-
-          # puts "members of $container $i $this_chunk_size : $members"
-          foreach val $members {
-            # add to the sum
-            set accum [ expr {$accum + $val} ]
-          }
-        }
-        # If we get out of loop, we're done
+        # Sum on server that owns container
+        set accum [ adlb::reduce $container sum 1 ]
         store_integer $result $accum
-        read_refcount_decr $container
     }
 
     # Sum all of the values in a container of floats
@@ -65,27 +47,9 @@ namespace eval turbine {
     }
 
     proc sum_float_body { container result } {
-        # TODO: could divide and conquer instead of doing linear search
-        set CHUNK_SIZE 65536
-        set accum 0
-        set pos 0
-        set maybe_more 1
-
-        while { $maybe_more } {
-          set members [ adlb::enumerate $container members $CHUNK_SIZE $pos ]
-          set members_len [ llength $members ]
-          set maybe_more [ expr $members_len == $CHUNK_SIZE ]
-          incr pos $members_len
-
-          # puts "members of $container $i $this_chunk_size : $members"
-          foreach val $members {
-            # add to the sum
-            set accum [ expr {$accum + $val} ]
-          }
-        }
-        # If we get out of loop, we're done
+        # Sum on server that owns container
+        set accum [ adlb::reduce $container sum 1 ]
         store_float $result $accum
-        read_refcount_decr $container
     }
 
     # calculate mean of an array of floats or ints
@@ -127,6 +91,13 @@ namespace eval turbine {
     # Calculate mean, standard deviation, max, min for array of float or int
     proc stats_body { container n_out sum_out mean_out M2_out \
                 samp_std_out pop_std_out max_out min_out } {
+      if { $M2_out == 0 && $samp_std_out == 0 && $pop_std_out == 0 } {
+        # Don't need the values here
+        stats_reduce_body $container $n_out $sum_out $mean_out \
+                          $max_out $min_out
+        return
+      }
+
       set sum_accum 0.0
       set mean_accum 0.0 
       set M2_accum 0.0
@@ -142,20 +113,8 @@ namespace eval turbine {
       }
 
       set i 0
-      while { $i < $n } {
-        set last_chunk [ expr { $i + $CHUNK_SIZE >= $n } ]
-
-        if { $last_chunk } {
-          set this_chunk_size [ expr {$n - $i} ]
-          set read_decr 1
-        } else {
-          set this_chunk_size $CHUNK_SIZE
-          set read_decr 0
-        }
-
-        set vals [ adlb::enumerate $container members $this_chunk_size $i $read_decr ]
-
-        foreach x $vals {
+      if { $n > 0 } {
+        container_foreach x $container {
           # Make sure it's floating point so we don't get surprised by
           # integer division
           set x [ expr {double($x)} ]
@@ -178,7 +137,7 @@ namespace eval turbine {
           set mean_accum [ expr {$mean_accum + ( $delta / ($i + 1) )} ]
           set M2_accum [ expr {$M2_accum + $delta*($x - $mean_accum)} ]
           incr i
-        }
+        } 1 $CHUNK_SIZE
       }
       
       if { $n == 0 } {
@@ -231,6 +190,50 @@ namespace eval turbine {
       }
     }
 
+    # As stats_body, but reduce on server that owns container
+    proc stats_reduce_body { container n_out sum_out mean_out \
+                             max_out min_out } {
+      set n [ adlb::reduce $container count ]
+      if { $n_out != 0 } {
+        store_integer $n_out $n
+      }
+
+      if { $sum_out != 0 || $mean_out != 0 } {
+        set sum [ expr {double([ adlb::reduce $container sum ])} ]
+      }
+      if { $min_out != 0 && $n != 0 } {
+        set min [ expr {double([ adlb::reduce $container min ])} ]
+      }
+      if { $max_out != 0 && $n != 0 } {
+        set max [ expr {double([ adlb::reduce $container max ])} ]
+      }
+      read_refcount_decr $container
+
+      if { $sum_out != 0 } {
+        store_float $sum_out $sum
+      }
+
+      if { $mean_out != 0 } {
+        if { $n == 0 } {
+          error "calculating mean of empty array <$container>"
+        }
+        store_float $mean_out [ expr {$sum / $n} ]
+      }
+
+      if { $min_out != 0 } {
+        if { $n == 0 } {
+          error "calculating min of empty array <$container>"
+        }
+        store_float $min_out $min
+      }
+
+      if { $max_out != 0 } {
+        if { $n == 0 } {
+          error "calculating max of empty array <$container>"
+        }
+        store_float $max_out $max
+      }
+    }
 
   # take a container of PartialStats and summarize them
   # outputs are mean, stddev
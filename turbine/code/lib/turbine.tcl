@@ -18,9 +18,9 @@
 package provide turbine [ turbine::c::version ]
 
 namespace eval turbine {
-    namespace import ::turbine::c::rule
+    namespace import ::turbine::c::rule ::turbine::c::rule_group
 
-    namespace export init start finalize spawn_rule rule
+    namespace export init start finalize spawn_rule rule rule_group
 
 
     # Import adlb commands
@@ -68,6 +68,7 @@
 #include <vint.h>
 
 #include "src/tcl/util.h"
+#include "src/turbine/blob_shm.h"
 #include "src/util/debug.h"
 
 #include "tcl-adlb.h"
@@ -163,6 +164,28 @@ static struct {
   int size;
 } field_name_objs;
 
+/**
+   Tasks buffered by tcl_adlb_dput() between adlb::batch_begin and
+   adlb::batch_end, to be sent with ADLB_Dput_batch
+ */
+static struct {
+  int depth; // Nesting depth of batch_begin calls
+  adlb_put_spec *tasks;
+  void **storage; // Copies of data referenced by each task
+  int count;
+  int size;
+} put_batch = { 0, NULL, NULL, 0, 0 };
+
+/** Send buffered tasks once we have this many */
+#define PUT_BATCH_MAX 256
+
+/**
+   Nesting depth of adlb::write_buffer_begin calls.  If positive,
+   adlb::store and adlb::write_refcount_decr are buffered by ADLB.
+   Read refcount decrements are always buffered.
+ */
+static int write_buffer_depth = 0;
+
 /*
   Represent full type of a data structure
  */
@@ -198,6 +221,8 @@ static int uncache_blob(Tcl_Interp *interp, int objc,
 
 static int blob_cache_finalize(void);
 
+static adlb_code put_batch_flush(void);
+
 static int
 packed_struct_to_tcl_dict(Tcl_Interp *interp, Tcl_Obj *const objv[],
                          const void *data, size_t length,
@@ -484,6 +509,10 @@ ADLB_Init_Cmd(ClientData cdata, Tcl_Interp *interp,
   if (! am_server)
     MPI_Comm_rank(adlb_worker_comm, &adlb_worker_comm_rank);
 
+  turbine_code tc = turbine_blob_shm_init(adlb_comm);
+  TCL_CONDITION(tc == TURBINE_SUCCESS,
+                "Could not initialize node blob store");
+
   // Set static variables
   adlb_workers = workers;
   adlb_servers = servers;
@@ -980,6 +1009,298 @@ ADLB_Spawn_Cmd(ClientData cdata, Tcl_Interp *interp,
   return TCL_OK;
 }
 
+/**
+   Send all tasks buffered by tcl_adlb_dput()
+ */
+static adlb_code
+put_batch_flush(void)
+{
+  if (put_batch.count == 0)
+    return ADLB_SUCCESS;
+
+  DEBUG_ADLB("adlb::batch: flushing %i tasks", put_batch.count);
+  adlb_code ac = ADLB_Dput_batch(put_batch.tasks, put_batch.count);
+
+  for (int i = 0; i < put_batch.count; i++)
+  {
+    free(put_batch.storage[i]);
+  }
+  put_batch.count = 0;
+  return ac;
+}
+
+/**
+   Add copy of task to put_batch.  All data referenced by the task is
+   copied into a single allocation.
+ */
+static adlb_code
+put_batch_add(const void* payload, int length, int target,
+        int answer, int type, adlb_put_opts opts, const char *name,
+        const adlb_datum_id *wait_ids, int wait_id_count,
+        const adlb_datum_id_sub *wait_id_subs, int wait_id_sub_count)
+{
+  if (put_batch.count == put_batch.size)
+  {
+    int new_size = put_batch.size == 0 ? 16 : put_batch.size * 2;
+    adlb_put_spec *tasks = realloc(put_batch.tasks,
+                              sizeof(tasks[0]) * (size_t)new_size);
+    if (tasks == NULL)
+      return ADLB_ERROR;
+    put_batch.tasks = tasks;
+    void **storage = realloc(put_batch.storage,
+                              sizeof(storage[0]) * (size_t)new_size);
+    if (storage == NULL)
+      return ADLB_ERROR;
+    put_batch.storage = storage;
+    put_batch.size = new_size;
+  }
+
+  // Arrays first for alignment, then subscripts, payload and name
+  size_t ids_size = sizeof(wait_ids[0]) * (size_t)wait_id_count;
+  size_t subs_size = sizeof(wait_id_subs[0]) * (size_t)wait_id_sub_count;
+  size_t name_size = (name != NULL) ? strlen(name) + 1 : 0;
+  size_t total = ids_size + subs_size + (size_t)length + name_size;
+  for (int i = 0; i < wait_id_sub_count; i++)
+  {
+    total += wait_id_subs[i].subscript.length;
+  }
+
+  char *storage = malloc(total > 0 ? total : 1);
+  if (storage == NULL)
+    return ADLB_ERROR;
+  char *pos = storage;
+
+  adlb_datum_id *ids_copy = (adlb_datum_id*)pos;
+  memcpy(ids_copy, wait_ids, ids_size);
+  pos += ids_size;
+
+  adlb_datum_id_sub *subs_copy = (adlb_datum_id_sub*)pos;
+  pos += subs_size;
+  for (int i = 0; i < wait_id_sub_count; i++)
+  {
+    subs_copy[i] = wait_id_subs[i];
+    if (adlb_has_sub(wait_id_subs[i].subscript))
+    {
+      memcpy(pos, wait_id_subs[i].subscript.key,
+             wait_id_subs[i].subscript.length);
+      subs_copy[i].subscript.key = pos;
+      pos += wait_id_subs[i].subscript.length;
+    }
+  }
+
+  memcpy(pos, payload, (size_t)length);
+  const void *payload_copy = pos;
+  pos += length;
+
+  const char *name_copy = NULL;
+  if (name != NULL)
+  {
+    memcpy(pos, name, name_size);
+    name_copy = pos;
+  }
+
+  adlb_put_spec *task = &put_batch.tasks[put_batch.count];
+  task->payload = payload_copy;
+  task->length = length;
+  task->target = target;
+  task->answer = answer;
+  task->type = type;
+  task->opts = opts;
+  task->name = name_copy;
+  task->wait_ids = ids_copy;
+  task->wait_id_count = wait_id_count;
+  task->wait_id_subs = subs_copy;
+  task->wait_id_sub_count = wait_id_sub_count;
+  put_batch.storage[put_batch.count] = storage;
+  put_batch.count++;
+
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+tcl_adlb_dput(const void* payload, int length, int target,
+        int answer, int type, adlb_put_opts opts, const char *name,
+        const adlb_datum_id *wait_ids, int wait_id_count,
+        const adlb_datum_id_sub *wait_id_subs, int wait_id_sub_count)
+{
+  if (put_batch.depth == 0)
+  {
+    return ADLB_Dput(payload, length, target, answer, type, opts, name,
+            wait_ids, wait_id_count, wait_id_subs, wait_id_sub_count);
+  }
+
+  adlb_code ac = put_batch_add(payload, length, target, answer, type,
+        opts, name, wait_ids, wait_id_count, wait_id_subs,
+        wait_id_sub_count);
+  if (ac != ADLB_SUCCESS)
+    return ac;
+
+  if (put_batch.count >= PUT_BATCH_MAX)
+  {
+    return put_batch_flush();
+  }
+  return ADLB_SUCCESS;
+}
+
+adlb_code
+tcl_adlb_dput_group(const adlb_datum_id *shared_ids,
+        int shared_id_count, const adlb_datum_id_sub *shared_id_subs,
+        int shared_id_sub_count, const adlb_put_spec *tasks, int count)
+{
+  adlb_code ac = put_batch_flush();
+  if (ac != ADLB_SUCCESS)
+    return ac;
+
+  return ADLB_Dput_group(shared_ids, shared_id_count, shared_id_subs,
+                         shared_id_sub_count, tasks, count);
+}
+
+/**
+   Start buffering tasks from turbine::rule to send in batches.
+   Calls may be nested: tasks are sent when outermost batch ends,
+   or when PUT_BATCH_MAX tasks are buffered.
+   usage: adlb::batch_begin
+ */
+static int
+ADLB_Batch_Begin_Cmd(ClientData cdata, Tcl_Interp *interp,
+                     int objc, Tcl_Obj *const objv[])
+{
+  TCL_ARGS(1);
+  put_batch.depth++;
+  return TCL_OK;
+}
+
+/**
+   End batch started with adlb::batch_begin
+   usage: adlb::batch_end
+ */
+static int
+ADLB_Batch_End_Cmd(ClientData cdata, Tcl_Interp *interp,
+                   int objc, Tcl_Obj *const objv[])
+{
+  TCL_ARGS(1);
+  TCL_CONDITION(put_batch.depth > 0,
+                "adlb::batch_end without adlb::batch_begin");
+
+  put_batch.depth--;
+  if (put_batch.depth == 0)
+  {
+    adlb_code ac = put_batch_flush();
+    TCL_CONDITION(ac == ADLB_SUCCESS, "ADLB_Dput_batch failed!");
+  }
+  return TCL_OK;
+}
+
+/**
+   Start buffering stores and write refcount decrements.  Calls may be
+   nested: buffered writes are sent when outermost buffer ends, or
+   earlier if ADLB needs to, e.g. when this worker gets its next task.
+   usage: adlb::write_buffer_begin
+ */
+static int
+ADLB_Write_Buffer_Begin_Cmd(ClientData cdata, Tcl_Interp *interp,
+                            int objc, Tcl_Obj *const objv[])
+{
+  TCL_ARGS(1);
+  write_buffer_depth++;
+  return TCL_OK;
+}
+
+/**
+   End buffering started with adlb::write_buffer_begin
+   usage: adlb::write_buffer_end
+ */
+static int
+ADLB_Write_Buffer_End_Cmd(ClientData cdata, Tcl_Interp *interp,
+                          int objc, Tcl_Obj *const objv[])
+{
+  TCL_ARGS(1);
+  TCL_CONDITION(write_buffer_depth > 0,
+                "adlb::write_buffer_end without adlb::write_buffer_begin");
+
+  write_buffer_depth--;
+  if (write_buffer_depth == 0)
+  {
+    adlb_code ac = ADLB_Flush_writes();
+    TCL_CONDITION(ac != ADLB_REJECTED,
+                  "buffered store failed: double assign!");
+    TCL_CONDITION(ac == ADLB_SUCCESS, "ADLB_Flush_writes failed!");
+  }
+  return TCL_OK;
+}
+
+/**
+   Put several tasks with one call.  Each task is a list with the
+   arguments of adlb::put.
+   usage: adlb::put_batch <tasks>
+ */
+static int
+ADLB_Put_Batch_Cmd(ClientData cdata, Tcl_Interp *interp,
+                   int objc, Tcl_Obj *const objv[])
+{
+  TCL_ARGS(2);
+  int rc;
+
+  int count;
+  Tcl_Obj **task_objs;
+  rc = Tcl_ListObjGetElements(interp, objv[1], &count, &task_objs);
+  TCL_CHECK_MSG(rc, "adlb::put_batch: argument must be list of tasks");
+
+  adlb_put_spec tasks[count];
+  for (int i = 0; i < count; i++)
+  {
+    int argc;
+    Tcl_Obj **args;
+    rc = Tcl_ListObjGetElements(interp, task_objs[i], &argc, &args);
+    TCL_CHECK(rc);
+    TCL_CONDITION(argc >= 5 && argc <= 7,
+          "adlb::put_batch: task %i: expected 5 to 7 elements", i);
+
+    adlb_put_spec *t = &tasks[i];
+    t->opts = ADLB_DEFAULT_PUT_OPTS;
+    rc = Tcl_GetIntFromObj(interp, args[0], &t->target);
+    TCL_CHECK(rc);
+    rc = Tcl_GetIntFromObj(interp, args[1], &t->type);
+    TCL_CHECK(rc);
+    int cmd_len;
+    t->payload = Tcl_GetStringFromObj(args[2], &cmd_len);
+    t->length = cmd_len + 1;
+    rc = Tcl_GetIntFromObj(interp, args[3], &t->opts.priority);
+    TCL_CHECK(rc);
+    rc = Tcl_GetIntFromObj(interp, args[4], &t->opts.parallelism);
+    TCL_CHECK(rc);
+
+    if (t->target >= 0)
+    {
+      t->opts.strictness = ADLB_TGT_STRICT_HARD;
+      t->opts.accuracy = ADLB_TGT_ACCRY_RANK;
+    }
+    if (argc >= 6)
+    {
+      rc = adlb_parse_strictness(interp, args[5], &t->opts.strictness);
+      TCL_CHECK(rc);
+    }
+    if (argc >= 7)
+    {
+      rc = adlb_parse_accuracy(interp, args[6], &t->opts.accuracy);
+      TCL_CHECK(rc);
+    }
+
+    t->answer = adlb_comm_rank;
+    t->name = NULL;
+    t->wait_ids = NULL;
+    t->wait_id_count = 0;
+    t->wait_id_subs = NULL;
+    t->wait_id_sub_count = 0;
+  }
+
+  DEBUG_ADLB("adlb::put_batch: %i tasks", count);
+
+  adlb_code ac = ADLB_Put_batch(tasks, count);
+  TCL_CONDITION(ac == ADLB_SUCCESS, "ADLB_Put_batch failed!");
+  return TCL_OK;
+}
+
 /**
    usage: get_priority
  */
@@ -1347,6 +1668,36 @@ extract_create_props(Tcl_Interp *interp, bool accept_id, int argstart,
       TCL_CONDITION(ac == ADLB_SUCCESS, "invalid placement string %s",
                     placement_s);
       argpos++;
+
+      // Hints take argument: datum ID, rank or key
+      if (props->placement == ADLB_PLACE_DATUM ||
+          props->placement == ADLB_PLACE_RANK ||
+          props->placement == ADLB_PLACE_HASH)
+      {
+        TCL_CONDITION(argpos + 1 < objc, "Missing argument for "
+                      "placement %s", placement_s);
+        Tcl_Obj *hint = objv[argpos + 1];
+        if (props->placement == ADLB_PLACE_DATUM)
+        {
+          rc = Tcl_GetADLB_ID(interp, hint, &props->placement_arg);
+          TCL_CHECK_MSG(rc, "could not get datum ID for placement");
+        }
+        else if (props->placement == ADLB_PLACE_RANK)
+        {
+          int rank;
+          rc = Tcl_GetIntFromObj(interp, hint, &rank);
+          TCL_CHECK_MSG(rc, "could not get rank for placement");
+          props->placement_arg = rank;
+        }
+        else
+        {
+          int key_len;
+          const char *key = Tcl_GetStringFromObj(hint, &key_len);
+          props->placement_arg = ADLB_Placement_hash(key,
+                                                     (size_t)key_len);
+        }
+        argpos++;
+      }
     }
     else
     {
@@ -1377,7 +1728,9 @@ extract_create_props(Tcl_Interp *interp, bool accept_id, int argstart,
 /**
    usage: adlb::create <id> <type> [<extra for type>]
           [ <read_refcount> [ <write_refcount> [ <permanent> ] ] ]
+          [ placement <policy> [ <datum ID, rank or key> ] ]
    if <id> is adlb::NULL_ID, returns a newly created id
+   policy datum, rank or hash is a hint that takes an argument
    @param extra is only used for files and containers
 */
 static int
@@ -2633,7 +2986,12 @@ ADLB_Store_Cmd(ClientData cdata, Tcl_Interp *interp,
           "extra trailing arguments starting at argument %i", argpos);
 
   // DEBUG_ADLB("adlb::store: <%"PRId64">=%s", id, data);
-  int store_rc = ADLB_Store(handle.id, handle.sub.val, type,
+  int store_rc;
+  if (write_buffer_depth > 0)
+    store_rc = ADLB_Store_buffered(handle.id, handle.sub.val, type,
+                  data.data, data.length, decr, store_refcounts);
+  else
+    store_rc = ADLB_Store(handle.id, handle.sub.val, type,
                   data.data, data.length, decr, store_refcounts);
 
   // Free if needed
@@ -2739,6 +3097,115 @@ ADLB_Retrieve_Impl(ClientData cdata, Tcl_Interp *interp,
   return TCL_OK;
 }
 
+/**
+   usage: adlb::retrieve_multi [<id> <decr> <type>]*
+   Retrieve several datums at once, decrementing the read reference
+   count of each by <decr>.  Types are checked as for adlb::retrieve.
+   returns list of values in the order given
+*/
+static int
+ADLB_Retrieve_Multi_Cmd(ClientData cdata, Tcl_Interp *interp,
+                        int objc, Tcl_Obj *const objv[])
+{
+  TCL_CONDITION(objc % 3 == 1, "requires triples of id, decr, type!");
+  int rc;
+  int count = (objc - 1) / 3;
+  if (count == 0)
+  {
+    Tcl_SetObjResult(interp, Tcl_NewListObj(0, NULL));
+    return TCL_OK;
+  }
+
+  tcl_adlb_handle *handles = malloc(sizeof(handles[0]) * (size_t)count);
+  adlb_data_type *given_types = malloc(sizeof(given_types[0]) *
+                                       (size_t)count);
+  adlb_type_extra *extras = malloc(sizeof(extras[0]) * (size_t)count);
+  adlb_retrieve_spec *specs = calloc((size_t)count, sizeof(specs[0]));
+  adlb_retrieve_result *results = malloc(sizeof(results[0]) *
+                                         (size_t)count);
+
+  int parsed = 0;
+  void *storage = NULL;
+  Tcl_Obj *list = NULL;
+  TCL_CONDITION_GOTO(handles != NULL && given_types != NULL &&
+        extras != NULL && specs != NULL && results != NULL, exit_err,
+        "Allocating memory failed");
+
+  for (int i = 0; i < count; i++)
+  {
+    Tcl_Obj *const *args = &objv[1 + i * 3];
+    // Each handle needs its own subscript buffer
+    rc = ADLB_PARSE_HANDLE(args[0], &handles[i], false);
+    TCL_CHECK_MSG_GOTO(rc, exit_err, "Invalid handle %s",
+                       Tcl_GetString(args[0]));
+    parsed++;
+
+    int decr_amount;
+    rc = Tcl_GetIntFromObj(interp, args[1], &decr_amount);
+    TCL_CHECK_MSG_GOTO(rc, exit_err, "requires decr amount!");
+
+    rc = adlb_type_from_obj_extra(interp, objv, args[2], &given_types[i],
+                                  &extras[i]);
+    TCL_CHECK_MSG_GOTO(rc, exit_err, "arg %i must be valid type!",
+                       3 + i * 3);
+
+    specs[i].id = handles[i].id;
+    specs[i].subscript = handles[i].sub.val;
+    specs[i].refcounts = ADLB_RETRIEVE_NO_REFC;
+    specs[i].refcounts.decr_self.read_refcount = decr_amount;
+  }
+
+  // Errors for individual datums are reported below
+  adlb_code ac = ADLB_Retrieve_multi(specs, count, results, &storage);
+  TCL_CONDITION_GOTO(ac == ADLB_SUCCESS, exit_err,
+                     "ADLB_Retrieve_multi failed!");
+
+  list = Tcl_NewListObj(0, NULL);
+  Tcl_IncrRefCount(list);
+  for (int i = 0; i < count; i++)
+  {
+    tcl_adlb_handle *h = &handles[i];
+    TCL_CONDITION_GOTO(results[i].code != ADLB_NOTHING, exit_err,
+                       "<%"PRId64"> not found!", h->id);
+    TCL_CONDITION_GOTO(results[i].code == ADLB_SUCCESS, exit_err,
+                       "<%"PRId64"> failed!", h->id);
+
+    if (given_types[i] != ADLB_DATA_TYPE_NULL &&
+        given_types[i] != results[i].type)
+    {
+      report_type_mismatch(given_types[i], results[i].type);
+      goto exit_err;
+    }
+
+    Tcl_Obj *val;
+    rc = adlb_datum2tclobj(interp, objv, h->id, results[i].type,
+                  extras[i], results[i].data, results[i].length, &val);
+    TCL_CHECK_GOTO(rc, exit_err);
+    Tcl_ListObjAppendElement(interp, list, val);
+  }
+
+  Tcl_SetObjResult(interp, list);
+  rc = TCL_OK;
+  goto exit;
+
+exit_err:
+  rc = TCL_ERROR;
+exit:
+  for (int i = 0; i < parsed; i++)
+  {
+    ADLB_PARSE_HANDLE_CLEANUP(&handles[i]);
+  }
+  if (list != NULL)
+    Tcl_DecrRefCount(list);
+  free(storage);
+  free(handles);
+  free(given_types);
+  free(extras);
+  free(specs);
+  free(results);
+  return rc;
+}
+
 /**
    interp, objv, id, and length: just for error checking and messages
    If object is a blob, this converts it to a string
@@ -3091,6 +3558,118 @@ ADLB_Enumerate_Cmd(ClientData cdata, Tcl_Interp *interp,
   return TCL_OK;
 }
 
+/**
+   usage:
+   adlb::enumerate_next <id> <cursor> subscripts|members|dict|count
+                        <count> [<read decr>] [<write decr>]
+
+   Return list of next cursor and next chunk of at most count members,
+   in the format of adlb::enumerate.  The cursor starts at 0, and is 0
+   again after the last chunk, when the refcounts are decremented.
+ */
+static int
+ADLB_Enumerate_Next_Cmd(ClientData cdata, Tcl_Interp *interp,
+                        int objc, Tcl_Obj *const objv[])
+{
+  TCL_CONDITION(objc >= 5, "must have at least 5 arguments");
+  int rc;
+  int argpos = 1;
+  adlb_datum_id container_id;
+  Tcl_WideInt cursor;
+  int count;
+  rc = Tcl_GetADLB_ID(interp, objv[argpos++], &container_id);
+  TCL_CHECK_MSG(rc, "requires container id!");
+  rc = Tcl_GetWideIntFromObj(interp, objv[argpos++], &cursor);
+  TCL_CHECK_MSG(rc, "requires cursor!");
+  char* token = Tcl_GetStringFromObj(objv[argpos++], NULL);
+  TCL_CONDITION(token, "requires token!");
+  rc = Tcl_GetIntFromObj(interp, objv[argpos++], &count);
+  TCL_CHECK_MSG(rc, "requires count!");
+
+  adlb_refc decr = ADLB_NO_REFC;
+  if (argpos < objc)
+  {
+    rc = Tcl_GetIntFromObj(interp, objv[argpos++], &decr.read_refcount);
+    TCL_CHECK_MSG(rc, "Expected integer argument");
+  }
+  if (argpos < objc)
+  {
+    rc = Tcl_GetIntFromObj(interp, objv[argpos++], &decr.write_refcount);
+    TCL_CHECK_MSG(rc, "Expected integer argument");
+  }
+
+  TCL_CONDITION(argpos == objc, "unexpected trailing args at %ith arg",
+                                argpos);
+
+  bool include_keys;
+  bool include_vals;
+  void *data = NULL;
+  size_t data_length;
+  int records;
+  adlb_type_extra kv_type;
+  rc = set_enumerate_params(interp, objv, token, &include_keys,
+                            &include_vals);
+  TCL_CHECK_MSG(rc, "unknown token %s!", token);
+
+  int64_t next = cursor;
+  rc = ADLB_Enumerate_next(container_id, &next, count, decr,
+                      include_keys, include_vals,
+                      &data, &data_length, &records, &kv_type);
+  TCL_CONDITION(rc == ADLB_SUCCESS, "ADLB enumerate_next call failed");
+
+  Tcl_Obj* items[2];
+  items[0] = Tcl_NewWideIntObj(next);
+  rc = enumerate_object(interp, objv, container_id,
+                        include_keys, include_vals,
+                        data, data_length, records, kv_type, &items[1]);
+  TCL_CHECK(rc);
+
+  if (data != NULL)
+    free(data);
+
+  Tcl_SetObjResult(interp, Tcl_NewListObj(2, items));
+  return TCL_OK;
+}
+
+/**
+   usage:
+   adlb::enumerate_close <id> <cursor> [<read decr>] [<write decr>]
+
+   Stop enumeration started with adlb::enumerate_next and decrement
+   refcounts.  The cursor may be 0.
+ */
+static int
+ADLB_Enumerate_Close_Cmd(ClientData cdata, Tcl_Interp *interp,
+                         int objc, Tcl_Obj *const objv[])
+{
+  TCL_CONDITION(objc >= 3 && objc <= 5,
+                "requires 2 to 4 arguments");
+  int rc;
+  int argpos = 1;
+  adlb_datum_id container_id;
+  Tcl_WideInt cursor;
+  rc = Tcl_GetADLB_ID(interp, objv[argpos++], &container_id);
+  TCL_CHECK_MSG(rc, "requires container id!");
+  rc = Tcl_GetWideIntFromObj(interp, objv[argpos++], &cursor);
+  TCL_CHECK_MSG(rc, "requires cursor!");
+
+  adlb_refc decr = ADLB_NO_REFC;
+  if (argpos < objc)
+  {
+    rc = Tcl_GetIntFromObj(interp, objv[argpos++], &decr.read_refcount);
+    TCL_CHECK_MSG(rc, "Expected integer argument");
+  }
+  if (argpos < objc)
+  {
+    rc = Tcl_GetIntFromObj(interp, objv[argpos++], &decr.write_refcount);
+    TCL_CHECK_MSG(rc, "Expected integer argument");
+  }
+
+  rc = ADLB_Enumerate_close(container_id, cursor, decr);
+  TCL_CONDITION(rc == ADLB_SUCCESS, "ADLB enumerate_close call failed");
+  return TCL_OK;
+}
+
 /**
    Interpret args and set params
    interp, objv provided for error handling
@@ -3127,6 +3706,85 @@ set_enumerate_params(Tcl_Interp *interp, Tcl_Obj *const objv[],
   return TCL_OK;
 }
 
+/**
+   usage:
+   adlb::reduce <id> sum|min|max|count|concat [<read decr>] [<write decr>]
+
+   Reduce values of container or multiset on the owning server.
+   Returns integer, float or string result, or the empty string for
+   min or max of no values.
+ */
+static int
+ADLB_Reduce_Cmd(ClientData cdata, Tcl_Interp *interp,
+                int objc, Tcl_Obj *const objv[])
+{
+  TCL_CONDITION(objc >= 3, "must have at least 3 arguments");
+  int rc;
+  int argpos = 1;
+  adlb_datum_id id;
+  rc = Tcl_GetADLB_ID(interp, objv[argpos++], &id);
+  TCL_CHECK_MSG(rc, "requires container id!");
+
+  const char *op_name = Tcl_GetString(objv[argpos++]);
+  adlb_reduce_op op;
+  if (!strcmp(op_name, "sum"))
+    op = ADLB_REDUCE_SUM;
+  else if (!strcmp(op_name, "min"))
+    op = ADLB_REDUCE_MIN;
+  else if (!strcmp(op_name, "max"))
+    op = ADLB_REDUCE_MAX;
+  else if (!strcmp(op_name, "count"))
+    op = ADLB_REDUCE_COUNT;
+  else if (!strcmp(op_name, "concat"))
+    op = ADLB_REDUCE_CONCAT;
+  else
+    TCL_RETURN_ERROR("unknown reduction: %s", op_name);
+
+  adlb_refc decr = ADLB_NO_REFC;
+  if (argpos < objc)
+  {
+    rc = Tcl_GetIntFromObj(interp, objv[argpos++], &decr.read_refcount);
+    TCL_CHECK_MSG(rc, "Expected integer argument");
+  }
+  if (argpos < objc)
+  {
+    rc = Tcl_GetIntFromObj(interp, objv[argpos++], &decr.write_refcount);
+    TCL_CHECK_MSG(rc, "Expected integer argument");
+  }
+
+  TCL_CONDITION(argpos == objc, "unexpected trailing args at %ith arg",
+                                argpos);
+
+  adlb_data_type type;
+  void *data;
+  size_t length;
+  rc = ADLB_Reduce(id, op, decr, &type, &data, &length);
+  TCL_CONDITION(rc == ADLB_SUCCESS, "<%"PRId64"> reduce %s failed!",
+                id, op_name);
+
+  Tcl_Obj *result;
+  if (type == ADLB_DATA_TYPE_NULL)
+  {
+    result = Tcl_NewObj();
+  }
+  else if (type == ADLB_DATA_TYPE_STRING)
+  {
+    // Result may be larger than ADLB_DATA_MAX
+    assert(length >= 1);
+    result = Tcl_NewStringObj(data, (int)length - 1);
+  }
+  else
+  {
+    rc = adlb_datum2tclobj(interp, objv, id, type, ADLB_TYPE_EXTRA_NULL,
+                           data, length, &result);
+    TCL_CHECK(rc);
+  }
+  free(data);
+
+  Tcl_SetObjResult(interp, result);
+  return TCL_OK;
+}
+
 /**
    Simple string struct for indices of strings
    Note: s may not be NULL-terminated: user must refer to length
@@ -3236,7 +3894,8 @@ ADLB_Retrieve_Blob_Impl(ClientData cdata, Tcl_Interp *interp,
 
 /**
    Copy a blob from the distributed store into a local blob
-   in the memory of this process
+   in the memory of this process, or map it read-only from the
+   node blob store if enabled with TURBINE_BLOB_SHM
    Must be freed with adlb::blob_free
    usage: adlb::retrieve_blob <id> => [ list <pointer> <length> ]
  */
@@ -3306,25 +3965,52 @@ ADLB_Retrieve_Blob_Impl(ClientData cdata, Tcl_Interp *interp,
     TCL_CHECK_MSG(rc, "requires id!");
   }
 
-  // TODO: will need to avoid using xfer to support large blobs
-
-  // Retrieve the blob data
-  adlb_data_type type;
+  void* blob = NULL;
   size_t length;
-  int ret_rc = ADLB_Retrieve(handle.id, handle.sub.val, refcounts,
-                             &type, xfer, &length);
-  CHECK_ADLB_RETRIEVE(ret_rc, handle);
+  bool whole = !adlb_has_sub(handle.sub.val);
 
-  TCL_CONDITION(type == ADLB_DATA_TYPE_BLOB,
-                "type mismatch: expected: %i actual: %i",
-                ADLB_DATA_TYPE_BLOB, type);
+  // Another worker on this node may have it already
+  if (whole && turbine_blob_shm_lookup(handle.id, &blob, &length))
+  {
+    if (decr)
+    {
+      adlb_code ac = ADLB_Refcount_decr_buffered(handle.id,
+                                          refcounts.decr_self);
+      TCL_CONDITION(ac == ADLB_SUCCESS, "<%"PRId64"> decrementing "
+                    "refcount failed", handle.id);
+    }
+  }
+  else
+  {
+    // TODO: will need to avoid using xfer to support large blobs
 
-  // Allocate the local blob
-  void* blob = malloc(length);
-  TCL_CONDITION(blob != NULL, "Error allocating blob: %zu bytes", length);
+    // Retrieve the blob data
+    adlb_data_type type;
+    int ret_rc = ADLB_Retrieve(handle.id, handle.sub.val, refcounts,
+                               &type, xfer, &length);
+    CHECK_ADLB_RETRIEVE(ret_rc, handle);
 
-  // Copy the blob data
-  memcpy(blob, xfer, (size_t)length);
+    TCL_CONDITION(type == ADLB_DATA_TYPE_BLOB,
+                  "type mismatch: expected: %i actual: %i",
+                  ADLB_DATA_TYPE_BLOB, type);
+
+    if (whole)
+    {
+      // Share with other workers on node if large
+      blob = turbine_blob_shm_create(handle.id, xfer, length);
+    }
+
+    if (blob == NULL)
+    {
+      // Allocate the local blob
+      blob = malloc(length);
+      TCL_CONDITION(blob != NULL, "Error allocating blob: %zu bytes",
+                    length);
+
+      // Copy the blob data
+      memcpy(blob, xfer, (size_t)length);
+    }
+  }
 
   DEBUG_ADLB("ADD TO CACHE: {%s}\n", Tcl_GetString(handle_obj));
   rc = cache_blob(interp, objc, objv, handle.id, handle.sub.val, blob);
@@ -3449,7 +4135,7 @@ static int uncache_blob(Tcl_Interp *interp, int objc,
 
   *found_in_cache = table_bp_remove(&blob_cache, cache_key,
                                     cache_key_len, &blob);
-  if (*found_in_cache)
+  if (*found_in_cache && !turbine_blob_shm_release(blob))
   {
     free(blob);
   }
@@ -3731,6 +4417,65 @@ ADLB_Blob_From_Float_List_Cmd(ClientData cdata, Tcl_Interp *interp,
   return TCL_OK;
 }
 
+/**
+   usage:
+   adlb::blob_from_container <id> [<read decr>] [<write decr>]
+
+   Return local blob with values of container with subscripts
+   0..N-1, in the format of adlb::blob_from_int_list or
+   adlb::blob_from_float_list.  The values are copied out by the
+   server in one message instead of being enumerated.
+ */
+static int
+ADLB_Blob_From_Container_Cmd(ClientData cdata, Tcl_Interp *interp,
+                             int objc, Tcl_Obj *const objv[])
+{
+  TCL_CONDITION(objc >= 2 && objc <= 4, "Expected 1 to 3 args");
+  int rc;
+  int argpos = 1;
+  adlb_datum_id id;
+  rc = Tcl_GetADLB_ID(interp, objv[argpos++], &id);
+  TCL_CHECK_MSG(rc, "requires container id!");
+
+  adlb_refc decr = ADLB_NO_REFC;
+  if (argpos < objc)
+  {
+    rc = Tcl_GetIntFromObj(interp, objv[argpos++], &decr.read_refcount);
+    TCL_CHECK_MSG(rc, "Expected integer argument");
+  }
+  if (argpos < objc)
+  {
+    rc = Tcl_GetIntFromObj(interp, objv[argpos++], &decr.write_refcount);
+    TCL_CHECK_MSG(rc, "Expected integer argument");
+  }
+
+  adlb_data_type type;
+  void *data;
+  int count;
+  rc = ADLB_Retrieve_array(id, decr, &type, &data, &count);
+  if (rc != ADLB_SUCCESS)
+  {
+    TCL_RETURN_ERROR("<%"PRId64"> failed to retrieve values as array",
+                     id);
+  }
+
+  size_t blob_size = (size_t)count * sizeof(double);
+  if (type == ADLB_DATA_TYPE_INTEGER)
+  {
+    // Narrow in place to match blob_from_int_list
+    int64_t *vals = data;
+    int *blob = data;
+    for (int i = 0; i < count; i++)
+    {
+      blob[i] = (int)vals[i];
+    }
+    blob_size = (size_t)count * sizeof(int);
+  }
+
+  Tcl_SetObjResult(interp, build_tcl_blob(data, blob_size, NULL));
+  return TCL_OK;
+}
+
 /**
    adlb::string2blob <string value> -> blob
  */
@@ -4740,8 +5485,16 @@ ADLB_Write_Refcount_Decr_Cmd(ClientData cdata, Tcl_Interp *interp,
   }
 
   // DEBUG_ADLB("adlb::write_refcount_decr: <%"PRId64">", container_id);
-  adlb_refc decr = { .read_refcount = 0, .write_refcount = -decr_w };
-  rc = ADLB_Refcount_incr(container_id, decr);
+  if (write_buffer_depth > 0)
+  {
+    adlb_refc decr = { .read_refcount = 0, .write_refcount = decr_w };
+    rc = ADLB_Refcount_decr_buffered(container_id, decr);
+  }
+  else
+  {
+    adlb_refc decr = { .read_refcount = 0, .write_refcount = -decr_w };
+    rc = ADLB_Refcount_incr(container_id, decr);
+  }
 
   if (rc != ADLB_SUCCESS)
     return TCL_ERROR;
@@ -4789,7 +5542,18 @@ ADLB_Refcount_Incr_Impl(ClientData cdata, Tcl_Interp *interp,
   {
     incr.write_refcount = change;
   }
-  rc = ADLB_Refcount_incr(id, incr);
+
+  if (change < 0 &&
+      (type == ADLB_READ_REFCOUNT || write_buffer_depth > 0))
+  {
+    // Applying a read decrement late only delays freeing the data,
+    // so merge it with others in the write buffer
+    rc = ADLB_Refcount_decr_buffered(id, adlb_refc_negate(incr));
+  }
+  else
+  {
+    rc = ADLB_Refcount_incr(id, incr);
+  }
 
   if (rc != ADLB_SUCCESS)
     return TCL_ERROR;
@@ -5887,6 +6651,12 @@ ADLB_Finalize_Cmd(ClientData cdata, Tcl_Interp *interp,
   rc = field_name_objs_finalize(interp, objv);
   TCL_CHECK(rc);
 
+  // Send any tasks left in unterminated batch.  Buffered writes are
+  // sent by ADLB_Finalize()
+  adlb_code ac = put_batch_flush();
+  TCL_CONDITION(ac == ADLB_SUCCESS, "could not send batched tasks");
+  write_buffer_depth = 0;
+
   rc = ADLB_Finalize();
   if (rc != ADLB_SUCCESS)
     printf("WARNING: ADLB_Finalize() failed!\n");
@@ -5894,6 +6664,12 @@ ADLB_Finalize_Cmd(ClientData cdata, Tcl_Interp *interp,
   int b;
   Tcl_GetBooleanFromObj(interp, objv[1], &b);
 
+  free(put_batch.tasks);
+  free(put_batch.storage);
+  put_batch.tasks = NULL;
+  put_batch.storage = NULL;
+  put_batch.size = 0;
+
   if (must_comm_free)
     MPI_Comm_free(&adlb_comm);
 
@@ -5913,13 +6689,15 @@ ADLB_Finalize_Cmd(ClientData cdata, Tcl_Interp *interp,
 static void blob_free_callback(const void *key, size_t key_len,
                                void *blob)
 {
-  free(blob);
+  if (!turbine_blob_shm_release(blob))
+    free(blob);
 }
 
 static int blob_cache_finalize(void)
 {
   // Free table structure and any contained blobs
   table_bp_free_callback(&blob_cache, false, blob_free_callback);
+  turbine_blob_shm_finalize();
   return TCL_OK;
 }
 
@@ -5974,6 +6752,11 @@ tcl_adlb_init(Tcl_Interp* interp)
   COMMAND("set_priority",   ADLB_Set_Priority_Cmd);
   COMMAND("put",       ADLB_Put_Cmd);
   COMMAND("spawn",     ADLB_Spawn_Cmd);
+  COMMAND("put_batch", ADLB_Put_Batch_Cmd);
+  COMMAND("batch_begin", ADLB_Batch_Begin_Cmd);
+  COMMAND("batch_end", ADLB_Batch_End_Cmd);
+  COMMAND("write_buffer_begin", ADLB_Write_Buffer_Begin_Cmd);
+  COMMAND("write_buffer_end", ADLB_Write_Buffer_End_Cmd);
   COMMAND("get",       ADLB_Get_Cmd);
   COMMAND("iget",      ADLB_Iget_Cmd);
   COMMAND("create",    ADLB_Create_Cmd);
@@ -5986,11 +6769,15 @@ tcl_adlb_init(Tcl_Interp* interp)
   COMMAND("store",     ADLB_Store_Cmd);
   COMMAND("retrieve",  ADLB_Retrieve_Cmd);
   COMMAND("retrieve_decr",  ADLB_Retrieve_Decr_Cmd);
+  COMMAND("retrieve_multi",  ADLB_Retrieve_Multi_Cmd);
   COMMAND("acquire_ref",  ADLB_Acquire_Ref_Cmd);
   COMMAND("acquire_write_ref",  ADLB_Acquire_Write_Ref_Cmd);
   COMMAND("acquire_sub_ref",  ADLB_Acquire_Sub_Ref_Cmd);
   COMMAND("acquire_sub_write_ref",  ADLB_Acquire_Sub_Write_Ref_Cmd);
   COMMAND("enumerate", ADLB_Enumerate_Cmd);
+  COMMAND("enumerate_next", ADLB_Enumerate_Next_Cmd);
+  COMMAND("enumerate_close", ADLB_Enumerate_Close_Cmd);
+  COMMAND("reduce",    ADLB_Reduce_Cmd);
   COMMAND("retrieve_blob", ADLB_Retrieve_Blob_Cmd);
   COMMAND("retrieve_decr_blob", ADLB_Retrieve_Blob_Decr_Cmd);
   COMMAND("blob_free",  ADLB_Blob_Free_Cmd);
@@ -5999,6 +6786,7 @@ tcl_adlb_init(Tcl_Interp* interp)
   COMMAND("store_blob_floats", ADLB_Blob_store_floats_Cmd);
   COMMAND("store_blob_ints", ADLB_Blob_store_ints_Cmd);
   COMMAND("blob_from_float_list", ADLB_Blob_From_Float_List_Cmd);
+  COMMAND("blob_from_container", ADLB_Blob_From_Container_Cmd);
   COMMAND("blob_from_int_list", ADLB_Blob_From_Int_List_Cmd);
   COMMAND("string2blob", ADLB_String2Blob_Cmd);
   COMMAND("blob2string", ADLB_Blob2String_Cmd);
@@ -32,6 +32,25 @@ extern int adlb_comm_rank;
 /* Return a pointer to a shared buffer */
 char *tcl_adlb_xfer_buffer(uint64_t *buf_size);
 
+/**
+   Same as ADLB_Dput, except that task is buffered and sent with
+   ADLB_Dput_batch if called between adlb::batch_begin and
+   adlb::batch_end.  Caller keeps ownership of all arguments.
+ */
+adlb_code tcl_adlb_dput(const void* payload, int length, int target,
+        int answer, int type, adlb_put_opts opts, const char *name,
+        const adlb_datum_id *wait_ids, int wait_id_count,
+        const adlb_datum_id_sub *wait_id_subs, int wait_id_sub_count);
+
+/**
+   Same as ADLB_Dput_group.  Tasks buffered by tcl_adlb_dput() are
+   sent first to preserve ordering.  Caller keeps ownership of all
+   arguments.
+ */
+adlb_code tcl_adlb_dput_group(const adlb_datum_id *shared_ids,
+        int shared_id_count, const adlb_datum_id_sub *shared_id_subs,
+        int shared_id_sub_count, const adlb_put_spec *tasks, int count);
+
 int adlb_type_from_obj(Tcl_Interp *interp, Tcl_Obj *const objv[],
                          Tcl_Obj* obj, adlb_data_type *type);
 
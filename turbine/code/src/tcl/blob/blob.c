@@ -29,6 +29,7 @@
 
 #include <tools.h>
 #include "src/tcl/blob/blob.h"
+#include "src/turbine/blob_shm.h"
 
 #include "config.h"
 
@@ -316,6 +317,12 @@ blobutils_destroy(turbine_blob* data)
 
 static inline int write_all(int fd, void* buffer, int count);
 
+bool
+blobutils_is_shared(void* pointer)
+{
+  return turbine_blob_shm_contains(pointer);
+}
+
 bool
 blobutils_write(const char* output, turbine_blob* blob)
 {
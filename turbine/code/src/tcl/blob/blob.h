@@ -276,6 +276,20 @@ char blobutils_get_char(turbine_blob* blob, int index);
 
 turbine_blob* blobutils_make_test(void);
 
+// DOCNN(=== Shared blobs)
+/* DOCNN(`With +TURBINE_BLOB_SHM=1+, large blobs retrieved from the
+          data store are mapped read-only from shared memory, so the
+          workers on a node share one copy.  Leaf functions in C,
+          Python or R get the mapped pointer without a copy.') */
+
+/**
+   DOCD(blobutils_is_shared pointer,
+        `Returns +true+ if +pointer+ is a blob mapped read-only from
+         node shared memory.  Copy such a blob before modifying it,
+         and do not free it.')
+ */
+bool blobutils_is_shared(void* pointer);
+
 // DOCNN(=== I/O)
 // DOCNN(Blob I/O functions.)
 
@@ -405,7 +405,7 @@ Turbine_Rule_Cmd(ClientData cdata, Tcl_Interp* interp,
 
   rule_log(inputs, input_list, action);
 
-  adlb_code ac = ADLB_Dput(action, action_len, opts.target,
+  adlb_code ac = tcl_adlb_dput(action, action_len, opts.target,
         adlb_comm_rank, opts.work_type, opts.opts, opts.name,
         input_list, inputs, input_pair_list, input_pairs);
   TCL_CONDITION(ac == ADLB_SUCCESS, "could not process rule!");
@@ -418,6 +418,137 @@ Turbine_Rule_Cmd(ClientData cdata, Tcl_Interp* interp,
   return TCL_OK;
 }
 
+/**
+   usage:
+   rule_group [ list shared_inputs ] [ list inputs action ... ]
+              [ name ... ] [ work_type ... ] [ target ... ] ...
+   Register one rule per inputs/action pair of the member list, each
+   waiting for the shared inputs as well as its own inputs.  Options
+   are as for rule and apply to every member.  The shared inputs are
+   subscribed to once per server rather than once per member, so this
+   is cheaper than calling rule for each member, e.g. for the
+   iterations of a foreach loop.
+ */
+static int
+Turbine_Rule_Group_Cmd(ClientData cdata, Tcl_Interp* interp,
+                       int objc, Tcl_Obj *const objv[])
+{
+  const int BASIC_ARGS = 3;
+  TCL_CONDITION(objc >= BASIC_ARGS,
+                "turbine::c::rule_group requires at least %i args!",
+                BASIC_ARGS);
+  int rc;
+  int shared = 0, shared_pairs = 0;
+  adlb_datum_id shared_list[TCL_TURBINE_MAX_INPUTS];
+  adlb_datum_id_sub shared_pair_list[TCL_TURBINE_MAX_INPUTS];
+  char name_buffer[TURBINE_NAME_MAX];
+
+  Tcl_Obj **member_objs;
+  int member_objc;
+  rc = Tcl_ListObjGetElements(interp, objv[2], &member_objc,
+                              &member_objs);
+  TCL_CHECK_MSG(rc, "rule_group members must be a list");
+  TCL_CONDITION(member_objc % 2 == 0,
+                "rule_group members must be inputs/action pairs, "
+                "but found odd number: %i", member_objc);
+  int count = member_objc / 2;
+  if (count <= 0)
+    return TCL_OK;
+
+  // Name defaults to first token of first action
+  const char *first_action = Tcl_GetString(member_objs[1]);
+  struct rule_opts opts = {NULL, 0, 0, ADLB_DEFAULT_PUT_OPTS};
+  if (objc > BASIC_ARGS)
+  {
+    rc = rule_opts_from_list(interp, objv, &opts, objv + BASIC_ARGS,
+                             objc - BASIC_ARGS,
+                             name_buffer, TURBINE_NAME_MAX, first_action);
+    TCL_CHECK(rc);
+  }
+  else
+  {
+    rule_set_opts_default(&opts, first_action, name_buffer,
+                          TURBINE_NAME_MAX);
+  }
+  opts.opts.priority = ADLB_curr_priority;
+
+  rc = turbine_extract_ids(interp, objv, objv[1], TCL_TURBINE_MAX_INPUTS,
+              shared_list, &shared, shared_pair_list, &shared_pairs);
+  TCL_CHECK_MSG(rc, "could not parse shared inputs list as ids or "
+                "id/subscript pairs:\n in rule_group: %s inputs: \"%s\"",
+                opts.name, Tcl_GetString(objv[1]));
+
+  // Size member input arrays from list lengths
+  int total_inputs = 0;
+  for (int i = 0; i < count; i++)
+  {
+    int n;
+    rc = Tcl_ListObjLength(interp, member_objs[2 * i], &n);
+    TCL_CHECK_MSG(rc, "rule_group member inputs must be a list");
+    total_inputs += n;
+  }
+
+  adlb_put_spec *tasks = malloc(sizeof(tasks[0]) * (size_t)count);
+  adlb_datum_id *ids = malloc(sizeof(ids[0]) *
+                              ((size_t)total_inputs + 1));
+  adlb_datum_id_sub *pairs = malloc(sizeof(pairs[0]) *
+                                    ((size_t)total_inputs + 1));
+  TCL_CONDITION(tasks != NULL && ids != NULL && pairs != NULL,
+                "rule_group: out of memory");
+
+  int ids_used = 0, pairs_used = 0;
+  for (int i = 0; i < count; i++)
+  {
+    int inputs = 0, input_pairs = 0;
+    rc = turbine_extract_ids(interp, objv, member_objs[2 * i],
+              total_inputs + 1 - ids_used - pairs_used,
+              &ids[ids_used], &inputs,
+              &pairs[pairs_used], &input_pairs);
+    TCL_CHECK_MSG(rc, "could not parse inputs list as ids or "
+                  "id/subscript pairs:\n in rule_group: %s inputs: \"%s\"",
+                  opts.name, Tcl_GetString(member_objs[2 * i]));
+
+    int action_len;
+    char *action = Tcl_GetStringFromObj(member_objs[2 * i + 1],
+                                        &action_len);
+    rule_log(inputs, &ids[ids_used], action);
+
+    adlb_put_spec *task = &tasks[i];
+    task->payload = action;
+    task->length = action_len + 1; // Include null terminator
+    task->target = opts.target;
+    task->answer = adlb_comm_rank;
+    task->type = opts.work_type;
+    task->opts = opts.opts;
+    task->name = opts.name;
+    task->wait_ids = &ids[ids_used];
+    task->wait_id_count = inputs;
+    task->wait_id_subs = &pairs[pairs_used];
+    task->wait_id_sub_count = input_pairs;
+
+    ids_used += inputs;
+    pairs_used += input_pairs;
+  }
+
+  adlb_code ac = tcl_adlb_dput_group(shared_list, shared,
+        shared_pair_list, shared_pairs, tasks, count);
+  TCL_CONDITION(ac == ADLB_SUCCESS, "could not process rule group!");
+
+  // Free subscripts that were allocated
+  for (int i = 0; i < shared_pairs; i++)
+  {
+    free((void*)shared_pair_list[i].subscript.key);
+  }
+  for (int i = 0; i < pairs_used; i++)
+  {
+    free((void*)pairs[i].subscript.key);
+  }
+  free(tasks);
+  free(ids);
+  free(pairs);
+  return TCL_OK;
+}
+
 static inline void
 rule_log(int inputs, const adlb_datum_id input_list[],
          const char* action)
@@ -632,16 +763,8 @@ Turbine_Cache_Check_Cmd(ClientData cdata, Tcl_Interp *interp,
                                   &subscript_len);
   TCL_CHECK(error);
 
-  bool found;
-  if (subscript_len == 0)
-  {
-    found = turbine_cache_check(td);
-  }
-  else
-  {
-    // TODO: handle caching subscripts - currently just ignore
-    found = false;
-  }
+  adlb_subscript sub = { .key = subscript, .length = subscript_len };
+  bool found = turbine_cache_check(td, sub);
 
   Tcl_Obj* result = Tcl_NewBooleanObj(found);
   Tcl_SetObjResult(interp, result);
@@ -660,18 +783,18 @@ Turbine_Cache_Retrieve_Cmd(ClientData cdata, Tcl_Interp *interp,
                                   &subscript_len);
   TCL_CHECK(error);
 
-  // TODO: handle caching subscripts
-  TCL_CONDITION(subscript_len == 0, "Don't handle caching subscripts");
-
+  adlb_subscript sub = { .key = subscript, .length = subscript_len };
   turbine_type type;
+  adlb_type_extra extra;
   void* data;
   size_t length;
-  turbine_code rc = turbine_cache_retrieve(td, &type, &data, &length);
+  turbine_code rc = turbine_cache_retrieve(td, sub, &type, &extra,
+                                           &data, &length);
   TURBINE_CHECK(rc, "cache retrieve failed: %"PRId64"", td);
 
   Tcl_Obj* result = NULL;
   int tcl_code = adlb_datum2tclobj(interp, objv, td, type,
-                      ADLB_TYPE_EXTRA_NULL, data, length, &result);
+                      extra, data, length, &result);
   TCL_CHECK(tcl_code);
   Tcl_SetObjResult(interp, result);
   return TCL_OK;
@@ -704,12 +827,7 @@ Turbine_Cache_Store_Cmd(ClientData cdata, Tcl_Interp* interp,
   error = ADLB_EXTRACT_HANDLE(objv[argpos++], &td, &subscript,
                                   &subscript_len);
   TCL_CHECK(error);
-
-  if (subscript_len != 0)
-  {
-    // TODO: handle caching subscripts
-    return TCL_OK;
-  }
+  adlb_subscript sub = { .key = subscript, .length = subscript_len };
 
   adlb_data_type type;
   adlb_type_extra extra;
@@ -725,7 +843,8 @@ Turbine_Cache_Store_Cmd(ClientData cdata, Tcl_Interp* interp,
   TCL_CONDITION(argpos == objc, "extra trailing arguments from %i",
                 argpos);
 
-  turbine_code rc = turbine_cache_store(td, type, data, length);
+  turbine_code rc = turbine_cache_store(td, sub, type, extra,
+                                        data, length);
   TURBINE_CHECK(rc, "cache store failed: %"PRId64"", td);
 
   return TCL_OK;
@@ -1772,6 +1891,7 @@ Tclturbine_Init(Tcl_Interp* interp)
   COMMAND("init_debug",  Turbine_Init_Debug_Cmd);
   COMMAND("version",     Turbine_Version_Cmd);
   COMMAND("rule",        Turbine_Rule_Cmd);
+  COMMAND("rule_group",  Turbine_Rule_Group_Cmd);
   COMMAND("ruleopts",    Turbine_RuleOpts_Cmd);
   COMMAND("log",         Turbine_Log_Cmd);
   COMMAND("normalize",   Turbine_Normalize_Cmd);
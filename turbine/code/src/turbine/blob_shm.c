@@ -0,0 +1,313 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * blob_shm.c
+ *
+ *  Each object starts with a header page, mapped read-write by all
+ *  workers, followed by the blob data, mapped read-only.  The creator
+ *  sets the ready flag once the data is complete; workers that find
+ *  the object before that retrieve the blob from the server instead
+ *  of waiting.  The header counts the workers mapping the object so
+ *  that the last one can unlink it.  Once the count drops to 0 the
+ *  object is never mapped again, so only the last worker unlinks the
+ *  name, and never a new object created under the same name.
+ */
+
+#include <assert.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <rhtable_lp.h>
+#include <tools.h>
+
+#include "src/util/debug.h"
+
+#include "blob_shm.h"
+
+struct shm_header
+{
+  turbine_datum_id id;
+  size_t length;
+  /** Set once data is complete */
+  int ready;
+  /** Number of mappings of this object on the node: 0 once the
+      object is unlinked or about to be */
+  int mappers;
+};
+
+/** Mapping of an object by this process */
+struct mapping
+{
+  struct shm_header* header;
+  void* data;
+  size_t length;
+};
+
+static bool enabled = false;
+
+static unsigned long min_length;
+
+/** Object name prefix, unique to this run */
+static char prefix[64];
+
+/** Size of header: data must start on a page boundary */
+static size_t header_size;
+
+/** Map from data pointer to mapping */
+static struct rhtable_lp mappings;
+
+#define SHM_NAME_MAX 96
+
+static inline void
+shm_name(char* name, turbine_datum_id id)
+{
+  snprintf(name, SHM_NAME_MAX, "%s-%"PRId64, prefix, id);
+}
+
+turbine_code
+turbine_blob_shm_init(MPI_Comm comm)
+{
+  bool b = getenv_boolean("TURBINE_BLOB_SHM", false, &enabled);
+  if (!b)
+  {
+    printf("malformed boolean in environment: TURBINE_BLOB_SHM\n");
+    return TURBINE_ERROR_INVALID;
+  }
+  if (!enabled)
+    return TURBINE_SUCCESS;
+
+  b = getenv_ulong("TURBINE_BLOB_SHM_MIN", 1024*1024, &min_length);
+  if (!b)
+  {
+    printf("malformed integer in environment: TURBINE_BLOB_SHM_MIN\n");
+    return TURBINE_ERROR_INVALID;
+  }
+  // Mapping empty data is not possible
+  if (min_length == 0)
+    min_length = 1;
+
+  // Names are shared by all ranks on the node, but not between runs
+  long run[2] = { (long)getpid(), (long)time(NULL) };
+  MPI_Bcast(run, 2, MPI_LONG, 0, comm);
+  snprintf(prefix, sizeof(prefix), "/turbine-%lx-%lx", run[0], run[1]);
+
+  header_size = (size_t)sysconf(_SC_PAGESIZE);
+  assert(header_size >= sizeof(struct shm_header));
+
+  rhtable_lp_init(&mappings, 16);
+  DEBUG_TURBINE("blob_shm: %s min: %lu", prefix, min_length);
+  return TURBINE_SUCCESS;
+}
+
+/**
+   Map object open as fd, already sized for length bytes of data
+   writable: if true, data is mapped writable for the creator
+   return NULL on failure
+ */
+static struct mapping*
+mapping_create(int fd, size_t length, bool writable)
+{
+  struct shm_header* header = mmap(NULL, header_size,
+        PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  if (header == MAP_FAILED)
+    return NULL;
+
+  int prot = writable ? PROT_READ|PROT_WRITE : PROT_READ;
+  void* data = mmap(NULL, length, prot, MAP_SHARED, fd,
+                    (off_t)header_size);
+  if (data == MAP_FAILED)
+  {
+    munmap(header, header_size);
+    return NULL;
+  }
+
+  struct mapping* m = malloc(sizeof(struct mapping));
+  m->header = header;
+  m->data = data;
+  m->length = length;
+  return m;
+}
+
+/**
+   Drop mapping and unlink object if this was the last one,
+   but do not free m
+ */
+static void
+mapping_unmap(struct mapping* m)
+{
+  struct shm_header* header = m->header;
+  int left = __atomic_sub_fetch(&header->mappers, 1, __ATOMIC_ACQ_REL);
+  if (left == 0)
+  {
+    char name[SHM_NAME_MAX];
+    shm_name(name, header->id);
+    DEBUG_TURBINE("blob_shm: unlink: %s", name);
+    // Name cannot be reused until we unlink it
+    shm_unlink(name);
+  }
+  munmap(m->data, m->length);
+  munmap(header, header_size);
+}
+
+/**
+   Count a new mapping of a complete object
+   return false if the last mapping was already dropped
+ */
+static bool
+mappers_acquire(struct shm_header* header)
+{
+  int n = __atomic_load_n(&header->mappers, __ATOMIC_ACQUIRE);
+  do
+  {
+    if (n == 0)
+      return false;
+  } while (!__atomic_compare_exchange_n(&header->mappers, &n, n + 1,
+                  false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+  return true;
+}
+
+bool
+turbine_blob_shm_lookup(turbine_datum_id id,
+                        void** data, size_t* length)
+{
+  if (!enabled)
+    return false;
+
+  char name[SHM_NAME_MAX];
+  shm_name(name, id);
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd == -1)
+    return false;
+
+  // Creator may not have sized object yet
+  struct stat s;
+  if (fstat(fd, &s) != 0 || (size_t)s.st_size <= header_size)
+  {
+    close(fd);
+    return false;
+  }
+
+  size_t object_length = (size_t)s.st_size - header_size;
+  struct mapping* m = mapping_create(fd, object_length, false);
+  close(fd);
+  if (m == NULL)
+    return false;
+
+  struct shm_header* header = m->header;
+  if (!__atomic_load_n(&header->ready, __ATOMIC_ACQUIRE) ||
+      !mappers_acquire(header))
+  {
+    // Not complete, or being unlinked: don't wait for creator
+    munmap(m->data, m->length);
+    munmap(header, header_size);
+    free(m);
+    return false;
+  }
+  assert(header->id == id && header->length == object_length);
+
+  rhtable_lp_add(&mappings, (int64_t)(uintptr_t)m->data, m);
+  DEBUG_TURBINE("blob_shm: mapped: %s length: %zu", name, m->length);
+  *data = m->data;
+  *length = m->length;
+  return true;
+}
+
+void*
+turbine_blob_shm_create(turbine_datum_id id,
+                        const void* data, size_t length)
+{
+  if (!enabled || length < min_length)
+    return NULL;
+
+  char name[SHM_NAME_MAX];
+  shm_name(name, id);
+  int fd = shm_open(name, O_RDWR|O_CREAT|O_EXCL, 0600);
+  if (fd == -1)
+    // Another worker on the node is creating it
+    return NULL;
+
+  struct mapping* m = NULL;
+  if (ftruncate(fd, (off_t)(header_size + length)) == 0)
+    m = mapping_create(fd, length, true);
+  close(fd);
+  if (m == NULL)
+  {
+    shm_unlink(name);
+    return NULL;
+  }
+
+  memcpy(m->data, data, length);
+  mprotect(m->data, length, PROT_READ);
+
+  struct shm_header* header = m->header;
+  header->id = id;
+  header->length = length;
+  header->mappers = 1;
+  __atomic_store_n(&header->ready, 1, __ATOMIC_RELEASE);
+
+  rhtable_lp_add(&mappings, (int64_t)(uintptr_t)m->data, m);
+  DEBUG_TURBINE("blob_shm: created: %s length: %zu", name, length);
+  return m->data;
+}
+
+bool
+turbine_blob_shm_contains(const void* data)
+{
+  if (!enabled)
+    return false;
+  return rhtable_lp_contains(&mappings, (int64_t)(uintptr_t)data);
+}
+
+bool
+turbine_blob_shm_release(void* data)
+{
+  if (!enabled)
+    return false;
+
+  void* v;
+  if (!rhtable_lp_remove(&mappings, (int64_t)(uintptr_t)data, &v))
+    return false;
+
+  struct mapping* m = v;
+  mapping_unmap(m);
+  free(m);
+  return true;
+}
+
+void
+turbine_blob_shm_finalize(void)
+{
+  if (!enabled)
+    return;
+
+  RHTABLE_LP_FOREACH(&mappings, item)
+  {
+    mapping_unmap(item->data);
+  }
+  // Frees mappings
+  rhtable_lp_delete(&mappings);
+  rhtable_lp_release(&mappings);
+  enabled = false;
+}
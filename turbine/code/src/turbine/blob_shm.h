@@ -0,0 +1,84 @@
+/*
+ * Copyright 2015 University of Chicago and Argonne National Laboratory
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/*
+ * blob_shm.h
+ *
+ *  Node-level shared memory store for large blobs
+ *
+ *  Workers on a node that retrieve the same large blob share one
+ *  copy in a POSIX shared memory object.  The first worker on the
+ *  node to retrieve the blob creates the object, later workers map
+ *  the same pages read-only.  The object is unlinked when the last
+ *  worker on the node releases its mapping.
+ *
+ *  Enabled with TURBINE_BLOB_SHM=1.  Blobs smaller than
+ *  TURBINE_BLOB_SHM_MIN bytes (default 1MB) are not shared.
+ *  Only whole blobs are shared, not blobs in containers or structs.
+ *
+ *  Objects are named /turbine-<pid>-<time>-<id>, from the pid of
+ *  rank 0 and the start time of the run.  Objects still mapped when
+ *  a run aborts are not unlinked: on Linux, remove them with
+ *  rm /dev/shm/turbine-* once no run is using them.
+ */
+
+#ifndef BLOB_SHM_H
+#define BLOB_SHM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <mpi.h>
+
+#include "turbine-defs.h"
+
+/**
+   Collective over comm, so that all ranks agree on object names
+ */
+turbine_code turbine_blob_shm_init(MPI_Comm comm);
+
+/**
+   Map blob from the node store if another worker stored it
+   return true if found, setting data to read-only mapping
+ */
+bool turbine_blob_shm_lookup(turbine_datum_id id,
+                             void** data, size_t* length);
+
+/**
+   Copy blob into the node store, if it is large enough and no other
+   worker on the node is storing it
+   return read-only mapping of the copy, or NULL if not stored
+ */
+void* turbine_blob_shm_create(turbine_datum_id id,
+                              const void* data, size_t length);
+
+/**
+   return true if data is a mapping from the node store
+ */
+bool turbine_blob_shm_contains(const void* data);
+
+/**
+   Release a mapping from the node store
+   return false if data is not from the node store
+ */
+bool turbine_blob_shm_release(void* data);
+
+/**
+   Release all mappings of this process
+ */
+void turbine_blob_shm_finalize(void);
+
+#endif
@@ -19,12 +19,19 @@
  *
  *  Created on: Sep 4, 2012
  *      Author: wozniak
+ *
+ *  Entries are keyed by TD, or by TD and subscript for members of
+ *  containers and fields of structs.  Only write-once data is cached:
+ *  a member or field does not change once set, and TDs are never
+ *  reused, so entries never need to be invalidated.
  */
 
 #include <assert.h>
 
 #include <stdio.h>
-#include <table_lp.h>
+#include <string.h>
+#include <rhtable_lp.h>
+#include <table_bp.h>
 #include <tools.h>
 #include <rbtree.h>
 
@@ -43,14 +50,23 @@ static bool initialized = false;
 /** Avoid relying on clock for LRU */
 static long counter = 0;
 
-/** Memory remaining */
-static unsigned long memory;
+/** Memory remaining: may go negative until cache is shrunk */
+static long memory;
+
+/** Number of entries in both tables */
+static int count = 0;
 
 /**
-   Cache entries
+   Cache entries without subscript
    Maps from TD to entry
   */
-static struct table_lp entries;
+static struct rhtable_lp entries;
+
+/**
+   Cache entries with subscript
+   Maps from packed TD and subscript to entry
+  */
+static table_bp sub_entries;
 
 /**
    Maintain LRU ordering
@@ -63,13 +79,33 @@ static struct rbtree lru;
 struct entry
 {
   turbine_datum_id td;
+  /** Packed TD and subscript key, or NULL if no subscript */
+  void* key;
+  size_t key_len;
   turbine_type type;
+  adlb_type_extra extra;
   void* data;
   size_t length;
   /** Counter as of last access */
   long stamp;
 };
 
+/**
+   Length of key for TD and subscript
+ */
+static inline size_t
+sub_key_len(adlb_subscript sub)
+{
+  return sizeof(turbine_datum_id) + sub.length;
+}
+
+static inline void
+sub_key_write(void* key, turbine_datum_id td, adlb_subscript sub)
+{
+  memcpy(key, &td, sizeof(td));
+  memcpy((char*)key + sizeof(td), sub.key, sub.length);
+}
+
 void
 turbine_cache_init(int size, unsigned long max_memory)
 {
@@ -77,40 +113,64 @@ turbine_cache_init(int size, unsigned long max_memory)
   assert(!initialized);
   initialized = true;
   max_entries = size;
-  memory = max_memory;
+  memory = (long)max_memory;
   if (max_entries == 0)
     return;
-  table_lp_init(&entries, size);
+  rhtable_lp_init(&entries, size);
+  table_bp_init(&sub_entries, size);
   rbtree_init(&lru);
 
 }
 
+/**
+   Look up entry
+   return NULL if not found
+ */
+static inline struct entry*
+cache_lookup(turbine_datum_id td, adlb_subscript sub)
+{
+  void* e;
+  bool found;
+  if (!adlb_has_sub(sub))
+  {
+    found = rhtable_lp_search(&entries, td, &e);
+  }
+  else
+  {
+    size_t key_len = sub_key_len(sub);
+    char key[key_len];
+    sub_key_write(key, td, sub);
+    found = table_bp_search(&sub_entries, key, key_len, &e);
+  }
+  return found ? e : NULL;
+}
+
 bool
-turbine_cache_check(turbine_datum_id td)
+turbine_cache_check(turbine_datum_id td, adlb_subscript sub)
 {
   if (max_entries == 0)
     return false;
 
-  bool result = table_lp_contains(&entries, td);
-  DEBUG_CACHE("check: <%li> %s", td,
-              result ? "hit" : "miss");
+  bool result = (cache_lookup(td, sub) != NULL);
+  DEBUG_CACHE("check: <%li>[%.*s] %s", td, (int)sub.length,
+              (const char*)sub.key, result ? "hit" : "miss");
   return result;
 }
 
 turbine_code
-turbine_cache_retrieve(turbine_datum_id td,
-                       turbine_type* type,
+turbine_cache_retrieve(turbine_datum_id td, adlb_subscript sub,
+                       turbine_type* type, adlb_type_extra* extra,
                        void** result, size_t* length)
 {
   // We do not need to check max_entries here: if max_entries==0,
   // then turbine_cache_check() will miss
 
   DEBUG_CACHE("retrieve: <%li>", td);
-  struct entry* e;
-  bool found = table_lp_search(&entries, td, (void**)&e);
-  if (!found)
+  struct entry* e = cache_lookup(td, sub);
+  if (e == NULL)
     return TURBINE_ERROR_NOT_FOUND;
   *type   = e->type;
+  *extra  = e->extra;
   *result = e->data;
   *length = e->length;
 
@@ -125,30 +185,43 @@ turbine_cache_retrieve(turbine_datum_id td,
   return TURBINE_SUCCESS;
 }
 
-static inline void cache_add(turbine_datum_id td, turbine_type type,
+static inline void cache_add(turbine_datum_id td, adlb_subscript sub,
+                             turbine_type type, adlb_type_extra extra,
                              void* data, size_t length);
 
 static inline void cache_replace(turbine_datum_id td,
-                                 turbine_type type,
+                                 adlb_subscript sub, turbine_type type,
+                                 adlb_type_extra extra,
                                  void* data, size_t length);
 
 turbine_code
-turbine_cache_store(turbine_datum_id td, turbine_type type,
+turbine_cache_store(turbine_datum_id td, adlb_subscript sub,
+                    turbine_type type, adlb_type_extra extra,
                     void* data, size_t size)
 {
   if (max_entries == 0)
+  {
+    free(data);
     return TURBINE_SUCCESS;
+  }
 
-  DEBUG_CACHE("store: <%li> size: %i counter: %li",
+  DEBUG_CACHE("store: <%li> size: %zu counter: %li",
               td, size, counter);
-  assert(entries.size <= max_entries);
-  if (max_entries - entries.size == 1)
+  if (cache_lookup(td, sub) != NULL)
+  {
+    // Data is write-once, so the cached value is the same
+    free(data);
+    return TURBINE_SUCCESS;
+  }
+
+  assert(count <= max_entries);
+  if (max_entries - count == 1)
   {
-    cache_replace(td, type, data, size);
+    cache_replace(td, sub, type, extra, data, size);
   }
   else
   {
-    cache_add(td, type, data, size);
+    cache_add(td, sub, type, extra, data, size);
   }
 
   return TURBINE_SUCCESS;
@@ -156,11 +229,24 @@ turbine_cache_store(turbine_datum_id td, turbine_type type,
 
 static inline void
 entry_init(struct entry* result,
-           turbine_datum_id td, turbine_type type,
+           turbine_datum_id td, adlb_subscript sub,
+           turbine_type type, adlb_type_extra extra,
            void* data, size_t length, long counter)
 {
   result->td = td;
+  if (adlb_has_sub(sub))
+  {
+    result->key_len = sub_key_len(sub);
+    result->key = malloc(result->key_len);
+    sub_key_write(result->key, td, sub);
+  }
+  else
+  {
+    result->key = NULL;
+    result->key_len = 0;
+  }
   result->type = type;
+  result->extra = extra;
   result->data = data;
   result->length = length;
   result->stamp = counter;
@@ -170,28 +256,65 @@ entry_init(struct entry* result,
    Allocate and initialize an entry
  */
 static inline struct entry*
-entry_create(turbine_datum_id td, turbine_type type,
+entry_create(turbine_datum_id td, adlb_subscript sub,
+             turbine_type type, adlb_type_extra extra,
              void* data, size_t length, long counter)
 {
   struct entry* result = malloc(sizeof(struct entry));
-  entry_init(result, td, type, data, length, counter);
+  entry_init(result, td, sub, type, extra, data, length, counter);
   return result;
 }
 
+/**
+   Add entry to the table for its key
+ */
+static inline void
+entry_index(struct entry* e)
+{
+  if (e->key == NULL)
+    rhtable_lp_add(&entries, e->td, e);
+  else
+    table_bp_add(&sub_entries, e->key, e->key_len, e);
+}
+
+/**
+   Remove entry from the table for its key and free its data,
+   but not the entry itself
+ */
+static inline void
+entry_evict(struct entry* e)
+{
+  void *tmp;
+  if (e->key == NULL)
+  {
+    rhtable_lp_remove(&entries, e->td, &tmp);
+  }
+  else
+  {
+    table_bp_remove(&sub_entries, e->key, e->key_len, &tmp);
+    free(e->key);
+  }
+  assert(tmp == e);
+  memory += (long)e->length;
+  free(e->data);
+}
+
 static inline void cache_shrink(void);
 
 /**
    Add a cache entry- no eviction necessary unless out of memory
 */
 static inline void
-cache_add(turbine_datum_id td, turbine_type type,
-          void* data, size_t length)
+cache_add(turbine_datum_id td, adlb_subscript sub, turbine_type type,
+          adlb_type_extra extra, void* data, size_t length)
 {
-  struct entry* e = entry_create(td, type, data, length, counter);
-  table_lp_add(&entries, td, e);
+  struct entry* e = entry_create(td, sub, type, extra, data, length,
+                                 counter);
+  entry_index(e);
   rbtree_add(&lru, counter, e);
   counter++;
-  memory -= (unsigned long)length;
+  count++;
+  memory -= (long)length;
   cache_shrink();
 }
 
@@ -200,8 +323,8 @@ cache_add(turbine_datum_id td, turbine_type type,
    This prevents memory reallocation in the tree
  */
 static inline void
-cache_replace(turbine_datum_id td, turbine_type type,
-              void* data, size_t length)
+cache_replace(turbine_datum_id td, adlb_subscript sub, turbine_type type,
+              adlb_type_extra extra, void* data, size_t length)
 {
   // Lookup the least-recently-used entry
   struct rbtree_node* node = rbtree_leftmost(&lru);
@@ -209,20 +332,14 @@ cache_replace(turbine_datum_id td, turbine_type type,
   DEBUG_CACHE("cache_replace(): LRU victim: <%li>", e->td);
   // Remove the victim from cache data structures
   rbtree_remove_node(&lru, node);
+  entry_evict(e);
 
-  void *tmp;
-  table_lp_remove(&entries, e->td, &tmp);
-  assert(tmp == e);
-
-  assert(e->length >= 0);
-  memory += (unsigned long)e->length;
-  free(e->data);
   // Replace the entry with the new data
-  entry_init(e, td, type, data, length, counter);
+  entry_init(e, td, sub, type, extra, data, length, counter);
   node->key = counter;
   rbtree_add_node(&lru, node);
-  table_lp_add(&entries, td, e);
-  memory -= (unsigned long)length;
+  entry_index(e);
+  memory -= (long)length;
   counter++;
   cache_shrink();
 }
@@ -234,21 +351,29 @@ cache_replace(turbine_datum_id td, turbine_type type,
 static inline void
 cache_shrink(void)
 {
-  while (memory < 0)
+  while (memory < 0 && count > 0)
   {
     int64_t stamp;
     void* v;
     rbtree_pop(&lru, &stamp, &v);
     struct entry* e = (struct entry*) v;
     DEBUG_CACHE("cache_shrink(): LRU victim: <%li>", e->td);
-    memory += (unsigned long)e->length;
-    free(e->data);
+    entry_evict(e);
     free(e);
+    count--;
   }
 
   DEBUG_CACHE("cache_shrink(): memory: %li", memory);
 }
 
+static void
+entry_free(struct entry* e)
+{
+  free(e->key);
+  free(e->data);
+  free(e);
+}
+
 void
 turbine_cache_finalize()
 {
@@ -256,13 +381,23 @@ turbine_cache_finalize()
     // This process is not a worker
     return;
   DEBUG_CACHE("finalize");
-  TABLE_LP_FOREACH(&entries, item)
+  if (max_entries > 0)
   {
-    struct entry* e = (struct entry*) item->data;
-    free(e->data);
+    RHTABLE_LP_FOREACH(&entries, item)
+    {
+      struct entry* e = (struct entry*) item->data;
+      free(e->data);
+    }
+    // Frees entries
+    rhtable_lp_delete(&entries);
+    rhtable_lp_release(&entries);
+    TABLE_BP_FOREACH(&sub_entries, item)
+    {
+      entry_free(item->data);
+    }
+    table_bp_free_callback(&sub_entries, false, NULL);
+    rbtree_clear(&lru);
   }
-  table_lp_delete(&entries);
-  table_lp_release(&entries);
-  rbtree_clear(&lru);
+  count = 0;
   initialized = false;
 }
@@ -20,7 +20,8 @@
  *  Created on: Sep 4, 2012
  *      Author: wozniak
  *
- *  Local cache for variables in ADLB data store
+ *  Local cache for variables in ADLB data store, and for members
+ *  of containers and fields of structs
  *  This is initialized and finalized by the Turbine C layer
  */
 
@@ -34,14 +35,28 @@
  */
 void turbine_cache_init(int size, unsigned long max_memory);
 
-bool turbine_cache_check(turbine_datum_id td);
+/**
+   sub: subscript of container member or struct field, or ADLB_NO_SUB
+ */
+bool turbine_cache_check(turbine_datum_id td, adlb_subscript sub);
 
+/**
+   result: set to cached data, still owned by the cache
+ */
 turbine_code turbine_cache_retrieve(turbine_datum_id td,
+                                    adlb_subscript sub,
                                     turbine_type* type,
+                                    adlb_type_extra* extra,
                                     void** result, size_t* length);
 
+/**
+   Takes ownership of data, which must be malloc'ed.
+   Only write-once data may be stored.
+ */
 turbine_code turbine_cache_store(turbine_datum_id td,
+                                 adlb_subscript sub,
                                  turbine_type type,
+                                 adlb_type_extra extra,
                                  void* data, size_t length);
 
 void turbine_cache_finalize(void);